@@ -1,4 +1,5 @@
 #include <clap/clap.h>
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include <atomic>
@@ -8,11 +9,9 @@
 // Include our core components
 #include "../src/RingBuffer.h"
 #include "../src/PolyphaseDecimator.h"
-#include "../src/RealtimeThreadPool.h"
-#include "../src/AiInference.h"
+#include "../src/InferenceService.h"
 #include "../src/MidiEventHandler.h"
 #include "../src/WaveformData.h"
-#include "../src/PostProcessor.h"
 
 namespace KhDetector {
 
@@ -77,34 +76,37 @@ public:
         , mHadHit(false)
         , mDecimator()
         , mDecimatedBuffer()
-        , mDecimatedSamples(kFrameSize)
         , mProcessingFrame(kFrameSize)
     {
         // Initialize waveform buffer
         mWaveformBuffer = std::make_shared<WaveformBuffer4K>();
         mSpectralAnalyzer = std::make_unique<SpectralAnalyzer>();
         
-        // Initialize AI inference and thread pool
-        mAiInference = std::make_unique<AiInference>();
-        mThreadPool = std::make_unique<RealtimeThreadPool>(
-            std::thread::hardware_concurrency() - 1,
-            RealtimeThreadPool::Priority::High
-        );
+        // Run inference on the process-wide service, as the VST3 processor does;
+        // the first instance of the model loads the engines in the background
+        auto aiConfig = createDefaultModelConfig();
+        aiConfig.inputSize = kFrameSize;  // 20ms frames at 16kHz
+        aiConfig.useActivityGate = true;  // Skip the model on silence and voiced-only frames
+        aiConfig.activityGate.hangoverFrames = 200 / kHopSizeMs;  // Hold open for 200 ms
+        aiConfig.featureInput = !aiConfig.modelPath.empty();  // The shipped model is trained on FeatureExtractor frames
+        mInferenceStream = InferenceService::getShared().registerStream(&mDecimatedBuffer, aiConfig, kHopSize);
+        applySensitivity();
         
         // Initialize MIDI handler
         mMidiHandler = std::make_unique<MidiEventHandler>();
     }
 
-    ~KhDetectorClapPlugin() = default;
+    ~KhDetectorClapPlugin() {
+        // Unregister from the inference service before the ring buffer goes away
+        mInferenceStream.reset();
+    }
 
     bool init() {
         return true;
     }
 
     void destroy() {
-        if (mThreadPool) {
-            mThreadPool->stop();
-        }
+        // The destructor unregisters the inference stream
     }
 
     bool activate(double sample_rate, uint32_t min_frames_count, uint32_t max_frames_count) {
@@ -113,17 +115,18 @@ public:
         // Initialize for sample rate
         initializeForSampleRate(sample_rate);
         
-        // Start thread pool
-        if (mThreadPool) {
-            mThreadPool->start(&mDecimatedBuffer, mAiInference.get());
+        // Start inference on a fresh stream
+        if (mInferenceStream) {
+            mInferenceStream->setActive(true);
         }
         
         return true;
     }
 
     void deactivate() {
-        if (mThreadPool) {
-            mThreadPool->stop();
+        // The service stops reading our ring buffer
+        if (mInferenceStream) {
+            mInferenceStream->setActive(false);
         }
     }
 
@@ -132,17 +135,14 @@ public:
     }
 
     void stop_processing() {
-        // Clear any pending processing
-        mDecimatedBuffer.clear();
+        // Queued samples belong to the inference service while active
     }
 
     void reset() {
-        mDecimatedBuffer.clear();
+        mProcessingFill = 0;
         mCurrentSamplePosition = 0;
         mHadHit.store(false);
-        
-        // Reset AI inference state
-        mHadHit.store(false);
+        mReportedHit = false;
     }
 
     clap_process_status process(const clap_process_t* process) {
@@ -332,8 +332,7 @@ public:
         if (stream->read(stream, &state, sizeof(state)) == sizeof(state)) {
             mBypass = state.bypass;
             mSensitivity = state.sensitivity;
-            
-            // Sensitivity updated (handled in processing)
+            applySensitivity();
             
             return true;
         }
@@ -345,6 +344,8 @@ private:
     static constexpr int kTargetSampleRate = 16000;
     static constexpr int kFrameSizeMs = 20;
     static constexpr int kFrameSize = (kTargetSampleRate * kFrameSizeMs) / 1000; // 320 samples at 16kHz
+    static constexpr int kHopSizeMs = 10;   // 50% overlap between frames
+    static constexpr int kHopSize = (kTargetSampleRate * kHopSizeMs) / 1000;     // 160 samples at 16kHz
     static constexpr size_t kRingBufferSize = 2048; // Must be power of 2, larger than frame size
 
     // Host and state
@@ -353,15 +354,15 @@ private:
     int32_t mCurrentSamplePosition = 0;
     bool mBypass;
     float mSensitivity;
-    std::atomic<bool> mHadHit;
+    std::atomic<bool> mHadHit;      // A hit started since the last output events
+    bool mReportedHit = false;
 
     // Audio processing components
     PolyphaseDecimator<DECIM_FACTOR> mDecimator;
     RingBuffer<float, kRingBufferSize> mDecimatedBuffer;
     
     // AI processing components
-    std::unique_ptr<AiInference> mAiInference;
-    std::unique_ptr<RealtimeThreadPool> mThreadPool;
+    std::unique_ptr<InferenceService::Stream> mInferenceStream;    // Declared after the ring buffer it reads
     
     // MIDI event handling
     std::unique_ptr<MidiEventHandler> mMidiHandler;
@@ -370,9 +371,9 @@ private:
     std::shared_ptr<WaveformBuffer4K> mWaveformBuffer;
     std::unique_ptr<SpectralAnalyzer> mSpectralAnalyzer;
     
-    // Working buffers
-    std::vector<float> mDecimatedSamples;
+    // Working buffers: decimated samples for the visualization, which leaves the ring buffer to the service
     std::vector<float> mProcessingFrame;
+    int mProcessingFill = 0;
 
     void initializeForSampleRate(double sampleRate) {
         mCurrentSampleRate = sampleRate;
@@ -381,20 +382,15 @@ private:
         int decimationFactor = static_cast<int>(std::round(sampleRate / kTargetSampleRate));
         decimationFactor = std::max(1, std::min(decimationFactor, 8)); // Clamp to reasonable range
         
-        // Clear buffers
+        // Clear buffers; the stream is inactive, so nothing reads the ring buffer
         mDecimatedBuffer.clear();
-        mDecimatedSamples.clear();
-        mProcessingFrame.clear();
-        
-        // Resize working buffers
-        mDecimatedSamples.resize(kFrameSize);
-        mProcessingFrame.resize(kFrameSize);
-        
-        // Initialize AI inference with default config
-        if (mAiInference) {
-            KhDetector::AiInference::ModelConfig config;
-            config.inputSize = kFrameSize;
-            mAiInference->initialize(config);
+        mProcessingFill = 0;
+    }
+
+    // Sensitivity is the stream's hit threshold on the detection probability
+    void applySensitivity() {
+        if (mInferenceStream) {
+            mInferenceStream->setThreshold(mSensitivity);
         }
     }
 
@@ -420,7 +416,7 @@ private:
                         break;
                     case PARAM_SENSITIVITY:
                         mSensitivity = static_cast<float>(param_event->value);
-                        // Update sensitivity (handled by post-processor)
+                        applySensitivity();
                         break;
                 }
             }
@@ -487,11 +483,21 @@ private:
         // Process audio for analysis
         processAudioAnalysis(input_l, input_r, process->frames_count);
         
+        // Report each hit once, when the stream's post-processor starts one;
+        // no hits while the model is still loading
+        const bool hit = mInferenceStream && mInferenceStream->hasHit();
+        if (hit && !mReportedHit) {
+            mHadHit.store(true);
+        }
+        mReportedHit = hit;
+        
         mCurrentSamplePosition += process->frames_count;
     }
 
     void processAudioAnalysis(const float* input_l, const float* input_r, uint32_t frame_count) {
         // Decimate stereo to mono at target sample rate
+        size_t committed = 0;
+        size_t dropped = 0;
         for (uint32_t i = 0; i < frame_count; ++i) {
             float mono_sample = (input_l[i] + input_r[i]) * 0.5f;
             
@@ -499,22 +505,29 @@ private:
             // Simple decimation by factor of 3 (placeholder)
             if ((i % DECIM_FACTOR) == 0) {
                 decimated_sample = mono_sample;
-                // Add to ring buffer
-                if (!mDecimatedBuffer.push(decimated_sample)) {
-                    // Buffer full, this shouldn't happen with proper sizing
-                    continue;
+                // Add to ring buffer; the inference service sheds load well before it fills
+                if (mDecimatedBuffer.push(decimated_sample)) {
+                    ++committed;
+                } else {
+                    ++dropped;
                 }
                 
-                // Check if we have enough samples for a frame
-                if (mDecimatedBuffer.size() >= kFrameSize) {
-                    // Extract frame for processing
-                    size_t samples_popped = mDecimatedBuffer.pop_bulk(mProcessingFrame.data(), kFrameSize);
-                    if (samples_popped == kFrameSize) {
-                        processDecimatedFrame(mProcessingFrame.data(), kFrameSize);
-                    }
+                // Whole frames go to the visualization
+                mProcessingFrame[mProcessingFill++] = decimated_sample;
+                if (mProcessingFill == kFrameSize) {
+                    processDecimatedFrame(mProcessingFrame.data(), kFrameSize);
+                    mProcessingFill = 0;
                 }
             }
         }
+        
+        if (mInferenceStream) {
+            if (dropped > 0) {
+                mInferenceStream->noteInputDropped(dropped);
+            }
+            // Wake an inference worker once a whole hop is queued
+            mInferenceStream->notifyInputCommitted(committed);
+        }
     }
 
     void processDecimatedFrame(const float* frameData, int frameSize) {
@@ -547,24 +560,6 @@ private:
             // Add sample to waveform buffer (simplified)
             // mWaveformBuffer->addSample(sample);
         }
-        
-        // Submit frame for AI processing
-        if (mThreadPool && mAiInference) {
-            std::vector<float> frame_copy(frameData, frameData + frameSize);
-            mThreadPool->submitTask([this, frame_copy = std::move(frame_copy)]() {
-                // Simulate AI processing and hit detection
-                float energy = 0.0f;
-                for (const auto& sample : frame_copy) {
-                    energy += sample * sample;
-                }
-                energy /= frame_copy.size();
-                
-                // Simple threshold-based hit detection
-                if (energy > mSensitivity) {
-                    mHadHit.store(true);
-                }
-            });
-        }
     }
 
     // Static extension implementations
@@ -0,0 +1,39 @@
+# Detector model shipped with the plugins.
+#
+# KHDETECTOR_MODEL_FILE is the model written by training/train_het_detector.py
+# (het_detector.khmlp, or het_detector.onnx for an ONNX Runtime build).
+# khdetector_bundle_model(<target>) copies it next to the plugin binary, or
+# into Contents/Resources of a macOS bundle, where findDefaultModelPath()
+# looks for it. Without the file the plugin still builds and AiInference uses
+# its heuristic fallback. The lookup needs dladdr(), hence CMAKE_DL_LIBS.
+
+set(KHDETECTOR_MODEL_FILE "${CMAKE_CURRENT_LIST_DIR}/../models/het_detector.khmlp"
+    CACHE FILEPATH "Trained detector model to ship with the plugins")
+
+if(EXISTS "${KHDETECTOR_MODEL_FILE}")
+    message(STATUS "Detector model: ${KHDETECTOR_MODEL_FILE}")
+else()
+    message(STATUS "Detector model: not found (set KHDETECTOR_MODEL_FILE), AiInference uses its heuristic fallback")
+endif()
+
+function(khdetector_bundle_model target)
+    target_link_libraries(${target} PRIVATE ${CMAKE_DL_LIBS})
+
+    if(NOT EXISTS "${KHDETECTOR_MODEL_FILE}")
+        return()
+    endif()
+
+    get_filename_component(model_extension "${KHDETECTOR_MODEL_FILE}" EXT)
+    get_target_property(is_bundle ${target} BUNDLE)
+    if(APPLE AND is_bundle)
+        set(model_directory "$<TARGET_BUNDLE_CONTENT_DIR:${target}>/Resources")
+    else()
+        set(model_directory "$<TARGET_FILE_DIR:${target}>")
+    endif()
+
+    add_custom_command(TARGET ${target} POST_BUILD
+        COMMAND ${CMAKE_COMMAND} -E make_directory "${model_directory}"
+        COMMAND ${CMAKE_COMMAND} -E copy_if_different "${KHDETECTOR_MODEL_FILE}"
+                "${model_directory}/het_detector${model_extension}"
+        COMMENT "Bundling detector model with ${target}")
+endfunction()
@@ -0,0 +1,38 @@
+# DSP kernel sources and their per-file instruction-set flags.
+#
+# Each SIMD variant lives in its own translation unit and only that unit is
+# built with the extra flags, so the rest of the plugin stays runnable on any
+# CPU of the target architecture; DspKernels.cpp picks a variant at load time.
+# Units built for an architecture without their instruction set compile to a
+# stub that reports the variant as unavailable.
+
+set(KHDETECTOR_DSP_KERNEL_DIR "${CMAKE_CURRENT_LIST_DIR}/../src")
+
+set(KHDETECTOR_DSP_KERNEL_SOURCES
+    ${KHDETECTOR_DSP_KERNEL_DIR}/DspKernels.h
+    ${KHDETECTOR_DSP_KERNEL_DIR}/DspKernels.cpp
+    ${KHDETECTOR_DSP_KERNEL_DIR}/DspKernelsSSE2.cpp
+    ${KHDETECTOR_DSP_KERNEL_DIR}/DspKernelsAVX2.cpp
+    ${KHDETECTOR_DSP_KERNEL_DIR}/DspKernelsAVX512.cpp
+    ${KHDETECTOR_DSP_KERNEL_DIR}/DspKernelsNEON.cpp
+)
+
+if(MSVC)
+    if(CMAKE_SYSTEM_PROCESSOR MATCHES "AMD64|x86_64|x64")
+        set_source_files_properties(${KHDETECTOR_DSP_KERNEL_DIR}/DspKernelsAVX2.cpp
+            PROPERTIES COMPILE_OPTIONS "/arch:AVX2")
+        set_source_files_properties(${KHDETECTOR_DSP_KERNEL_DIR}/DspKernelsAVX512.cpp
+            PROPERTIES COMPILE_OPTIONS "/arch:AVX512")
+    endif()
+elseif(APPLE AND CMAKE_OSX_ARCHITECTURES MATCHES "x86_64")
+    # Universal builds compile every unit once per slice; scope the flags to x86_64
+    set_source_files_properties(${KHDETECTOR_DSP_KERNEL_DIR}/DspKernelsAVX2.cpp
+        PROPERTIES COMPILE_OPTIONS "-Xarch_x86_64;-mavx2;-Xarch_x86_64;-mfma")
+    set_source_files_properties(${KHDETECTOR_DSP_KERNEL_DIR}/DspKernelsAVX512.cpp
+        PROPERTIES COMPILE_OPTIONS "-Xarch_x86_64;-mavx512f;-Xarch_x86_64;-mavx2;-Xarch_x86_64;-mfma")
+elseif(CMAKE_SYSTEM_PROCESSOR MATCHES "x86_64|AMD64|i.86")
+    set_source_files_properties(${KHDETECTOR_DSP_KERNEL_DIR}/DspKernelsAVX2.cpp
+        PROPERTIES COMPILE_OPTIONS "-mavx2;-mfma")
+    set_source_files_properties(${KHDETECTOR_DSP_KERNEL_DIR}/DspKernelsAVX512.cpp
+        PROPERTIES COMPILE_OPTIONS "-mavx512f;-mavx2;-mfma")
+endif()
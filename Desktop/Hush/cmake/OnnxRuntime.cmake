@@ -0,0 +1,49 @@
+# Optional ONNX Runtime backend for AiInference (src/OnnxBackend.cpp).
+#
+# Uses an installed onnxruntime CMake package if there is one, otherwise the
+# headers and library of an extracted release archive under ONNXRUNTIME_ROOT.
+# When neither is found the plugin still builds: OnnxBackend compiles to a
+# stub and AiInference keeps its heuristic fallback.
+#
+# khdetector_use_onnxruntime(<target>) links a target against ONNX Runtime
+# and defines KHDETECTOR_WITH_ONNXRUNTIME for it.
+
+option(KHDETECTOR_WITH_ONNXRUNTIME "Run models with ONNX Runtime when it is available" ON)
+set(ONNXRUNTIME_ROOT "" CACHE PATH "Extracted ONNX Runtime release (with include/ and lib/)")
+
+if(KHDETECTOR_WITH_ONNXRUNTIME AND NOT TARGET KhDetector::OnnxRuntime)
+    find_package(onnxruntime CONFIG QUIET)
+
+    if(TARGET onnxruntime::onnxruntime)
+        add_library(KhDetector::OnnxRuntime INTERFACE IMPORTED)
+        target_link_libraries(KhDetector::OnnxRuntime INTERFACE onnxruntime::onnxruntime)
+    else()
+        find_path(ONNXRUNTIME_INCLUDE_DIR onnxruntime_cxx_api.h
+            HINTS ${ONNXRUNTIME_ROOT}
+            PATH_SUFFIXES include include/onnxruntime include/onnxruntime/core/session)
+        find_library(ONNXRUNTIME_LIBRARY onnxruntime
+            HINTS ${ONNXRUNTIME_ROOT}
+            PATH_SUFFIXES lib)
+
+        if(ONNXRUNTIME_INCLUDE_DIR AND ONNXRUNTIME_LIBRARY)
+            add_library(KhDetector::OnnxRuntime UNKNOWN IMPORTED)
+            set_target_properties(KhDetector::OnnxRuntime PROPERTIES
+                IMPORTED_LOCATION "${ONNXRUNTIME_LIBRARY}"
+                INTERFACE_INCLUDE_DIRECTORIES "${ONNXRUNTIME_INCLUDE_DIR}")
+        endif()
+    endif()
+
+    if(TARGET KhDetector::OnnxRuntime)
+        set_property(TARGET KhDetector::OnnxRuntime APPEND PROPERTY
+            INTERFACE_COMPILE_DEFINITIONS KHDETECTOR_WITH_ONNXRUNTIME)
+        message(STATUS "ONNX Runtime: found, AiInference runs models")
+    else()
+        message(STATUS "ONNX Runtime: not found (set ONNXRUNTIME_ROOT), AiInference uses its heuristic fallback")
+    endif()
+endif()
+
+function(khdetector_use_onnxruntime target)
+    if(TARGET KhDetector::OnnxRuntime)
+        target_link_libraries(${target} PRIVATE KhDetector::OnnxRuntime)
+    endif()
+endfunction()
@@ -6,6 +6,7 @@
  * and RingBuffer to process stereo audio input into 20ms mono frames.
  */
 
+#include "../src/DspKernels.h"
 #include "../src/PolyphaseDecimator.h"
 #include "../src/RingBuffer.h"
 #include <iostream>
@@ -220,18 +221,8 @@ void demonstrateSIMDPerformance()
     std::cout << "- Real-time factor: " << std::fixed << std::setprecision(1) 
               << rtFactor << "x" << std::endl;
     
-    // SIMD architecture detection
-    std::cout << "- SIMD Support: ";
-#if defined(KHDETECTOR_USE_AVX)
-    std::cout << "AVX";
-#elif defined(KHDETECTOR_USE_SSE2)
-    std::cout << "SSE2/SSE4.1";
-#elif defined(KHDETECTOR_USE_NEON)
-    std::cout << "ARM NEON";
-#else
-    std::cout << "Scalar (no SIMD)";
-#endif
-    std::cout << std::endl;
+    // Kernel variant bound for this CPU at load time
+    std::cout << "- SIMD Support: " << getSimdLevelName(getDspKernels().level) << std::endl;
 }
 
 int main()
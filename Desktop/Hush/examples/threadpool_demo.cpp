@@ -5,10 +5,17 @@
 #include <vector>
 #include <atomic>
 #include <iomanip>
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <queue>
 
 #include "RealtimeThreadPool.h"
 #include "AiInference.h"
 #include "RingBuffer.h"
+#include "TaskScheduler.h"
 
 using namespace KhDetector;
 
@@ -243,12 +250,12 @@ private:
             auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(currentTime - lastMonitorTime);
             
             // Get thread pool statistics
-            auto threadPoolStats = mThreadPool->getStatistics();
+            const auto& threadPoolStats = mThreadPool->getStatistics();
             auto currentFrameCount = threadPoolStats.framesProcessed.load();
             auto frameRate = (currentFrameCount - lastFrameCount) / static_cast<double>(elapsed.count());
             
             // Get AI inference statistics
-            auto aiStats = mAiInference->getStatistics();
+            const auto& aiStats = mAiInference->getStatistics();
             
             // Print performance report
             std::cout << "\n--- Performance Report ---" << std::endl;
@@ -257,9 +264,9 @@ private:
             std::cout << "  Processing rate: " << std::fixed << std::setprecision(1) 
                       << frameRate << " frames/sec" << std::endl;
             std::cout << "  Average processing time: " << std::fixed << std::setprecision(3)
-                      << threadPoolStats.averageProcessingTimeMs.load() << " ms" << std::endl;
+                      << threadPoolStats.getAverageProcessingTimeMs() << " ms" << std::endl;
             std::cout << "  CPU usage: " << std::fixed << std::setprecision(1)
-                      << threadPoolStats.cpuUsagePercent.load() << "%" << std::endl;
+                      << mThreadPool->getCpuUsagePercent() << "%" << std::endl;
             std::cout << "  Dropped frames: " << threadPoolStats.droppedFrames.load() << std::endl;
             std::cout << "  Queue size: " << mThreadPool->getQueueSize() << std::endl;
             
@@ -270,9 +277,9 @@ private:
                          100.0 * aiStats.successfulInferences.load() / aiStats.totalInferences.load() : 0.0)
                       << "%" << std::endl;
             std::cout << "  Average confidence: " << std::fixed << std::setprecision(3)
-                      << aiStats.averageConfidence.load() << std::endl;
+                      << aiStats.getAverageConfidence() << std::endl;
             std::cout << "  Average inference time: " << std::fixed << std::setprecision(3)
-                      << aiStats.averageProcessingTimeMs.load() << " ms" << std::endl;
+                      << aiStats.getAverageProcessingTimeMs() << " ms" << std::endl;
             
             std::cout << "Ring Buffer:" << std::endl;
             std::cout << "  Current size: " << mRingBuffer->size() << " / " << mRingBuffer->capacity() << std::endl;
@@ -293,16 +300,16 @@ private:
     {
         std::cout << "\n=== Final Performance Statistics ===" << std::endl;
         
-        auto threadPoolStats = mThreadPool->getStatistics();
-        auto aiStats = mAiInference->getStatistics();
+        const auto& threadPoolStats = mThreadPool->getStatistics();
+        const auto& aiStats = mAiInference->getStatistics();
         
         std::cout << "Thread Pool Performance:" << std::endl;
         std::cout << "  Total frames processed: " << threadPoolStats.framesProcessed.load() << std::endl;
         std::cout << "  Total processing time: " << (threadPoolStats.totalProcessingTimeUs.load() / 1000.0) << " ms" << std::endl;
         std::cout << "  Average processing time: " << std::fixed << std::setprecision(3)
-                  << threadPoolStats.averageProcessingTimeMs.load() << " ms/frame" << std::endl;
+                  << threadPoolStats.getAverageProcessingTimeMs() << " ms/frame" << std::endl;
         std::cout << "  Peak CPU usage: " << std::fixed << std::setprecision(1)
-                  << threadPoolStats.cpuUsagePercent.load() << "%" << std::endl;
+                  << mThreadPool->getCpuUsagePercent() << "%" << std::endl;
         std::cout << "  Dropped frames: " << threadPoolStats.droppedFrames.load() << std::endl;
         
         if (threadPoolStats.framesProcessed.load() > 0) {
@@ -322,9 +329,9 @@ private:
         }
         
         std::cout << "  Average inference time: " << std::fixed << std::setprecision(3)
-                  << aiStats.averageProcessingTimeMs.load() << " ms" << std::endl;
+                  << aiStats.getAverageProcessingTimeMs() << " ms" << std::endl;
         std::cout << "  Average confidence: " << std::fixed << std::setprecision(3)
-                  << aiStats.averageConfidence.load() << std::endl;
+                  << aiStats.getAverageConfidence() << std::endl;
         
         std::cout << "\nAudio Generation:" << std::endl;
         std::cout << "  Total samples generated: " << mAudioSamplesGenerated.load() << std::endl;
@@ -334,12 +341,12 @@ private:
         std::cout << "\n=== Performance Evaluation ===" << std::endl;
         bool performanceGood = true;
         
-        if (threadPoolStats.averageProcessingTimeMs.load() > 15.0) {
+        if (threadPoolStats.getAverageProcessingTimeMs() > 15.0) {
             std::cout << "⚠️  High processing time detected" << std::endl;
             performanceGood = false;
         }
         
-        if (threadPoolStats.cpuUsagePercent.load() > 50.0) {
+        if (mThreadPool->getCpuUsagePercent() > 50.0) {
             std::cout << "⚠️  High CPU usage detected" << std::endl;
             performanceGood = false;
         }
@@ -357,15 +364,257 @@ private:
     }
 };
 
+/**
+ * @brief Task scheduling scenarios: the lock-free scheduler against the queue it replaced
+ * 
+ * Both sides run the same tasks on the same number of workers. The task
+ * captures 24 bytes, like a closure that carries a timestamp and a frame
+ * index, so std::function has to allocate where RealtimeTask does not.
+ */
+class TaskSchedulingBenchmark
+{
+public:
+    void run()
+    {
+        const int numWorkers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+        std::cout << "\n=== Task Scheduling Benchmark ===" << std::endl;
+        std::cout << "Worker threads: " << numWorkers << std::endl;
+        
+        std::cout << "\nBurst: " << kBurstTasks << " tiny tasks submitted back to back" << std::endl;
+        printThroughput("  mutex + std::function: ", measureThroughput<MutexTaskQueue>(numWorkers));
+        printThroughput("  work-stealing:         ", measureThroughput<LockFreeTaskQueue>(numWorkers));
+        
+        std::cout << "\nAudio-rate: one task every " << kPeriod.count() << " us, as an audio callback submits them" << std::endl;
+        printLatency("  mutex + std::function: ", measureLatency<MutexTaskQueue>(numWorkers));
+        printLatency("  work-stealing:         ", measureLatency<LockFreeTaskQueue>(numWorkers));
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr int kBurstTasks = 200000;
+    static constexpr int kPacedTasks = 2000;
+    static constexpr std::chrono::microseconds kPeriod{250};
+    
+    /**
+     * @brief The queue submitTask() used before: a mutex, a condition variable and std::function
+     */
+    class MutexTaskQueue
+    {
+    public:
+        explicit MutexTaskQueue(int numWorkers)
+        {
+            for (int i = 0; i < numWorkers; ++i) {
+                mThreads.emplace_back([this] {
+                    while (true) {
+                        std::function<void()> task;
+                        {
+                            std::unique_lock<std::mutex> lock(mMutex);
+                            mCondition.wait(lock, [this] { return mStop || !mQueue.empty(); });
+                            if (mStop) {
+                                return;
+                            }
+                            task = std::move(mQueue.front());
+                            mQueue.pop();
+                        }
+                        task();
+                    }
+                });
+            }
+        }
+        
+        ~MutexTaskQueue()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mStop = true;
+            }
+            mCondition.notify_all();
+            for (auto& thread : mThreads) {
+                thread.join();
+            }
+        }
+        
+        template<typename F>
+        bool submit(F&& function)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                if (mQueue.size() >= TaskScheduler::kCapacity) {
+                    return false;
+                }
+                mQueue.push(std::forward<F>(function));
+            }
+            mCondition.notify_one();
+            return true;
+        }
+        
+    private:
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        std::queue<std::function<void()>> mQueue;
+        bool mStop = false;
+        std::vector<std::thread> mThreads;
+    };
+    
+    /**
+     * @brief TaskScheduler with workers running it as RealtimeThreadPool does
+     */
+    class LockFreeTaskQueue
+    {
+    public:
+        explicit LockFreeTaskQueue(int numWorkers)
+            : mScheduler(numWorkers)
+        {
+            for (int i = 0; i < numWorkers; ++i) {
+                mThreads.emplace_back([this, i] {
+                    mScheduler.bindWorker(i);
+                    RealtimeTask task;
+                    while (!mStop.load()) {
+                        if (mScheduler.take(i, task)) {
+                            task();
+                            task.reset();
+                        } else {
+                            mScheduler.waitForWork();
+                        }
+                    }
+                });
+            }
+        }
+        
+        ~LockFreeTaskQueue()
+        {
+            mStop.store(true);
+            mScheduler.wakeAll();
+            for (auto& thread : mThreads) {
+                thread.join();
+            }
+        }
+        
+        template<typename F>
+        bool submit(F&& function) { return mScheduler.submit(RealtimeTask(std::forward<F>(function))); }
+        
+    private:
+        TaskScheduler mScheduler;
+        std::atomic<bool> mStop{false};
+        std::vector<std::thread> mThreads;
+    };
+    
+    struct Throughput
+    {
+        double tasksPerSecond = 0.0;
+        double submitNs = 0.0;          // Mean cost of a successful submit
+        int rejected = 0;               // Submissions turned down by a full queue, then retried
+    };
+    
+    struct Latency
+    {
+        double meanUs = 0.0;            // Submit to start of the task
+        double p99Us = 0.0;
+        double maxUs = 0.0;
+        double submitMeanNs = 0.0;      // Time the producer spends in submit
+        double submitMaxNs = 0.0;
+    };
+    
+    template<typename Queue>
+    Throughput measureThroughput(int numWorkers)
+    {
+        std::atomic<int> done{0};
+        Throughput result;
+        Clock::duration submitting{};
+        
+        Queue queue(numWorkers);
+        const auto start = Clock::now();
+        for (int i = 0; i < kBurstTasks; ++i) {
+            const auto submitStart = Clock::now();
+            const Clock::time_point stamp = submitStart;
+            while (!queue.submit([&done, stamp, i] { if (stamp.time_since_epoch().count() + i != 0) done.fetch_add(1, std::memory_order_relaxed); })) {
+                ++result.rejected;
+                std::this_thread::yield();
+            }
+            submitting += Clock::now() - submitStart;
+        }
+        while (done.load() < kBurstTasks) {
+            std::this_thread::yield();
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        
+        result.tasksPerSecond = kBurstTasks / seconds;
+        result.submitNs = std::chrono::duration<double, std::nano>(submitting).count() / kBurstTasks;
+        return result;
+    }
+    
+    template<typename Queue>
+    Latency measureLatency(int numWorkers)
+    {
+        std::vector<double> latenciesUs(kPacedTasks, 0.0);
+        std::vector<double> submitNs(kPacedTasks, 0.0);
+        std::atomic<int> done{0};
+        
+        {
+            Queue queue(numWorkers);
+            auto next = Clock::now();
+            for (int i = 0; i < kPacedTasks; ++i) {
+                next += kPeriod;
+                std::this_thread::sleep_until(next);
+                
+                double* latency = &latenciesUs[i];
+                const auto submitted = Clock::now();
+                const bool queued = queue.submit([latency, submitted, &done] {
+                    *latency = std::chrono::duration<double, std::micro>(Clock::now() - submitted).count();
+                    done.fetch_add(1, std::memory_order_release);
+                });
+                submitNs[i] = std::chrono::duration<double, std::nano>(Clock::now() - submitted).count();
+                if (!queued) {
+                    done.fetch_add(1, std::memory_order_release);   // Not expected at this rate
+                }
+            }
+            while (done.load(std::memory_order_acquire) < kPacedTasks) {
+                std::this_thread::yield();
+            }
+        }
+        
+        Latency result;
+        for (int i = 0; i < kPacedTasks; ++i) {
+            result.meanUs += latenciesUs[i] / kPacedTasks;
+            result.submitMeanNs += submitNs[i] / kPacedTasks;
+            result.submitMaxNs = std::max(result.submitMaxNs, submitNs[i]);
+        }
+        std::sort(latenciesUs.begin(), latenciesUs.end());
+        result.p99Us = latenciesUs[kPacedTasks * 99 / 100];
+        result.maxUs = latenciesUs.back();
+        return result;
+    }
+    
+    static void printThroughput(const char* name, const Throughput& result)
+    {
+        std::cout << name << std::fixed << std::setprecision(0) << result.tasksPerSecond << " tasks/s, submit "
+                  << std::setprecision(1) << result.submitNs << " ns, " << result.rejected << " retries on a full queue"
+                  << std::endl;
+    }
+    
+    static void printLatency(const char* name, const Latency& result)
+    {
+        std::cout << name << std::fixed << std::setprecision(1) << "start after mean " << result.meanUs << " us, p99 "
+                  << result.p99Us << " us, max " << result.maxUs << " us; submit mean " << result.submitMeanNs
+                  << " ns, max " << result.submitMaxNs << " ns" << std::endl;
+    }
+};
+
 int main(int argc, char* argv[])
 {
     try {
         int duration = 10; // Default duration
         
+        if (argc > 1 && std::strcmp(argv[1], "--tasks") == 0) {
+            TaskSchedulingBenchmark benchmark;
+            benchmark.run();
+            return 0;
+        }
+        
         if (argc > 1) {
             duration = std::atoi(argv[1]);
             if (duration <= 0 || duration > 300) {
-                std::cout << "Duration must be between 1 and 300 seconds" << std::endl;
+                std::cout << "Duration must be between 1 and 300 seconds (or --tasks for the task scheduling benchmark)" << std::endl;
                 return 1;
             }
         }
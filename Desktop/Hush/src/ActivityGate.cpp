@@ -0,0 +1,101 @@
+#include "ActivityGate.h"
+#include "DspKernels.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace KhDetector {
+
+double ActivityGate::Statistics::getOpenRatio() const
+{
+    const uint64_t open = activeFrames.load() + heldFrames.load();
+    const uint64_t total = open + closedFrames.load();
+    return total > 0 ? static_cast<double>(open) / static_cast<double>(total) : 0.0;
+}
+
+ActivityGate::ActivityGate(const Config& config)
+    : mConfig(config)
+{
+}
+
+bool ActivityGate::process(const float* samples, int numSamples)
+{
+    if (isActive(measure(samples, numSamples))) {
+        mHangover = std::max(0, mConfig.hangoverFrames) + 1;
+        mStats.activeFrames.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    if (mHangover > 1) {
+        --mHangover;
+        mStats.heldFrames.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    mHangover = 0;
+    mStats.closedFrames.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void ActivityGate::reset()
+{
+    mHangover = 0;
+}
+
+void ActivityGate::setConfig(const Config& config)
+{
+    mConfig = config;
+    reset();
+}
+
+void ActivityGate::resetStatistics()
+{
+    mStats.activeFrames.store(0);
+    mStats.heldFrames.store(0);
+    mStats.closedFrames.store(0);
+}
+
+ActivityGate::FrameMeasures ActivityGate::measure(const float* samples, int numSamples)
+{
+    FrameMeasures measures;
+    if (!samples || numSamples <= 0) {
+        return measures;
+    }
+
+    const DspKernels& kernels = getDspKernels();
+    FrameFeatures sums;
+    kernels.frameFeatures(samples, numSamples, sums);
+
+    const float meanSquare = sums.sumSquares / static_cast<float>(numSamples);
+    measures.levelDb = 10.0f * std::log10(std::max(meanSquare, 1e-20f));
+    measures.zeroCrossingRate = sums.zeroCrossings / static_cast<float>(numSamples);
+
+    // 0.5 (1 - r1 / r0) is the mean of sin^2(w / 2) weighted by the power spectrum
+    if (sums.sumSquares >= FLT_MIN && numSamples > 1) {
+        const float lag1 = kernels.dotProduct(samples, samples + 1, numSamples - 1);
+        measures.highBandRatio = std::clamp(0.5f * (1.0f - lag1 / sums.sumSquares), 0.0f, 1.0f);
+    }
+    return measures;
+}
+
+bool ActivityGate::isActive(const FrameMeasures& measures) const
+{
+    return measures.levelDb >= mConfig.minLevelDb
+        && (measures.zeroCrossingRate >= mConfig.minZeroCrossingRate
+            || measures.highBandRatio >= mConfig.minHighBandRatio);
+}
+
+float ActivityGate::fricativeConfidence(const float* samples, int numSamples, const Config& config)
+{
+    constexpr float kFricativeCrossingRate = 0.4f;      // Crossings per sample of a clear "s" at 16 kHz
+
+    const FrameMeasures measures = measure(samples, numSamples);
+    if (measures.levelDb < config.minLevelDb) {
+        return 0.0f;
+    }
+    return std::clamp((measures.zeroCrossingRate - config.minZeroCrossingRate)
+                      / (kFricativeCrossingRate - config.minZeroCrossingRate), 0.0f, 1.0f);
+}
+
+} // namespace KhDetector
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace KhDetector {
+
+/**
+ * @brief Cheap front gate that keeps silence and voiced-only frames from the model
+ *
+ * Most of a dialogue track is silence, room tone or vowels, none of which can
+ * hold the fricative the model looks for. Each frame is measured with two
+ * SIMD passes (DspKernels::frameFeatures() and a lag-1 dotProduct()) for:
+ *
+ * - its RMS level in dBFS,
+ * - its zero crossing rate (crossings per sample),
+ * - its high-band ratio, 0.5 (1 - r1 / r0) from the lag-0 and lag-1
+ *   autocorrelation: the power-weighted mean of sin^2(w / 2) over the
+ *   spectrum, so 0 for DC, 0.5 for white noise and 1 at Nyquist.
+ *
+ * A frame is active when it is loud enough and either its zero crossing
+ * rate or its high-band ratio says it carries noise-like, high-frequency
+ * energy. The gate opens on the active frame itself, so it adds no latency,
+ * and stays open for hangoverFrames after the last active one so the model
+ * (and the post-processor's median window) sees the whole of a fricative
+ * whose tail drops below the thresholds. process() never allocates.
+ */
+class ActivityGate
+{
+public:
+    struct Config
+    {
+        float minLevelDb = -50.0f;          // Quieter frames are silence or room tone
+        float minZeroCrossingRate = 0.1f;   // Crossings per sample (0.1 is a 800 Hz tone at 16 kHz)
+        float minHighBandRatio = 0.05f;     // 0.05 is a 1.2 kHz tone at 16 kHz
+        int hangoverFrames = 10;            // Frames held open after the last active frame
+    };
+
+    /**
+     * @brief Measurements of one frame
+     */
+    struct FrameMeasures
+    {
+        float levelDb = -200.0f;
+        float zeroCrossingRate = 0.0f;
+        float highBandRatio = 0.0f;
+    };
+
+    /**
+     * @brief Gate counters, readable from any thread
+     */
+    struct Statistics
+    {
+        std::atomic<uint64_t> activeFrames{0};  // Open because the frame itself was active
+        std::atomic<uint64_t> heldFrames{0};    // Open during the hangover
+        std::atomic<uint64_t> closedFrames{0};
+
+        /**
+         * @brief Share of frames the gate let through (0 before any frame)
+         */
+        double getOpenRatio() const;
+    };
+
+    ActivityGate() : ActivityGate(Config()) {}
+    explicit ActivityGate(const Config& config);
+
+    /**
+     * @brief Measure a frame and decide whether it goes to the model
+     *
+     * @return true if the gate is open for this frame
+     */
+    bool process(const float* samples, int numSamples);
+
+    /**
+     * @brief Whether the last processed frame was let through
+     */
+    bool isOpen() const { return mHangover > 0; }
+
+    /**
+     * @brief Close the gate and clear the hangover (statistics are kept)
+     */
+    void reset();
+
+    void setConfig(const Config& config);
+    const Config& getConfig() const { return mConfig; }
+
+    const Statistics& getStatistics() const { return mStats; }
+    void resetStatistics();
+
+    /**
+     * @brief Level, zero crossing rate and high-band ratio of a frame
+     */
+    static FrameMeasures measure(const float* samples, int numSamples);
+
+    /**
+     * @brief Whether measured values pass the configured thresholds
+     */
+    bool isActive(const FrameMeasures& measures) const;
+
+    /**
+     * @brief Detection probability from frame measures alone, for frames no model scores
+     *
+     * Fricatives are noise-like: loud enough and with a crossing rate well
+     * above voiced speech. Coarse next to the model, but deterministic and
+     * two SIMD passes per frame. 0 below config.minLevelDb, rising linearly
+     * from config.minZeroCrossingRate to 1 at the crossing rate of a clear
+     * "s" at 16 kHz.
+     */
+    static float fricativeConfidence(const float* samples, int numSamples, const Config& config);
+
+private:
+    Config mConfig;
+    int mHangover = 0;      // Frames the gate stays open for, counting the current one
+    Statistics mStats;
+};
+
+} // namespace KhDetector
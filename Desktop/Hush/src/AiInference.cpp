@@ -1,10 +1,22 @@
 #include "AiInference.h"
+#include "DspKernels.h"
+#include "MlpModel.h"
+#include "ModelRegistry.h"
+#include "OnnxBackend.h"
 #include <random>
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <fstream>
 #include <functional>
 #include <iostream>
 
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <dlfcn.h>
+#endif
+
 namespace KhDetector {
 
 AiInference::AiInference(const ModelConfig& config)
@@ -38,12 +50,39 @@ bool AiInference::initialize(const ModelConfig& config)
         return true;
     }
     
+    if (config.outputSize > InferenceResult::kMaxPredictions) {
+        std::cerr << "AiInference: " << config.outputSize << " outputs configured, at most "
+                  << InferenceResult::kMaxPredictions << " supported" << std::endl;
+        return false;
+    }
+    
+    const std::string loadedModelPath = mConfig.modelPath;
     mConfig = config;
     
+    // Load the configured model, or keep one loaded earlier with loadModel()
+    if (!config.modelPath.empty()) {
+        if (!loadModel(config.modelPath)) {
+            return false;
+        }
+    } else if (mNativeModel || mBackend) {
+        const int modelInputs = mNativeModel ? mNativeModel->getInputSize() : mBackend->getInputSize();
+        if (modelInputs != config.inputSize) {
+            std::cerr << "AiInference: Loaded model expects " << modelInputs
+                      << " inputs per frame, configured for " << config.inputSize << std::endl;
+            return false;
+        }
+        mConfig.modelPath = loadedModelPath;
+        mConfig.outputSize = mNativeModel ? mNativeModel->getOutputSize() : mBackend->getOutputSize();
+    }
+    
     // Resize buffers
-    mInputBuffer.resize(config.inputSize);
-    mOutputBuffer.resize(config.outputSize);
-    mNormalizedInput.resize(config.inputSize);
+    mInputBuffer.resize(mConfig.inputSize);
+    mOutputBuffer.resize(mConfig.outputSize);
+    mNormalizedInput.resize(mConfig.inputSize);
+    
+    if (mBackend && !bindBackend(mNormalizedInput.data(), mOutputBuffer.data(), 1)) {
+        return false;
+    }
     
     // Set default normalization if not provided
     if (mConfig.normalizationMean.empty()) {
@@ -60,13 +99,17 @@ bool AiInference::initialize(const ModelConfig& config)
         mPostProcessor = createPostProcessor(config.confidenceThreshold, 5);
     }
     
-    // Simulate initialization time
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (config.useActivityGate) {
+        mActivityGate = std::make_unique<ActivityGate>(config.activityGate);
+    } else {
+        mActivityGate.reset();
+    }
+    mGateWasOpen = true;
     
     mInitialized.store(true);
     
-    std::cout << "AiInference: Initialized with input size " << config.inputSize 
-              << ", output size " << config.outputSize 
+    std::cout << "AiInference: Initialized with input size " << mConfig.inputSize 
+              << ", output size " << mConfig.outputSize 
               << ", sample rate " << config.sampleRate << " Hz" << std::endl;
     
     return true;
@@ -74,47 +117,131 @@ bool AiInference::initialize(const ModelConfig& config)
 
 bool AiInference::loadModel(const std::string& modelPath)
 {
+    const std::string nativeExtension = ".khmlp";
+    const bool native = modelPath.size() > nativeExtension.size()
+        && modelPath.compare(modelPath.size() - nativeExtension.size(), nativeExtension.size(), nativeExtension) == 0;
+    
+    int modelInputs = 0;
+    int modelOutputs = 0;
+    std::unique_ptr<MlpModel> nativeModel;
+    std::unique_ptr<OnnxBackend> backend;
+    if (native) {
+        // Weights are mapped once per process and shared by every engine running this file
+        nativeModel = std::make_unique<MlpModel>();
+        if (!nativeModel->setWeights(ModelRegistry::getShared().acquire(modelPath))) {
+            return false;
+        }
+        modelInputs = nativeModel->getInputSize();
+        modelOutputs = nativeModel->getOutputSize();
+    } else {
+        backend = std::make_unique<OnnxBackend>();
+        if (!backend->load(modelPath, mConfig.numThreads)) {
+            return false;
+        }
+        modelInputs = backend->getInputSize();
+        modelOutputs = backend->getOutputSize();
+    }
+    
+    if (modelInputs != mConfig.inputSize) {
+        std::cerr << "AiInference: Model " << modelPath << " expects " << modelInputs
+                  << " inputs per frame, configured for " << mConfig.inputSize << std::endl;
+        return false;
+    }
+    if (modelOutputs > InferenceResult::kMaxPredictions) {
+        std::cerr << "AiInference: Model " << modelPath << " has " << modelOutputs << " outputs, at most "
+                  << InferenceResult::kMaxPredictions << " supported" << std::endl;
+        return false;
+    }
+    
+    mNativeModel = std::move(nativeModel);
+    mBackend = std::move(backend);
+    mBoundInput = nullptr;
+    mBoundOutput = nullptr;
+    mBoundFrames = 0;
     mConfig.modelPath = modelPath;
+    mConfig.outputSize = modelOutputs;
+    mPositiveClass = mConfig.outputSize == 2 ? 1 : -1;
     
-    // Simulate model loading time
-    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    // Before initialize() the buffers are sized (and bound) there
+    if (mInitialized.load()) {
+        mOutputBuffer.resize(mConfig.outputSize);
+        if (mBackend && !bindBackend(mNormalizedInput.data(), mOutputBuffer.data(), 1)) {
+            return false;
+        }
+    }
     
-    std::cout << "AiInference: Loaded model from " << modelPath << std::endl;
+    std::cout << "AiInference: Loaded " << (native ? "native " : "") << "model from " << modelPath << std::endl;
     return true;
 }
 
 AiInference::InferenceResult AiInference::run(const float* audioData, int numSamples)
 {
     InferenceResult result;
+    result.frameIndex = mNextFrameIndex++;
     auto startTime = std::chrono::high_resolution_clock::now();
     
-    if (!mInitialized.load() || !audioData || numSamples <= 0) {
+    if (!mInitialized.load() || !audioData || numSamples != mConfig.inputSize) {
+        mStats.rejectedFrames.fetch_add(1);
         result.success = false;
         return result;
     }
     
-    if (numSamples != mConfig.inputSize) {
-        std::cerr << "AiInference: Input size mismatch. Expected " << mConfig.inputSize 
-                  << ", got " << numSamples << std::endl;
-        result.success = false;
+    // Per-stage latency, when a monitor is attached
+    LatencyMonitor* monitor = mLatencyMonitor.get();
+    auto stageStart = monitor ? LatencyMonitor::Clock::now() : LatencyMonitor::Clock::time_point();
+    const auto endStage = [&](LatencyStage stage) {
+        if (monitor) {
+            const auto now = LatencyMonitor::Clock::now();
+            monitor->record(stage, now - stageStart);
+            stageStart = now;
+        }
+    };
+    
+    if (mActivityGate && !mActivityGate->process(audioData, numSamples)) {
+        // Nothing the model could detect: the post-processor sees zero confidence
+        endStage(LatencyStage::FeatureExtraction);
+        mGateWasOpen = false;
+        result.gated = true;
+        result.success = true;
+        postprocessConfidence(0.0f, result);
+        endStage(LatencyStage::PostProcessing);
+        result.processingTime = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - startTime);
+        mStats.gatedFrames.fetch_add(1);
+        
+        if (mCallback) {
+            mCallback(result, mCallbackContext);
+        }
         return result;
     }
     
+    if (!mGateWasOpen) {
+        // Audio resumes after a gap the model did not see
+        mGateWasOpen = true;
+        if (mNativeModel) {
+            mNativeModel->resetState(0);
+        }
+    }
+    
     try {
         // Normalize input
         normalizeInput(audioData, numSamples, mNormalizedInput.data());
+        endStage(LatencyStage::FeatureExtraction);
         
         // Run inference
         bool inferenceSuccess = runInferenceInternal(
             mNormalizedInput.data(), 
             numSamples, 
             mOutputBuffer.data(), 
-            mConfig.outputSize
+            mConfig.outputSize,
+            1
         );
+        endStage(LatencyStage::Inference);
         
         if (inferenceSuccess) {
             // Post-process output
             postprocessOutput(mOutputBuffer.data(), mConfig.outputSize, result);
+            endStage(LatencyStage::PostProcessing);
             result.success = true;
         } else {
             result.success = false;
@@ -132,11 +259,7 @@ AiInference::InferenceResult AiInference::run(const float* audioData, int numSam
     
     // Call callback if set
     if (mCallback && result.success) {
-        try {
-            mCallback(result);
-        } catch (const std::exception& e) {
-            std::cerr << "AiInference: Callback exception: " << e.what() << std::endl;
-        }
+        mCallback(result, mCallbackContext);
     }
     
     return result;
@@ -147,19 +270,232 @@ AiInference::InferenceResult AiInference::run(const std::vector<float>& audioFra
     return run(audioFrame.data(), static_cast<int>(audioFrame.size()));
 }
 
+bool AiInference::runBatch(const float* frames, int numFrames, InferenceResult* results)
+{
+    if (!results || numFrames <= 0) {
+        return false;
+    }
+    
+    auto startTime = std::chrono::high_resolution_clock::now();
+    bool success = mInitialized.load() && frames;
+    
+    for (int frame = 0; frame < numFrames; ++frame) {
+        results[frame] = InferenceResult();
+    }
+    
+    if (success) {
+        const size_t inputSize = static_cast<size_t>(numFrames) * mConfig.inputSize;
+        const size_t outputSize = static_cast<size_t>(numFrames) * mConfig.outputSize;
+        if (mBatchInput.size() < inputSize) {
+            mBatchInput.resize(inputSize);
+        }
+        if (mBatchOutput.size() < outputSize) {
+            mBatchOutput.resize(outputSize);
+        }
+        
+        // A streaming model restarts after a gap the gate kept from it, so
+        // its open frames run in one call per stretch between gaps
+        const bool streaming = isStreaming();
+        int numOpen = 0;
+        int segmentStart = 0;
+        const auto runSegment = [&](int end) {
+            if (success && end > segmentStart) {
+                const size_t offset = static_cast<size_t>(segmentStart);
+                success = runInferenceInternal(mBatchInput.data() + offset * mConfig.inputSize, mConfig.inputSize,
+                                               mBatchOutput.data() + offset * mConfig.outputSize,
+                                               mConfig.outputSize, end - segmentStart);
+            }
+            segmentStart = end;
+        };
+        
+        try {
+            // Gate the frames in order and pack the open ones for the model
+            for (int frame = 0; frame < numFrames; ++frame) {
+                const float* samples = frames + static_cast<size_t>(frame) * mConfig.inputSize;
+                if (mActivityGate && !mActivityGate->process(samples, mConfig.inputSize)) {
+                    mGateWasOpen = false;
+                    results[frame].gated = true;
+                    continue;
+                }
+                if (!mGateWasOpen) {
+                    mGateWasOpen = true;
+                    if (streaming) {
+                        runSegment(numOpen);
+                        mNativeModel->resetState(0);
+                    }
+                }
+                normalizeInput(samples, mConfig.inputSize,
+                               mBatchInput.data() + static_cast<size_t>(numOpen) * mConfig.inputSize);
+                ++numOpen;
+            }
+            runSegment(numOpen);
+        } catch (const std::exception& e) {
+            std::cerr << "AiInference: Exception during batch inference: " << e.what() << std::endl;
+            success = false;
+        }
+    }
+    
+    auto endTime = std::chrono::high_resolution_clock::now();
+    const auto frameTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime) / numFrames;
+    
+    // Post-processing is stateful (median filter, hit hysteresis), so frames go through it in order
+    int openFrame = 0;
+    for (int frame = 0; frame < numFrames; ++frame) {
+        InferenceResult& result = results[frame];
+        result.frameIndex = mNextFrameIndex++;
+        result.processingTime = frameTime;
+        
+        if (result.gated) {
+            // As in run(): zero confidence for the post-processor, counted apart from inferences
+            result.success = true;
+            postprocessConfidence(0.0f, result);
+            mStats.gatedFrames.fetch_add(1);
+        } else {
+            if (success) {
+                postprocessOutput(mBatchOutput.data() + static_cast<size_t>(openFrame) * mConfig.outputSize,
+                                  mConfig.outputSize, result);
+            }
+            ++openFrame;
+            result.success = success;
+            updateStatistics(result);
+        }
+        
+        if (mCallback && result.success) {
+            mCallback(result, mCallbackContext);
+        }
+    }
+    
+    return success;
+}
+
+bool AiInference::isStreaming() const
+{
+    return mNativeModel && mNativeModel->isStateful();
+}
+
+void AiInference::resetState()
+{
+    if (mNativeModel) {
+        mNativeModel->resetState();
+    }
+    if (mActivityGate) {
+        mActivityGate->reset();
+    }
+    mGateWasOpen = true;
+}
+
+int AiInference::getStateSize() const
+{
+    return mNativeModel ? mNativeModel->getStateSize() : 0;
+}
+
+bool AiInference::saveState(float* state, int stream) const
+{
+    if (!state || stream < 0 || stream >= getNumStreams()) {
+        return false;
+    }
+    if (mNativeModel) {
+        mNativeModel->saveState(stream, state);
+    }
+    return true;
+}
+
+bool AiInference::restoreState(const float* state, int stream)
+{
+    if (!state || stream < 0 || stream >= getNumStreams()) {
+        return false;
+    }
+    if (mNativeModel) {
+        mNativeModel->restoreState(stream, state);
+    }
+    return true;
+}
+
+bool AiInference::setNumStreams(int numStreams)
+{
+    if (numStreams <= 0) {
+        return false;
+    }
+    if (mNativeModel) {
+        mNativeModel->setNumStreams(numStreams);
+    }
+    return true;
+}
+
+int AiInference::getNumStreams() const
+{
+    return mNativeModel ? mNativeModel->getNumStreams() : 1;
+}
+
+bool AiInference::runStreams(const float* hops, int numStreams, InferenceResult* results)
+{
+    if (!results || numStreams <= 0) {
+        return false;
+    }
+    
+    auto startTime = std::chrono::high_resolution_clock::now();
+    bool success = mInitialized.load() && hops && (!isStreaming() || numStreams <= getNumStreams());
+    
+    if (success) {
+        const size_t inputSize = static_cast<size_t>(numStreams) * mConfig.inputSize;
+        const size_t outputSize = static_cast<size_t>(numStreams) * mConfig.outputSize;
+        if (mBatchInput.size() < inputSize) {
+            mBatchInput.resize(inputSize);
+        }
+        if (mBatchOutput.size() < outputSize) {
+            mBatchOutput.resize(outputSize);
+        }
+        
+        normalizeInput(hops, static_cast<int>(inputSize), mBatchInput.data());
+        if (mNativeModel) {
+            mNativeModel->runStreams(mBatchInput.data(), numStreams, mBatchOutput.data());
+            logitsToProbabilities(mBatchOutput.data(), mConfig.outputSize, numStreams);
+        } else {
+            // Stateless models treat the hops as independent frames
+            success = runInferenceInternal(mBatchInput.data(), mConfig.inputSize, mBatchOutput.data(),
+                                           mConfig.outputSize, numStreams);
+        }
+    }
+    
+    auto endTime = std::chrono::high_resolution_clock::now();
+    const auto streamTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime) / numStreams;
+    const uint64_t frameIndex = mNextFrameIndex++;
+    
+    for (int stream = 0; stream < numStreams; ++stream) {
+        InferenceResult& result = results[stream];
+        result = InferenceResult();
+        result.frameIndex = frameIndex;
+        if (success) {
+            const float* output = mBatchOutput.data() + static_cast<size_t>(stream) * mConfig.outputSize;
+            result.numPredictions = std::min(mConfig.outputSize, InferenceResult::kMaxPredictions);
+            std::copy(output, output + result.numPredictions, result.predictions.begin());
+            result.confidence = getRawConfidence(output, mConfig.outputSize);
+            result.label = result.confidence > mConfig.confidenceThreshold ? Label::Detected : Label::NotDetected;
+        }
+        result.success = success;
+        result.processingTime = streamTime;
+        
+        updateStatistics(result);
+    }
+    
+    return success;
+}
+
 void AiInference::resetStatistics()
 {
     mStats.totalInferences.store(0);
     mStats.successfulInferences.store(0);
     mStats.failedInferences.store(0);
+    mStats.rejectedFrames.store(0);
+    mStats.gatedFrames.store(0);
     mStats.totalProcessingTimeUs.store(0);
-    mStats.averageProcessingTimeMs.store(0.0);
-    mStats.averageConfidence.store(0.0);
+    mStats.confidenceSumPpm.store(0);
 }
 
-void AiInference::setInferenceCallback(InferenceCallback callback)
+void AiInference::setInferenceCallback(InferenceCallback callback, void* context)
 {
-    mCallback = std::move(callback);
+    mCallback = callback;
+    mCallbackContext = context;
 }
 
 void AiInference::warmup(int numWarmupRuns)
@@ -174,9 +510,8 @@ void AiInference::warmup(int numWarmupRuns)
     // Create dummy audio data
     std::vector<float> dummyAudio(mConfig.inputSize, 0.0f);
     
-    // Generate some realistic audio-like data
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    // Generate some realistic audio-like data, the same on every run
+    std::mt19937 gen(1);
     std::normal_distribution<float> dist(0.0f, 0.1f);
     
     for (int i = 0; i < mConfig.inputSize; ++i) {
@@ -200,40 +535,60 @@ void AiInference::normalizeInput(const float* input, int numSamples, float* outp
     float mean = mConfig.normalizationMean.empty() ? 0.0f : mConfig.normalizationMean[0];
     float std = mConfig.normalizationStd.empty() ? 1.0f : mConfig.normalizationStd[0];
     
-    for (int i = 0; i < numSamples; ++i) {
-        output[i] = (input[i] - mean) / std;
-    }
+    getDspKernels().normalize(input, output, numSamples, mean, 1.0f / std);
 }
 
 void AiInference::postprocessOutput(const float* output, int numOutputs, InferenceResult& result)
 {
-    result.predictions.resize(numOutputs);
-    std::copy(output, output + numOutputs, result.predictions.begin());
-    
-    // Calculate raw confidence as the maximum output value (assuming softmax-like output)
-    float rawConfidence = 0.0f;
-    if (numOutputs > 0) {
-        rawConfidence = *std::max_element(output, output + numOutputs);
-        rawConfidence = std::clamp(rawConfidence, 0.0f, 1.0f);
-    }
+    result.numPredictions = std::min(numOutputs, InferenceResult::kMaxPredictions);
+    std::copy(output, output + result.numPredictions, result.predictions.begin());
     
+    postprocessConfidence(getRawConfidence(output, numOutputs), result);
+}
+
+void AiInference::postprocessConfidence(float rawConfidence, InferenceResult& result)
+{
     // Apply post-processing (median filtering + threshold detection)
     if (mPostProcessor) {
         result.confidence = mPostProcessor->processConfidence(rawConfidence);
         
         // Generate classification based on hit detection
-        if (mPostProcessor->hasHit()) {
-            result.classification = "detected";
-        } else {
-            result.classification = "not_detected";
-        }
+        result.label = mPostProcessor->hasHit() ? Label::Detected : Label::NotDetected;
     } else {
         // Fallback to raw confidence if no post-processor
         result.confidence = rawConfidence;
-        if (result.confidence > mConfig.confidenceThreshold) {
-            result.classification = "detected";
-        } else {
-            result.classification = "not_detected";
+        result.label = result.confidence > mConfig.confidenceThreshold ? Label::Detected : Label::NotDetected;
+    }
+}
+
+float AiInference::getRawConfidence(const float* output, int numOutputs) const
+{
+    // Raw confidence is the detection class probability, or the maximum
+    // output value (assuming softmax-like output)
+    if (mPositiveClass >= 0 && mPositiveClass < numOutputs) {
+        return output[mPositiveClass];
+    }
+    if (numOutputs > 0) {
+        return std::clamp(*std::max_element(output, output + numOutputs), 0.0f, 1.0f);
+    }
+    return 0.0f;
+}
+
+void AiInference::logitsToProbabilities(float* output, int outputSize, int numFrames) const
+{
+    if (mPositiveClass < 0) {
+        return;
+    }
+    for (int frame = 0; frame < numFrames; ++frame) {
+        float* logits = output + static_cast<size_t>(frame) * outputSize;
+        const float maxLogit = *std::max_element(logits, logits + outputSize);
+        float sum = 0.0f;
+        for (int i = 0; i < outputSize; ++i) {
+            logits[i] = std::exp(logits[i] - maxLogit);
+            sum += logits[i];
+        }
+        for (int i = 0; i < outputSize; ++i) {
+            logits[i] /= sum;
         }
     }
 }
@@ -244,52 +599,37 @@ void AiInference::updateStatistics(const InferenceResult& result)
     
     if (result.success) {
         mStats.successfulInferences.fetch_add(1);
-        
-        // Update average confidence
-        auto totalSuccessful = mStats.successfulInferences.load();
-        if (totalSuccessful > 0) {
-            double currentAvg = mStats.averageConfidence.load();
-            double newAvg = currentAvg + (result.confidence - currentAvg) / totalSuccessful;
-            mStats.averageConfidence.store(newAvg);
-        }
+        mStats.confidenceSumPpm.fetch_add(static_cast<uint64_t>(std::lround(std::clamp(result.confidence, 0.0f, 1.0f) * 1e6f)));
     } else {
         mStats.failedInferences.fetch_add(1);
     }
     
-    // Update processing time statistics
-    auto totalTime = mStats.totalProcessingTimeUs.fetch_add(result.processingTime.count()) 
-                     + result.processingTime.count();
-    auto totalInferences = mStats.totalInferences.load();
-    
-    if (totalInferences > 0) {
-        double avgTimeMs = static_cast<double>(totalTime) / (totalInferences * 1000.0);
-        mStats.averageProcessingTimeMs.store(avgTimeMs);
-    }
+    mStats.totalProcessingTimeUs.fetch_add(static_cast<uint64_t>(result.processingTime.count()));
 }
 
-bool AiInference::runInferenceInternal(const float* input, int inputSize, float* output, int outputSize)
+bool AiInference::runInferenceInternal(float* input, int inputSize, float* output, int outputSize, int numFrames)
 {
-    // This is a stub implementation that generates realistic dummy results
-    // In a real implementation, this would call actual ML framework APIs
-    
-    // Simulate some processing time
-    if (mConfig.useGpu && mGpuAvailable) {
-        // GPU inference is typically faster but has some overhead
-        std::this_thread::sleep_for(std::chrono::microseconds(100));
-    } else {
-        // CPU inference
-        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    if (mNativeModel || mBackend) {
+        if (mNativeModel) {
+            mNativeModel->runBatch(input, numFrames, output);
+        } else if (!bindBackend(input, output, numFrames) || !mBackend->run()) {
+            return false;
+        }
+        
+        logitsToProbabilities(output, outputSize, numFrames);
+        return true;
     }
     
-    // Generate realistic output based on input characteristics
-    float inputEnergy = 0.0f;
-    for (int i = 0; i < inputSize; ++i) {
-        inputEnergy += input[i] * input[i];
+    if (numFrames > 1) {
+        for (int frame = 0; frame < numFrames; ++frame) {
+            runInferenceInternal(input + static_cast<size_t>(frame) * inputSize, inputSize,
+                                 output + static_cast<size_t>(frame) * outputSize, outputSize, 1);
+        }
+        return true;
     }
-    inputEnergy = std::sqrt(inputEnergy / inputSize);
     
-    // Generate output based on input energy and some random factors
-    float baseResult = generateTestResult(input, inputSize);
+    // Without a model, score the frame with the deterministic fricative heuristic
+    const float baseResult = ActivityGate::fricativeConfidence(input, inputSize, mConfig.activityGate);
     
     for (int i = 0; i < outputSize; ++i) {
         // Each output represents a different class probability
@@ -306,6 +646,24 @@ bool AiInference::runInferenceInternal(const float* input, int inputSize, float*
     return true;
 }
 
+bool AiInference::bindBackend(float* input, float* output, int numFrames)
+{
+    if (input == mBoundInput && output == mBoundOutput && numFrames == mBoundFrames) {
+        return true;
+    }
+    
+    if (!mBackend->bind(input, output, numFrames)) {
+        mBoundInput = nullptr;
+        mBoundOutput = nullptr;
+        mBoundFrames = 0;
+        return false;
+    }
+    mBoundInput = input;
+    mBoundOutput = output;
+    mBoundFrames = numFrames;
+    return true;
+}
+
 void AiInference::detectHardwareCapabilities()
 {
     // Stub implementation - in reality would check for CUDA, OpenCL, etc.
@@ -329,67 +687,70 @@ void AiInference::detectHardwareCapabilities()
               << (mGpuAvailable.load() ? "available" : "not available") << std::endl;
 }
 
-float AiInference::generateTestResult(const float* audioData, int numSamples)
+namespace {
+
+/**
+ * @brief Directory of the binary this code is linked into (the plugin, not the host)
+ */
+std::string getModuleDirectory()
 {
-    // Generate a realistic test result based on audio characteristics
-    
-    // Calculate some basic audio features
-    float rms = 0.0f;
-    float zcr = 0.0f; // Zero crossing rate
-    float spectralCentroid = 0.0f;
-    
-    // RMS (energy)
-    for (int i = 0; i < numSamples; ++i) {
-        rms += audioData[i] * audioData[i];
-    }
-    rms = std::sqrt(rms / numSamples);
-    
-    // Zero crossing rate
-    for (int i = 1; i < numSamples; ++i) {
-        if ((audioData[i] >= 0.0f) != (audioData[i-1] >= 0.0f)) {
-            zcr += 1.0f;
+    std::string path;
+#ifdef _WIN32
+    HMODULE module = nullptr;
+    if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                           reinterpret_cast<LPCSTR>(&getModuleDirectory), &module)) {
+        char buffer[MAX_PATH];
+        const DWORD length = GetModuleFileNameA(module, buffer, MAX_PATH);
+        if (length > 0 && length < MAX_PATH) {
+            path.assign(buffer, length);
         }
     }
-    zcr /= (numSamples - 1);
-    
-    // Simple spectral centroid approximation
-    float sumMagnitude = 0.0f;
-    float weightedSum = 0.0f;
-    for (int i = 0; i < numSamples; ++i) {
-        float magnitude = std::abs(audioData[i]);
-        sumMagnitude += magnitude;
-        weightedSum += magnitude * i;
+    const size_t separator = path.find_last_of("\\/");
+#else
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void*>(&getModuleDirectory), &info) && info.dli_fname) {
+        path = info.dli_fname;
     }
-    if (sumMagnitude > 0.0f) {
-        spectralCentroid = weightedSum / sumMagnitude;
-        spectralCentroid /= numSamples; // Normalize
-    }
-    
-    // Combine features to generate a detection probability
-    float result = 0.0f;
-    
-    // Energy-based component (voices typically have moderate energy)
-    if (rms > 0.01f && rms < 0.3f) {
-        result += 0.3f;
+    const size_t separator = path.find_last_of('/');
+#endif
+    return separator == std::string::npos ? std::string() : path.substr(0, separator);
+}
+
+bool fileExists(const std::string& path)
+{
+    return std::ifstream(path, std::ios::binary).good();
+}
+
+} // namespace
+
+std::string findDefaultModelPath()
+{
+    if (const char* overridePath = std::getenv("KHDETECTOR_MODEL")) {
+        return overridePath;
     }
-    
-    // Zero crossing rate component (human speech typically has moderate ZCR)
-    if (zcr > 0.02f && zcr < 0.2f) {
-        result += 0.3f;
+
+    const std::string moduleDirectory = getModuleDirectory();
+    if (moduleDirectory.empty()) {
+        return {};
     }
-    
-    // Spectral centroid component
-    if (spectralCentroid > 0.2f && spectralCentroid < 0.8f) {
-        result += 0.2f;
+
+    // Single-file plugins keep the model beside the binary; bundles
+    // (Contents/<arch>/ or Contents/MacOS/) in Contents/Resources
+    const char* const names[] = {
+        "het_detector.khmlp",
+#ifdef KHDETECTOR_WITH_ONNXRUNTIME
+        "het_detector.onnx",
+#endif
+    };
+    for (const std::string& directory : { moduleDirectory, moduleDirectory + "/../Resources" }) {
+        for (const char* name : names) {
+            const std::string candidate = directory + "/" + name;
+            if (fileExists(candidate)) {
+                return candidate;
+            }
+        }
     }
-    
-    // Add some random variation to simulate model uncertainty
-    static thread_local std::random_device rd;
-    static thread_local std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> noise(-0.1f, 0.1f);
-    result += noise(gen);
-    
-    return std::clamp(result, 0.0f, 1.0f);
+    return {};
 }
 
 // Factory functions
@@ -412,6 +773,9 @@ AiInference::ModelConfig createDefaultModelConfig()
     config.numThreads = 1;            // Single threaded inference
     config.confidenceThreshold = 0.5f;
     
+    // The model shipped with the plugin; without one the engine uses its heuristic
+    config.modelPath = findDefaultModelPath();
+    
     // Default normalization (no normalization)
     config.normalizationMean = {0.0f};
     config.normalizationStd = {1.0f};
@@ -419,4 +783,13 @@ AiInference::ModelConfig createDefaultModelConfig()
     return config;
 }
 
+const char* getLabelName(AiInference::Label label)
+{
+    switch (label) {
+        case AiInference::Label::NotDetected: return "not_detected";
+        case AiInference::Label::Detected:    return "detected";
+    }
+    return "unknown";
+}
+
 } // namespace KhDetector 
\ No newline at end of file
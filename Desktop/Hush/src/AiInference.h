@@ -1,35 +1,62 @@
 #pragma once
 
+#include <array>
 #include <vector>
 #include <string>
 #include <memory>
 #include <atomic>
 #include <chrono>
-#include <functional>
+#include <cstdint>
 
+#include "ActivityGate.h"
+#include "LatencyHistogram.h"
 #include "PostProcessor.h"
 
 namespace KhDetector {
 
+class MlpModel;
+class OnnxBackend;
+
 /**
- * @brief Stub AI inference engine for audio processing
+ * @brief AI inference engine for audio processing
  * 
- * This is a placeholder implementation that can be replaced with actual
- * AI inference frameworks like TensorFlow Lite, PyTorch Mobile, ONNX Runtime, etc.
+ * Runs the loaded model natively (MlpModel, for .khmlp files written by
+ * training/export_native_model.py) or through ONNX Runtime (OnnxBackend)
+ * when the build includes it. Without a model the engine scores each frame
+ * with ActivityGate::fricativeConfidence(), a deterministic heuristic on
+ * its level and zero crossing rate.
  */
 class AiInference
 {
 public:
+    /**
+     * @brief Classification of a frame after post-processing
+     */
+    enum class Label
+    {
+        NotDetected,
+        Detected
+    };
+
     /**
      * @brief Inference result structure
+     * 
+     * Fixed size, so producing one on the inference thread never allocates.
      */
     struct InferenceResult
     {
-        std::vector<float> predictions;     // Model predictions/outputs
+        static constexpr int kMaxPredictions = 16;
+        
+        std::array<float, kMaxPredictions> predictions{}; // Model outputs; the first numPredictions are set
+        int numPredictions = 0;            // Number of model outputs
         float confidence = 0.0f;           // Confidence score (0.0 - 1.0)
-        std::string classification;        // Classification result if applicable
+        Label label = Label::NotDetected;  // Classification result
+        uint64_t frameIndex = 0;           // Position in the stream of frames passed to run() and runBatch()
         std::chrono::microseconds processingTime{0}; // Time taken for inference
         bool success = false;              // Whether inference succeeded
+        bool gated = false;                // The activity gate was closed and the model did not run
+        bool heuristic = false;            // Scored by InferenceService's fallback heuristic under overload
+        bool held = false;                 // InferenceService repeated the last confidence: no new feature frame
     };
 
     /**
@@ -48,12 +75,21 @@ public:
         std::vector<float> normalizationMean;
         std::vector<float> normalizationStd;
         float confidenceThreshold = 0.5f;
+        
+        // Skip the model on frames the ActivityGate rejects (frames must be raw audio)
+        bool useActivityGate = false;
+        ActivityGate::Config activityGate;
+
+        // The model takes one FeatureExtractor frame (FeatureExtractor::kNumFeatures values)
+        // instead of inputSize samples; InferenceService streams extract it, run() does not
+        bool featureInput = false;
     };
 
     /**
      * @brief Constructor
      */
-    explicit AiInference(const ModelConfig& config = ModelConfig{});
+    AiInference() : AiInference(ModelConfig()) {}
+    explicit AiInference(const ModelConfig& config);
 
     /**
      * @brief Destructor
@@ -77,6 +113,15 @@ public:
     /**
      * @brief Load model from file
      * 
+     * A .khmlp file is evaluated natively by MlpModel; anything else gets an
+     * ONNX Runtime session with ModelConfig::numThreads intra-op threads.
+     * The model input must have ModelConfig::inputSize features per
+     * frame; ModelConfig::outputSize is taken from the model. A model with two
+     * outputs is read as [other, detected] logits, as trained by
+     * train_het_detector.py, and reports the softmax probability of the second.
+     * Models with more than InferenceResult::kMaxPredictions outputs are
+     * rejected. Do not call while run() may be executing on another thread.
+     * 
      * @param modelPath Path to model file
      * @return true if model loaded successfully
      */
@@ -85,6 +130,16 @@ public:
     /**
      * @brief Run inference on audio frame
      * 
+     * Allocates nothing once initialized. Frames of the wrong size, or
+     * passed before initialize(), fail and are counted in
+     * Statistics::rejectedFrames.
+     * 
+     * With ModelConfig::useActivityGate, frames the gate closes skip
+     * normalization and the model: they succeed with result.gated set, no
+     * predictions, and a confidence of zero fed to the post-processor, so
+     * hits still end and the callback still sees every frame. A streaming
+     * model starts a fresh stream when the gate opens again.
+     * 
      * @param audioData Pointer to audio samples
      * @param numSamples Number of samples in the frame
      * @return Inference result
@@ -99,11 +154,94 @@ public:
      */
     InferenceResult run(const std::vector<float>& audioFrame);
 
+    /**
+     * @brief Run inference on consecutive frames in one model call
+     * 
+     * Passes the frames through the activity gate in order, then evaluates
+     * the model once for all open frames (ONNX Runtime runs a
+     * [frames, inputSize] tensor; a streaming model once per stretch between
+     * gated frames, since it restarts after each gap). Gated frames, the
+     * post-processing, statistics and the callback then see the frames in
+     * order, exactly as numFrames calls to run() would; each result's
+     * processingTime is its share of the batch. Use it to catch up after a
+     * stall or for offline analysis. Allocates only when numFrames is
+     * larger than any earlier batch.
+     * 
+     * @param frames numFrames x ModelConfig::inputSize samples, frame by frame
+     * @param numFrames Number of frames
+     * @param results numFrames results, filled in frame order
+     * @return true if the model ran on the batch
+     */
+    bool runBatch(const float* frames, int numFrames, InferenceResult* results);
+
+    /**
+     * @brief Whether the loaded model is stateful
+     * 
+     * A streaming model (a native model with GRU layers) carries a hidden
+     * state from call to call, so each run() takes the next hop of the
+     * stream (ModelConfig::inputSize samples, e.g. 5-10 ms) instead of an
+     * independent window, and the thread pool can be started with the hop
+     * as its interval. run() and runBatch() advance stream 0.
+     */
+    bool isStreaming() const;
+
+    /**
+     * @brief Clear the model state of every stream, and close the activity gate
+     * 
+     * Call when the audio stream restarts (KhDetectorProcessor::setActive),
+     * not while run() may be executing on another thread.
+     */
+    void resetState();
+
+    /**
+     * @brief Floats in a state snapshot (0 for a stateless model)
+     */
+    int getStateSize() const;
+
+    /**
+     * @brief Copy a stream's model state to or from getStateSize() floats
+     * 
+     * Snapshots let a caller rewind a stream or move it to another stream
+     * slot. Not while run() may be executing on another thread.
+     * 
+     * @return false if the stream does not exist
+     */
+    bool saveState(float* state, int stream = 0) const;
+    bool restoreState(const float* state, int stream = 0);
+
+    /**
+     * @brief Number of streams with their own model state (allocates; resets every stream)
+     */
+    bool setNumStreams(int numStreams);
+    int getNumStreams() const;
+
+    /**
+     * @brief Advance several independent streams by one hop each in one model call
+     * 
+     * Hop s continues stream s. The post-processor follows a single stream,
+     * so results carry the model's detection probability as their
+     * confidence and are labelled against ModelConfig::confidenceThreshold;
+     * all results of a call share one frameIndex. Statistics are updated,
+     * the callback is not called. Allocates only when numStreams is larger
+     * than any earlier batch.
+     * 
+     * @param hops numStreams x ModelConfig::inputSize samples, stream by stream
+     * @param numStreams At most getNumStreams() for a streaming model
+     * @param results numStreams results, in stream order
+     * @return true if the model ran on the hops
+     */
+    bool runStreams(const float* hops, int numStreams, InferenceResult* results);
+
     /**
      * @brief Check if the inference engine is ready
      */
     bool isReady() const { return mInitialized.load(); }
 
+    /**
+     * @brief Whether a trained model is loaded, rather than the fricativeConfidence() fallback
+     */
+    bool hasModel() const { return mNativeModel || mBackend; }
+
     /**
      * @brief Get model configuration
      */
@@ -111,15 +249,32 @@ public:
 
     /**
      * @brief Get inference statistics
+     *
+     * Only counters and sums are stored, each a single atomic add, so
+     * readers on other threads never see a half-updated average; the
+     * averages are derived from them on read.
      */
     struct Statistics
     {
         std::atomic<uint64_t> totalInferences{0};
         std::atomic<uint64_t> successfulInferences{0};
         std::atomic<uint64_t> failedInferences{0};
+        std::atomic<uint64_t> rejectedFrames{0};    // Wrong size, or before initialize()
+        std::atomic<uint64_t> gatedFrames{0};       // Kept from the model by the activity gate
         std::atomic<uint64_t> totalProcessingTimeUs{0};
-        std::atomic<double> averageProcessingTimeMs{0.0};
-        std::atomic<double> averageConfidence{0.0};
+        std::atomic<uint64_t> confidenceSumPpm{0};  // Confidences of successful inferences, in millionths
+
+        double getAverageProcessingTimeMs() const
+        {
+            const uint64_t inferences = totalInferences.load();
+            return inferences > 0 ? static_cast<double>(totalProcessingTimeUs.load()) / (inferences * 1000.0) : 0.0;
+        }
+
+        double getAverageConfidence() const
+        {
+            const uint64_t successful = successfulInferences.load();
+            return successful > 0 ? static_cast<double>(confidenceSumPpm.load()) / (successful * 1e6) : 0.0;
+        }
     };
 
     const Statistics& getStatistics() const { return mStats; }
@@ -132,10 +287,14 @@ public:
     /**
      * @brief Set inference callback for real-time results
      * 
-     * @param callback Function to call with inference results
+     * Called on the inference thread after every successful frame, so it
+     * must not block or allocate, and cannot throw.
+     * 
+     * @param callback Function to call with inference results, or nullptr
+     * @param context Passed back to the callback
      */
-    using InferenceCallback = std::function<void(const InferenceResult&)>;
-    void setInferenceCallback(InferenceCallback callback);
+    using InferenceCallback = void (*)(const InferenceResult& result, void* context) noexcept;
+    void setInferenceCallback(InferenceCallback callback, void* context = nullptr);
 
     /**
      * @brief Warmup the inference engine with dummy data
@@ -161,6 +320,19 @@ public:
     PostProcessor* getPostProcessor() { return mPostProcessor.get(); }
     const PostProcessor* getPostProcessor() const { return mPostProcessor.get(); }
 
+    /**
+     * @brief Record the feature extraction, inference and post-processing time of every run() frame
+     * 
+     * Set before the inference thread starts; nullptr stops recording.
+     */
+    void setLatencyMonitor(std::shared_ptr<LatencyMonitor> monitor) { mLatencyMonitor = std::move(monitor); }
+
+    /**
+     * @brief Activity gate in front of run(), or nullptr without ModelConfig::useActivityGate
+     */
+    ActivityGate* getActivityGate() { return mActivityGate.get(); }
+    const ActivityGate* getActivityGate() const { return mActivityGate.get(); }
+
     /**
      * @brief Check if there's currently a hit detected (thread-safe)
      */
@@ -175,15 +347,35 @@ private:
     mutable Statistics mStats;
     
     // Callback
-    InferenceCallback mCallback;
+    InferenceCallback mCallback = nullptr;
+    void* mCallbackContext = nullptr;
+    
+    uint64_t mNextFrameIndex = 0;
     
     // Post-processing
     std::unique_ptr<PostProcessor> mPostProcessor;
     
+    // Gating
+    std::unique_ptr<ActivityGate> mActivityGate;
+    bool mGateWasOpen = true;
+    
+    std::shared_ptr<LatencyMonitor> mLatencyMonitor;
+    
     // Internal processing buffers
     std::vector<float> mInputBuffer;
     std::vector<float> mOutputBuffer;
     std::vector<float> mNormalizedInput;
+    std::vector<float> mBatchInput;    // runBatch() frames, normalized
+    std::vector<float> mBatchOutput;
+    
+    // Loaded model: a native MLP, or an ONNX Runtime session bound to the
+    // single-frame or the batch buffers, whichever ran last
+    std::unique_ptr<MlpModel> mNativeModel;
+    std::unique_ptr<OnnxBackend> mBackend;
+    const float* mBoundInput = nullptr;
+    const float* mBoundOutput = nullptr;
+    int mBoundFrames = 0;
+    int mPositiveClass = -1;           // Output holding the detection probability; -1 = highest output
     
     // Timing
     std::chrono::steady_clock::time_point mLastInferenceTime;
@@ -198,28 +390,45 @@ private:
      */
     void postprocessOutput(const float* output, int numOutputs, InferenceResult& result);
     
+    /**
+     * @brief Run a detection probability through the post-processor into the result
+     */
+    void postprocessConfidence(float rawConfidence, InferenceResult& result);
+    
+    /**
+     * @brief Detection probability from model outputs, before post-processing
+     */
+    float getRawConfidence(const float* output, int numOutputs) const;
+    
+    /**
+     * @brief Turn class logits into softmax probabilities, frame by frame
+     */
+    void logitsToProbabilities(float* output, int outputSize, int numFrames) const;
+    
     /**
      * @brief Update inference statistics
      */
     void updateStatistics(const InferenceResult& result);
     
     /**
-     * @brief Stub inference implementation
+     * @brief Run the model, or ActivityGate::fricativeConfidence() when no model is loaded
      * 
-     * This is where actual ML framework calls would go.
-     * Currently generates realistic dummy results for testing.
+     * Evaluates numFrames consecutive frames. An ONNX Runtime session is
+     * rebound only when the buffers or the frame count change, so repeated
+     * runs on the same buffers allocate nothing.
      */
-    bool runInferenceInternal(const float* input, int inputSize, float* output, int outputSize);
+    bool runInferenceInternal(float* input, int inputSize, float* output, int outputSize, int numFrames);
     
     /**
-     * @brief Check hardware capabilities
+     * @brief Bind the ONNX Runtime session to input and output buffers, unless already bound to them
      */
-    void detectHardwareCapabilities();
+    bool bindBackend(float* input, float* output, int numFrames);
     
     /**
-     * @brief Generate realistic test signal for demonstration
+     * @brief Check hardware capabilities
      */
-    float generateTestResult(const float* audioData, int numSamples);
+    void detectHardwareCapabilities();
+
 };
 
 /**
@@ -232,7 +441,26 @@ std::unique_ptr<AiInference> createAiInference(const AiInference::ModelConfig& c
 
 /**
  * @brief Helper function to create default model configuration
+ *
+ * Points modelPath at findDefaultModelPath().
  */
 AiInference::ModelConfig createDefaultModelConfig();
 
+/**
+ * @brief Path of the detector model shipped with the plugin
+ *
+ * KHDETECTOR_MODEL from the environment when it is set (empty for none),
+ * otherwise het_detector.khmlp (or, with ONNX Runtime, het_detector.onnx)
+ * beside the plugin binary or in the Resources directory of its bundle,
+ * where khdetector_bundle_model() in cmake/DetectorModel.cmake installs it.
+ *
+ * @return Empty if there is no model
+ */
+std::string findDefaultModelPath();
+
+/**
+ * @brief Printable name of a label ("detected" / "not_detected")
+ */
+const char* getLabelName(AiInference::Label label);
+
 } // namespace KhDetector 
\ No newline at end of file
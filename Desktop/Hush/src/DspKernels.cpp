@@ -0,0 +1,369 @@
+#include "DspKernels.h"
+
+#include <atomic>
+#include <cmath>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define KHDETECTOR_X86 1
+#endif
+
+namespace KhDetector {
+
+namespace {
+
+//==============================================================================
+// Scalar kernels - the reference every SIMD variant is tested against
+//==============================================================================
+
+float dotProductScalar(const float* coeffs, const float* samples, int length)
+{
+    float total = 0.0f;
+    for (int i = 0; i < length; ++i) {
+        total += samples[i] * coeffs[i];
+    }
+    return total;
+}
+
+void firBlockRowsScalar(const float* coeffs, int coeffStride,
+                        const float* samples, int sampleStride,
+                        int numRows, int numTaps,
+                        float* output, int numOutputs)
+{
+    for (int k = 0; k < numOutputs; ++k) {
+        float sum = 0.0f;
+        for (int r = 0; r < numRows; ++r) {
+            const float* c = coeffs + r * coeffStride;
+            const float* x = samples + r * sampleStride + k;
+            for (int t = 0; t < numTaps; ++t) {
+                sum += x[t] * c[t];
+            }
+        }
+        output[k] = sum;
+    }
+}
+
+void firGatherScalar(const float* coeffs, const int* coeffOffsets,
+                     const float* samples, const int* sampleOffsets,
+                     int numTaps, float* output, int numOutputs)
+{
+    for (int k = 0; k < numOutputs; ++k) {
+        output[k] = dotProductScalar(coeffs + coeffOffsets[k], samples + sampleOffsets[k], numTaps);
+    }
+}
+
+void firLanesScalar(const float* coeffs, int numTaps,
+                    const float* frames, int numLanes, int frameStep,
+                    float* output, int numOutputs)
+{
+    for (int k = 0; k < numOutputs; ++k) {
+        const float* window = frames + static_cast<long>(k) * frameStep * numLanes;
+        float* out = output + k * numLanes;
+        for (int c = 0; c < numLanes; ++c) {
+            out[c] = 0.0f;
+        }
+        for (int t = 0; t < numTaps; ++t) {
+            const float coeff = coeffs[t];
+            const float* frame = window + t * numLanes;
+            for (int c = 0; c < numLanes; ++c) {
+                out[c] += coeff * frame[c];
+            }
+        }
+    }
+}
+
+void normalizeScalar(const float* input, float* output, int numSamples, float mean, float invStd)
+{
+    for (int i = 0; i < numSamples; ++i) {
+        output[i] = (input[i] - mean) * invStd;
+    }
+}
+
+void multiplyAccumulateScalar(const float* input, float gain, float* output, int numSamples)
+{
+    for (int i = 0; i < numSamples; ++i) {
+        output[i] += gain * input[i];
+    }
+}
+
+void fftButterfliesScalar(float* re, float* im, const float* twiddleRe, const float* twiddleIm,
+                          int size, int half)
+{
+    for (int start = 0; start < size; start += 2 * half) {
+        float* aRe = re + start;
+        float* aIm = im + start;
+        float* bRe = aRe + half;
+        float* bIm = aIm + half;
+        for (int k = 0; k < half; ++k) {
+            const float tRe = bRe[k] * twiddleRe[k] - bIm[k] * twiddleIm[k];
+            const float tIm = bRe[k] * twiddleIm[k] + bIm[k] * twiddleRe[k];
+            bRe[k] = aRe[k] - tRe;
+            bIm[k] = aIm[k] - tIm;
+            aRe[k] += tRe;
+            aIm[k] += tIm;
+        }
+    }
+}
+
+void denseLayerScalar(const float* weights, const float* bias, const float* input, int numInputs,
+                      float* output, int numOutputs, bool relu)
+{
+    for (int block = 0; block < numOutputs; block += 8) {
+        const float* w = weights + block * numInputs;
+        for (int j = 0; j < 8; ++j) {
+            float sum = bias[block + j];
+            for (int i = 0; i < numInputs; ++i) {
+                sum += w[i * 8 + j] * input[i];
+            }
+            output[block + j] = relu && sum < 0.0f ? 0.0f : sum;
+        }
+    }
+}
+
+float tanhScalar(float x)
+{
+    x = x < -detail::kTanhClamp ? -detail::kTanhClamp : x > detail::kTanhClamp ? detail::kTanhClamp : x;
+    const float x2 = x * x;
+    float p = detail::kTanhNumerator[0];
+    for (int i = 1; i < detail::kTanhNumeratorTerms; ++i) {
+        p = p * x2 + detail::kTanhNumerator[i];
+    }
+    float q = detail::kTanhDenominator[0];
+    for (int i = 1; i < detail::kTanhDenominatorTerms; ++i) {
+        q = q * x2 + detail::kTanhDenominator[i];
+    }
+    return x * p / q;
+}
+
+void gruUpdateScalar(const float* inputGates, const float* hiddenGates, float* hidden, int size)
+{
+    for (int j = 0; j < size; ++j) {
+        const float reset = 0.5f + 0.5f * tanhScalar(0.5f * (inputGates[j] + hiddenGates[j]));
+        const float update = 0.5f + 0.5f * tanhScalar(0.5f * (inputGates[size + j] + hiddenGates[size + j]));
+        const float candidate = tanhScalar(inputGates[2 * size + j] + reset * hiddenGates[2 * size + j]);
+        hidden[j] = candidate + update * (hidden[j] - candidate);
+    }
+}
+
+void frameFeaturesScalar(const float* samples, int numSamples, FrameFeatures& features)
+{
+    features = FrameFeatures{};
+    for (int i = 0; i < numSamples; ++i) {
+        const float magnitude = std::fabs(samples[i]);
+        features.sumSquares += samples[i] * samples[i];
+        features.sumMagnitude += magnitude;
+        features.weightedMagnitude += magnitude * static_cast<float>(i);
+        if (i > 0 && (samples[i] >= 0.0f) != (samples[i - 1] >= 0.0f)) {
+            features.zeroCrossings += 1.0f;
+        }
+    }
+}
+
+float medianScalar(const float* values, int numValues)
+{
+    if (numValues <= 0) {
+        return 0.0f;
+    }
+
+    // values[i] holds ranks [less, less + equal) of the sorted sequence
+    const int lowerRank = (numValues - 1) / 2;
+    const int upperRank = numValues / 2;
+    float lower = 0.0f;
+    float upper = 0.0f;
+    bool foundLower = false;
+    bool foundUpper = false;
+
+    for (int i = 0; i < numValues && !(foundLower && foundUpper); ++i) {
+        const float candidate = values[i];
+        int less = 0;
+        int equal = 0;
+        for (int j = 0; j < numValues; ++j) {
+            less += values[j] < candidate;
+            equal += values[j] == candidate;
+        }
+        if (!foundLower && less <= lowerRank && lowerRank < less + equal) {
+            lower = candidate;
+            foundLower = true;
+        }
+        if (!foundUpper && less <= upperRank && upperRank < less + equal) {
+            upper = candidate;
+            foundUpper = true;
+        }
+    }
+
+    return (lower + upper) * 0.5f;
+}
+
+constexpr DspKernels kScalarKernels = {
+    SimdLevel::Scalar,
+    dotProductScalar,
+    firBlockRowsScalar,
+    firGatherScalar,
+    firLanesScalar,
+    normalizeScalar,
+    multiplyAccumulateScalar,
+    fftButterfliesScalar,
+    denseLayerScalar,
+    gruUpdateScalar,
+    frameFeaturesScalar,
+    medianScalar
+};
+
+//==============================================================================
+// CPU feature detection
+//==============================================================================
+
+bool cpuSupports(SimdLevel level)
+{
+    switch (level) {
+        case SimdLevel::Scalar:
+            return true;
+
+#if defined(KHDETECTOR_X86)
+    #if defined(_MSC_VER) && !defined(__clang__)
+        case SimdLevel::SSE2:
+        case SimdLevel::AVX2:
+        case SimdLevel::AVX512: {
+            int info[4] = {};
+            __cpuid(info, 0);
+            const int maxLeaf = info[0];
+            __cpuid(info, 1);
+            const bool sse2 = (info[3] & (1 << 26)) != 0;
+            const bool fma = (info[2] & (1 << 12)) != 0;
+            const bool osxsave = (info[2] & (1 << 27)) != 0;
+            const bool avx = (info[2] & (1 << 28)) != 0;
+            if (level == SimdLevel::SSE2) {
+                return sse2;
+            }
+            if (!osxsave || !avx || maxLeaf < 7) {
+                return false;
+            }
+            // The OS must save the YMM (and for AVX-512 the ZMM/mask) state
+            const unsigned long long xcr0 = _xgetbv(0);
+            __cpuidex(info, 7, 0);
+            if (level == SimdLevel::AVX2) {
+                return fma && (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+            }
+            return (info[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;
+        }
+    #else
+        case SimdLevel::SSE2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+        case SimdLevel::AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case SimdLevel::AVX512:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx512f");
+    #endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+        case SimdLevel::NEON:
+            return true;
+#endif
+
+        default:
+            return false;
+    }
+}
+
+const DspKernels* compiledKernels(SimdLevel level)
+{
+    switch (level) {
+        case SimdLevel::Scalar: return detail::getScalarKernels();
+        case SimdLevel::SSE2:   return detail::getSse2Kernels();
+        case SimdLevel::AVX2:   return detail::getAvx2Kernels();
+        case SimdLevel::AVX512: return detail::getAvx512Kernels();
+        case SimdLevel::NEON:   return detail::getNeonKernels();
+    }
+    return nullptr;
+}
+
+//==============================================================================
+// Binding
+//==============================================================================
+
+std::atomic<const DspKernels*> gActiveKernels{nullptr};
+
+const DspKernels* bindBestKernels()
+{
+    const DspKernels* kernels = getDspKernelsFor(detectSimdLevel());
+    gActiveKernels.store(kernels, std::memory_order_release);
+    return kernels;
+}
+
+// Probe the CPU while the library loads so the audio thread never pays for it
+const DspKernels* const gLoadTimeKernels = bindBestKernels();
+
+} // namespace
+
+namespace detail {
+
+const DspKernels* getScalarKernels()
+{
+    return &kScalarKernels;
+}
+
+} // namespace detail
+
+const DspKernels& getDspKernels()
+{
+    const DspKernels* kernels = gActiveKernels.load(std::memory_order_acquire);
+    if (!kernels) {
+        // Called from another library's static initialisation before ours ran
+        kernels = bindBestKernels();
+    }
+    return *kernels;
+}
+
+const DspKernels* getDspKernelsFor(SimdLevel level)
+{
+    const DspKernels* kernels = compiledKernels(level);
+    return (kernels && cpuSupports(level)) ? kernels : nullptr;
+}
+
+bool forceSimdLevel(SimdLevel level)
+{
+    const DspKernels* kernels = getDspKernelsFor(level);
+    if (!kernels) {
+        return false;
+    }
+    gActiveKernels.store(kernels, std::memory_order_release);
+    return true;
+}
+
+SimdLevel detectSimdLevel()
+{
+    static constexpr SimdLevel kPreference[] = {
+        SimdLevel::AVX512,
+        SimdLevel::AVX2,
+        SimdLevel::SSE2,
+        SimdLevel::NEON
+    };
+
+    for (SimdLevel level : kPreference) {
+        if (getDspKernelsFor(level)) {
+            return level;
+        }
+    }
+    return SimdLevel::Scalar;
+}
+
+const char* getSimdLevelName(SimdLevel level)
+{
+    switch (level) {
+        case SimdLevel::Scalar: return "Scalar";
+        case SimdLevel::SSE2:   return "SSE2";
+        case SimdLevel::AVX2:   return "AVX2+FMA";
+        case SimdLevel::AVX512: return "AVX-512";
+        case SimdLevel::NEON:   return "NEON";
+    }
+    return "Unknown";
+}
+
+} // namespace KhDetector
@@ -0,0 +1,200 @@
+#pragma once
+
+namespace KhDetector {
+
+/**
+ * @brief Instruction-set variants of the DSP kernels
+ */
+enum class SimdLevel
+{
+    Scalar,     ///< Portable C++, always available
+    SSE2,       ///< x86 SSE2 (x86-64 baseline)
+    AVX2,       ///< x86 AVX2 with FMA
+    AVX512,     ///< x86 AVX-512F
+    NEON        ///< ARM NEON
+};
+
+/**
+ * @brief Per-frame sums used for the basic audio features
+ *
+ * RMS, zero crossing rate and the spectral centroid approximation are all
+ * derived from these.
+ */
+struct FrameFeatures
+{
+    float sumSquares = 0.0f;           ///< sum of x[i]^2
+    float zeroCrossings = 0.0f;        ///< number of sign changes between neighbours
+    float sumMagnitude = 0.0f;         ///< sum of |x[i]|
+    float weightedMagnitude = 0.0f;    ///< sum of |x[i]| * i
+};
+
+/**
+ * @brief Table of hot DSP kernels for one instruction set
+ *
+ * Every variant computes the same result up to floating-point summation
+ * order; normalize() and median() agree exactly.
+ */
+struct DspKernels
+{
+    SimdLevel level;
+
+    /**
+     * @brief Dot product of a coefficient row with a window of input samples
+     */
+    float (*dotProduct)(const float* coeffs, const float* samples, int length);
+
+    /**
+     * @brief Run a bank of short FIR rows over a block of outputs
+     *
+     * output[k] = sum_r sum_t coeffs[r * coeffStride + t] * samples[r * sampleStride + k + t]
+     * for k in [0, numOutputs). Rows hold their taps oldest sample first.
+     */
+    void (*firBlockRows)(const float* coeffs, int coeffStride,
+                         const float* samples, int sampleStride,
+                         int numRows, int numTaps,
+                         float* output, int numOutputs);
+
+    /**
+     * @brief Dot products of gathered coefficient rows and sample windows
+     *
+     * output[k] = dotProduct(coeffs + coeffOffsets[k], samples + sampleOffsets[k], numTaps)
+     * for k in [0, numOutputs); one call covers a block of outputs that each
+     * need a different row, as in a rational resampler.
+     */
+    void (*firGather)(const float* coeffs, const int* coeffOffsets,
+                      const float* samples, const int* sampleOffsets,
+                      int numTaps, float* output, int numOutputs);
+
+    /**
+     * @brief FIR over frames of interleaved channels, vectorized across channels
+     *
+     * output[k * numLanes + c] = sum_t coeffs[t] * frames[(k * frameStep + t) * numLanes + c]
+     * for k in [0, numOutputs) and c in [0, numLanes). Coefficients are
+     * oldest sample first; frameStep is the decimation factor. numLanes must
+     * be a multiple of 8.
+     */
+    void (*firLanes)(const float* coeffs, int numTaps,
+                     const float* frames, int numLanes, int frameStep,
+                     float* output, int numOutputs);
+
+    /**
+     * @brief output[i] = (input[i] - mean) * invStd; input and output may alias
+     */
+    void (*normalize)(const float* input, float* output, int numSamples, float mean, float invStd);
+
+    /**
+     * @brief output[i] += gain * input[i], e.g. to accumulate a weighted downmix
+     */
+    void (*multiplyAccumulate)(const float* input, float gain, float* output, int numSamples);
+
+    /**
+     * @brief One radix-2 decimation-in-time FFT stage over split complex data
+     *
+     * For every group of 2 * half points: t = w[k] * b[k], b[k] = a[k] - t,
+     * a[k] = a[k] + t for k in [0, half), where a is the group's first half,
+     * b its second half and w = twiddleRe/twiddleIm[0, half). size and half
+     * must be multiples of 8.
+     */
+    void (*fftButterflies)(float* re, float* im, const float* twiddleRe, const float* twiddleIm,
+                           int size, int half);
+
+    /**
+     * @brief Fully connected layer with bias and optional ReLU
+     *
+     * output[o] = act(bias[o] + sum_i weights[((o / 8) * numInputs + i) * 8 + o % 8] * input[i])
+     * for o in [0, numOutputs): weights are packed in blocks of 8 outputs,
+     * input-major within a block, so one broadcast input feeds 8 outputs.
+     * numOutputs must be a multiple of 8; act is max(0, x) if relu is set.
+     */
+    void (*denseLayer)(const float* weights, const float* bias, const float* input, int numInputs,
+                       float* output, int numOutputs, bool relu);
+
+    /**
+     * @brief GRU state update from the gate pre-activations
+     *
+     * inputGates and hiddenGates hold the reset, update and new rows at
+     * [0, size), [size, 2 size) and [2 size, 3 size). With x and h those rows:
+     * r = sigmoid(x_r + h_r), z = sigmoid(x_z + h_z), n = tanh(x_n + r h_n)
+     * and hidden = (1 - z) n + z hidden. tanh is a rational approximation
+     * (detail::kTanh*, absolute error below 1e-6) and sigmoid(v) is
+     * (1 + tanh(v / 2)) / 2.
+     */
+    void (*gruUpdate)(const float* inputGates, const float* hiddenGates, float* hidden, int size);
+
+    /**
+     * @brief Compute the FrameFeatures sums of a frame
+     */
+    void (*frameFeatures)(const float* samples, int numSamples, FrameFeatures& features);
+
+    /**
+     * @brief Median of numValues values (mean of the two middle values if even)
+     *
+     * Works by counting ranks in place, so it never allocates or reorders the
+     * input; cost is quadratic and meant for short filter windows. Values
+     * must not be NaN. Returns 0 for an empty input.
+     */
+    float (*median)(const float* values, int numValues);
+};
+
+/**
+ * @brief Kernels bound for this process
+ *
+ * The CPU is probed once when the library is loaded and the fastest
+ * supported variant is bound; the returned table stays valid for the
+ * lifetime of the process.
+ */
+const DspKernels& getDspKernels();
+
+/**
+ * @brief Kernels for a specific instruction set
+ *
+ * @return nullptr if the variant was not compiled in or the CPU lacks it
+ */
+const DspKernels* getDspKernelsFor(SimdLevel level);
+
+/**
+ * @brief Rebind getDspKernels() to a specific instruction set
+ *
+ * For tests and benchmarks only; not safe while audio is being processed.
+ *
+ * @return false if the variant is unavailable (binding is left unchanged)
+ */
+bool forceSimdLevel(SimdLevel level);
+
+/**
+ * @brief Fastest instruction set both compiled in and supported by this CPU
+ */
+SimdLevel detectSimdLevel();
+
+/**
+ * @brief Human-readable name of an instruction set
+ */
+const char* getSimdLevelName(SimdLevel level);
+
+namespace detail {
+
+// Per-ISA tables, each defined in its own translation unit and compiled with
+// only the flags it needs. They return nullptr when the unit was built for a
+// target without that instruction set.
+const DspKernels* getScalarKernels();
+const DspKernels* getSse2Kernels();
+const DspKernels* getAvx2Kernels();
+const DspKernels* getAvx512Kernels();
+const DspKernels* getNeonKernels();
+
+// tanh(x) ~ x P(x^2) / Q(x^2) for |x| <= kTanhClamp (and +-1 beyond), the
+// coefficients highest power first. Shared by every gruUpdate() variant.
+constexpr float kTanhClamp = 7.90531110763549805f;
+constexpr int kTanhNumeratorTerms = 7;
+constexpr float kTanhNumerator[kTanhNumeratorTerms] = {
+    -2.76076847742355e-16f, 2.00018790482477e-13f, -8.60467152213735e-11f, 5.12229709037114e-08f,
+    1.48572235717979e-05f, 6.37261928875436e-04f, 4.89352455891786e-03f
+};
+constexpr int kTanhDenominatorTerms = 4;
+constexpr float kTanhDenominator[kTanhDenominatorTerms] = {
+    1.19825839466702e-06f, 1.18534705686654e-04f, 2.26843463243900e-03f, 4.89352518554385e-03f
+};
+
+} // namespace detail
+
+} // namespace KhDetector
@@ -0,0 +1,603 @@
+// AVX2 + FMA kernels. This unit is the only one built with -mavx2 -mfma
+// (/arch:AVX2 on MSVC); it is only called after the CPU has been checked.
+// Only intrinsics and DspKernels.h may be included here: any inline function
+// emitted by this unit could otherwise be picked by the linker for the whole
+// program.
+
+#include "DspKernels.h"
+
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+    #include <immintrin.h>
+    #define KHDETECTOR_HAVE_AVX2 1
+#endif
+
+namespace KhDetector {
+
+#if defined(KHDETECTOR_HAVE_AVX2)
+
+namespace {
+
+inline float horizontalSum(__m256 sum)
+{
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 0x55));
+    return _mm_cvtss_f32(half);
+}
+
+float dotProductAvx2(const float* coeffs, const float* samples, int length)
+{
+    // Two independent accumulators hide the FMA latency of short rows
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    int i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(samples + i), _mm256_loadu_ps(coeffs + i), sum0);
+        sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(samples + i + 8), _mm256_loadu_ps(coeffs + i + 8), sum1);
+    }
+    if (i + 8 <= length) {
+        sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(samples + i), _mm256_loadu_ps(coeffs + i), sum0);
+        i += 8;
+    }
+
+    float total = horizontalSum(_mm256_add_ps(sum0, sum1));
+    for (; i < length; ++i) {
+        total += samples[i] * coeffs[i];
+    }
+    return total;
+}
+
+void firBlockRowsAvx2(const float* coeffs, int coeffStride,
+                      const float* samples, int sampleStride,
+                      int numRows, int numTaps,
+                      float* output, int numOutputs)
+{
+    int k = 0;
+
+    // Four output vectors per pass share each broadcast coefficient and keep
+    // four independent FMA chains in flight
+    for (; k + 32 <= numOutputs; k += 32) {
+        __m256 sum0 = _mm256_setzero_ps();
+        __m256 sum1 = _mm256_setzero_ps();
+        __m256 sum2 = _mm256_setzero_ps();
+        __m256 sum3 = _mm256_setzero_ps();
+        for (int r = 0; r < numRows; ++r) {
+            const float* c = coeffs + r * coeffStride;
+            const float* x = samples + r * sampleStride + k;
+            for (int t = 0; t < numTaps; ++t) {
+                const __m256 coeff = _mm256_broadcast_ss(c + t);
+                sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + t), coeff, sum0);
+                sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + t + 8), coeff, sum1);
+                sum2 = _mm256_fmadd_ps(_mm256_loadu_ps(x + t + 16), coeff, sum2);
+                sum3 = _mm256_fmadd_ps(_mm256_loadu_ps(x + t + 24), coeff, sum3);
+            }
+        }
+        _mm256_storeu_ps(output + k, sum0);
+        _mm256_storeu_ps(output + k + 8, sum1);
+        _mm256_storeu_ps(output + k + 16, sum2);
+        _mm256_storeu_ps(output + k + 24, sum3);
+    }
+    for (; k + 8 <= numOutputs; k += 8) {
+        __m256 sum = _mm256_setzero_ps();
+        for (int r = 0; r < numRows; ++r) {
+            const float* c = coeffs + r * coeffStride;
+            const float* x = samples + r * sampleStride + k;
+            for (int t = 0; t < numTaps; ++t) {
+                sum = _mm256_fmadd_ps(_mm256_loadu_ps(x + t), _mm256_broadcast_ss(c + t), sum);
+            }
+        }
+        _mm256_storeu_ps(output + k, sum);
+    }
+
+    // Remaining outputs one at a time, vectorized across taps
+    const int simdTaps = (numTaps / 8) * 8;
+    for (; k < numOutputs; ++k) {
+        __m256 acc = _mm256_setzero_ps();
+        for (int r = 0; r < numRows; ++r) {
+            const float* c = coeffs + r * coeffStride;
+            const float* x = samples + r * sampleStride + k;
+            for (int t = 0; t < simdTaps; t += 8) {
+                acc = _mm256_fmadd_ps(_mm256_loadu_ps(x + t), _mm256_loadu_ps(c + t), acc);
+            }
+        }
+        float sum = horizontalSum(acc);
+        for (int r = 0; r < numRows; ++r) {
+            const float* c = coeffs + r * coeffStride;
+            const float* x = samples + r * sampleStride + k;
+            for (int t = simdTaps; t < numTaps; ++t) {
+                sum += x[t] * c[t];
+            }
+        }
+        output[k] = sum;
+    }
+}
+
+// Horizontal sums of eight vectors, returned in order in one vector
+inline __m256 horizontalSum8(const __m256* sums)
+{
+    const __m256 h01 = _mm256_hadd_ps(sums[0], sums[1]);
+    const __m256 h23 = _mm256_hadd_ps(sums[2], sums[3]);
+    const __m256 h45 = _mm256_hadd_ps(sums[4], sums[5]);
+    const __m256 h67 = _mm256_hadd_ps(sums[6], sums[7]);
+    const __m256 h0123 = _mm256_hadd_ps(h01, h23);
+    const __m256 h4567 = _mm256_hadd_ps(h45, h67);
+    return _mm256_add_ps(_mm256_permute2f128_ps(h0123, h4567, 0x20),
+                         _mm256_permute2f128_ps(h0123, h4567, 0x31));
+}
+
+void firGatherAvx2(const float* coeffs, const int* coeffOffsets,
+                   const float* samples, const int* sampleOffsets,
+                   int numTaps, float* output, int numOutputs)
+{
+    const int simdTaps = (numTaps / 8) * 8;
+    int k = 0;
+
+    // Eight outputs per pass are reduced together, so the horizontal adds
+    // cost under one shuffle per output instead of four
+    for (; k + 8 <= numOutputs; k += 8) {
+        __m256 sums[8];
+        for (int j = 0; j < 8; j += 4) {
+            // Four rows advance together to keep four FMA chains in flight
+            const float* c0 = coeffs + coeffOffsets[k + j];
+            const float* c1 = coeffs + coeffOffsets[k + j + 1];
+            const float* c2 = coeffs + coeffOffsets[k + j + 2];
+            const float* c3 = coeffs + coeffOffsets[k + j + 3];
+            const float* x0 = samples + sampleOffsets[k + j];
+            const float* x1 = samples + sampleOffsets[k + j + 1];
+            const float* x2 = samples + sampleOffsets[k + j + 2];
+            const float* x3 = samples + sampleOffsets[k + j + 3];
+            __m256 sum0 = _mm256_setzero_ps();
+            __m256 sum1 = _mm256_setzero_ps();
+            __m256 sum2 = _mm256_setzero_ps();
+            __m256 sum3 = _mm256_setzero_ps();
+            for (int t = 0; t < simdTaps; t += 8) {
+                sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(x0 + t), _mm256_loadu_ps(c0 + t), sum0);
+                sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(x1 + t), _mm256_loadu_ps(c1 + t), sum1);
+                sum2 = _mm256_fmadd_ps(_mm256_loadu_ps(x2 + t), _mm256_loadu_ps(c2 + t), sum2);
+                sum3 = _mm256_fmadd_ps(_mm256_loadu_ps(x3 + t), _mm256_loadu_ps(c3 + t), sum3);
+            }
+            sums[j] = sum0;
+            sums[j + 1] = sum1;
+            sums[j + 2] = sum2;
+            sums[j + 3] = sum3;
+        }
+        _mm256_storeu_ps(output + k, horizontalSum8(sums));
+
+        for (int j = 0; j < 8 && simdTaps < numTaps; ++j) {
+            const float* c = coeffs + coeffOffsets[k + j];
+            const float* x = samples + sampleOffsets[k + j];
+            for (int t = simdTaps; t < numTaps; ++t) {
+                output[k + j] += x[t] * c[t];
+            }
+        }
+    }
+
+    for (; k < numOutputs; ++k) {
+        output[k] = dotProductAvx2(coeffs + coeffOffsets[k], samples + sampleOffsets[k], numTaps);
+    }
+}
+
+void firLanesAvx2(const float* coeffs, int numTaps,
+                  const float* frames, int numLanes, int frameStep,
+                  float* output, int numOutputs)
+{
+    const long outputStride = static_cast<long>(frameStep) * numLanes;
+
+    for (int c = 0; c < numLanes; c += 8) {
+        const float* x = frames + c;
+        int k = 0;
+
+        // Eight outputs per pass share each coefficient and keep eight FMA
+        // chains in flight, enough to hide the FMA latency
+        for (; k + 8 <= numOutputs; k += 8) {
+            const float* x0 = x + k * outputStride;
+            const float* x4 = x0 + 4 * outputStride;
+            __m256 sum0 = _mm256_setzero_ps();
+            __m256 sum1 = _mm256_setzero_ps();
+            __m256 sum2 = _mm256_setzero_ps();
+            __m256 sum3 = _mm256_setzero_ps();
+            __m256 sum4 = _mm256_setzero_ps();
+            __m256 sum5 = _mm256_setzero_ps();
+            __m256 sum6 = _mm256_setzero_ps();
+            __m256 sum7 = _mm256_setzero_ps();
+            for (int t = 0; t < numTaps; ++t) {
+                const __m256 coeff = _mm256_set1_ps(coeffs[t]);
+                const long offset = static_cast<long>(t) * numLanes;
+                sum0 = _mm256_fmadd_ps(coeff, _mm256_loadu_ps(x0 + offset), sum0);
+                sum1 = _mm256_fmadd_ps(coeff, _mm256_loadu_ps(x0 + outputStride + offset), sum1);
+                sum2 = _mm256_fmadd_ps(coeff, _mm256_loadu_ps(x0 + 2 * outputStride + offset), sum2);
+                sum3 = _mm256_fmadd_ps(coeff, _mm256_loadu_ps(x0 + 3 * outputStride + offset), sum3);
+                sum4 = _mm256_fmadd_ps(coeff, _mm256_loadu_ps(x4 + offset), sum4);
+                sum5 = _mm256_fmadd_ps(coeff, _mm256_loadu_ps(x4 + outputStride + offset), sum5);
+                sum6 = _mm256_fmadd_ps(coeff, _mm256_loadu_ps(x4 + 2 * outputStride + offset), sum6);
+                sum7 = _mm256_fmadd_ps(coeff, _mm256_loadu_ps(x4 + 3 * outputStride + offset), sum7);
+            }
+            float* out = output + k * numLanes + c;
+            _mm256_storeu_ps(out, sum0);
+            _mm256_storeu_ps(out + numLanes, sum1);
+            _mm256_storeu_ps(out + 2 * numLanes, sum2);
+            _mm256_storeu_ps(out + 3 * numLanes, sum3);
+            _mm256_storeu_ps(out + 4 * numLanes, sum4);
+            _mm256_storeu_ps(out + 5 * numLanes, sum5);
+            _mm256_storeu_ps(out + 6 * numLanes, sum6);
+            _mm256_storeu_ps(out + 7 * numLanes, sum7);
+        }
+
+        // Remaining outputs split their taps over two chains
+        for (; k < numOutputs; ++k) {
+            const float* x0 = x + k * outputStride;
+            __m256 sum0 = _mm256_setzero_ps();
+            __m256 sum1 = _mm256_setzero_ps();
+            int t = 0;
+            for (; t + 2 <= numTaps; t += 2) {
+                sum0 = _mm256_fmadd_ps(_mm256_set1_ps(coeffs[t]), _mm256_loadu_ps(x0 + t * numLanes), sum0);
+                sum1 = _mm256_fmadd_ps(_mm256_set1_ps(coeffs[t + 1]), _mm256_loadu_ps(x0 + (t + 1) * numLanes), sum1);
+            }
+            if (t < numTaps) {
+                sum0 = _mm256_fmadd_ps(_mm256_set1_ps(coeffs[t]), _mm256_loadu_ps(x0 + t * numLanes), sum0);
+            }
+            _mm256_storeu_ps(output + k * numLanes + c, _mm256_add_ps(sum0, sum1));
+        }
+    }
+}
+
+void normalizeAvx2(const float* input, float* output, int numSamples, float mean, float invStd)
+{
+    const __m256 meanVec = _mm256_set1_ps(mean);
+    const __m256 scaleVec = _mm256_set1_ps(invStd);
+    int i = 0;
+
+    for (; i + 8 <= numSamples; i += 8) {
+        _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(input + i), meanVec), scaleVec));
+    }
+    for (; i < numSamples; ++i) {
+        output[i] = (input[i] - mean) * invStd;
+    }
+}
+
+void multiplyAccumulateAvx2(const float* input, float gain, float* output, int numSamples)
+{
+    const __m256 gainVec = _mm256_set1_ps(gain);
+    int i = 0;
+
+    for (; i + 8 <= numSamples; i += 8) {
+        _mm256_storeu_ps(output + i, _mm256_fmadd_ps(gainVec, _mm256_loadu_ps(input + i), _mm256_loadu_ps(output + i)));
+    }
+    for (; i < numSamples; ++i) {
+        output[i] += gain * input[i];
+    }
+}
+
+void fftButterfliesAvx2(float* re, float* im, const float* twiddleRe, const float* twiddleIm,
+                        int size, int half)
+{
+    for (int start = 0; start < size; start += 2 * half) {
+        float* aRe = re + start;
+        float* aIm = im + start;
+        float* bRe = aRe + half;
+        float* bIm = aIm + half;
+        for (int k = 0; k < half; k += 8) {
+            const __m256 wRe = _mm256_loadu_ps(twiddleRe + k);
+            const __m256 wIm = _mm256_loadu_ps(twiddleIm + k);
+            const __m256 xRe = _mm256_loadu_ps(bRe + k);
+            const __m256 xIm = _mm256_loadu_ps(bIm + k);
+            const __m256 tRe = _mm256_fmsub_ps(xRe, wRe, _mm256_mul_ps(xIm, wIm));
+            const __m256 tIm = _mm256_fmadd_ps(xRe, wIm, _mm256_mul_ps(xIm, wRe));
+            const __m256 yRe = _mm256_loadu_ps(aRe + k);
+            const __m256 yIm = _mm256_loadu_ps(aIm + k);
+            _mm256_storeu_ps(bRe + k, _mm256_sub_ps(yRe, tRe));
+            _mm256_storeu_ps(bIm + k, _mm256_sub_ps(yIm, tIm));
+            _mm256_storeu_ps(aRe + k, _mm256_add_ps(yRe, tRe));
+            _mm256_storeu_ps(aIm + k, _mm256_add_ps(yIm, tIm));
+        }
+    }
+}
+
+// Stores one block of 8 outputs, applying the ReLU if requested
+inline void storeDenseBlock(float* output, __m256 sum, bool relu)
+{
+    _mm256_storeu_ps(output, relu ? _mm256_max_ps(sum, _mm256_setzero_ps()) : sum);
+}
+
+void denseLayerAvx2(const float* weights, const float* bias, const float* input, int numInputs,
+                    float* output, int numOutputs, bool relu)
+{
+    // Every pass keeps eight FMA chains in flight to hide the FMA latency:
+    // eight blocks of 8 outputs share each broadcast input, four blocks
+    // split the inputs into even and odd chains, single blocks into four
+    const int blockStride = 8 * numInputs;
+    int o = 0;
+
+    for (; o + 64 <= numOutputs; o += 64) {
+        const float* w0 = weights + o * numInputs;
+        const float* w4 = w0 + 4 * blockStride;
+        __m256 sum0 = _mm256_loadu_ps(bias + o);
+        __m256 sum1 = _mm256_loadu_ps(bias + o + 8);
+        __m256 sum2 = _mm256_loadu_ps(bias + o + 16);
+        __m256 sum3 = _mm256_loadu_ps(bias + o + 24);
+        __m256 sum4 = _mm256_loadu_ps(bias + o + 32);
+        __m256 sum5 = _mm256_loadu_ps(bias + o + 40);
+        __m256 sum6 = _mm256_loadu_ps(bias + o + 48);
+        __m256 sum7 = _mm256_loadu_ps(bias + o + 56);
+        for (int i = 0; i < numInputs; ++i) {
+            const __m256 x = _mm256_set1_ps(input[i]);
+            sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(w0 + i * 8), x, sum0);
+            sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(w0 + blockStride + i * 8), x, sum1);
+            sum2 = _mm256_fmadd_ps(_mm256_loadu_ps(w0 + 2 * blockStride + i * 8), x, sum2);
+            sum3 = _mm256_fmadd_ps(_mm256_loadu_ps(w0 + 3 * blockStride + i * 8), x, sum3);
+            sum4 = _mm256_fmadd_ps(_mm256_loadu_ps(w4 + i * 8), x, sum4);
+            sum5 = _mm256_fmadd_ps(_mm256_loadu_ps(w4 + blockStride + i * 8), x, sum5);
+            sum6 = _mm256_fmadd_ps(_mm256_loadu_ps(w4 + 2 * blockStride + i * 8), x, sum6);
+            sum7 = _mm256_fmadd_ps(_mm256_loadu_ps(w4 + 3 * blockStride + i * 8), x, sum7);
+        }
+        storeDenseBlock(output + o, sum0, relu);
+        storeDenseBlock(output + o + 8, sum1, relu);
+        storeDenseBlock(output + o + 16, sum2, relu);
+        storeDenseBlock(output + o + 24, sum3, relu);
+        storeDenseBlock(output + o + 32, sum4, relu);
+        storeDenseBlock(output + o + 40, sum5, relu);
+        storeDenseBlock(output + o + 48, sum6, relu);
+        storeDenseBlock(output + o + 56, sum7, relu);
+    }
+
+    for (; o + 32 <= numOutputs; o += 32) {
+        const float* w = weights + o * numInputs;
+        __m256 even0 = _mm256_loadu_ps(bias + o);
+        __m256 even1 = _mm256_loadu_ps(bias + o + 8);
+        __m256 even2 = _mm256_loadu_ps(bias + o + 16);
+        __m256 even3 = _mm256_loadu_ps(bias + o + 24);
+        __m256 odd0 = _mm256_setzero_ps();
+        __m256 odd1 = _mm256_setzero_ps();
+        __m256 odd2 = _mm256_setzero_ps();
+        __m256 odd3 = _mm256_setzero_ps();
+        int i = 0;
+        for (; i + 2 <= numInputs; i += 2) {
+            const __m256 x0 = _mm256_set1_ps(input[i]);
+            const __m256 x1 = _mm256_set1_ps(input[i + 1]);
+            even0 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i * 8), x0, even0);
+            even1 = _mm256_fmadd_ps(_mm256_loadu_ps(w + blockStride + i * 8), x0, even1);
+            even2 = _mm256_fmadd_ps(_mm256_loadu_ps(w + 2 * blockStride + i * 8), x0, even2);
+            even3 = _mm256_fmadd_ps(_mm256_loadu_ps(w + 3 * blockStride + i * 8), x0, even3);
+            odd0 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i * 8 + 8), x1, odd0);
+            odd1 = _mm256_fmadd_ps(_mm256_loadu_ps(w + blockStride + i * 8 + 8), x1, odd1);
+            odd2 = _mm256_fmadd_ps(_mm256_loadu_ps(w + 2 * blockStride + i * 8 + 8), x1, odd2);
+            odd3 = _mm256_fmadd_ps(_mm256_loadu_ps(w + 3 * blockStride + i * 8 + 8), x1, odd3);
+        }
+        if (i < numInputs) {
+            const __m256 x = _mm256_set1_ps(input[i]);
+            even0 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i * 8), x, even0);
+            even1 = _mm256_fmadd_ps(_mm256_loadu_ps(w + blockStride + i * 8), x, even1);
+            even2 = _mm256_fmadd_ps(_mm256_loadu_ps(w + 2 * blockStride + i * 8), x, even2);
+            even3 = _mm256_fmadd_ps(_mm256_loadu_ps(w + 3 * blockStride + i * 8), x, even3);
+        }
+        storeDenseBlock(output + o, _mm256_add_ps(even0, odd0), relu);
+        storeDenseBlock(output + o + 8, _mm256_add_ps(even1, odd1), relu);
+        storeDenseBlock(output + o + 16, _mm256_add_ps(even2, odd2), relu);
+        storeDenseBlock(output + o + 24, _mm256_add_ps(even3, odd3), relu);
+    }
+
+    for (; o < numOutputs; o += 8) {
+        const float* w = weights + o * numInputs;
+        __m256 sum0 = _mm256_loadu_ps(bias + o);
+        __m256 sum1 = _mm256_setzero_ps();
+        __m256 sum2 = _mm256_setzero_ps();
+        __m256 sum3 = _mm256_setzero_ps();
+        int i = 0;
+        for (; i + 4 <= numInputs; i += 4) {
+            sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i * 8), _mm256_set1_ps(input[i]), sum0);
+            sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i * 8 + 8), _mm256_set1_ps(input[i + 1]), sum1);
+            sum2 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i * 8 + 16), _mm256_set1_ps(input[i + 2]), sum2);
+            sum3 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i * 8 + 24), _mm256_set1_ps(input[i + 3]), sum3);
+        }
+        for (; i < numInputs; ++i) {
+            sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i * 8), _mm256_set1_ps(input[i]), sum0);
+        }
+        storeDenseBlock(output + o, _mm256_add_ps(_mm256_add_ps(sum0, sum1), _mm256_add_ps(sum2, sum3)), relu);
+    }
+}
+
+__m256 tanhAvx2(__m256 x)
+{
+    const __m256 clamp = _mm256_set1_ps(detail::kTanhClamp);
+    x = _mm256_min_ps(clamp, _mm256_max_ps(_mm256_sub_ps(_mm256_setzero_ps(), clamp), x));
+    const __m256 x2 = _mm256_mul_ps(x, x);
+    __m256 p = _mm256_set1_ps(detail::kTanhNumerator[0]);
+    for (int i = 1; i < detail::kTanhNumeratorTerms; ++i) {
+        p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(detail::kTanhNumerator[i]));
+    }
+    __m256 q = _mm256_set1_ps(detail::kTanhDenominator[0]);
+    for (int i = 1; i < detail::kTanhDenominatorTerms; ++i) {
+        q = _mm256_fmadd_ps(q, x2, _mm256_set1_ps(detail::kTanhDenominator[i]));
+    }
+    return _mm256_div_ps(_mm256_mul_ps(x, p), q);
+}
+
+// 8 units of gruUpdate(); a unit's reset, update and new rows are gateStride apart
+void gruLanesAvx2(const float* x, const float* h, int gateStride, float* hidden)
+{
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 reset = _mm256_fmadd_ps(
+        half, tanhAvx2(_mm256_mul_ps(half, _mm256_add_ps(_mm256_loadu_ps(x), _mm256_loadu_ps(h)))), half);
+    const __m256 update = _mm256_fmadd_ps(
+        half, tanhAvx2(_mm256_mul_ps(half, _mm256_add_ps(_mm256_loadu_ps(x + gateStride),
+                                                         _mm256_loadu_ps(h + gateStride)))), half);
+    const __m256 candidate = tanhAvx2(
+        _mm256_fmadd_ps(reset, _mm256_loadu_ps(h + 2 * gateStride), _mm256_loadu_ps(x + 2 * gateStride)));
+    const __m256 state = _mm256_loadu_ps(hidden);
+    _mm256_storeu_ps(hidden, _mm256_fmadd_ps(update, _mm256_sub_ps(state, candidate), candidate));
+}
+
+void gruUpdateAvx2(const float* inputGates, const float* hiddenGates, float* hidden, int size)
+{
+    int j = 0;
+    for (; j + 8 <= size; j += 8) {
+        gruLanesAvx2(inputGates + j, hiddenGates + j, size, hidden + j);
+    }
+    if (j < size) {
+        // The last units go through one zero-padded vector, the same arithmetic as the others
+        float x[3 * 8] = {};
+        float h[3 * 8] = {};
+        float state[8] = {};
+        const int count = size - j;
+        for (int gate = 0; gate < 3; ++gate) {
+            for (int k = 0; k < count; ++k) {
+                x[gate * 8 + k] = inputGates[gate * size + j + k];
+                h[gate * 8 + k] = hiddenGates[gate * size + j + k];
+            }
+        }
+        for (int k = 0; k < count; ++k) {
+            state[k] = hidden[j + k];
+        }
+        gruLanesAvx2(x, h, 8, state);
+        for (int k = 0; k < count; ++k) {
+            hidden[j + k] = state[k];
+        }
+    }
+}
+
+void frameFeaturesAvx2(const float* samples, int numSamples, FrameFeatures& features)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 squares = zero;
+    __m256 crossings = zero;
+    __m256 magnitudes = zero;
+    __m256 weighted = zero;
+    __m256 index = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    const __m256 indexStep = _mm256_set1_ps(8.0f);
+
+    float sumSquares = 0.0f;
+    float zeroCrossings = 0.0f;
+    float sumMagnitude = 0.0f;
+    float weightedMagnitude = 0.0f;
+    int i = 0;
+
+    if (numSamples > 0) {
+        // Sample 0 has no predecessor
+        const float first = samples[0];
+        sumSquares = first * first;
+        sumMagnitude = first < 0.0f ? -first : first;
+        i = 1;
+        index = _mm256_add_ps(index, one);
+    }
+
+    for (; i + 8 <= numSamples; i += 8) {
+        const __m256 x = _mm256_loadu_ps(samples + i);
+        const __m256 previous = _mm256_loadu_ps(samples + i - 1);
+        const __m256 magnitude = _mm256_and_ps(x, absMask);
+        const __m256 signChange = _mm256_xor_ps(_mm256_cmp_ps(x, zero, _CMP_GE_OQ),
+                                                _mm256_cmp_ps(previous, zero, _CMP_GE_OQ));
+        squares = _mm256_fmadd_ps(x, x, squares);
+        magnitudes = _mm256_add_ps(magnitudes, magnitude);
+        weighted = _mm256_fmadd_ps(magnitude, index, weighted);
+        crossings = _mm256_add_ps(crossings, _mm256_and_ps(signChange, one));
+        index = _mm256_add_ps(index, indexStep);
+    }
+
+    sumSquares += horizontalSum(squares);
+    zeroCrossings += horizontalSum(crossings);
+    sumMagnitude += horizontalSum(magnitudes);
+    weightedMagnitude += horizontalSum(weighted);
+
+    for (; i < numSamples; ++i) {
+        const float magnitude = samples[i] < 0.0f ? -samples[i] : samples[i];
+        sumSquares += samples[i] * samples[i];
+        sumMagnitude += magnitude;
+        weightedMagnitude += magnitude * static_cast<float>(i);
+        if ((samples[i] >= 0.0f) != (samples[i - 1] >= 0.0f)) {
+            zeroCrossings += 1.0f;
+        }
+    }
+
+    features.sumSquares = sumSquares;
+    features.zeroCrossings = zeroCrossings;
+    features.sumMagnitude = sumMagnitude;
+    features.weightedMagnitude = weightedMagnitude;
+}
+
+float medianAvx2(const float* values, int numValues)
+{
+    if (numValues <= 0) {
+        return 0.0f;
+    }
+
+    const int lowerRank = (numValues - 1) / 2;
+    const int upperRank = numValues / 2;
+    const __m256 one = _mm256_set1_ps(1.0f);
+    float lower = 0.0f;
+    float upper = 0.0f;
+    bool foundLower = false;
+    bool foundUpper = false;
+
+    for (int i = 0; i < numValues && !(foundLower && foundUpper); ++i) {
+        const float candidate = values[i];
+        const __m256 candidateVec = _mm256_set1_ps(candidate);
+        __m256 lessVec = _mm256_setzero_ps();
+        __m256 equalVec = _mm256_setzero_ps();
+        int j = 0;
+        for (; j + 8 <= numValues; j += 8) {
+            const __m256 v = _mm256_loadu_ps(values + j);
+            lessVec = _mm256_add_ps(lessVec, _mm256_and_ps(_mm256_cmp_ps(v, candidateVec, _CMP_LT_OQ), one));
+            equalVec = _mm256_add_ps(equalVec, _mm256_and_ps(_mm256_cmp_ps(v, candidateVec, _CMP_EQ_OQ), one));
+        }
+        int less = static_cast<int>(horizontalSum(lessVec));
+        int equal = static_cast<int>(horizontalSum(equalVec));
+        for (; j < numValues; ++j) {
+            less += values[j] < candidate;
+            equal += values[j] == candidate;
+        }
+        if (!foundLower && less <= lowerRank && lowerRank < less + equal) {
+            lower = candidate;
+            foundLower = true;
+        }
+        if (!foundUpper && less <= upperRank && upperRank < less + equal) {
+            upper = candidate;
+            foundUpper = true;
+        }
+    }
+
+    return (lower + upper) * 0.5f;
+}
+
+constexpr DspKernels kAvx2Kernels = {
+    SimdLevel::AVX2,
+    dotProductAvx2,
+    firBlockRowsAvx2,
+    firGatherAvx2,
+    firLanesAvx2,
+    normalizeAvx2,
+    multiplyAccumulateAvx2,
+    fftButterfliesAvx2,
+    denseLayerAvx2,
+    gruUpdateAvx2,
+    frameFeaturesAvx2,
+    medianAvx2
+};
+
+} // namespace
+
+namespace detail {
+
+const DspKernels* getAvx2Kernels()
+{
+    return &kAvx2Kernels;
+}
+
+} // namespace detail
+
+#else
+
+namespace detail {
+
+const DspKernels* getAvx2Kernels()
+{
+    return nullptr;
+}
+
+} // namespace detail
+
+#endif
+
+} // namespace KhDetector
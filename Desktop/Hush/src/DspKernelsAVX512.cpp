@@ -0,0 +1,611 @@
+// AVX-512F kernels. This unit is the only one built with -mavx512f
+// (/arch:AVX512 on MSVC); it is only called after the CPU has been checked.
+// Only intrinsics and DspKernels.h may be included here: any inline function
+// emitted by this unit could otherwise be picked by the linker for the whole
+// program.
+
+#include "DspKernels.h"
+
+#if defined(__AVX512F__)
+    #include <immintrin.h>
+    #define KHDETECTOR_HAVE_AVX512 1
+#endif
+
+namespace KhDetector {
+
+#if defined(KHDETECTOR_HAVE_AVX512)
+
+namespace {
+
+// Lanes [0, count) set; count must be in [0, 16]
+inline __mmask16 tailMask(int count)
+{
+    return static_cast<__mmask16>((1u << count) - 1u);
+}
+
+// Folds 128-bit lanes with full-mask shuffles and extracts: the unmasked forms
+// (and _mm512_reduce_add_ps) trip -Wuninitialized in GCC 12's headers
+inline float horizontalSum(__m512 sum)
+{
+    sum = _mm512_add_ps(sum, _mm512_mask_shuffle_f32x4(sum, 0xFFFF, sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm512_add_ps(sum, _mm512_mask_shuffle_f32x4(sum, 0xFFFF, sum, sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    __m128 quarter = _mm512_mask_extractf32x4_ps(_mm_setzero_ps(), 0xF, sum, 0);
+    quarter = _mm_add_ps(quarter, _mm_movehl_ps(quarter, quarter));
+    quarter = _mm_add_ss(quarter, _mm_shuffle_ps(quarter, quarter, 0x55));
+    return _mm_cvtss_f32(quarter);
+}
+
+float dotProductAvx512(const float* coeffs, const float* samples, int length)
+{
+    __m512 sum0 = _mm512_setzero_ps();
+    __m512 sum1 = _mm512_setzero_ps();
+    int i = 0;
+
+    for (; i + 32 <= length; i += 32) {
+        sum0 = _mm512_fmadd_ps(_mm512_loadu_ps(samples + i), _mm512_loadu_ps(coeffs + i), sum0);
+        sum1 = _mm512_fmadd_ps(_mm512_loadu_ps(samples + i + 16), _mm512_loadu_ps(coeffs + i + 16), sum1);
+    }
+    for (; i < length; i += 16) {
+        // Masked loads finish the row without a scalar tail
+        const __mmask16 mask = tailMask(length - i < 16 ? length - i : 16);
+        sum0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, samples + i),
+                               _mm512_maskz_loadu_ps(mask, coeffs + i), sum0);
+    }
+
+    return horizontalSum(_mm512_add_ps(sum0, sum1));
+}
+
+void firBlockRowsAvx512(const float* coeffs, int coeffStride,
+                        const float* samples, int sampleStride,
+                        int numRows, int numTaps,
+                        float* output, int numOutputs)
+{
+    int k = 0;
+
+    // Four output vectors per pass share each broadcast coefficient
+    for (; k + 64 <= numOutputs; k += 64) {
+        __m512 sum0 = _mm512_setzero_ps();
+        __m512 sum1 = _mm512_setzero_ps();
+        __m512 sum2 = _mm512_setzero_ps();
+        __m512 sum3 = _mm512_setzero_ps();
+        for (int r = 0; r < numRows; ++r) {
+            const float* c = coeffs + r * coeffStride;
+            const float* x = samples + r * sampleStride + k;
+            for (int t = 0; t < numTaps; ++t) {
+                const __m512 coeff = _mm512_set1_ps(c[t]);
+                sum0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + t), coeff, sum0);
+                sum1 = _mm512_fmadd_ps(_mm512_loadu_ps(x + t + 16), coeff, sum1);
+                sum2 = _mm512_fmadd_ps(_mm512_loadu_ps(x + t + 32), coeff, sum2);
+                sum3 = _mm512_fmadd_ps(_mm512_loadu_ps(x + t + 48), coeff, sum3);
+            }
+        }
+        _mm512_storeu_ps(output + k, sum0);
+        _mm512_storeu_ps(output + k + 16, sum1);
+        _mm512_storeu_ps(output + k + 32, sum2);
+        _mm512_storeu_ps(output + k + 48, sum3);
+    }
+
+    // Remaining outputs 16 at a time, the last vector masked so no sample
+    // past the final output's window is read
+    for (; k < numOutputs; k += 16) {
+        const __mmask16 mask = tailMask(numOutputs - k < 16 ? numOutputs - k : 16);
+        __m512 sum = _mm512_setzero_ps();
+        for (int r = 0; r < numRows; ++r) {
+            const float* c = coeffs + r * coeffStride;
+            const float* x = samples + r * sampleStride + k;
+            for (int t = 0; t < numTaps; ++t) {
+                sum = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x + t), _mm512_set1_ps(c[t]), sum);
+            }
+        }
+        _mm512_mask_storeu_ps(output + k, mask, sum);
+    }
+}
+
+// Horizontal sums of eight vectors, returned in order in one 256-bit vector
+inline __m256 horizontalSum8(const __m512* sums)
+{
+    __m256 halves[8];
+    for (int j = 0; j < 8; ++j) {
+        const __m512d wide = _mm512_castps_pd(sums[j]);
+        const __m256d low = _mm512_mask_extractf64x4_pd(_mm256_setzero_pd(), 0xF, wide, 0);
+        const __m256d high = _mm512_mask_extractf64x4_pd(_mm256_setzero_pd(), 0xF, wide, 1);
+        halves[j] = _mm256_add_ps(_mm256_castpd_ps(low), _mm256_castpd_ps(high));
+    }
+    const __m256 h01 = _mm256_hadd_ps(halves[0], halves[1]);
+    const __m256 h23 = _mm256_hadd_ps(halves[2], halves[3]);
+    const __m256 h45 = _mm256_hadd_ps(halves[4], halves[5]);
+    const __m256 h67 = _mm256_hadd_ps(halves[6], halves[7]);
+    const __m256 h0123 = _mm256_hadd_ps(h01, h23);
+    const __m256 h4567 = _mm256_hadd_ps(h45, h67);
+    return _mm256_add_ps(_mm256_permute2f128_ps(h0123, h4567, 0x20),
+                         _mm256_permute2f128_ps(h0123, h4567, 0x31));
+}
+
+void firGatherAvx512(const float* coeffs, const int* coeffOffsets,
+                     const float* samples, const int* sampleOffsets,
+                     int numTaps, float* output, int numOutputs)
+{
+    int k = 0;
+
+    // Eight outputs per pass are reduced together; the last tap vector of
+    // each row is masked, so any tap count runs without a scalar tail
+    for (; k + 8 <= numOutputs; k += 8) {
+        __m512 sums[8];
+        for (int j = 0; j < 8; j += 4) {
+            // Four rows advance together to keep four FMA chains in flight
+            const float* c0 = coeffs + coeffOffsets[k + j];
+            const float* c1 = coeffs + coeffOffsets[k + j + 1];
+            const float* c2 = coeffs + coeffOffsets[k + j + 2];
+            const float* c3 = coeffs + coeffOffsets[k + j + 3];
+            const float* x0 = samples + sampleOffsets[k + j];
+            const float* x1 = samples + sampleOffsets[k + j + 1];
+            const float* x2 = samples + sampleOffsets[k + j + 2];
+            const float* x3 = samples + sampleOffsets[k + j + 3];
+            __m512 sum0 = _mm512_setzero_ps();
+            __m512 sum1 = _mm512_setzero_ps();
+            __m512 sum2 = _mm512_setzero_ps();
+            __m512 sum3 = _mm512_setzero_ps();
+            for (int t = 0; t < numTaps; t += 16) {
+                const __mmask16 mask = tailMask(numTaps - t < 16 ? numTaps - t : 16);
+                sum0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x0 + t), _mm512_maskz_loadu_ps(mask, c0 + t), sum0);
+                sum1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x1 + t), _mm512_maskz_loadu_ps(mask, c1 + t), sum1);
+                sum2 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x2 + t), _mm512_maskz_loadu_ps(mask, c2 + t), sum2);
+                sum3 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x3 + t), _mm512_maskz_loadu_ps(mask, c3 + t), sum3);
+            }
+            sums[j] = sum0;
+            sums[j + 1] = sum1;
+            sums[j + 2] = sum2;
+            sums[j + 3] = sum3;
+        }
+        _mm256_storeu_ps(output + k, horizontalSum8(sums));
+    }
+
+    for (; k < numOutputs; ++k) {
+        output[k] = dotProductAvx512(coeffs + coeffOffsets[k], samples + sampleOffsets[k], numTaps);
+    }
+}
+
+// Full-width and 256-bit vector operations for kernels whose vectors may be
+// 8 floats wide (the last lane group of firLanesAvx512(), the 8-point FFT
+// stage): 256-bit AVX2 is faster there than a half-masked 512-bit vector
+struct Lanes16
+{
+    using Vec = __m512;
+    static constexpr int kWidth = 16;
+    static Vec zero() { return _mm512_setzero_ps(); }
+    static Vec broadcast(float value) { return _mm512_set1_ps(value); }
+    static Vec load(const float* data) { return _mm512_loadu_ps(data); }
+    static void store(float* data, Vec value) { _mm512_storeu_ps(data, value); }
+    static Vec fmadd(Vec a, Vec b, Vec c) { return _mm512_fmadd_ps(a, b, c); }
+    static Vec fmsub(Vec a, Vec b, Vec c) { return _mm512_fmsub_ps(a, b, c); }
+    static Vec add(Vec a, Vec b) { return _mm512_add_ps(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm512_sub_ps(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm512_mul_ps(a, b); }
+};
+
+struct Lanes8
+{
+    using Vec = __m256;
+    static constexpr int kWidth = 8;
+    static Vec zero() { return _mm256_setzero_ps(); }
+    static Vec broadcast(float value) { return _mm256_set1_ps(value); }
+    static Vec load(const float* data) { return _mm256_loadu_ps(data); }
+    static void store(float* data, Vec value) { _mm256_storeu_ps(data, value); }
+    static Vec fmadd(Vec a, Vec b, Vec c) { return _mm256_fmadd_ps(a, b, c); }
+    static Vec fmsub(Vec a, Vec b, Vec c) { return _mm256_fmsub_ps(a, b, c); }
+    static Vec add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm256_sub_ps(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+};
+
+template<typename V>
+void firLaneGroup(const float* coeffs, int numTaps, const float* x, int numLanes, long outputStride,
+                  float* output, int numOutputs)
+{
+    using Vec = typename V::Vec;
+    int k = 0;
+
+    // Eight outputs per pass share each coefficient and keep eight FMA
+    // chains in flight, enough to hide the FMA latency
+    for (; k + 8 <= numOutputs; k += 8) {
+        const float* x0 = x + k * outputStride;
+        const float* x4 = x0 + 4 * outputStride;
+        Vec sum0 = V::zero();
+        Vec sum1 = V::zero();
+        Vec sum2 = V::zero();
+        Vec sum3 = V::zero();
+        Vec sum4 = V::zero();
+        Vec sum5 = V::zero();
+        Vec sum6 = V::zero();
+        Vec sum7 = V::zero();
+        for (int t = 0; t < numTaps; ++t) {
+            const Vec coeff = V::broadcast(coeffs[t]);
+            const long offset = static_cast<long>(t) * numLanes;
+            sum0 = V::fmadd(coeff, V::load(x0 + offset), sum0);
+            sum1 = V::fmadd(coeff, V::load(x0 + outputStride + offset), sum1);
+            sum2 = V::fmadd(coeff, V::load(x0 + 2 * outputStride + offset), sum2);
+            sum3 = V::fmadd(coeff, V::load(x0 + 3 * outputStride + offset), sum3);
+            sum4 = V::fmadd(coeff, V::load(x4 + offset), sum4);
+            sum5 = V::fmadd(coeff, V::load(x4 + outputStride + offset), sum5);
+            sum6 = V::fmadd(coeff, V::load(x4 + 2 * outputStride + offset), sum6);
+            sum7 = V::fmadd(coeff, V::load(x4 + 3 * outputStride + offset), sum7);
+        }
+        float* out = output + k * numLanes;
+        V::store(out, sum0);
+        V::store(out + numLanes, sum1);
+        V::store(out + 2 * numLanes, sum2);
+        V::store(out + 3 * numLanes, sum3);
+        V::store(out + 4 * numLanes, sum4);
+        V::store(out + 5 * numLanes, sum5);
+        V::store(out + 6 * numLanes, sum6);
+        V::store(out + 7 * numLanes, sum7);
+    }
+
+    // Remaining outputs split their taps over two chains
+    for (; k < numOutputs; ++k) {
+        const float* x0 = x + k * outputStride;
+        Vec sum0 = V::zero();
+        Vec sum1 = V::zero();
+        int t = 0;
+        for (; t + 2 <= numTaps; t += 2) {
+            sum0 = V::fmadd(V::broadcast(coeffs[t]), V::load(x0 + t * numLanes), sum0);
+            sum1 = V::fmadd(V::broadcast(coeffs[t + 1]), V::load(x0 + (t + 1) * numLanes), sum1);
+        }
+        if (t < numTaps) {
+            sum0 = V::fmadd(V::broadcast(coeffs[t]), V::load(x0 + t * numLanes), sum0);
+        }
+        V::store(output + k * numLanes, V::add(sum0, sum1));
+    }
+}
+
+void firLanesAvx512(const float* coeffs, int numTaps,
+                    const float* frames, int numLanes, int frameStep,
+                    float* output, int numOutputs)
+{
+    const long outputStride = static_cast<long>(frameStep) * numLanes;
+    int c = 0;
+
+    for (; c + 16 <= numLanes; c += 16) {
+        firLaneGroup<Lanes16>(coeffs, numTaps, frames + c, numLanes, outputStride, output + c, numOutputs);
+    }
+    // numLanes is a multiple of 8, so at most one group of 8 is left
+    if (c < numLanes) {
+        firLaneGroup<Lanes8>(coeffs, numTaps, frames + c, numLanes, outputStride, output + c, numOutputs);
+    }
+}
+
+void normalizeAvx512(const float* input, float* output, int numSamples, float mean, float invStd)
+{
+    const __m512 meanVec = _mm512_set1_ps(mean);
+    const __m512 scaleVec = _mm512_set1_ps(invStd);
+
+    for (int i = 0; i < numSamples; i += 16) {
+        const __mmask16 mask = tailMask(numSamples - i < 16 ? numSamples - i : 16);
+        const __m512 x = _mm512_maskz_loadu_ps(mask, input + i);
+        _mm512_mask_storeu_ps(output + i, mask, _mm512_mul_ps(_mm512_sub_ps(x, meanVec), scaleVec));
+    }
+}
+
+void multiplyAccumulateAvx512(const float* input, float gain, float* output, int numSamples)
+{
+    const __m512 gainVec = _mm512_set1_ps(gain);
+    int i = 0;
+
+    for (; i + 16 <= numSamples; i += 16) {
+        _mm512_storeu_ps(output + i, _mm512_fmadd_ps(gainVec, _mm512_loadu_ps(input + i), _mm512_loadu_ps(output + i)));
+    }
+    if (i < numSamples) {
+        const __mmask16 mask = tailMask(numSamples - i);
+        _mm512_mask_storeu_ps(output + i, mask, _mm512_fmadd_ps(gainVec, _mm512_maskz_loadu_ps(mask, input + i),
+                                                                _mm512_maskz_loadu_ps(mask, output + i)));
+    }
+}
+
+template<typename V>
+void fftButterflyGroups(float* re, float* im, const float* twiddleRe, const float* twiddleIm, int size, int half)
+{
+    using Vec = typename V::Vec;
+    for (int start = 0; start < size; start += 2 * half) {
+        float* aRe = re + start;
+        float* aIm = im + start;
+        float* bRe = aRe + half;
+        float* bIm = aIm + half;
+        for (int k = 0; k < half; k += V::kWidth) {
+            const Vec wRe = V::load(twiddleRe + k);
+            const Vec wIm = V::load(twiddleIm + k);
+            const Vec xRe = V::load(bRe + k);
+            const Vec xIm = V::load(bIm + k);
+            const Vec tRe = V::fmsub(xRe, wRe, V::mul(xIm, wIm));
+            const Vec tIm = V::fmadd(xRe, wIm, V::mul(xIm, wRe));
+            const Vec yRe = V::load(aRe + k);
+            const Vec yIm = V::load(aIm + k);
+            V::store(bRe + k, V::sub(yRe, tRe));
+            V::store(bIm + k, V::sub(yIm, tIm));
+            V::store(aRe + k, V::add(yRe, tRe));
+            V::store(aIm + k, V::add(yIm, tIm));
+        }
+    }
+}
+
+void fftButterfliesAvx512(float* re, float* im, const float* twiddleRe, const float* twiddleIm,
+                          int size, int half)
+{
+    // half is a multiple of 8; the 8-point stage runs on 256-bit vectors
+    if (half % 16 == 0) {
+        fftButterflyGroups<Lanes16>(re, im, twiddleRe, twiddleIm, size, half);
+    } else {
+        fftButterflyGroups<Lanes8>(re, im, twiddleRe, twiddleIm, size, half);
+    }
+}
+
+// Stores one block of 8 outputs, applying the ReLU if requested
+inline void storeDenseBlock(float* output, __m256 sum, bool relu)
+{
+    _mm256_storeu_ps(output, relu ? _mm256_max_ps(sum, _mm256_setzero_ps()) : sum);
+}
+
+void denseLayerAvx512(const float* weights, const float* bias, const float* input, int numInputs,
+                      float* output, int numOutputs, bool relu)
+{
+    // Same passes as the AVX2 kernel, kept 256 bits wide: one block's weights
+    // for one input are exactly one ymm, and filling a zmm with two inputs'
+    // weights costs a permute per FMA, which measured slower than AVX2 here
+    const int blockStride = 8 * numInputs;
+    int o = 0;
+
+    for (; o + 64 <= numOutputs; o += 64) {
+        const float* w0 = weights + o * numInputs;
+        const float* w4 = w0 + 4 * blockStride;
+        __m256 sum0 = _mm256_loadu_ps(bias + o);
+        __m256 sum1 = _mm256_loadu_ps(bias + o + 8);
+        __m256 sum2 = _mm256_loadu_ps(bias + o + 16);
+        __m256 sum3 = _mm256_loadu_ps(bias + o + 24);
+        __m256 sum4 = _mm256_loadu_ps(bias + o + 32);
+        __m256 sum5 = _mm256_loadu_ps(bias + o + 40);
+        __m256 sum6 = _mm256_loadu_ps(bias + o + 48);
+        __m256 sum7 = _mm256_loadu_ps(bias + o + 56);
+        for (int i = 0; i < numInputs; ++i) {
+            const __m256 x = _mm256_set1_ps(input[i]);
+            sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(w0 + i * 8), x, sum0);
+            sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(w0 + blockStride + i * 8), x, sum1);
+            sum2 = _mm256_fmadd_ps(_mm256_loadu_ps(w0 + 2 * blockStride + i * 8), x, sum2);
+            sum3 = _mm256_fmadd_ps(_mm256_loadu_ps(w0 + 3 * blockStride + i * 8), x, sum3);
+            sum4 = _mm256_fmadd_ps(_mm256_loadu_ps(w4 + i * 8), x, sum4);
+            sum5 = _mm256_fmadd_ps(_mm256_loadu_ps(w4 + blockStride + i * 8), x, sum5);
+            sum6 = _mm256_fmadd_ps(_mm256_loadu_ps(w4 + 2 * blockStride + i * 8), x, sum6);
+            sum7 = _mm256_fmadd_ps(_mm256_loadu_ps(w4 + 3 * blockStride + i * 8), x, sum7);
+        }
+        storeDenseBlock(output + o, sum0, relu);
+        storeDenseBlock(output + o + 8, sum1, relu);
+        storeDenseBlock(output + o + 16, sum2, relu);
+        storeDenseBlock(output + o + 24, sum3, relu);
+        storeDenseBlock(output + o + 32, sum4, relu);
+        storeDenseBlock(output + o + 40, sum5, relu);
+        storeDenseBlock(output + o + 48, sum6, relu);
+        storeDenseBlock(output + o + 56, sum7, relu);
+    }
+
+    for (; o + 32 <= numOutputs; o += 32) {
+        const float* w = weights + o * numInputs;
+        __m256 even0 = _mm256_loadu_ps(bias + o);
+        __m256 even1 = _mm256_loadu_ps(bias + o + 8);
+        __m256 even2 = _mm256_loadu_ps(bias + o + 16);
+        __m256 even3 = _mm256_loadu_ps(bias + o + 24);
+        __m256 odd0 = _mm256_setzero_ps();
+        __m256 odd1 = _mm256_setzero_ps();
+        __m256 odd2 = _mm256_setzero_ps();
+        __m256 odd3 = _mm256_setzero_ps();
+        int i = 0;
+        for (; i + 2 <= numInputs; i += 2) {
+            const __m256 x0 = _mm256_set1_ps(input[i]);
+            const __m256 x1 = _mm256_set1_ps(input[i + 1]);
+            even0 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i * 8), x0, even0);
+            even1 = _mm256_fmadd_ps(_mm256_loadu_ps(w + blockStride + i * 8), x0, even1);
+            even2 = _mm256_fmadd_ps(_mm256_loadu_ps(w + 2 * blockStride + i * 8), x0, even2);
+            even3 = _mm256_fmadd_ps(_mm256_loadu_ps(w + 3 * blockStride + i * 8), x0, even3);
+            odd0 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i * 8 + 8), x1, odd0);
+            odd1 = _mm256_fmadd_ps(_mm256_loadu_ps(w + blockStride + i * 8 + 8), x1, odd1);
+            odd2 = _mm256_fmadd_ps(_mm256_loadu_ps(w + 2 * blockStride + i * 8 + 8), x1, odd2);
+            odd3 = _mm256_fmadd_ps(_mm256_loadu_ps(w + 3 * blockStride + i * 8 + 8), x1, odd3);
+        }
+        if (i < numInputs) {
+            const __m256 x = _mm256_set1_ps(input[i]);
+            even0 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i * 8), x, even0);
+            even1 = _mm256_fmadd_ps(_mm256_loadu_ps(w + blockStride + i * 8), x, even1);
+            even2 = _mm256_fmadd_ps(_mm256_loadu_ps(w + 2 * blockStride + i * 8), x, even2);
+            even3 = _mm256_fmadd_ps(_mm256_loadu_ps(w + 3 * blockStride + i * 8), x, even3);
+        }
+        storeDenseBlock(output + o, _mm256_add_ps(even0, odd0), relu);
+        storeDenseBlock(output + o + 8, _mm256_add_ps(even1, odd1), relu);
+        storeDenseBlock(output + o + 16, _mm256_add_ps(even2, odd2), relu);
+        storeDenseBlock(output + o + 24, _mm256_add_ps(even3, odd3), relu);
+    }
+
+    for (; o < numOutputs; o += 8) {
+        const float* w = weights + o * numInputs;
+        __m256 sum0 = _mm256_loadu_ps(bias + o);
+        __m256 sum1 = _mm256_setzero_ps();
+        __m256 sum2 = _mm256_setzero_ps();
+        __m256 sum3 = _mm256_setzero_ps();
+        int i = 0;
+        for (; i + 4 <= numInputs; i += 4) {
+            sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i * 8), _mm256_set1_ps(input[i]), sum0);
+            sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i * 8 + 8), _mm256_set1_ps(input[i + 1]), sum1);
+            sum2 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i * 8 + 16), _mm256_set1_ps(input[i + 2]), sum2);
+            sum3 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i * 8 + 24), _mm256_set1_ps(input[i + 3]), sum3);
+        }
+        for (; i < numInputs; ++i) {
+            sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(w + i * 8), _mm256_set1_ps(input[i]), sum0);
+        }
+        storeDenseBlock(output + o, _mm256_add_ps(_mm256_add_ps(sum0, sum1), _mm256_add_ps(sum2, sum3)), relu);
+    }
+}
+
+__m512 tanhAvx512(__m512 x)
+{
+    // Masked min/max: the unmasked forms trip GCC's -Wmaybe-uninitialized
+    const __m512 clamp = _mm512_set1_ps(detail::kTanhClamp);
+    x = _mm512_mask_min_ps(x, 0xFFFF, x, clamp);
+    x = _mm512_mask_max_ps(x, 0xFFFF, x, _mm512_sub_ps(_mm512_setzero_ps(), clamp));
+    const __m512 x2 = _mm512_mul_ps(x, x);
+    __m512 p = _mm512_set1_ps(detail::kTanhNumerator[0]);
+    for (int i = 1; i < detail::kTanhNumeratorTerms; ++i) {
+        p = _mm512_fmadd_ps(p, x2, _mm512_set1_ps(detail::kTanhNumerator[i]));
+    }
+    __m512 q = _mm512_set1_ps(detail::kTanhDenominator[0]);
+    for (int i = 1; i < detail::kTanhDenominatorTerms; ++i) {
+        q = _mm512_fmadd_ps(q, x2, _mm512_set1_ps(detail::kTanhDenominator[i]));
+    }
+    return _mm512_div_ps(_mm512_mul_ps(x, p), q);
+}
+
+void gruUpdateAvx512(const float* inputGates, const float* hiddenGates, float* hidden, int size)
+{
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const float* xr = inputGates;
+    const float* xz = inputGates + size;
+    const float* xn = inputGates + 2 * size;
+    const float* hr = hiddenGates;
+    const float* hz = hiddenGates + size;
+    const float* hn = hiddenGates + 2 * size;
+
+    for (int j = 0; j < size; j += 16) {
+        const __mmask16 mask = tailMask(size - j < 16 ? size - j : 16);
+        const __m512 reset = _mm512_fmadd_ps(half, tanhAvx512(_mm512_mul_ps(
+            half, _mm512_add_ps(_mm512_maskz_loadu_ps(mask, xr + j), _mm512_maskz_loadu_ps(mask, hr + j)))), half);
+        const __m512 update = _mm512_fmadd_ps(half, tanhAvx512(_mm512_mul_ps(
+            half, _mm512_add_ps(_mm512_maskz_loadu_ps(mask, xz + j), _mm512_maskz_loadu_ps(mask, hz + j)))), half);
+        const __m512 candidate = tanhAvx512(
+            _mm512_fmadd_ps(reset, _mm512_maskz_loadu_ps(mask, hn + j), _mm512_maskz_loadu_ps(mask, xn + j)));
+        const __m512 state = _mm512_maskz_loadu_ps(mask, hidden + j);
+        _mm512_mask_storeu_ps(hidden + j, mask, _mm512_fmadd_ps(update, _mm512_sub_ps(state, candidate), candidate));
+    }
+}
+
+void frameFeaturesAvx512(const float* samples, int numSamples, FrameFeatures& features)
+{
+    if (numSamples <= 0) {
+        features.sumSquares = 0.0f;
+        features.zeroCrossings = 0.0f;
+        features.sumMagnitude = 0.0f;
+        features.weightedMagnitude = 0.0f;
+        return;
+    }
+
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 one = _mm512_set1_ps(1.0f);
+    __m512 squares = zero;
+    __m512 crossings = zero;
+    __m512 magnitudes = zero;
+    __m512 weighted = zero;
+    __m512 index = _mm512_setr_ps(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f,
+                                  9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f);
+    const __m512 indexStep = _mm512_set1_ps(16.0f);
+
+    // Sample 0 has no predecessor; the vector loop starts at sample 1
+    const float first = samples[0];
+    float sumSquares = first * first;
+    float sumMagnitude = first < 0.0f ? -first : first;
+
+    for (int i = 1; i < numSamples; i += 16) {
+        const __mmask16 mask = tailMask(numSamples - i < 16 ? numSamples - i : 16);
+        const __m512 x = _mm512_maskz_loadu_ps(mask, samples + i);
+        const __m512 previous = _mm512_maskz_loadu_ps(mask, samples + i - 1);
+        const __m512 magnitude = _mm512_abs_ps(x);
+        const __mmask16 signChange = _mm512_cmp_ps_mask(x, zero, _CMP_GE_OQ)
+                                   ^ _mm512_cmp_ps_mask(previous, zero, _CMP_GE_OQ);
+        squares = _mm512_fmadd_ps(x, x, squares);
+        magnitudes = _mm512_add_ps(magnitudes, magnitude);
+        weighted = _mm512_fmadd_ps(magnitude, index, weighted);
+        crossings = _mm512_mask_add_ps(crossings, signChange & mask, crossings, one);
+        index = _mm512_add_ps(index, indexStep);
+    }
+
+    features.sumSquares = sumSquares + horizontalSum(squares);
+    features.zeroCrossings = horizontalSum(crossings);
+    features.sumMagnitude = sumMagnitude + horizontalSum(magnitudes);
+    features.weightedMagnitude = horizontalSum(weighted);
+}
+
+float medianAvx512(const float* values, int numValues)
+{
+    if (numValues <= 0) {
+        return 0.0f;
+    }
+
+    const int lowerRank = (numValues - 1) / 2;
+    const int upperRank = numValues / 2;
+    const __m512 one = _mm512_set1_ps(1.0f);
+    float lower = 0.0f;
+    float upper = 0.0f;
+    bool foundLower = false;
+    bool foundUpper = false;
+
+    for (int i = 0; i < numValues && !(foundLower && foundUpper); ++i) {
+        const float candidate = values[i];
+        const __m512 candidateVec = _mm512_set1_ps(candidate);
+        __m512 lessVec = _mm512_setzero_ps();
+        __m512 equalVec = _mm512_setzero_ps();
+        for (int j = 0; j < numValues; j += 16) {
+            const __mmask16 mask = tailMask(numValues - j < 16 ? numValues - j : 16);
+            const __m512 v = _mm512_maskz_loadu_ps(mask, values + j);
+            lessVec = _mm512_mask_add_ps(lessVec, _mm512_mask_cmp_ps_mask(mask, v, candidateVec, _CMP_LT_OQ),
+                                         lessVec, one);
+            equalVec = _mm512_mask_add_ps(equalVec, _mm512_mask_cmp_ps_mask(mask, v, candidateVec, _CMP_EQ_OQ),
+                                          equalVec, one);
+        }
+        const int less = static_cast<int>(horizontalSum(lessVec));
+        const int equal = static_cast<int>(horizontalSum(equalVec));
+        if (!foundLower && less <= lowerRank && lowerRank < less + equal) {
+            lower = candidate;
+            foundLower = true;
+        }
+        if (!foundUpper && less <= upperRank && upperRank < less + equal) {
+            upper = candidate;
+            foundUpper = true;
+        }
+    }
+
+    return (lower + upper) * 0.5f;
+}
+
+constexpr DspKernels kAvx512Kernels = {
+    SimdLevel::AVX512,
+    dotProductAvx512,
+    firBlockRowsAvx512,
+    firGatherAvx512,
+    firLanesAvx512,
+    normalizeAvx512,
+    multiplyAccumulateAvx512,
+    fftButterfliesAvx512,
+    denseLayerAvx512,
+    gruUpdateAvx512,
+    frameFeaturesAvx512,
+    medianAvx512
+};
+
+} // namespace
+
+namespace detail {
+
+const DspKernels* getAvx512Kernels()
+{
+    return &kAvx512Kernels;
+}
+
+} // namespace detail
+
+#else
+
+namespace detail {
+
+const DspKernels* getAvx512Kernels()
+{
+    return nullptr;
+}
+
+} // namespace detail
+
+#endif
+
+} // namespace KhDetector
@@ -0,0 +1,492 @@
+// NEON kernels. Built without extra flags on AArch64, where NEON is baseline.
+// Only intrinsics and DspKernels.h may be included here: any inline function
+// emitted by this unit could otherwise be picked by the linker for the whole
+// program.
+
+#include "DspKernels.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+    #include <arm_neon.h>
+    #define KHDETECTOR_HAVE_NEON 1
+#endif
+
+namespace KhDetector {
+
+#if defined(KHDETECTOR_HAVE_NEON)
+
+namespace {
+
+inline float horizontalSum(float32x4_t sum)
+{
+    float32x2_t pair = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+    return vget_lane_f32(vpadd_f32(pair, pair), 0);
+}
+
+float dotProductNeon(const float* coeffs, const float* samples, int length)
+{
+    float32x4_t sum0 = vdupq_n_f32(0.0f);
+    float32x4_t sum1 = vdupq_n_f32(0.0f);
+    int i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        sum0 = vmlaq_f32(sum0, vld1q_f32(samples + i), vld1q_f32(coeffs + i));
+        sum1 = vmlaq_f32(sum1, vld1q_f32(samples + i + 4), vld1q_f32(coeffs + i + 4));
+    }
+    if (i + 4 <= length) {
+        sum0 = vmlaq_f32(sum0, vld1q_f32(samples + i), vld1q_f32(coeffs + i));
+        i += 4;
+    }
+
+    float total = horizontalSum(vaddq_f32(sum0, sum1));
+    for (; i < length; ++i) {
+        total += samples[i] * coeffs[i];
+    }
+    return total;
+}
+
+void firBlockRowsNeon(const float* coeffs, int coeffStride,
+                      const float* samples, int sampleStride,
+                      int numRows, int numTaps,
+                      float* output, int numOutputs)
+{
+    int k = 0;
+
+    // Four output vectors per pass share each coefficient
+    for (; k + 16 <= numOutputs; k += 16) {
+        float32x4_t sum0 = vdupq_n_f32(0.0f);
+        float32x4_t sum1 = vdupq_n_f32(0.0f);
+        float32x4_t sum2 = vdupq_n_f32(0.0f);
+        float32x4_t sum3 = vdupq_n_f32(0.0f);
+        for (int r = 0; r < numRows; ++r) {
+            const float* c = coeffs + r * coeffStride;
+            const float* x = samples + r * sampleStride + k;
+            for (int t = 0; t < numTaps; ++t) {
+                const float coeff = c[t];
+                sum0 = vmlaq_n_f32(sum0, vld1q_f32(x + t), coeff);
+                sum1 = vmlaq_n_f32(sum1, vld1q_f32(x + t + 4), coeff);
+                sum2 = vmlaq_n_f32(sum2, vld1q_f32(x + t + 8), coeff);
+                sum3 = vmlaq_n_f32(sum3, vld1q_f32(x + t + 12), coeff);
+            }
+        }
+        vst1q_f32(output + k, sum0);
+        vst1q_f32(output + k + 4, sum1);
+        vst1q_f32(output + k + 8, sum2);
+        vst1q_f32(output + k + 12, sum3);
+    }
+    for (; k + 4 <= numOutputs; k += 4) {
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        for (int r = 0; r < numRows; ++r) {
+            const float* c = coeffs + r * coeffStride;
+            const float* x = samples + r * sampleStride + k;
+            for (int t = 0; t < numTaps; ++t) {
+                sum = vmlaq_n_f32(sum, vld1q_f32(x + t), c[t]);
+            }
+        }
+        vst1q_f32(output + k, sum);
+    }
+
+    // Remaining outputs one at a time, vectorized across taps
+    const int simdTaps = (numTaps / 4) * 4;
+    for (; k < numOutputs; ++k) {
+        float32x4_t acc = vdupq_n_f32(0.0f);
+        for (int r = 0; r < numRows; ++r) {
+            const float* c = coeffs + r * coeffStride;
+            const float* x = samples + r * sampleStride + k;
+            for (int t = 0; t < simdTaps; t += 4) {
+                acc = vmlaq_f32(acc, vld1q_f32(x + t), vld1q_f32(c + t));
+            }
+        }
+        float sum = horizontalSum(acc);
+        for (int r = 0; r < numRows; ++r) {
+            const float* c = coeffs + r * coeffStride;
+            const float* x = samples + r * sampleStride + k;
+            for (int t = simdTaps; t < numTaps; ++t) {
+                sum += x[t] * c[t];
+            }
+        }
+        output[k] = sum;
+    }
+}
+
+void firGatherNeon(const float* coeffs, const int* coeffOffsets,
+                   const float* samples, const int* sampleOffsets,
+                   int numTaps, float* output, int numOutputs)
+{
+    for (int k = 0; k < numOutputs; ++k) {
+        output[k] = dotProductNeon(coeffs + coeffOffsets[k], samples + sampleOffsets[k], numTaps);
+    }
+}
+
+void firLanesNeon(const float* coeffs, int numTaps,
+                  const float* frames, int numLanes, int frameStep,
+                  float* output, int numOutputs)
+{
+    const long outputStride = static_cast<long>(frameStep) * numLanes;
+
+    for (int c = 0; c < numLanes; c += 4) {
+        const float* x = frames + c;
+        int k = 0;
+
+        // Eight outputs per pass share each coefficient and keep eight
+        // multiply-add chains in flight, enough to hide their latency
+        for (; k + 8 <= numOutputs; k += 8) {
+            const float* x0 = x + k * outputStride;
+            const float* x4 = x0 + 4 * outputStride;
+            float32x4_t sum0 = vdupq_n_f32(0.0f);
+            float32x4_t sum1 = vdupq_n_f32(0.0f);
+            float32x4_t sum2 = vdupq_n_f32(0.0f);
+            float32x4_t sum3 = vdupq_n_f32(0.0f);
+            float32x4_t sum4 = vdupq_n_f32(0.0f);
+            float32x4_t sum5 = vdupq_n_f32(0.0f);
+            float32x4_t sum6 = vdupq_n_f32(0.0f);
+            float32x4_t sum7 = vdupq_n_f32(0.0f);
+            for (int t = 0; t < numTaps; ++t) {
+                const float coeff = coeffs[t];
+                const long offset = static_cast<long>(t) * numLanes;
+                sum0 = vmlaq_n_f32(sum0, vld1q_f32(x0 + offset), coeff);
+                sum1 = vmlaq_n_f32(sum1, vld1q_f32(x0 + outputStride + offset), coeff);
+                sum2 = vmlaq_n_f32(sum2, vld1q_f32(x0 + 2 * outputStride + offset), coeff);
+                sum3 = vmlaq_n_f32(sum3, vld1q_f32(x0 + 3 * outputStride + offset), coeff);
+                sum4 = vmlaq_n_f32(sum4, vld1q_f32(x4 + offset), coeff);
+                sum5 = vmlaq_n_f32(sum5, vld1q_f32(x4 + outputStride + offset), coeff);
+                sum6 = vmlaq_n_f32(sum6, vld1q_f32(x4 + 2 * outputStride + offset), coeff);
+                sum7 = vmlaq_n_f32(sum7, vld1q_f32(x4 + 3 * outputStride + offset), coeff);
+            }
+            float* out = output + k * numLanes + c;
+            vst1q_f32(out, sum0);
+            vst1q_f32(out + numLanes, sum1);
+            vst1q_f32(out + 2 * numLanes, sum2);
+            vst1q_f32(out + 3 * numLanes, sum3);
+            vst1q_f32(out + 4 * numLanes, sum4);
+            vst1q_f32(out + 5 * numLanes, sum5);
+            vst1q_f32(out + 6 * numLanes, sum6);
+            vst1q_f32(out + 7 * numLanes, sum7);
+        }
+
+        // Remaining outputs split their taps over two chains
+        for (; k < numOutputs; ++k) {
+            const float* x0 = x + k * outputStride;
+            float32x4_t sum0 = vdupq_n_f32(0.0f);
+            float32x4_t sum1 = vdupq_n_f32(0.0f);
+            int t = 0;
+            for (; t + 2 <= numTaps; t += 2) {
+                sum0 = vmlaq_n_f32(sum0, vld1q_f32(x0 + t * numLanes), coeffs[t]);
+                sum1 = vmlaq_n_f32(sum1, vld1q_f32(x0 + (t + 1) * numLanes), coeffs[t + 1]);
+            }
+            if (t < numTaps) {
+                sum0 = vmlaq_n_f32(sum0, vld1q_f32(x0 + t * numLanes), coeffs[t]);
+            }
+            vst1q_f32(output + k * numLanes + c, vaddq_f32(sum0, sum1));
+        }
+    }
+}
+
+void normalizeNeon(const float* input, float* output, int numSamples, float mean, float invStd)
+{
+    const float32x4_t meanVec = vdupq_n_f32(mean);
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4) {
+        vst1q_f32(output + i, vmulq_n_f32(vsubq_f32(vld1q_f32(input + i), meanVec), invStd));
+    }
+    for (; i < numSamples; ++i) {
+        output[i] = (input[i] - mean) * invStd;
+    }
+}
+
+void multiplyAccumulateNeon(const float* input, float gain, float* output, int numSamples)
+{
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4) {
+        vst1q_f32(output + i, vmlaq_n_f32(vld1q_f32(output + i), vld1q_f32(input + i), gain));
+    }
+    for (; i < numSamples; ++i) {
+        output[i] += gain * input[i];
+    }
+}
+
+void fftButterfliesNeon(float* re, float* im, const float* twiddleRe, const float* twiddleIm,
+                        int size, int half)
+{
+    for (int start = 0; start < size; start += 2 * half) {
+        float* aRe = re + start;
+        float* aIm = im + start;
+        float* bRe = aRe + half;
+        float* bIm = aIm + half;
+        for (int k = 0; k < half; k += 4) {
+            const float32x4_t wRe = vld1q_f32(twiddleRe + k);
+            const float32x4_t wIm = vld1q_f32(twiddleIm + k);
+            const float32x4_t xRe = vld1q_f32(bRe + k);
+            const float32x4_t xIm = vld1q_f32(bIm + k);
+            const float32x4_t tRe = vmlsq_f32(vmulq_f32(xRe, wRe), xIm, wIm);
+            const float32x4_t tIm = vmlaq_f32(vmulq_f32(xRe, wIm), xIm, wRe);
+            const float32x4_t yRe = vld1q_f32(aRe + k);
+            const float32x4_t yIm = vld1q_f32(aIm + k);
+            vst1q_f32(bRe + k, vsubq_f32(yRe, tRe));
+            vst1q_f32(bIm + k, vsubq_f32(yIm, tIm));
+            vst1q_f32(aRe + k, vaddq_f32(yRe, tRe));
+            vst1q_f32(aIm + k, vaddq_f32(yIm, tIm));
+        }
+    }
+}
+
+void denseLayerNeon(const float* weights, const float* bias, const float* input, int numInputs,
+                    float* output, int numOutputs, bool relu)
+{
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    int o = 0;
+
+    // Two blocks of 8 outputs per pass share each broadcast input
+    for (; o + 16 <= numOutputs; o += 16) {
+        const float* w0 = weights + o * numInputs;
+        const float* w1 = w0 + 8 * numInputs;
+        float32x4_t sum0 = vld1q_f32(bias + o);
+        float32x4_t sum1 = vld1q_f32(bias + o + 4);
+        float32x4_t sum2 = vld1q_f32(bias + o + 8);
+        float32x4_t sum3 = vld1q_f32(bias + o + 12);
+        for (int i = 0; i < numInputs; ++i) {
+            const float32x4_t x = vdupq_n_f32(input[i]);
+            sum0 = vmlaq_f32(sum0, vld1q_f32(w0 + i * 8), x);
+            sum1 = vmlaq_f32(sum1, vld1q_f32(w0 + i * 8 + 4), x);
+            sum2 = vmlaq_f32(sum2, vld1q_f32(w1 + i * 8), x);
+            sum3 = vmlaq_f32(sum3, vld1q_f32(w1 + i * 8 + 4), x);
+        }
+        if (relu) {
+            sum0 = vmaxq_f32(sum0, zero);
+            sum1 = vmaxq_f32(sum1, zero);
+            sum2 = vmaxq_f32(sum2, zero);
+            sum3 = vmaxq_f32(sum3, zero);
+        }
+        vst1q_f32(output + o, sum0);
+        vst1q_f32(output + o + 4, sum1);
+        vst1q_f32(output + o + 8, sum2);
+        vst1q_f32(output + o + 12, sum3);
+    }
+
+    for (; o < numOutputs; o += 8) {
+        const float* w = weights + o * numInputs;
+        float32x4_t sum0 = vld1q_f32(bias + o);
+        float32x4_t sum1 = vld1q_f32(bias + o + 4);
+        for (int i = 0; i < numInputs; ++i) {
+            const float32x4_t x = vdupq_n_f32(input[i]);
+            sum0 = vmlaq_f32(sum0, vld1q_f32(w + i * 8), x);
+            sum1 = vmlaq_f32(sum1, vld1q_f32(w + i * 8 + 4), x);
+        }
+        if (relu) {
+            sum0 = vmaxq_f32(sum0, zero);
+            sum1 = vmaxq_f32(sum1, zero);
+        }
+        vst1q_f32(output + o, sum0);
+        vst1q_f32(output + o + 4, sum1);
+    }
+}
+
+float32x4_t tanhNeon(float32x4_t x)
+{
+    const float32x4_t clamp = vdupq_n_f32(detail::kTanhClamp);
+    x = vminq_f32(clamp, vmaxq_f32(vnegq_f32(clamp), x));
+    const float32x4_t x2 = vmulq_f32(x, x);
+    float32x4_t p = vdupq_n_f32(detail::kTanhNumerator[0]);
+    for (int i = 1; i < detail::kTanhNumeratorTerms; ++i) {
+        p = vmlaq_f32(vdupq_n_f32(detail::kTanhNumerator[i]), p, x2);
+    }
+    float32x4_t q = vdupq_n_f32(detail::kTanhDenominator[0]);
+    for (int i = 1; i < detail::kTanhDenominatorTerms; ++i) {
+        q = vmlaq_f32(vdupq_n_f32(detail::kTanhDenominator[i]), q, x2);
+    }
+
+    // 1 / q from the estimate and two Newton steps (32-bit ARM has no vector divide)
+    float32x4_t inverse = vrecpeq_f32(q);
+    inverse = vmulq_f32(vrecpsq_f32(q, inverse), inverse);
+    inverse = vmulq_f32(vrecpsq_f32(q, inverse), inverse);
+    return vmulq_f32(vmulq_f32(x, p), inverse);
+}
+
+// 4 units of gruUpdate(); a unit's reset, update and new rows are gateStride apart
+void gruLanesNeon(const float* x, const float* h, int gateStride, float* hidden)
+{
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    const float32x4_t reset = vmlaq_f32(half, half,
+        tanhNeon(vmulq_f32(half, vaddq_f32(vld1q_f32(x), vld1q_f32(h)))));
+    const float32x4_t update = vmlaq_f32(half, half,
+        tanhNeon(vmulq_f32(half, vaddq_f32(vld1q_f32(x + gateStride), vld1q_f32(h + gateStride)))));
+    const float32x4_t candidate = tanhNeon(
+        vmlaq_f32(vld1q_f32(x + 2 * gateStride), reset, vld1q_f32(h + 2 * gateStride)));
+    const float32x4_t state = vld1q_f32(hidden);
+    vst1q_f32(hidden, vmlaq_f32(candidate, update, vsubq_f32(state, candidate)));
+}
+
+void gruUpdateNeon(const float* inputGates, const float* hiddenGates, float* hidden, int size)
+{
+    int j = 0;
+    for (; j + 4 <= size; j += 4) {
+        gruLanesNeon(inputGates + j, hiddenGates + j, size, hidden + j);
+    }
+    if (j < size) {
+        // The last units go through one zero-padded vector, the same arithmetic as the others
+        float x[3 * 4] = {};
+        float h[3 * 4] = {};
+        float state[4] = {};
+        const int count = size - j;
+        for (int gate = 0; gate < 3; ++gate) {
+            for (int k = 0; k < count; ++k) {
+                x[gate * 4 + k] = inputGates[gate * size + j + k];
+                h[gate * 4 + k] = hiddenGates[gate * size + j + k];
+            }
+        }
+        for (int k = 0; k < count; ++k) {
+            state[k] = hidden[j + k];
+        }
+        gruLanesNeon(x, h, 4, state);
+        for (int k = 0; k < count; ++k) {
+            hidden[j + k] = state[k];
+        }
+    }
+}
+
+void frameFeaturesNeon(const float* samples, int numSamples, FrameFeatures& features)
+{
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const uint32x4_t one = vreinterpretq_u32_f32(vdupq_n_f32(1.0f));
+    float32x4_t squares = zero;
+    float32x4_t crossings = zero;
+    float32x4_t magnitudes = zero;
+    float32x4_t weighted = zero;
+    const float indexInit[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+    float32x4_t index = vld1q_f32(indexInit);
+    const float32x4_t indexStep = vdupq_n_f32(4.0f);
+
+    float sumSquares = 0.0f;
+    float zeroCrossings = 0.0f;
+    float sumMagnitude = 0.0f;
+    float weightedMagnitude = 0.0f;
+    int i = 0;
+
+    if (numSamples > 0) {
+        // Sample 0 has no predecessor; the vector loop starts at sample 1
+        const float first = samples[0];
+        sumSquares = first * first;
+        sumMagnitude = first < 0.0f ? -first : first;
+        i = 1;
+    }
+
+    for (; i + 4 <= numSamples; i += 4) {
+        const float32x4_t x = vld1q_f32(samples + i);
+        const float32x4_t previous = vld1q_f32(samples + i - 1);
+        const float32x4_t magnitude = vabsq_f32(x);
+        const uint32x4_t signChange = veorq_u32(vcgeq_f32(x, zero), vcgeq_f32(previous, zero));
+        squares = vmlaq_f32(squares, x, x);
+        magnitudes = vaddq_f32(magnitudes, magnitude);
+        weighted = vmlaq_f32(weighted, magnitude, index);
+        crossings = vaddq_f32(crossings, vreinterpretq_f32_u32(vandq_u32(signChange, one)));
+        index = vaddq_f32(index, indexStep);
+    }
+
+    sumSquares += horizontalSum(squares);
+    zeroCrossings += horizontalSum(crossings);
+    sumMagnitude += horizontalSum(magnitudes);
+    weightedMagnitude += horizontalSum(weighted);
+
+    for (; i < numSamples; ++i) {
+        const float magnitude = samples[i] < 0.0f ? -samples[i] : samples[i];
+        sumSquares += samples[i] * samples[i];
+        sumMagnitude += magnitude;
+        weightedMagnitude += magnitude * static_cast<float>(i);
+        if ((samples[i] >= 0.0f) != (samples[i - 1] >= 0.0f)) {
+            zeroCrossings += 1.0f;
+        }
+    }
+
+    features.sumSquares = sumSquares;
+    features.zeroCrossings = zeroCrossings;
+    features.sumMagnitude = sumMagnitude;
+    features.weightedMagnitude = weightedMagnitude;
+}
+
+float medianNeon(const float* values, int numValues)
+{
+    if (numValues <= 0) {
+        return 0.0f;
+    }
+
+    const int lowerRank = (numValues - 1) / 2;
+    const int upperRank = numValues / 2;
+    const uint32x4_t one = vdupq_n_u32(1);
+    float lower = 0.0f;
+    float upper = 0.0f;
+    bool foundLower = false;
+    bool foundUpper = false;
+
+    for (int i = 0; i < numValues && !(foundLower && foundUpper); ++i) {
+        const float candidate = values[i];
+        const float32x4_t candidateVec = vdupq_n_f32(candidate);
+        uint32x4_t lessVec = vdupq_n_u32(0);
+        uint32x4_t equalVec = vdupq_n_u32(0);
+        int j = 0;
+        for (; j + 4 <= numValues; j += 4) {
+            const float32x4_t v = vld1q_f32(values + j);
+            lessVec = vaddq_u32(lessVec, vandq_u32(vcltq_f32(v, candidateVec), one));
+            equalVec = vaddq_u32(equalVec, vandq_u32(vceqq_f32(v, candidateVec), one));
+        }
+        int less = static_cast<int>(vgetq_lane_u32(lessVec, 0) + vgetq_lane_u32(lessVec, 1)
+                                  + vgetq_lane_u32(lessVec, 2) + vgetq_lane_u32(lessVec, 3));
+        int equal = static_cast<int>(vgetq_lane_u32(equalVec, 0) + vgetq_lane_u32(equalVec, 1)
+                                   + vgetq_lane_u32(equalVec, 2) + vgetq_lane_u32(equalVec, 3));
+        for (; j < numValues; ++j) {
+            less += values[j] < candidate;
+            equal += values[j] == candidate;
+        }
+        if (!foundLower && less <= lowerRank && lowerRank < less + equal) {
+            lower = candidate;
+            foundLower = true;
+        }
+        if (!foundUpper && less <= upperRank && upperRank < less + equal) {
+            upper = candidate;
+            foundUpper = true;
+        }
+    }
+
+    return (lower + upper) * 0.5f;
+}
+
+constexpr DspKernels kNeonKernels = {
+    SimdLevel::NEON,
+    dotProductNeon,
+    firBlockRowsNeon,
+    firGatherNeon,
+    firLanesNeon,
+    normalizeNeon,
+    multiplyAccumulateNeon,
+    fftButterfliesNeon,
+    denseLayerNeon,
+    gruUpdateNeon,
+    frameFeaturesNeon,
+    medianNeon
+};
+
+} // namespace
+
+namespace detail {
+
+const DspKernels* getNeonKernels()
+{
+    return &kNeonKernels;
+}
+
+} // namespace detail
+
+#else
+
+namespace detail {
+
+const DspKernels* getNeonKernels()
+{
+    return nullptr;
+}
+
+} // namespace detail
+
+#endif
+
+} // namespace KhDetector
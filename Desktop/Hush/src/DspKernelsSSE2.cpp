@@ -0,0 +1,520 @@
+// SSE2 kernels. Built without extra flags on x86-64, where SSE2 is baseline.
+// Only intrinsics and DspKernels.h may be included here: any inline function
+// emitted by this unit could otherwise be picked by the linker for the whole
+// program.
+
+#include "DspKernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define KHDETECTOR_HAVE_SSE2 1
+#endif
+
+namespace KhDetector {
+
+#if defined(KHDETECTOR_HAVE_SSE2)
+
+namespace {
+
+inline float horizontalSum(__m128 sum)
+{
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 0x55));
+    return _mm_cvtss_f32(sum);
+}
+
+float dotProductSse2(const float* coeffs, const float* samples, int length)
+{
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    int i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(samples + i), _mm_loadu_ps(coeffs + i)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(samples + i + 4), _mm_loadu_ps(coeffs + i + 4)));
+    }
+    if (i + 4 <= length) {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(samples + i), _mm_loadu_ps(coeffs + i)));
+        i += 4;
+    }
+
+    float total = horizontalSum(_mm_add_ps(sum0, sum1));
+    for (; i < length; ++i) {
+        total += samples[i] * coeffs[i];
+    }
+    return total;
+}
+
+void firBlockRowsSse2(const float* coeffs, int coeffStride,
+                      const float* samples, int sampleStride,
+                      int numRows, int numTaps,
+                      float* output, int numOutputs)
+{
+    int k = 0;
+
+    // Two output vectors per pass share each broadcast coefficient
+    for (; k + 8 <= numOutputs; k += 8) {
+        __m128 sum0 = _mm_setzero_ps();
+        __m128 sum1 = _mm_setzero_ps();
+        for (int r = 0; r < numRows; ++r) {
+            const float* c = coeffs + r * coeffStride;
+            const float* x = samples + r * sampleStride + k;
+            for (int t = 0; t < numTaps; ++t) {
+                const __m128 coeff = _mm_set1_ps(c[t]);
+                sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(x + t), coeff));
+                sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(x + t + 4), coeff));
+            }
+        }
+        _mm_storeu_ps(output + k, sum0);
+        _mm_storeu_ps(output + k + 4, sum1);
+    }
+    for (; k + 4 <= numOutputs; k += 4) {
+        __m128 sum = _mm_setzero_ps();
+        for (int r = 0; r < numRows; ++r) {
+            const float* c = coeffs + r * coeffStride;
+            const float* x = samples + r * sampleStride + k;
+            for (int t = 0; t < numTaps; ++t) {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(x + t), _mm_set1_ps(c[t])));
+            }
+        }
+        _mm_storeu_ps(output + k, sum);
+    }
+
+    // Remaining outputs one at a time, vectorized across taps
+    const int simdTaps = (numTaps / 4) * 4;
+    for (; k < numOutputs; ++k) {
+        __m128 acc = _mm_setzero_ps();
+        for (int r = 0; r < numRows; ++r) {
+            const float* c = coeffs + r * coeffStride;
+            const float* x = samples + r * sampleStride + k;
+            for (int t = 0; t < simdTaps; t += 4) {
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(x + t), _mm_loadu_ps(c + t)));
+            }
+        }
+        float sum = horizontalSum(acc);
+        for (int r = 0; r < numRows; ++r) {
+            const float* c = coeffs + r * coeffStride;
+            const float* x = samples + r * sampleStride + k;
+            for (int t = simdTaps; t < numTaps; ++t) {
+                sum += x[t] * c[t];
+            }
+        }
+        output[k] = sum;
+    }
+}
+
+void firGatherSse2(const float* coeffs, const int* coeffOffsets,
+                   const float* samples, const int* sampleOffsets,
+                   int numTaps, float* output, int numOutputs)
+{
+    const int simdTaps = (numTaps / 4) * 4;
+    int k = 0;
+
+    // Four outputs per pass are reduced together with one transpose
+    for (; k + 4 <= numOutputs; k += 4) {
+        // The four rows advance together to keep four add chains in flight
+        const float* c0 = coeffs + coeffOffsets[k];
+        const float* c1 = coeffs + coeffOffsets[k + 1];
+        const float* c2 = coeffs + coeffOffsets[k + 2];
+        const float* c3 = coeffs + coeffOffsets[k + 3];
+        const float* x0 = samples + sampleOffsets[k];
+        const float* x1 = samples + sampleOffsets[k + 1];
+        const float* x2 = samples + sampleOffsets[k + 2];
+        const float* x3 = samples + sampleOffsets[k + 3];
+        __m128 sum0 = _mm_setzero_ps();
+        __m128 sum1 = _mm_setzero_ps();
+        __m128 sum2 = _mm_setzero_ps();
+        __m128 sum3 = _mm_setzero_ps();
+        for (int t = 0; t < simdTaps; t += 4) {
+            sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(x0 + t), _mm_loadu_ps(c0 + t)));
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(x1 + t), _mm_loadu_ps(c1 + t)));
+            sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(x2 + t), _mm_loadu_ps(c2 + t)));
+            sum3 = _mm_add_ps(sum3, _mm_mul_ps(_mm_loadu_ps(x3 + t), _mm_loadu_ps(c3 + t)));
+        }
+        _MM_TRANSPOSE4_PS(sum0, sum1, sum2, sum3);
+        _mm_storeu_ps(output + k, _mm_add_ps(_mm_add_ps(sum0, sum1), _mm_add_ps(sum2, sum3)));
+
+        for (int j = 0; j < 4 && simdTaps < numTaps; ++j) {
+            const float* c = coeffs + coeffOffsets[k + j];
+            const float* x = samples + sampleOffsets[k + j];
+            for (int t = simdTaps; t < numTaps; ++t) {
+                output[k + j] += x[t] * c[t];
+            }
+        }
+    }
+
+    for (; k < numOutputs; ++k) {
+        output[k] = dotProductSse2(coeffs + coeffOffsets[k], samples + sampleOffsets[k], numTaps);
+    }
+}
+
+void firLanesSse2(const float* coeffs, int numTaps,
+                  const float* frames, int numLanes, int frameStep,
+                  float* output, int numOutputs)
+{
+    const long outputStride = static_cast<long>(frameStep) * numLanes;
+
+    for (int c = 0; c < numLanes; c += 4) {
+        const float* x = frames + c;
+        int k = 0;
+
+        // Eight outputs per pass share each coefficient and keep eight add
+        // chains in flight, enough to hide the add latency
+        for (; k + 8 <= numOutputs; k += 8) {
+            const float* x0 = x + k * outputStride;
+            const float* x4 = x0 + 4 * outputStride;
+            __m128 sum0 = _mm_setzero_ps();
+            __m128 sum1 = _mm_setzero_ps();
+            __m128 sum2 = _mm_setzero_ps();
+            __m128 sum3 = _mm_setzero_ps();
+            __m128 sum4 = _mm_setzero_ps();
+            __m128 sum5 = _mm_setzero_ps();
+            __m128 sum6 = _mm_setzero_ps();
+            __m128 sum7 = _mm_setzero_ps();
+            for (int t = 0; t < numTaps; ++t) {
+                const __m128 coeff = _mm_set1_ps(coeffs[t]);
+                const long offset = static_cast<long>(t) * numLanes;
+                sum0 = _mm_add_ps(sum0, _mm_mul_ps(coeff, _mm_loadu_ps(x0 + offset)));
+                sum1 = _mm_add_ps(sum1, _mm_mul_ps(coeff, _mm_loadu_ps(x0 + outputStride + offset)));
+                sum2 = _mm_add_ps(sum2, _mm_mul_ps(coeff, _mm_loadu_ps(x0 + 2 * outputStride + offset)));
+                sum3 = _mm_add_ps(sum3, _mm_mul_ps(coeff, _mm_loadu_ps(x0 + 3 * outputStride + offset)));
+                sum4 = _mm_add_ps(sum4, _mm_mul_ps(coeff, _mm_loadu_ps(x4 + offset)));
+                sum5 = _mm_add_ps(sum5, _mm_mul_ps(coeff, _mm_loadu_ps(x4 + outputStride + offset)));
+                sum6 = _mm_add_ps(sum6, _mm_mul_ps(coeff, _mm_loadu_ps(x4 + 2 * outputStride + offset)));
+                sum7 = _mm_add_ps(sum7, _mm_mul_ps(coeff, _mm_loadu_ps(x4 + 3 * outputStride + offset)));
+            }
+            float* out = output + k * numLanes + c;
+            _mm_storeu_ps(out, sum0);
+            _mm_storeu_ps(out + numLanes, sum1);
+            _mm_storeu_ps(out + 2 * numLanes, sum2);
+            _mm_storeu_ps(out + 3 * numLanes, sum3);
+            _mm_storeu_ps(out + 4 * numLanes, sum4);
+            _mm_storeu_ps(out + 5 * numLanes, sum5);
+            _mm_storeu_ps(out + 6 * numLanes, sum6);
+            _mm_storeu_ps(out + 7 * numLanes, sum7);
+        }
+
+        // Remaining outputs split their taps over two chains
+        for (; k < numOutputs; ++k) {
+            const float* x0 = x + k * outputStride;
+            __m128 sum0 = _mm_setzero_ps();
+            __m128 sum1 = _mm_setzero_ps();
+            int t = 0;
+            for (; t + 2 <= numTaps; t += 2) {
+                sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_set1_ps(coeffs[t]), _mm_loadu_ps(x0 + t * numLanes)));
+                sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_set1_ps(coeffs[t + 1]), _mm_loadu_ps(x0 + (t + 1) * numLanes)));
+            }
+            if (t < numTaps) {
+                sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_set1_ps(coeffs[t]), _mm_loadu_ps(x0 + t * numLanes)));
+            }
+            _mm_storeu_ps(output + k * numLanes + c, _mm_add_ps(sum0, sum1));
+        }
+    }
+}
+
+void normalizeSse2(const float* input, float* output, int numSamples, float mean, float invStd)
+{
+    const __m128 meanVec = _mm_set1_ps(mean);
+    const __m128 scaleVec = _mm_set1_ps(invStd);
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4) {
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(input + i), meanVec), scaleVec));
+    }
+    for (; i < numSamples; ++i) {
+        output[i] = (input[i] - mean) * invStd;
+    }
+}
+
+void multiplyAccumulateSse2(const float* input, float gain, float* output, int numSamples)
+{
+    const __m128 gainVec = _mm_set1_ps(gain);
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4) {
+        _mm_storeu_ps(output + i, _mm_add_ps(_mm_loadu_ps(output + i), _mm_mul_ps(gainVec, _mm_loadu_ps(input + i))));
+    }
+    for (; i < numSamples; ++i) {
+        output[i] += gain * input[i];
+    }
+}
+
+void fftButterfliesSse2(float* re, float* im, const float* twiddleRe, const float* twiddleIm,
+                        int size, int half)
+{
+    for (int start = 0; start < size; start += 2 * half) {
+        float* aRe = re + start;
+        float* aIm = im + start;
+        float* bRe = aRe + half;
+        float* bIm = aIm + half;
+        for (int k = 0; k < half; k += 4) {
+            const __m128 wRe = _mm_loadu_ps(twiddleRe + k);
+            const __m128 wIm = _mm_loadu_ps(twiddleIm + k);
+            const __m128 xRe = _mm_loadu_ps(bRe + k);
+            const __m128 xIm = _mm_loadu_ps(bIm + k);
+            const __m128 tRe = _mm_sub_ps(_mm_mul_ps(xRe, wRe), _mm_mul_ps(xIm, wIm));
+            const __m128 tIm = _mm_add_ps(_mm_mul_ps(xRe, wIm), _mm_mul_ps(xIm, wRe));
+            const __m128 yRe = _mm_loadu_ps(aRe + k);
+            const __m128 yIm = _mm_loadu_ps(aIm + k);
+            _mm_storeu_ps(bRe + k, _mm_sub_ps(yRe, tRe));
+            _mm_storeu_ps(bIm + k, _mm_sub_ps(yIm, tIm));
+            _mm_storeu_ps(aRe + k, _mm_add_ps(yRe, tRe));
+            _mm_storeu_ps(aIm + k, _mm_add_ps(yIm, tIm));
+        }
+    }
+}
+
+void denseLayerSse2(const float* weights, const float* bias, const float* input, int numInputs,
+                    float* output, int numOutputs, bool relu)
+{
+    const __m128 zero = _mm_setzero_ps();
+    int o = 0;
+
+    // Two blocks of 8 outputs per pass share each broadcast input
+    for (; o + 16 <= numOutputs; o += 16) {
+        const float* w0 = weights + o * numInputs;
+        const float* w1 = w0 + 8 * numInputs;
+        __m128 sum0 = _mm_loadu_ps(bias + o);
+        __m128 sum1 = _mm_loadu_ps(bias + o + 4);
+        __m128 sum2 = _mm_loadu_ps(bias + o + 8);
+        __m128 sum3 = _mm_loadu_ps(bias + o + 12);
+        for (int i = 0; i < numInputs; ++i) {
+            const __m128 x = _mm_set1_ps(input[i]);
+            sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(w0 + i * 8), x));
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(w0 + i * 8 + 4), x));
+            sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(w1 + i * 8), x));
+            sum3 = _mm_add_ps(sum3, _mm_mul_ps(_mm_loadu_ps(w1 + i * 8 + 4), x));
+        }
+        if (relu) {
+            sum0 = _mm_max_ps(sum0, zero);
+            sum1 = _mm_max_ps(sum1, zero);
+            sum2 = _mm_max_ps(sum2, zero);
+            sum3 = _mm_max_ps(sum3, zero);
+        }
+        _mm_storeu_ps(output + o, sum0);
+        _mm_storeu_ps(output + o + 4, sum1);
+        _mm_storeu_ps(output + o + 8, sum2);
+        _mm_storeu_ps(output + o + 12, sum3);
+    }
+
+    for (; o < numOutputs; o += 8) {
+        const float* w = weights + o * numInputs;
+        __m128 sum0 = _mm_loadu_ps(bias + o);
+        __m128 sum1 = _mm_loadu_ps(bias + o + 4);
+        for (int i = 0; i < numInputs; ++i) {
+            const __m128 x = _mm_set1_ps(input[i]);
+            sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(w + i * 8), x));
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(w + i * 8 + 4), x));
+        }
+        if (relu) {
+            sum0 = _mm_max_ps(sum0, zero);
+            sum1 = _mm_max_ps(sum1, zero);
+        }
+        _mm_storeu_ps(output + o, sum0);
+        _mm_storeu_ps(output + o + 4, sum1);
+    }
+}
+
+__m128 tanhSse2(__m128 x)
+{
+    const __m128 clamp = _mm_set1_ps(detail::kTanhClamp);
+    x = _mm_min_ps(clamp, _mm_max_ps(_mm_sub_ps(_mm_setzero_ps(), clamp), x));
+    const __m128 x2 = _mm_mul_ps(x, x);
+    __m128 p = _mm_set1_ps(detail::kTanhNumerator[0]);
+    for (int i = 1; i < detail::kTanhNumeratorTerms; ++i) {
+        p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(detail::kTanhNumerator[i]));
+    }
+    __m128 q = _mm_set1_ps(detail::kTanhDenominator[0]);
+    for (int i = 1; i < detail::kTanhDenominatorTerms; ++i) {
+        q = _mm_add_ps(_mm_mul_ps(q, x2), _mm_set1_ps(detail::kTanhDenominator[i]));
+    }
+    return _mm_div_ps(_mm_mul_ps(x, p), q);
+}
+
+// 4 units of gruUpdate(); a unit's reset, update and new rows are gateStride apart
+void gruLanesSse2(const float* x, const float* h, int gateStride, float* hidden)
+{
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 reset = _mm_add_ps(half, _mm_mul_ps(
+        half, tanhSse2(_mm_mul_ps(half, _mm_add_ps(_mm_loadu_ps(x), _mm_loadu_ps(h))))));
+    const __m128 update = _mm_add_ps(half, _mm_mul_ps(
+        half, tanhSse2(_mm_mul_ps(half, _mm_add_ps(_mm_loadu_ps(x + gateStride), _mm_loadu_ps(h + gateStride))))));
+    const __m128 candidate = tanhSse2(
+        _mm_add_ps(_mm_loadu_ps(x + 2 * gateStride), _mm_mul_ps(reset, _mm_loadu_ps(h + 2 * gateStride))));
+    const __m128 state = _mm_loadu_ps(hidden);
+    _mm_storeu_ps(hidden, _mm_add_ps(candidate, _mm_mul_ps(update, _mm_sub_ps(state, candidate))));
+}
+
+void gruUpdateSse2(const float* inputGates, const float* hiddenGates, float* hidden, int size)
+{
+    int j = 0;
+    for (; j + 4 <= size; j += 4) {
+        gruLanesSse2(inputGates + j, hiddenGates + j, size, hidden + j);
+    }
+    if (j < size) {
+        // The last units go through one zero-padded vector, the same arithmetic as the others
+        float x[3 * 4] = {};
+        float h[3 * 4] = {};
+        float state[4] = {};
+        const int count = size - j;
+        for (int gate = 0; gate < 3; ++gate) {
+            for (int k = 0; k < count; ++k) {
+                x[gate * 4 + k] = inputGates[gate * size + j + k];
+                h[gate * 4 + k] = hiddenGates[gate * size + j + k];
+            }
+        }
+        for (int k = 0; k < count; ++k) {
+            state[k] = hidden[j + k];
+        }
+        gruLanesSse2(x, h, 4, state);
+        for (int k = 0; k < count; ++k) {
+            hidden[j + k] = state[k];
+        }
+    }
+}
+
+void frameFeaturesSse2(const float* samples, int numSamples, FrameFeatures& features)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 squares = zero;
+    __m128 crossings = zero;
+    __m128 magnitudes = zero;
+    __m128 weighted = zero;
+    __m128 index = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128 indexStep = _mm_set1_ps(4.0f);
+
+    float sumSquares = 0.0f;
+    float zeroCrossings = 0.0f;
+    float sumMagnitude = 0.0f;
+    float weightedMagnitude = 0.0f;
+    int i = 0;
+
+    if (numSamples > 0) {
+        // Sample 0 has no predecessor; compare it with itself
+        const float first = samples[0];
+        const float magnitude = first < 0.0f ? -first : first;
+        sumSquares = first * first;
+        sumMagnitude = magnitude;
+        i = 1;
+        index = _mm_add_ps(index, one);
+    }
+
+    for (; i + 4 <= numSamples; i += 4) {
+        const __m128 x = _mm_loadu_ps(samples + i);
+        const __m128 previous = _mm_loadu_ps(samples + i - 1);
+        const __m128 magnitude = _mm_and_ps(x, absMask);
+        const __m128 signChange = _mm_xor_ps(_mm_cmpge_ps(x, zero), _mm_cmpge_ps(previous, zero));
+        squares = _mm_add_ps(squares, _mm_mul_ps(x, x));
+        magnitudes = _mm_add_ps(magnitudes, magnitude);
+        weighted = _mm_add_ps(weighted, _mm_mul_ps(magnitude, index));
+        crossings = _mm_add_ps(crossings, _mm_and_ps(signChange, one));
+        index = _mm_add_ps(index, indexStep);
+    }
+
+    sumSquares += horizontalSum(squares);
+    zeroCrossings += horizontalSum(crossings);
+    sumMagnitude += horizontalSum(magnitudes);
+    weightedMagnitude += horizontalSum(weighted);
+
+    for (; i < numSamples; ++i) {
+        const float magnitude = samples[i] < 0.0f ? -samples[i] : samples[i];
+        sumSquares += samples[i] * samples[i];
+        sumMagnitude += magnitude;
+        weightedMagnitude += magnitude * static_cast<float>(i);
+        if ((samples[i] >= 0.0f) != (samples[i - 1] >= 0.0f)) {
+            zeroCrossings += 1.0f;
+        }
+    }
+
+    features.sumSquares = sumSquares;
+    features.zeroCrossings = zeroCrossings;
+    features.sumMagnitude = sumMagnitude;
+    features.weightedMagnitude = weightedMagnitude;
+}
+
+float medianSse2(const float* values, int numValues)
+{
+    if (numValues <= 0) {
+        return 0.0f;
+    }
+
+    const int lowerRank = (numValues - 1) / 2;
+    const int upperRank = numValues / 2;
+    const __m128 one = _mm_set1_ps(1.0f);
+    float lower = 0.0f;
+    float upper = 0.0f;
+    bool foundLower = false;
+    bool foundUpper = false;
+
+    for (int i = 0; i < numValues && !(foundLower && foundUpper); ++i) {
+        const float candidate = values[i];
+        const __m128 candidateVec = _mm_set1_ps(candidate);
+        __m128 lessVec = _mm_setzero_ps();
+        __m128 equalVec = _mm_setzero_ps();
+        int j = 0;
+        for (; j + 4 <= numValues; j += 4) {
+            const __m128 v = _mm_loadu_ps(values + j);
+            lessVec = _mm_add_ps(lessVec, _mm_and_ps(_mm_cmplt_ps(v, candidateVec), one));
+            equalVec = _mm_add_ps(equalVec, _mm_and_ps(_mm_cmpeq_ps(v, candidateVec), one));
+        }
+        int less = static_cast<int>(horizontalSum(lessVec));
+        int equal = static_cast<int>(horizontalSum(equalVec));
+        for (; j < numValues; ++j) {
+            less += values[j] < candidate;
+            equal += values[j] == candidate;
+        }
+        if (!foundLower && less <= lowerRank && lowerRank < less + equal) {
+            lower = candidate;
+            foundLower = true;
+        }
+        if (!foundUpper && less <= upperRank && upperRank < less + equal) {
+            upper = candidate;
+            foundUpper = true;
+        }
+    }
+
+    return (lower + upper) * 0.5f;
+}
+
+constexpr DspKernels kSse2Kernels = {
+    SimdLevel::SSE2,
+    dotProductSse2,
+    firBlockRowsSse2,
+    firGatherSse2,
+    firLanesSse2,
+    normalizeSse2,
+    multiplyAccumulateSse2,
+    fftButterfliesSse2,
+    denseLayerSse2,
+    gruUpdateSse2,
+    frameFeaturesSse2,
+    medianSse2
+};
+
+} // namespace
+
+namespace detail {
+
+const DspKernels* getSse2Kernels()
+{
+    return &kSse2Kernels;
+}
+
+} // namespace detail
+
+#else
+
+namespace detail {
+
+const DspKernels* getSse2Kernels()
+{
+    return nullptr;
+}
+
+} // namespace detail
+
+#endif
+
+} // namespace KhDetector
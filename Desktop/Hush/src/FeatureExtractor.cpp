@@ -0,0 +1,251 @@
+#include "FeatureExtractor.h"
+#include "DspKernels.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace KhDetector {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Slaney's mel scale (librosa's default, htk=False): linear below 1 kHz, logarithmic above
+constexpr double kMelLinearStep = 200.0 / 3.0;
+constexpr double kMelLogStartHz = 1000.0;
+constexpr double kMelLogStart = kMelLogStartHz / kMelLinearStep;
+
+double melLogStep()
+{
+    return std::log(6.4) / 27.0;
+}
+
+double hzToMel(double hz)
+{
+    return hz < kMelLogStartHz ? hz / kMelLinearStep : kMelLogStart + std::log(hz / kMelLogStartHz) / melLogStep();
+}
+
+double melToHz(double mel)
+{
+    return mel < kMelLogStart ? mel * kMelLinearStep : kMelLogStartHz * std::exp(melLogStep() * (mel - kMelLogStart));
+}
+
+// power_to_db() defaults: amin 1e-10, ref 1, top_db 80
+constexpr float kMinPower = 1e-10f;
+constexpr float kTopDb = 80.0f;
+
+} // namespace
+
+FeatureExtractor::FeatureExtractor(float sampleRate)
+{
+    // Periodic Hann (scipy.signal.get_window('hann', n, fftbins=True))
+    for (int n = 0; n < kFftSize; ++n) {
+        mWindow[n] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * kPi * n / kFftSize));
+    }
+
+    // Orthonormal DCT-II rows packed for DspKernels::denseLayer(); padded rows stay zero
+    mDctWeights.fill(0.0f);
+    mDctBias.fill(0.0f);
+    for (int k = 0; k < kNumMfcc; ++k) {
+        const double scale = std::sqrt((k == 0 ? 1.0 : 2.0) / kNumMels);
+        for (int n = 0; n < kNumMels; ++n) {
+            mDctWeights[((k / 8) * kNumMels + n) * 8 + k % 8] =
+                static_cast<float>(scale * std::cos(kPi * k * (2 * n + 1) / (2.0 * kNumMels)));
+        }
+    }
+
+    setSampleRate(sampleRate);
+}
+
+void FeatureExtractor::setSampleRate(float sampleRate)
+{
+    mSampleRate = sampleRate;
+
+    for (int k = 0; k < kNumBins; ++k) {
+        mBinFrequencies[k] = static_cast<float>(static_cast<double>(k) * sampleRate / kFftSize);
+    }
+
+    // librosa.filters.mel(): triangles between kNumMels + 2 points evenly spaced
+    // in mel from 0 Hz to Nyquist, each scaled to unit area (norm='slaney')
+    std::array<double, kNumMels + 2> edges;
+    const double maxMel = hzToMel(sampleRate / 2.0);
+    for (int i = 0; i < kNumMels + 2; ++i) {
+        edges[i] = melToHz(maxMel * i / (kNumMels + 1));
+    }
+
+    int offset = 0;
+    for (int m = 0; m < kNumMels; ++m) {
+        const double lower = edges[m];
+        const double centre = edges[m + 1];
+        const double upper = edges[m + 2];
+        const double norm = 2.0 / (upper - lower);
+
+        MelBand& band = mMelBands[m];
+        band.firstBin = 0;
+        band.numBins = 0;
+        band.offset = offset;
+        for (int k = 0; k < kNumBins; ++k) {
+            const double frequency = static_cast<double>(k) * sampleRate / kFftSize;
+            const double rising = (frequency - lower) / (centre - lower);
+            const double falling = (upper - frequency) / (upper - centre);
+            const double weight = std::max(0.0, std::min(rising, falling)) * norm;
+            if (weight <= 0.0) {
+                if (band.numBins > 0) {
+                    break;
+                }
+                continue;
+            }
+            if (band.numBins == 0) {
+                band.firstBin = k;
+            }
+            mMelWeights[offset++] = static_cast<float>(weight);
+            ++band.numBins;
+        }
+    }
+
+    reset();
+}
+
+void FeatureExtractor::reset()
+{
+    // Centered frames: the first one is half zero padding
+    mSamples.fill(0.0f);
+    mFill = kFftSize / 2;
+    mPadding = kFftSize / 2;
+    mNumAnalyzed = 0;
+}
+
+int FeatureExtractor::framesReleasedAfter(long long numAnalyzed)
+{
+    return numAnalyzed >= kDeltaWidth ? static_cast<int>(numAnalyzed - kDeltaWidth / 2) : 0;
+}
+
+int FeatureExtractor::getFrameCount(int numSamples) const
+{
+    const int needed = kFftSize - mFill;
+    if (numSamples < needed) {
+        return 0;
+    }
+    const long long analyzed = 1 + (numSamples - needed) / kHopLength;
+    return framesReleasedAfter(mNumAnalyzed + analyzed) - framesReleasedAfter(mNumAnalyzed);
+}
+
+int FeatureExtractor::process(const float* samples, int numSamples, float* features)
+{
+    constexpr int kHalfWidth = kDeltaWidth / 2;
+    int numFrames = 0;
+
+    while (numSamples > 0) {
+        const int count = std::min(numSamples, kFftSize - mFill);
+        std::copy(samples, samples + count, mSamples.data() + mFill);
+        mFill += count;
+        samples += count;
+        numSamples -= count;
+        if (mFill < kFftSize) {
+            break;
+        }
+
+        analyzeFrame();
+        std::memmove(mSamples.data(), mSamples.data() + kHopLength, (kFftSize - kHopLength) * sizeof(float));
+        mFill -= kHopLength;
+        mPadding = std::max(0, mPadding - kHopLength);
+
+        // Release the frame whose delta window just filled; the first window
+        // also releases the frames before its centre
+        const long long frame = mNumAnalyzed++;
+        if (frame == kDeltaWidth - 1) {
+            for (int f = 0; f <= kHalfWidth; ++f) {
+                emitFrame(f, kHalfWidth, features + numFrames++ * kNumFeatures);
+            }
+        } else if (frame >= kDeltaWidth) {
+            const int centre = static_cast<int>((frame - kHalfWidth) % kDeltaWidth);
+            emitFrame(centre, centre, features + numFrames++ * kNumFeatures);
+        }
+    }
+
+    return numFrames;
+}
+
+void FeatureExtractor::analyzeFrame()
+{
+    const DspKernels& kernels = getDspKernels();
+    AnalyzedFrame& frame = mHistory[mNumAnalyzed % kDeltaWidth];
+
+    for (int n = 0; n < kFftSize; ++n) {
+        mWindowed[n] = mSamples[n] * mWindow[n];
+    }
+    mFft.forward(mWindowed.data(), mRe.data(), mIm.data());
+
+    // preprocess_audio.py sums the squared complex bins, np.sum(stft ** 2),
+    // and the float features keep the real part of that sum
+    float energy = 0.0f;
+    float sumMagnitude = 0.0f;
+    for (int k = 0; k < kNumBins; ++k) {
+        const float power = mRe[k] * mRe[k] + mIm[k] * mIm[k];
+        mPower[k] = power;
+        mMagnitude[k] = std::sqrt(power);
+        energy += mRe[k] * mRe[k] - mIm[k] * mIm[k];
+        sumMagnitude += mMagnitude[k];
+    }
+    frame.energy = energy;
+
+    // librosa leaves an all-zero frame unnormalized, i.e. a centroid of 0
+    const float weightedFrequency = kernels.dotProduct(mBinFrequencies.data(), mMagnitude.data(), kNumBins);
+    frame.centroid = sumMagnitude >= FLT_MIN ? weightedFrequency / sumMagnitude : weightedFrequency;
+
+    float maxDb = -FLT_MAX;
+    for (int m = 0; m < kNumMels; ++m) {
+        const MelBand& band = mMelBands[m];
+        const float melPower = kernels.dotProduct(mMelWeights.data() + band.offset, mPower.data() + band.firstBin,
+                                                  band.numBins);
+        mLogMel[m] = 10.0f * std::log10(std::max(kMinPower, melPower));
+        maxDb = std::max(maxDb, mLogMel[m]);
+    }
+    for (float& value : mLogMel) {
+        value = std::max(value, maxDb - kTopDb);
+    }
+    kernels.denseLayer(mDctWeights.data(), mDctBias.data(), mLogMel.data(), kNumMels, frame.mfcc.data(),
+                       kDctOutputs, false);
+
+    // Padding is librosa's edge padding here, which adds no crossings
+    FrameFeatures sums;
+    kernels.frameFeatures(mSamples.data() + mPadding, kFftSize - mPadding, sums);
+    frame.zeroCrossingRate = sums.zeroCrossings / kFftSize;
+}
+
+void FeatureExtractor::emitFrame(int frame, int deltaCentre, float* features) const
+{
+    // librosa.feature.delta(): Savitzky-Golay derivatives over 9 frames,
+    // sum(k x[t + k]) / 60 and 2 sum((k^2 - 20/3) x[t + k]) / 308
+    constexpr int kHalfWidth = kDeltaWidth / 2;
+    constexpr float kMeanSquare = (kHalfWidth * (kHalfWidth + 1) * (2 * kHalfWidth + 1) / 3.0f) / kDeltaWidth;
+    float slopeNorm = 0.0f;
+    float curvatureNorm = 0.0f;
+    for (int k = -kHalfWidth; k <= kHalfWidth; ++k) {
+        slopeNorm += static_cast<float>(k * k);
+        curvatureNorm += (k * k - kMeanSquare) * (k * k - kMeanSquare);
+    }
+
+    const AnalyzedFrame& analyzed = mHistory[frame];
+    std::copy(analyzed.mfcc.begin(), analyzed.mfcc.begin() + kNumMfcc, features + kMfccOffset);
+
+    for (int c = 0; c < kNumMfcc; ++c) {
+        float slope = 0.0f;
+        float curvature = 0.0f;
+        for (int k = -kHalfWidth; k <= kHalfWidth; ++k) {
+            const float value = mHistory[(deltaCentre + k + kDeltaWidth) % kDeltaWidth].mfcc[c];
+            slope += static_cast<float>(k) * value;
+            curvature += (k * k - kMeanSquare) * value;
+        }
+        features[kDeltaOffset + c] = slope / slopeNorm;
+        features[kDelta2Offset + c] = 2.0f * curvature / curvatureNorm;
+    }
+
+    features[kCentroidIndex] = analyzed.centroid;
+    features[kZeroCrossingIndex] = analyzed.zeroCrossingRate;
+    features[kEnergyIndex] = analyzed.energy;
+}
+
+} // namespace KhDetector
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "RealFft.h"
+
+#include <array>
+
+namespace KhDetector {
+
+/**
+ * @brief Streaming version of the features preprocess_audio.py trains on
+ *
+ * Computes, for every hop of 512 samples, the per-frame values of
+ * HebrewAudioPreprocessor::extract_audio_features() with librosa's
+ * defaults: 2048-point centered frames (zero padded at the start of the
+ * stream, librosa's padding since 0.10), a periodic Hann window, a
+ * 128-band Slaney mel filterbank, log power (power_to_db) and an
+ * orthonormal DCT-II for 13 MFCCs, their 9-frame Savitzky-Golay deltas and
+ * delta-deltas, the spectral centroid, the zero crossing rate and the frame
+ * energy. The energy is what the Python computes, the real part of the sum
+ * of the squared complex bins rather than the power. A feature frame is
+ * laid out in the order save_processed_data() concatenates them:
+ *
+ *     mfcc[13], delta[13], delta2[13], centroid (Hz), zcr, energy
+ *
+ * One FFT per hop feeds the mel bands, the centroid and the energy, and the
+ * mel bands, centroid, DCT and zero crossings run on the SIMD DspKernels.
+ * Deltas need the four following frames, so a frame is released four hops
+ * after its own analysis; the first four frames of a stream take the deltas
+ * of the fifth, as librosa's "interp" mode gives for them.
+ *
+ * Differences from librosa on the same samples: power_to_db clips at
+ * 80 dB below the loudest band of each frame rather than of the whole clip,
+ * samples within 1e-10 of zero count by their sign for the zero crossing
+ * rate, and the stream has no end, so frames that would overlap librosa's
+ * end padding are never produced. Everything is sized at construction, so
+ * process() never allocates.
+ */
+class FeatureExtractor
+{
+public:
+    static constexpr int kFftSize = 2048;
+    static constexpr int kHopLength = 512;
+    static constexpr int kNumBins = kFftSize / 2 + 1;
+    static constexpr int kNumMels = 128;
+    static constexpr int kNumMfcc = 13;
+    static constexpr int kDeltaWidth = 9;
+
+    // Feature frame layout
+    static constexpr int kMfccOffset = 0;
+    static constexpr int kDeltaOffset = kMfccOffset + kNumMfcc;
+    static constexpr int kDelta2Offset = kDeltaOffset + kNumMfcc;
+    static constexpr int kCentroidIndex = kDelta2Offset + kNumMfcc;
+    static constexpr int kZeroCrossingIndex = kCentroidIndex + 1;
+    static constexpr int kEnergyIndex = kZeroCrossingIndex + 1;
+    static constexpr int kNumFeatures = kEnergyIndex + 1;
+
+    /**
+     * @brief Samples from the centre of a frame to the input that releases it
+     */
+    static constexpr int kLatencySamples = kFftSize / 2 + (kDeltaWidth / 2) * kHopLength;
+
+    /**
+     * @brief Constructor
+     *
+     * @param sampleRate Input sample rate; the model's training rate
+     *                   (preprocess_audio.py --sample-rate, 44100 by default)
+     */
+    explicit FeatureExtractor(float sampleRate = 44100.0f);
+
+    /**
+     * @brief Rebuild the filterbank for another sample rate and reset
+     */
+    void setSampleRate(float sampleRate);
+    float getSampleRate() const { return mSampleRate; }
+
+    /**
+     * @brief Start a new stream
+     */
+    void reset();
+
+    /**
+     * @brief Number of feature frames the next process() call of numSamples releases
+     */
+    int getFrameCount(int numSamples) const;
+
+    /**
+     * @brief Push samples and collect the feature frames they complete
+     *
+     * @param features Room for getFrameCount(numSamples) * kNumFeatures floats
+     * @return Number of frames written
+     */
+    int process(const float* samples, int numSamples, float* features);
+
+private:
+    // Padded DCT outputs for DspKernels::denseLayer()
+    static constexpr int kDctOutputs = (kNumMfcc + 7) / 8 * 8;
+    // Triangles span at most the bins between their outer edges
+    static constexpr int kMaxMelWeights = 2 * kNumBins + 2 * kNumMels;
+
+    struct MelBand
+    {
+        int firstBin = 0;
+        int numBins = 0;
+        int offset = 0;     // Position in mMelWeights
+    };
+
+    /**
+     * @brief Per-frame features of the full window in mSamples
+     */
+    void analyzeFrame();
+
+    /**
+     * @brief Write the feature frame of history slot frame, with the deltas of slot deltaCentre
+     */
+    void emitFrame(int frame, int deltaCentre, float* features) const;
+
+    static int framesReleasedAfter(long long numAnalyzed);
+
+    float mSampleRate = 0.0f;
+    detail::RealFft<kFftSize> mFft;
+
+    // Filterbank, DCT and window, built by setSampleRate()
+    std::array<MelBand, kNumMels> mMelBands;
+    std::array<float, kMaxMelWeights> mMelWeights;
+    std::array<float, kNumBins> mBinFrequencies;
+    std::array<float, kFftSize> mWindow;
+    std::array<float, kDctOutputs * kNumMels> mDctWeights;
+    std::array<float, kDctOutputs> mDctBias;
+
+    // Input window: samples [t * hop - kFftSize / 2, t * hop + kFftSize / 2)
+    // of the next frame t
+    alignas(32) std::array<float, kFftSize> mSamples;
+    int mFill = 0;
+    int mPadding = 0;               // Leading zeros in mSamples (stream start)
+
+    // Per-frame scratch
+    alignas(32) std::array<float, kFftSize> mWindowed;
+    alignas(32) std::array<float, kNumBins> mRe;
+    alignas(32) std::array<float, kNumBins> mIm;
+    alignas(32) std::array<float, kNumBins> mPower;
+    alignas(32) std::array<float, kNumBins> mMagnitude;
+    alignas(32) std::array<float, kNumMels> mLogMel;
+
+    // Last kDeltaWidth analyzed frames, indexed by frame number modulo kDeltaWidth
+    struct AnalyzedFrame
+    {
+        std::array<float, kDctOutputs> mfcc;
+        float centroid = 0.0f;
+        float zeroCrossingRate = 0.0f;
+        float energy = 0.0f;
+    };
+    std::array<AnalyzedFrame, kDeltaWidth> mHistory;
+    long long mNumAnalyzed = 0;
+};
+
+} // namespace KhDetector
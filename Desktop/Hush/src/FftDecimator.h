@@ -0,0 +1,339 @@
+#pragma once
+
+#include "PolyphaseDecimator.h"
+#include "RealFft.h"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+namespace KhDetector {
+
+/**
+ * @brief Decimator that filters with overlap-save FFT convolution
+ *
+ * Same filter, output alignment and group delay as PolyphaseDecimator, for
+ * filters long enough that block convolution beats the direct form. The
+ * input is split into its DecimationFactor phase streams as in
+ * PolyphaseDecimator, so only the output samples are ever computed: every
+ * block, each phase stream is transformed once, multiplied by the spectrum
+ * of its polyphase branch and accumulated, and one inverse transform yields
+ * kBlockOutputs outputs. The cost per output grows with log(FilterLength)
+ * instead of FilterLength.
+ *
+ * Outputs are released a whole block at a time, so up to kBlockOutputs - 1
+ * outputs can be held back between calls. That makes it a fit for offline
+ * analysis rather than the real-time path; getOutputCount() reports exactly
+ * what the next call releases. Use OfflineDecimator to pick this class or
+ * PolyphaseDecimator from the filter length.
+ *
+ * Branch spectra are computed once per instantiation on first construction;
+ * processing never allocates.
+ *
+ * @tparam DecimationFactor The integer decimation factor
+ * @tparam FilterLength The total FIR filter length
+ * @tparam Phase Linear (default) or minimum-phase prototype filter
+ */
+template<int DecimationFactor = DECIM_FACTOR, int FilterLength = DecimationFactor * 16,
+         FilterPhase Phase = FilterPhase::Linear>
+class FftDecimator
+{
+public:
+    static constexpr int kDecimationFactor = DecimationFactor;
+    static constexpr int kFilterLength = FilterLength;
+    static constexpr int kPhaseLength = FilterLength / DecimationFactor;
+    static constexpr FilterPhase kPhase = Phase;
+
+    // Each branch is convolved over kFftSize stream samples, of which the
+    // first kPhaseLength - 1 are history; at least 3/4 of every block is new
+    static constexpr int kFftSize = detail::nextPowerOfTwo(4 * kPhaseLength < 32 ? 32 : 4 * kPhaseLength);
+    static constexpr int kBlockOutputs = kFftSize - kPhaseLength + 1;
+
+    static_assert(DecimationFactor > 0, "Decimation factor must be positive");
+    static_assert(FilterLength % DecimationFactor == 0, "Filter length must be divisible by decimation factor");
+
+    FftDecimator()
+        : spectra_(&spectrumTable())
+    {
+        reset();
+    }
+
+    /**
+     * @brief Process stereo input (float or double) and produce mono decimated output
+     *
+     * @param output Output buffer, at least getOutputCount(numInputSamples) long
+     * @return Number of output samples produced
+     */
+    template<typename SampleType>
+    int processStereoToMono(const SampleType* leftInput, const SampleType* rightInput,
+                           float* output, int numInputSamples)
+    {
+        return run(numInputSamples, [&](int i) {
+            return detail::stereoToMono(leftInput[i], rightInput[i]);
+        }, output);
+    }
+
+    /**
+     * @brief Process mono input and produce decimated output
+     *
+     * @param output Output buffer, at least getOutputCount(numInputSamples) long
+     * @return Number of output samples produced
+     */
+    int processMono(const float* input, float* output, int numInputSamples)
+    {
+        return run(numInputSamples, [&](int i) { return input[i]; }, output);
+    }
+
+    /**
+     * @brief Reset the decimator state
+     */
+    void reset()
+    {
+        streams_.fill(0.0f);
+
+        // Same stream alignment as PolyphaseDecimator::reset()
+        streamLength_.fill(kStreamHistory + 1);
+        streamLength_[0] = kStreamHistory;
+        nextPhase_ = 0;
+    }
+
+    /**
+     * @brief Number of output samples the next call will release
+     *
+     * A multiple of kBlockOutputs: outputs that do not complete a block stay
+     * pending until a later call.
+     */
+    int getOutputCount(int numInputSamples) const
+    {
+        const int periods = numInputSamples <= nextPhase_ ? 0 : (numInputSamples - nextPhase_ - 1) / DecimationFactor + 1;
+        return (pendingOutputs() + periods) / kBlockOutputs * kBlockOutputs;
+    }
+
+    /**
+     * @brief Group delay of the filter in output samples (as PolyphaseDecimator)
+     *
+     * Does not include the block hold-back described in the class comment.
+     */
+    double getGroupDelay() const
+    {
+        return spectra_->groupDelay;
+    }
+
+private:
+    using Fft = detail::RealFft<kFftSize>;
+
+    static constexpr int kNumBins = Fft::kNumBins;
+    static constexpr int kStreamHistory = kPhaseLength - 1;
+    // History, up to a block waiting, one chunk and the extra sample of phases 1..D-1
+    static constexpr int kStreamStride = kStreamHistory + 2 * kBlockOutputs + 2;
+    static constexpr int kChunkInputs = kBlockOutputs * DecimationFactor;
+
+    /**
+     * @brief Branch spectra shared by every instance, pre-scaled for Fft::inverse()
+     */
+    struct SpectrumTable
+    {
+        std::array<float, DecimationFactor * kNumBins> re;
+        std::array<float, DecimationFactor * kNumBins> im;
+        double groupDelay;  // In output samples
+    };
+
+    const SpectrumTable* spectra_;
+    Fft fft_;
+
+    // Phase-major streams: [phase][kStreamStride]
+    alignas(32) std::array<float, DecimationFactor * kStreamStride> streams_;
+    std::array<int, DecimationFactor> streamLength_;
+    int nextPhase_ = 0;
+
+    alignas(32) std::array<float, kNumBins> streamRe_;
+    alignas(32) std::array<float, kNumBins> streamIm_;
+    alignas(32) std::array<float, kNumBins> sumRe_;
+    alignas(32) std::array<float, kNumBins> sumIm_;
+    alignas(32) std::array<float, kFftSize> block_;
+
+    template<typename SampleSource>
+    int run(int numInputSamples, SampleSource&& sampleAt, float* output)
+    {
+        int outputCount = 0;
+
+        for (int offset = 0; offset < numInputSamples; offset += kChunkInputs) {
+            const int count = std::min(kChunkInputs, numInputSamples - offset);
+            distributeBlock(count, [&](int i) { return sampleAt(offset + i); });
+            while (pendingOutputs() >= kBlockOutputs) {
+                computeBlock(output + outputCount);
+                outputCount += kBlockOutputs;
+            }
+        }
+
+        return outputCount;
+    }
+
+    /**
+     * @brief Append samples to their phase streams (as PolyphaseDecimator)
+     */
+    template<typename SampleSource>
+    void distributeBlock(int count, SampleSource&& sampleAt)
+    {
+        for (int phase = 0; phase < DecimationFactor; ++phase) {
+            float* stream = streams_.data() + phase * kStreamStride + streamLength_[phase];
+            int first = nextPhase_ - phase;
+            if (first < 0) {
+                first += DecimationFactor;
+            }
+
+            int appended = 0;
+            for (int i = first; i < count; i += DecimationFactor) {
+                stream[appended++] = sampleAt(i);
+            }
+            streamLength_[phase] += appended;
+        }
+
+        nextPhase_ = (nextPhase_ - count % DecimationFactor + DecimationFactor) % DecimationFactor;
+    }
+
+    int pendingOutputs() const
+    {
+        return streamLength_[0] - kStreamHistory;
+    }
+
+    /**
+     * @brief Convolve the first kFftSize samples of every stream and retire one block
+     *
+     * Output k of the block is sum_p sum_i h_p[i] * stream_p[k + kPhaseLength - 1 - i],
+     * the linear-convolution part of the circular convolution of each stream
+     * window with its branch h_p[i] = h[i * D + p].
+     */
+    void computeBlock(float* output)
+    {
+        for (int phase = 0; phase < DecimationFactor; ++phase) {
+            fft_.forward(streams_.data() + phase * kStreamStride, streamRe_.data(), streamIm_.data());
+
+            const float* branchRe = spectra_->re.data() + phase * kNumBins;
+            const float* branchIm = spectra_->im.data() + phase * kNumBins;
+            if (phase == 0) {
+                for (int k = 0; k < kNumBins; ++k) {
+                    sumRe_[k] = streamRe_[k] * branchRe[k] - streamIm_[k] * branchIm[k];
+                    sumIm_[k] = streamRe_[k] * branchIm[k] + streamIm_[k] * branchRe[k];
+                }
+            } else {
+                for (int k = 0; k < kNumBins; ++k) {
+                    sumRe_[k] += streamRe_[k] * branchRe[k] - streamIm_[k] * branchIm[k];
+                    sumIm_[k] += streamRe_[k] * branchIm[k] + streamIm_[k] * branchRe[k];
+                }
+            }
+        }
+
+        fft_.inverse(sumRe_.data(), sumIm_.data(), block_.data());
+        std::memcpy(output, block_.data() + kStreamHistory, kBlockOutputs * sizeof(float));
+
+        for (int phase = 0; phase < DecimationFactor; ++phase) {
+            float* stream = streams_.data() + phase * kStreamStride;
+            const int keep = streamLength_[phase] - kBlockOutputs;
+            std::memmove(stream, stream + kBlockOutputs, keep * sizeof(float));
+            streamLength_[phase] = keep;
+        }
+    }
+
+    static const SpectrumTable& spectrumTable()
+    {
+        static const SpectrumTable table = [] {
+            std::array<double, FilterLength> prototype = designWindowedSinc<FilterLength>(PolyphaseDecimator<
+                DecimationFactor, FilterLength, Phase>::kCutoff);
+            if constexpr (Phase == FilterPhase::Minimum) {
+                prototype = toMinimumPhase(prototype);
+            }
+
+            SpectrumTable t{};
+            Fft fft;
+            std::array<float, kFftSize> branch{};
+            const float scale = 2.0f / kFftSize;  // Undo the Size / 2 gain of Fft::inverse()
+            for (int phase = 0; phase < DecimationFactor; ++phase) {
+                branch.fill(0.0f);
+                for (int i = 0; i < kPhaseLength; ++i) {
+                    branch[i] = static_cast<float>(prototype[i * DecimationFactor + phase]) * scale;
+                }
+                fft.forward(branch.data(), t.re.data() + phase * kNumBins, t.im.data() + phase * kNumBins);
+            }
+            t.groupDelay = Phase == FilterPhase::Linear
+                ? (FilterLength / 2) / static_cast<double>(DecimationFactor)
+                : dcGroupDelay(prototype) / DecimationFactor;
+            return t;
+        }();
+        return table;
+    }
+};
+
+#ifndef FFT_BUTTERFLY_COST
+    #define FFT_BUTTERFLY_COST 7.0  // Default: measured on x86-64 AVX2, see kFftButterflyCost
+#endif
+
+/**
+ * @brief Cost of one radix-2 butterfly of FftDecimator, in direct-form taps
+ *
+ * The ratio of two measured times: FftDecimator's time per butterfly
+ * (including its share of the per-block stream copies) over
+ * PolyphaseDecimator's time per filter tap. PerformanceBenchmark_FftCrossover
+ * in tests/test_decimator.cpp measures both and prints the ratio for the
+ * build machine. The default of 7 is that measurement on an x86-64 AVX2 build
+ * (GCC -O2): about 0.12 ns per tap, and a crossover of 192 taps at 3:1. Set the
+ * FFT_BUTTERFLY_COST compile option to the printed value to re-tune
+ * OfflineDecimator for another target.
+ */
+constexpr double kFftButterflyCost = FFT_BUTTERFLY_COST;
+
+/**
+ * @brief Work per block of FftDecimator for a given decimator shape
+ */
+struct FftDecimationCost
+{
+    int fftSize;                 ///< Transform size, as FftDecimator::kFftSize
+    int blockOutputs;            ///< Outputs per block, as FftDecimator::kBlockOutputs
+    double butterflies;          ///< Radix-2 butterflies in the D + 1 transforms
+    double spectrumProducts;     ///< Real multiply-adds in the D branch products
+};
+
+constexpr FftDecimationCost fftDecimationCost(int decimationFactor, int filterLength)
+{
+    const int phaseLength = filterLength / decimationFactor;
+    const int fftSize = detail::nextPowerOfTwo(4 * phaseLength < 32 ? 32 : 4 * phaseLength);
+
+    int log2Size = 0;
+    while ((1 << log2Size) < fftSize) {
+        ++log2Size;
+    }
+
+    return { fftSize, fftSize - phaseLength + 1,
+             (decimationFactor + 1) * (fftSize / 2.0) * log2Size,
+             decimationFactor * 4.0 * (fftSize / 2 + 1) };
+}
+
+/**
+ * @brief Whether FftDecimator is cheaper per output than PolyphaseDecimator
+ *
+ * The direct form costs FilterLength taps per output. The FFT form costs
+ * its butterflies, weighted by butterflyCost, plus one tap per spectrum
+ * multiply-add, spread over a block of outputs.
+ */
+constexpr bool fftDecimationIsCheaper(int decimationFactor, int filterLength,
+                                      double butterflyCost = kFftButterflyCost)
+{
+    const FftDecimationCost cost = fftDecimationCost(decimationFactor, filterLength);
+    const double fftCost = butterflyCost * cost.butterflies + cost.spectrumProducts;
+    return fftCost / cost.blockOutputs < filterLength;
+}
+
+/**
+ * @brief Decimator for offline analysis: FFT block filtering for long filters,
+ *        the direct polyphase form otherwise
+ *
+ * Both have processMono()/processStereoToMono()/getOutputCount()/reset() and
+ * produce the same samples; the FFT form releases them in blocks.
+ */
+template<int DecimationFactor, int FilterLength, FilterPhase Phase = FilterPhase::Linear>
+using OfflineDecimator = std::conditional_t<fftDecimationIsCheaper(DecimationFactor, FilterLength),
+                                            FftDecimator<DecimationFactor, FilterLength, Phase>,
+                                            PolyphaseDecimator<DecimationFactor, FilterLength, Phase>>;
+
+} // namespace KhDetector
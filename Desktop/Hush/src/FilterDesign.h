@@ -0,0 +1,306 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace KhDetector {
+
+/**
+ * @brief Phase response of a designed FIR filter
+ */
+enum class FilterPhase
+{
+    Linear,     ///< Symmetric taps: constant, integer group delay
+    Minimum     ///< Same magnitude response with the energy moved to the first taps (lower delay)
+};
+
+/**
+ * @brief constexpr replacements for the <cmath> functions used in filter design
+ *
+ * <cmath> is not constexpr in C++17. These are accurate to a few ulp over
+ * the ranges filter design needs and are cheap enough to stay within the
+ * default constant-evaluation limits of GCC, Clang and MSVC.
+ */
+namespace constmath {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kLn2 = 0.69314718055994530942;
+constexpr double kSqrt2 = 1.41421356237309504880;
+
+constexpr long long roundToInt(double x)
+{
+    return static_cast<long long>(x < 0.0 ? x - 0.5 : x + 0.5);
+}
+
+constexpr double sin(double x)
+{
+    // Reduce to [-pi, pi], then fold onto [-pi/2, pi/2]
+    x -= static_cast<double>(roundToInt(x / (2.0 * kPi))) * 2.0 * kPi;
+    if (x > kPi / 2) {
+        x = kPi - x;
+    } else if (x < -kPi / 2) {
+        x = -kPi - x;
+    }
+
+    const double x2 = x * x;
+    double term = x;
+    double sum = x;
+    for (int n = 1; n <= 11; ++n) {
+        term *= -x2 / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double cos(double x)
+{
+    return sin(x + kPi / 2);
+}
+
+constexpr double exp(double x)
+{
+    // x = k * ln2 + r with |r| <= ln2 / 2
+    const long long k = roundToInt(x / kLn2);
+    const double r = x - static_cast<double>(k) * kLn2;
+
+    double term = 1.0;
+    double sum = 1.0;
+    for (int n = 1; n <= 18; ++n) {
+        term *= r / n;
+        sum += term;
+    }
+
+    double base = k < 0 ? 0.5 : 2.0;
+    for (long long e = k < 0 ? -k : k; e > 0; e >>= 1) {
+        if (e & 1) {
+            sum *= base;
+        }
+        base *= base;
+    }
+    return sum;
+}
+
+/**
+ * @brief Natural logarithm; x must be positive
+ */
+constexpr double log(double x)
+{
+    // x = m * 2^e with m in [1/sqrt2, sqrt2), then log(m) = 2 atanh((m - 1) / (m + 1))
+    int e = 0;
+    while (x >= kSqrt2) {
+        x *= 0.5;
+        ++e;
+    }
+    while (x < kSqrt2 / 2) {
+        x *= 2.0;
+        --e;
+    }
+
+    const double y = (x - 1.0) / (x + 1.0);
+    const double y2 = y * y;
+    double power = y;
+    double sum = y;
+    for (int n = 3; n <= 39; n += 2) {
+        power *= y2;
+        sum += power / n;
+    }
+    return 2.0 * sum + e * kLn2;
+}
+
+} // namespace constmath
+
+/**
+ * @brief Blackman-windowed sinc lowpass with unity DC gain
+ *
+ * The filter is centred on tap Length / 2 and its first tap is zero, so it
+ * is exactly symmetric (linear phase) with an integer delay.
+ *
+ * @param cutoff Normalized cutoff frequency (1.0 = Nyquist)
+ */
+template<int Length>
+constexpr std::array<double, Length> designWindowedSinc(double cutoff)
+{
+    using namespace constmath;
+
+    std::array<double, Length> h{};
+    double sum = 0.0;
+
+    for (int n = 1; n < Length; ++n) {
+        const int m = n - Length / 2;
+        double tap = (m == 0) ? cutoff : sin(kPi * cutoff * m) / (kPi * m);
+        tap *= 0.42 - 0.5 * cos(2.0 * kPi * n / Length) + 0.08 * cos(4.0 * kPi * n / Length);
+        h[n] = tap;
+        sum += tap;
+    }
+
+    for (int n = 0; n < Length; ++n) {
+        h[n] /= sum;
+    }
+    return h;
+}
+
+/**
+ * @brief Group delay at DC in samples: sum(n * h[n]) / sum(h[n])
+ */
+template<size_t Length>
+constexpr double dcGroupDelay(const std::array<double, Length>& h)
+{
+    double moment = 0.0;
+    double sum = 0.0;
+    for (size_t n = 0; n < Length; ++n) {
+        moment += static_cast<double>(n) * h[n];
+        sum += h[n];
+    }
+    return moment / sum;
+}
+
+namespace detail {
+
+struct Complex
+{
+    double re = 0.0;
+    double im = 0.0;
+};
+
+/**
+ * @brief In-place radix-2 FFT; the inverse is scaled by 1 / N
+ */
+template<size_t N>
+constexpr void fft(std::array<Complex, N>& data, bool inverse)
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "FFT size must be a power of two");
+
+    for (size_t i = 1, j = 0; i < N; ++i) {
+        size_t bit = N >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            const Complex swap = data[i];
+            data[i] = data[j];
+            data[j] = swap;
+        }
+    }
+
+    for (size_t length = 2; length <= N; length <<= 1) {
+        const double angle = (inverse ? 2.0 : -2.0) * constmath::kPi / static_cast<double>(length);
+        for (size_t k = 0; k < length / 2; ++k) {
+            const double wr = constmath::cos(angle * k);
+            const double wi = constmath::sin(angle * k);
+            for (size_t i = k; i < N; i += length) {
+                const Complex u = data[i];
+                const Complex& b = data[i + length / 2];
+                const Complex v{ b.re * wr - b.im * wi, b.re * wi + b.im * wr };
+                data[i] = { u.re + v.re, u.im + v.im };
+                data[i + length / 2] = { u.re - v.re, u.im - v.im };
+            }
+        }
+    }
+
+    if (inverse) {
+        for (auto& value : data) {
+            value.re /= static_cast<double>(N);
+            value.im /= static_cast<double>(N);
+        }
+    }
+}
+
+constexpr size_t minimumPhaseFftSize(size_t length)
+{
+    // Long enough that cepstral aliasing stays below the stopband
+    size_t size = 256;
+    while (size < 16 * length) {
+        size <<= 1;
+    }
+    return size;
+}
+
+} // namespace detail
+
+/**
+ * @brief Minimum-phase filter with the magnitude response of h
+ *
+ * Homomorphic method: the real cepstrum of |H| is folded onto its causal
+ * half and exponentiated back, which reflects every zero outside the unit
+ * circle inside it. The magnitude response is kept (down to a -200 dB floor
+ * that keeps the logarithm finite at stopband zeros) while the group delay
+ * drops to a few taps.
+ *
+ * Usable in constant expressions, but a 48-tap design already takes more
+ * evaluation steps than Clang and MSVC allow by default, so callers run it
+ * once at startup.
+ */
+template<size_t Length>
+constexpr std::array<double, Length> toMinimumPhase(const std::array<double, Length>& h)
+{
+    constexpr size_t N = detail::minimumPhaseFftSize(Length);
+    std::array<detail::Complex, N> spectrum{};
+    for (size_t n = 0; n < Length; ++n) {
+        spectrum[n].re = h[n];
+    }
+    detail::fft(spectrum, false);
+
+    double peak = 0.0;
+    for (const auto& bin : spectrum) {
+        const double power = bin.re * bin.re + bin.im * bin.im;
+        peak = power > peak ? power : peak;
+    }
+    const double floor = peak * 1e-20;
+
+    // Real cepstrum of log|H|
+    for (auto& bin : spectrum) {
+        const double power = bin.re * bin.re + bin.im * bin.im;
+        bin = { 0.5 * constmath::log(power > floor ? power : floor), 0.0 };
+    }
+    detail::fft(spectrum, true);
+
+    // Fold the anti-causal half onto the causal half
+    for (size_t n = 1; n < N / 2; ++n) {
+        spectrum[n] = { 2.0 * spectrum[n].re, 0.0 };
+    }
+    spectrum[0].im = 0.0;
+    spectrum[N / 2].im = 0.0;
+    for (size_t n = N / 2 + 1; n < N; ++n) {
+        spectrum[n] = {};
+    }
+    detail::fft(spectrum, false);
+
+    for (auto& bin : spectrum) {
+        const double magnitude = constmath::exp(bin.re);
+        bin = { magnitude * constmath::cos(bin.im), magnitude * constmath::sin(bin.im) };
+    }
+    detail::fft(spectrum, true);
+
+    std::array<double, Length> result{};
+    double sum = 0.0;
+    for (size_t n = 0; n < Length; ++n) {
+        result[n] = spectrum[n].re;
+        sum += result[n];
+    }
+    for (size_t n = 0; n < Length; ++n) {
+        result[n] /= sum;
+    }
+    return result;
+}
+
+/**
+ * @brief Split a prototype filter into DecimationFactor polyphase rows
+ *
+ * Rows are phase-major and time-reversed, so tap j of a row multiplies the
+ * j-th oldest sample of its window.
+ */
+template<int DecimationFactor, size_t Length>
+constexpr std::array<float, Length> makePolyphaseTable(const std::array<double, Length>& h)
+{
+    constexpr int phaseLength = static_cast<int>(Length) / DecimationFactor;
+    std::array<float, Length> table{};
+    for (int phase = 0; phase < DecimationFactor; ++phase) {
+        for (int i = 0; i < phaseLength; ++i) {
+            table[phase * phaseLength + (phaseLength - 1 - i)] = static_cast<float>(h[i * DecimationFactor + phase]);
+        }
+    }
+    return table;
+}
+
+} // namespace KhDetector
@@ -0,0 +1,98 @@
+#include "FrameAssembler.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace KhDetector {
+
+namespace {
+
+// History length in frames; when it fills, the last frame is moved to the front
+constexpr int kHistoryFrames = 8;
+
+} // namespace
+
+FrameAssembler::FrameAssembler(int frameSize, int hop)
+    : mFrameSize(std::max(1, frameSize))
+    , mHop(isValidHop(mFrameSize, hop) ? hop : mFrameSize)
+    , mRequestedHop(mHop.load())
+    , mHistory(static_cast<size_t>(mFrameSize) * kHistoryFrames)
+{
+}
+
+bool FrameAssembler::setHop(int hop)
+{
+    if (!isValidHop(mFrameSize, hop)) {
+        return false;
+    }
+    mRequestedHop.store(hop, std::memory_order_relaxed);
+    return true;
+}
+
+size_t FrameAssembler::getSamplesNeeded() const
+{
+    const size_t target = static_cast<size_t>(mHasFrame ? mHop.load(std::memory_order_relaxed) : mFrameSize);
+    return target > mPending ? target - mPending : 0;
+}
+
+float* FrameAssembler::getWritePointer()
+{
+    if (mEnd + getSamplesNeeded() > mHistory.size()) {
+        // The next frame reuses at most the last frame of history
+        const size_t keep = std::min(mEnd, static_cast<size_t>(mFrameSize));
+        std::memmove(mHistory.data(), mHistory.data() + mEnd - keep, keep * sizeof(float));
+        mEnd = keep;
+    }
+    return mHistory.data() + mEnd;
+}
+
+void FrameAssembler::commit(size_t numSamples)
+{
+    numSamples = std::min(numSamples, getSamplesNeeded());
+    mEnd += numSamples;
+    mPending += numSamples;
+    mTotalSamples += numSamples;
+}
+
+size_t FrameAssembler::push(const float* samples, size_t numSamples)
+{
+    if (!samples) {
+        return 0;
+    }
+    const size_t count = std::min(numSamples, getSamplesNeeded());
+    std::memcpy(getWritePointer(), samples, count * sizeof(float));
+    commit(count);
+    return count;
+}
+
+bool FrameAssembler::nextFrame(Frame& frame)
+{
+    if (mPending == 0 || getSamplesNeeded() > 0) {
+        return false;
+    }
+
+    frame.samples = mHistory.data() + mEnd - mFrameSize;
+    frame.numSamples = mFrameSize;
+    frame.startSample = mTotalSamples - static_cast<uint64_t>(mFrameSize);
+    frame.hop = static_cast<int>(mPending);
+    mPending = 0;
+    mHasFrame = true;
+
+    // A new hop starts where frames of both hops would end
+    const int requested = mRequestedHop.load(std::memory_order_relaxed);
+    if (requested != mHop.load(std::memory_order_relaxed) && mTotalSamples % static_cast<uint64_t>(requested) == 0) {
+        mHop.store(requested, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void FrameAssembler::reset()
+{
+    mEnd = 0;
+    mPending = 0;
+    mTotalSamples = 0;
+    mHasFrame = false;
+    mHop.store(mRequestedHop.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+} // namespace KhDetector
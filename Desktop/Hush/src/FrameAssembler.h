@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace KhDetector {
+
+/**
+ * @brief Sliding-window frame assembly with a runtime-configurable hop
+ *
+ * Keeps a contiguous history of the stream and emits a frame of frameSize
+ * samples every hop samples, so with a hop of half the frame each sample is
+ * seen by two frames and an event on a frame boundary is still seen whole.
+ * Frames point into the history and carry the absolute index of their
+ * first sample. The consumer writes straight into the history
+ * (getWritePointer() and commit(), e.g. with RingBuffer::pop_bulk()) and
+ * then asks nextFrame() for the frame, so each sample is copied once
+ * however many frames see it; the history is moved to the front once
+ * every few frames.
+ *
+ * The hop must divide the frame size; setHop() may be called from any
+ * thread and takes effect at the first frame boundary that is a multiple of
+ * the new hop, so frames always end on multiples of the hop in force.
+ * Everything else belongs to the consumer thread. Allocates only in the
+ * constructor.
+ */
+class FrameAssembler
+{
+public:
+    struct Frame
+    {
+        const float* samples = nullptr;    // numSamples contiguous samples, valid until the next write
+        int numSamples = 0;
+        uint64_t startSample = 0;          // Absolute index of samples[0] since reset()
+        int hop = 0;                       // New samples since the previous frame
+    };
+
+    /**
+     * @param frameSize Samples per frame
+     * @param hop Samples between frame starts; 0 for disjoint frames
+     */
+    explicit FrameAssembler(int frameSize, int hop = 0);
+
+    FrameAssembler(const FrameAssembler&) = delete;
+    FrameAssembler& operator=(const FrameAssembler&) = delete;
+
+    /**
+     * @brief Request a new hop (any thread)
+     *
+     * @return false unless 1 <= hop <= frameSize and hop divides frameSize
+     */
+    bool setHop(int hop);
+
+    /**
+     * @brief Hop in force (any thread); setHop() may not have reached it yet
+     */
+    int getHop() const { return mHop.load(std::memory_order_relaxed); }
+
+    int getFrameSize() const { return mFrameSize; }
+
+    /**
+     * @brief Samples still missing for the next frame
+     */
+    size_t getSamplesNeeded() const;
+
+    /**
+     * @brief Room for getSamplesNeeded() samples, to be filled and committed
+     */
+    float* getWritePointer();
+
+    /**
+     * @brief Take samples written at getWritePointer() (at most getSamplesNeeded())
+     */
+    void commit(size_t numSamples);
+
+    /**
+     * @brief Copy up to getSamplesNeeded() samples in
+     *
+     * @return Samples taken
+     */
+    size_t push(const float* samples, size_t numSamples);
+
+    /**
+     * @brief Emit the next frame once enough samples are in
+     *
+     * @return false if samples are still missing
+     */
+    bool nextFrame(Frame& frame);
+
+    /**
+     * @brief Drop the history and restart the sample count at zero
+     */
+    void reset();
+
+    /**
+     * @brief Samples committed since reset()
+     */
+    uint64_t getTotalSamples() const { return mTotalSamples; }
+
+private:
+    static bool isValidHop(int frameSize, int hop) { return hop >= 1 && hop <= frameSize && frameSize % hop == 0; }
+
+    const int mFrameSize;
+    std::atomic<int> mHop;
+    std::atomic<int> mRequestedHop;
+
+    std::vector<float> mHistory;
+    size_t mEnd = 0;                   // History holds samples [0, mEnd)
+    size_t mPending = 0;               // Samples at the end not yet in a frame
+    uint64_t mTotalSamples = 0;
+    bool mHasFrame = false;
+};
+
+} // namespace KhDetector
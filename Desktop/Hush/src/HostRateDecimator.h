@@ -0,0 +1,130 @@
+#pragma once
+
+#include "PolyphaseDecimator.h"
+#include "RationalResampler.h"
+
+#include <cmath>
+
+namespace KhDetector {
+
+/**
+ * @brief Brings any supported host rate down to the 16 kHz model rate
+ *
+ * Picks the decimation path for the host rate and forwards to it: the
+ * integer decimator handles DECIM_FACTOR * 16kHz, the half-band cascades
+ * 96kHz and 192kHz, and the rational resampler every other rate in
+ * kRatesTo16k. Unsupported rates fall back to the integer decimator, which
+ * then feeds the model at sampleRate / DECIM_FACTOR instead of 16kHz.
+ *
+ * Float and double input take the same path; the first stage of each path
+ * converts to float as it reads, so input that is exactly representable in
+ * float decimates to the same samples at either precision.
+ */
+class HostRateDecimator
+{
+public:
+    static constexpr int kTargetSampleRate = 16000;
+
+    /**
+     * @brief Which stage brings the host rate down to 16kHz
+     */
+    enum class Path { Integer, HalfBand96, HalfBand192, Resampler };
+
+    /**
+     * @brief Choose the path for a host rate and clear all filter state
+     *
+     * The resampler designs its filter here so processing stays allocation free.
+     *
+     * @return false if the rate is unsupported and the integer decimator is used as a fallback
+     */
+    bool configure(double sampleRate)
+    {
+        mIntegerDecimator.reset();
+        mDecimator96.reset();
+        mDecimator192.reset();
+
+        const double factor = sampleRate / kTargetSampleRate;
+        auto isFactor = [factor](int candidate) {
+            return std::abs(factor - candidate) <= 0.1;
+        };
+
+        if (isFactor(DECIM_FACTOR)) {
+            mPath = Path::Integer;
+        } else if (isFactor(Decimator96to16::kDecimationFactor)) {
+            mPath = Path::HalfBand96;
+        } else if (isFactor(Decimator192to16::kDecimationFactor)) {
+            mPath = Path::HalfBand192;
+        } else if (mResampler.configure(sampleRate)) {
+            mPath = Path::Resampler;
+        } else {
+            mPath = Path::Integer;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Clear the filter state of the current path
+     */
+    void reset()
+    {
+        switch (mPath) {
+            case Path::HalfBand96: mDecimator96.reset(); return;
+            case Path::HalfBand192: mDecimator192.reset(); return;
+            case Path::Resampler: mResampler.reset(); return;
+            case Path::Integer: break;
+        }
+        mIntegerDecimator.reset();
+    }
+
+    /**
+     * @brief Path chosen by the last configure()
+     */
+    Path getPath() const { return mPath; }
+
+    /**
+     * @brief Number of 16kHz samples the next numInputSamples inputs produce
+     */
+    int getOutputCount(int numInputSamples) const
+    {
+        switch (mPath) {
+            case Path::HalfBand96: return mDecimator96.getOutputCount(numInputSamples);
+            case Path::HalfBand192: return mDecimator192.getOutputCount(numInputSamples);
+            case Path::Resampler: return mResampler.getOutputCount(numInputSamples);
+            case Path::Integer: break;
+        }
+        return mIntegerDecimator.getOutputCount(numInputSamples);
+    }
+
+    /**
+     * @brief Decimate stereo input to mono through the current path
+     *
+     * @param output Output buffer or RingBuffer write spans; span output
+     *               drops samples that do not fit, as the decimators do
+     * @return Number of output samples produced
+     */
+    template<typename SampleType, typename Output>
+    int processStereoToMono(const SampleType* leftInput, const SampleType* rightInput,
+                            const Output& output, int numInputSamples)
+    {
+        switch (mPath) {
+            case Path::HalfBand96:
+                return mDecimator96.processStereoToMono(leftInput, rightInput, output, numInputSamples);
+            case Path::HalfBand192:
+                return mDecimator192.processStereoToMono(leftInput, rightInput, output, numInputSamples);
+            case Path::Resampler:
+                return mResampler.processStereoToMono(leftInput, rightInput, output, numInputSamples);
+            case Path::Integer: break;
+        }
+        return mIntegerDecimator.processStereoToMono(leftInput, rightInput, output, numInputSamples);
+    }
+
+private:
+    PolyphaseDecimator<DECIM_FACTOR> mIntegerDecimator;
+    Decimator96to16 mDecimator96;    // Half-band 2:1, then 3:1
+    Decimator192to16 mDecimator192;  // Two half-band 2:1 stages, then 3:1
+    ResamplerTo16k mResampler;       // Every other host rate
+    Path mPath = Path::Integer;
+};
+
+} // namespace KhDetector
@@ -0,0 +1,700 @@
+#include "InferenceService.h"
+#include "RealtimeThreadPool.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace KhDetector {
+
+namespace {
+
+std::mutex& sharedConfigMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+// Configuration for getShared(), until it has been created
+InferenceService::Config gSharedConfig;
+bool gSharedCreated = false;
+
+bool isSameModel(const AiInference::ModelConfig& a, const AiInference::ModelConfig& b)
+{
+    return a.modelPath == b.modelPath && a.inputSize == b.inputSize && a.featureInput == b.featureInput
+        && a.normalizationMean == b.normalizationMean && a.normalizationStd == b.normalizationStd;
+}
+
+// Next hop up that divides the frame: at least double, at most the frame
+int largerHop(int hop, int frameSize)
+{
+    int candidate = std::min(2 * hop, frameSize);
+    while (frameSize % candidate != 0) {
+        ++candidate;
+    }
+    return candidate;
+}
+
+// Next hop down that divides the frame: at most half, at least the stream's own
+int smallerHop(int hop, int baseHop, int frameSize)
+{
+    int candidate = std::max(hop / 2, baseHop);
+    while (candidate > baseHop && frameSize % candidate != 0) {
+        --candidate;
+    }
+    return candidate;
+}
+
+void updateMax(std::atomic<uint64_t>& maximum, uint64_t value)
+{
+    uint64_t current = maximum.load(std::memory_order_relaxed);
+    while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace
+
+/**
+ * @brief A worker's frames for one model call, and the streams they continue
+ */
+struct InferenceService::Batch
+{
+    std::vector<Stream*> claimed;                           // Ready streams this worker took, one model group
+    std::vector<Stream*> streams;                           // Those with a frame in the batch
+    std::vector<float> frames;                              // streams.size() x inputSize samples
+    std::vector<AiInference::InferenceResult> results;
+    LatencyMonitor::Clock::time_point collectedAt;
+};
+
+// Stream
+
+InferenceService::Stream::Stream(InferenceService& service, ModelGroup& group, RingBuffer<float, 2048>* ringBuffer,
+                                 const AiInference::ModelConfig& config, int hopSize)
+    : mService(service)
+    , mGroup(group)
+    , mRingBuffer(ringBuffer)
+    , mSampleRate(config.sampleRate)
+    , mAssembler(config.inputSize, hopSize)
+    , mPostProcessor(createPostProcessor(config.confidenceThreshold, 5))
+{
+    mBaseHop.store(mAssembler.getHop());
+    mThreshold.store(mPostProcessor->getConfig().threshold);
+    if (config.useActivityGate) {
+        mActivityGate = std::make_unique<ActivityGate>(config.activityGate);
+    }
+    if (config.featureInput) {
+        // Room for the frames of the largest hop load shedding may reach; the
+        // extractor's first delta window releases the frames before its centre too
+        mFeatureExtractor = std::make_unique<FeatureExtractor>(static_cast<float>(config.sampleRate));
+        const int maxFrames = config.inputSize / FeatureExtractor::kHopLength + 1 + FeatureExtractor::kDeltaWidth / 2;
+        mFeatures.resize(static_cast<size_t>(maxFrames) * FeatureExtractor::kNumFeatures);
+    }
+}
+
+InferenceService::Stream::~Stream()
+{
+    mService.unregisterStream(*this);
+}
+
+void InferenceService::Stream::setActive(bool active)
+{
+    // Wait out a batch the stream is in; workers skip it while we hold it
+    while (!tryClaim()) {
+        std::this_thread::yield();
+    }
+    if (active && !mActive.load(std::memory_order_relaxed)) {
+        resetForStart();
+    }
+    mActive.store(active, std::memory_order_relaxed);
+    release();
+
+    if (active) {
+        // Input may have been queued while the stream was inactive
+        mService.mWorkAvailable.post();
+    }
+}
+
+void InferenceService::Stream::resetForStart()
+{
+    mAssembler.reset();
+    if (mActivityGate) {
+        mActivityGate->reset();
+    }
+    mPostProcessor->reset();
+    if (mFeatureExtractor) {
+        mFeatureExtractor->reset();
+    }
+    mNumFeatureFrames = 0;
+    mLastConfidence = 0.0f;
+    std::fill(mModelState.begin(), mModelState.end(), 0.0f);
+    mResetModelState = false;
+    mNextFrameIndex = 0;
+    mCommittedSamples = 0;
+    mLastCommit.store(0, std::memory_order_relaxed);
+
+    // Shedding starts over too
+    mAssembler.setHop(mBaseHop.load());
+    mUseHeuristic.store(false, std::memory_order_relaxed);
+    mOnTimeFrames = 0;
+    mLastVisit = LatencyMonitor::Clock::time_point();
+}
+
+bool InferenceService::Stream::setHopSize(int hopSize)
+{
+    if (!mAssembler.setHop(hopSize)) {
+        return false;
+    }
+    mBaseHop.store(hopSize);
+    return true;
+}
+
+LatencyMonitor::Clock::duration InferenceService::Stream::measureLag(size_t queuedBehind,
+                                                                     LatencyMonitor::Clock::time_point now) const
+{
+    // The newest sample arrived with the last commit; the queued ones are that much older than it is
+    auto lag = std::chrono::duration_cast<LatencyMonitor::Clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(queuedBehind) / std::max(1.0, mSampleRate)));
+    const LatencyMonitor::Clock::rep lastCommit = mLastCommit.load(std::memory_order_acquire);
+    if (lastCommit != 0) {
+        lag += std::max(LatencyMonitor::Clock::duration::zero(),
+                        now - LatencyMonitor::Clock::time_point(LatencyMonitor::Clock::duration(lastCommit)));
+    }
+    return lag;
+}
+
+void InferenceService::Stream::notifyInputCommitted(size_t numSamples) noexcept
+{
+    mLastCommit.store(LatencyMonitor::Clock::now().time_since_epoch().count(), std::memory_order_release);
+
+    // Frames end on multiples of the hop
+    const uint64_t hopSize = static_cast<uint64_t>(mAssembler.getHop());
+    const uint64_t framesBefore = mCommittedSamples / hopSize;
+    mCommittedSamples += numSamples;
+    if (mCommittedSamples / hopSize == framesBefore) {
+        return;
+    }
+
+    // A pending wake-up is followed by a scan of every stream, which will find this frame
+    if (mService.mWorkAvailable.getCount() <= 0) {
+        mService.mWorkAvailable.post();
+    }
+}
+
+void InferenceService::Stream::noteInputDropped(size_t numSamples) noexcept
+{
+    mStats.overflowSamples.fetch_add(numSamples, std::memory_order_relaxed);
+    mService.mStats.overflowSamples.fetch_add(numSamples, std::memory_order_relaxed);
+}
+
+ModelHandle::State InferenceService::Stream::getModelState() const
+{
+    ModelHandle::State state = ModelHandle::State::Ready;
+    for (const std::shared_ptr<ModelHandle>& engine : mGroup.engines) {
+        const ModelHandle::State engineState = engine->getState();
+        if (engineState == ModelHandle::State::Failed) {
+            return engineState;
+        }
+        if (engineState == ModelHandle::State::Loading || state == ModelHandle::State::Ready) {
+            state = engineState;
+        }
+    }
+    return state;
+}
+
+void InferenceService::Stream::setInferenceCallback(AiInference::InferenceCallback callback, void* context)
+{
+    mCallback = callback;
+    mCallbackContext = context;
+}
+
+// InferenceService
+
+InferenceService::InferenceService()
+    : InferenceService(Config())
+{
+}
+
+InferenceService::InferenceService(const Config& config)
+    : mConfig(config)
+{
+    mConfig.numWorkers = std::max(1, mConfig.numWorkers);
+    mConfig.maxBatch = std::max(1, mConfig.maxBatch);
+
+    // Engines are loaded by the shared loader; create it first so it outlives a static service
+    ModelLoader::getShared();
+
+    mWorkers.reserve(static_cast<size_t>(mConfig.numWorkers));
+    for (int i = 0; i < mConfig.numWorkers; ++i) {
+        mWorkers.emplace_back(&InferenceService::workerThreadMain, this, i);
+    }
+
+    std::cout << "InferenceService: Started " << mConfig.numWorkers << " workers, up to "
+              << mConfig.maxBatch << " streams per batch" << std::endl;
+}
+
+InferenceService::~InferenceService()
+{
+    mShouldStop.store(true);
+    mWorkAvailable.post(static_cast<int>(mWorkers.size()));
+    for (auto& worker : mWorkers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const auto& group : mGroups) {
+        if (!group->streams.empty()) {
+            std::cerr << "InferenceService: Destroyed with " << group->streams.size()
+                      << " streams still registered" << std::endl;
+        }
+    }
+}
+
+std::unique_ptr<InferenceService::Stream> InferenceService::registerStream(RingBuffer<float, 2048>* ringBuffer,
+                                                                           const AiInference::ModelConfig& modelConfig,
+                                                                           int hopSize)
+{
+    if (!ringBuffer || modelConfig.inputSize <= 0) {
+        std::cerr << "InferenceService: Invalid ring buffer or frame size" << std::endl;
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto found = std::find_if(mGroups.begin(), mGroups.end(),
+                              [&](const auto& group) { return isSameModel(group->config, modelConfig); });
+    if (found == mGroups.end()) {
+        auto group = std::make_unique<Stream::ModelGroup>();
+        group->config = modelConfig;
+        group->config.useActivityGate = false;     // Streams gate their own frames
+
+        // Streams extract the features of a feature-input model; the engines see only those
+        AiInference::ModelConfig engineConfig = group->config;
+        if (engineConfig.featureInput) {
+            engineConfig.inputSize = FeatureExtractor::kNumFeatures;
+            engineConfig.featureInput = false;
+        }
+
+        // One engine per worker, each with a state slot for every stream of a batch
+        const int maxBatch = mConfig.maxBatch;
+        for (size_t i = 0; i < mWorkers.size(); ++i) {
+            group->engines.push_back(ModelLoader::getShared().load(engineConfig,
+                [maxBatch](AiInference& engine) { engine.setNumStreams(maxBatch); }));
+        }
+        mGroups.push_back(std::move(group));
+        found = mGroups.end() - 1;
+    }
+
+    Stream::ModelGroup& group = **found;
+    std::unique_ptr<Stream> stream(new Stream(*this, group, ringBuffer, modelConfig, hopSize));
+    group.streams.push_back(stream.get());
+    ++group.members;
+    return stream;
+}
+
+void InferenceService::unregisterStream(Stream& stream)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto& streams = stream.mGroup.streams;
+        streams.erase(std::remove(streams.begin(), streams.end(), &stream), streams.end());
+    }
+
+    // No worker can claim it any more; wait for one that already has
+    while (!stream.tryClaim()) {
+        std::this_thread::yield();
+    }
+
+    // The last stream of a model takes the engines with it. Every batch of the
+    // group was made of its members, so none can still be running.
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (--stream.mGroup.members == 0) {
+        mGroups.erase(std::remove_if(mGroups.begin(), mGroups.end(),
+                                     [&](const auto& group) { return group.get() == &stream.mGroup; }),
+                      mGroups.end());
+    }
+}
+
+size_t InferenceService::getStreamCount() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    size_t count = 0;
+    for (const auto& group : mGroups) {
+        count += group->streams.size();
+    }
+    return count;
+}
+
+void InferenceService::workerThreadMain(int worker)
+{
+    ThreadPriorityGuard priority(RealtimeThreadPool::Priority::Low);
+
+    Batch batch;
+    batch.claimed.reserve(static_cast<size_t>(mConfig.maxBatch));
+    batch.streams.reserve(static_cast<size_t>(mConfig.maxBatch));
+    batch.results.resize(static_cast<size_t>(mConfig.maxBatch));
+
+    while (!mShouldStop.load()) {
+        // Keep going while there is work; sleep only after a scan of every stream came up empty
+        if (!processReadyStreams(worker, batch)) {
+            mWorkAvailable.wait();
+        }
+    }
+}
+
+bool InferenceService::processReadyStreams(int worker, Batch& batch)
+{
+    batch.claimed.clear();
+    batch.streams.clear();
+    AiInference* engine = nullptr;
+
+    {
+        // Only the choice of streams is made under the lock; a claim keeps a stream,
+        // and with it its group and engines, alive until it is released
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        // Round-robin over the groups and their streams, so a full batch never starves the rest
+        const size_t numGroups = mGroups.size();
+        for (size_t g = 0; g < numGroups && batch.claimed.empty(); ++g) {
+            const size_t groupIndex = (mNextGroup + g) % numGroups;
+            Stream::ModelGroup& group = *mGroups[groupIndex];
+
+            const size_t numStreams = group.streams.size();
+            for (size_t s = 0; s < numStreams && batch.claimed.size() < static_cast<size_t>(mConfig.maxBatch); ++s) {
+                const size_t streamIndex = (group.nextStream + s) % numStreams;
+                Stream& stream = *group.streams[streamIndex];
+                if (!stream.tryClaim()) {
+                    continue;       // Another worker has it
+                }
+                if (stream.isActive() && stream.mRingBuffer->size() >= stream.mAssembler.getSamplesNeeded()) {
+                    batch.claimed.push_back(&stream);
+                    group.nextStream = streamIndex + 1;
+                } else {
+                    stream.release();
+                }
+            }
+
+            if (!batch.claimed.empty()) {
+                engine = group.engines[static_cast<size_t>(worker)]->get();
+                mNextGroup = groupIndex + 1;
+            }
+        }
+    }
+
+    if (batch.claimed.empty()) {
+        return false;
+    }
+
+    // The group may have more ready streams than one batch takes: get a sleeping worker onto them
+    if (batch.claimed.size() == static_cast<size_t>(mConfig.maxBatch) && mWorkAvailable.getCount() <= 0) {
+        mWorkAvailable.post();
+    }
+
+    // Streams that end up without a frame in the batch (gated, heuristic or unready frames) are done
+    batch.collectedAt = LatencyMonitor::Clock::now();
+    for (Stream* stream : batch.claimed) {
+        const size_t batchSize = batch.streams.size();
+        collectFrame(*stream, engine, batch);
+        if (batch.streams.size() == batchSize) {
+            stream->release();
+        }
+    }
+
+    if (!batch.streams.empty()) {
+        runBatch(*engine, batch);
+    }
+    return true;
+}
+
+void InferenceService::collectFrame(Stream& stream, AiInference* engine, Batch& batch)
+{
+    FrameAssembler& assembler = stream.mAssembler;
+    const bool shedding = mConfig.maxLag.count() > 0;
+
+    // A stream gains a hop per hop period and loses one per visit: what is queued now
+    // waits at least as long as this round took before a worker is back
+    const auto sinceVisit = stream.mLastVisit == LatencyMonitor::Clock::time_point()
+        ? LatencyMonitor::Clock::duration::zero() : batch.collectedAt - stream.mLastVisit;
+    stream.mLastVisit = batch.collectedAt;
+
+    for (;;) {
+        const size_t samplesNeeded = assembler.getSamplesNeeded();
+        const size_t queued = stream.mRingBuffer->size();
+        if (queued < samplesNeeded) {
+            return;
+        }
+
+        // A frame's deadline: its newest sample may be at most maxLag old when it is taken.
+        // Shed when the frames behind this one would miss theirs before the next visit;
+        // only a backlog, since a producer that merely went quiet leaves nothing to skip.
+        const auto lag = stream.measureLag(queued - samplesNeeded, batch.collectedAt);
+        const auto hopDuration = std::chrono::duration_cast<LatencyMonitor::Clock::duration>(
+            std::chrono::duration<double>(assembler.getHop() / std::max(1.0, stream.mSampleRate)));
+        const auto projectedLag = lag + std::max(LatencyMonitor::Clock::duration::zero(), sinceVisit - hopDuration);
+        if (shedding && engine && projectedLag > mConfig.maxLag && queued > static_cast<size_t>(assembler.getFrameSize())) {
+            recordLag(stream, lag);
+            skipToNewestFrame(stream);
+            continue;
+        }
+
+        // Move the next hop from the ring buffer into the frame history
+        assembler.commit(stream.mRingBuffer->pop_bulk(assembler.getWritePointer(), samplesNeeded));
+
+        FrameAssembler::Frame frame;
+        if (!assembler.nextFrame(frame)) {
+            continue;
+        }
+
+        AiInference::InferenceResult result;
+        result.frameIndex = stream.mNextFrameIndex++;
+
+        // The extractor sees every hop, whatever becomes of the frame, so its window stays whole
+        LatencyMonitor* monitor = stream.mLatencyMonitor.get();
+        const auto featureStart = monitor ? LatencyMonitor::Clock::now() : LatencyMonitor::Clock::time_point();
+        if (stream.mFeatureExtractor) {
+            stream.mNumFeatureFrames = stream.mFeatureExtractor->process(
+                frame.samples + frame.numSamples - frame.hop, frame.hop, stream.mFeatures.data());
+        }
+
+        if (!engine) {
+            // Model still loading: keep the ring buffer flowing
+            stream.mStats.unreadyFrames.fetch_add(1);
+            mStats.unreadyFrames.fetch_add(1);
+            continue;
+        }
+        trackLag(stream, lag);
+
+        // The frame's features: the gate's analysis, the heuristic score or the model input
+        const auto endFeatures = [&] {
+            if (monitor) {
+                monitor->record(LatencyStage::FeatureExtraction, LatencyMonitor::Clock::now() - featureStart);
+            }
+        };
+
+        if (stream.mActivityGate && !stream.mActivityGate->process(frame.samples, frame.numSamples)) {
+            // Nothing the model could detect: the post-processor sees zero confidence
+            endFeatures();
+            stream.mResetModelState = true;
+            result.gated = true;
+            result.success = true;
+            deliver(stream, result, 0.0f);
+            stream.mStats.gatedFrames.fetch_add(1);
+            mStats.gatedFrames.fetch_add(1);
+            continue;
+        }
+
+        if (stream.mUseHeuristic.load(std::memory_order_relaxed)) {
+            // Shedding at its last level: no model call for this frame
+            stream.mResetModelState = true;
+            result.heuristic = true;
+            result.success = true;
+            const float confidence = ActivityGate::fricativeConfidence(frame.samples, frame.numSamples,
+                stream.mActivityGate ? stream.mActivityGate->getConfig() : ActivityGate::Config());
+            endFeatures();
+            deliver(stream, result, confidence);
+            stream.mStats.heuristicFrames.fetch_add(1);
+            mStats.heuristicFrames.fetch_add(1);
+            continue;
+        }
+
+        if (stream.mFeatureExtractor && stream.mNumFeatureFrames == 0) {
+            // The model's input has not moved on since its last frame
+            endFeatures();
+            result.held = true;
+            result.success = true;
+            deliver(stream, result, stream.mLastConfidence);
+            stream.mStats.heldFrames.fetch_add(1);
+            mStats.heldFrames.fetch_add(1);
+            continue;
+        }
+
+        const size_t stateSize = static_cast<size_t>(engine->getStateSize());
+        if (stream.mModelState.size() != stateSize) {
+            stream.mModelState.assign(stateSize, 0.0f);
+        }
+        if (stream.mResetModelState) {
+            // Audio resumes after a gap the model did not see
+            stream.mResetModelState = false;
+            std::fill(stream.mModelState.begin(), stream.mModelState.end(), 0.0f);
+        }
+
+        // A feature-input model takes the newest feature frame, any other the samples
+        const float* input = frame.samples;
+        size_t frameSize = static_cast<size_t>(frame.numSamples);
+        if (stream.mFeatureExtractor) {
+            frameSize = FeatureExtractor::kNumFeatures;
+            input = stream.mFeatures.data() + static_cast<size_t>(stream.mNumFeatureFrames - 1) * frameSize;
+        }
+        const size_t offset = batch.streams.size() * frameSize;
+        if (batch.frames.size() < offset + frameSize) {
+            // First batch of a model with larger frames than any before
+            batch.frames.resize(static_cast<size_t>(mConfig.maxBatch) * frameSize);
+        }
+        std::copy_n(input, frameSize, batch.frames.begin() + static_cast<std::ptrdiff_t>(offset));
+        batch.streams.push_back(&stream);
+        endFeatures();
+
+        stream.mLag = lag;
+        if (monitor) {
+            monitor->record(LatencyStage::QueueWait, lag);
+        }
+        return;
+    }
+}
+
+void InferenceService::skipToNewestFrame(Stream& stream)
+{
+    FrameAssembler& assembler = stream.mAssembler;
+    const int frameSize = assembler.getFrameSize();
+    const int hop = assembler.getHop();
+
+    // Keep one frame's worth, so the next frame is the newest audio
+    const size_t queued = stream.mRingBuffer->size();
+    const size_t drop = queued > static_cast<size_t>(frameSize) ? queued - frameSize : 0;
+    stream.mRingBuffer->commit_read(stream.mRingBuffer->acquire_read(drop).size());
+    assembler.reset();
+    stream.mResetModelState = true;
+    if (stream.mFeatureExtractor) {
+        stream.mFeatureExtractor->reset();   // The dropped audio leaves a gap in its window
+    }
+
+    const uint64_t skipped = drop / static_cast<size_t>(hop);
+    stream.mStats.skippedFrames.fetch_add(skipped);
+    mStats.skippedFrames.fetch_add(skipped);
+
+    // Missed again: fewer frames per second, and then no model at all
+    stream.mOnTimeFrames = 0;
+    if (hop < frameSize) {
+        assembler.setHop(largerHop(hop, frameSize));
+    } else {
+        stream.mUseHeuristic.store(true, std::memory_order_relaxed);
+    }
+}
+
+void InferenceService::recordLag(Stream& stream, LatencyMonitor::Clock::duration lag)
+{
+    const uint64_t lagUs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(lag).count());
+    updateMax(stream.mStats.maxLagUs, lagUs);
+    updateMax(mStats.maxLagUs, lagUs);
+}
+
+void InferenceService::trackLag(Stream& stream, LatencyMonitor::Clock::duration lag)
+{
+    recordLag(stream, lag);
+
+    const bool heuristic = stream.mUseHeuristic.load(std::memory_order_relaxed);
+    const int hop = stream.mAssembler.getHop();
+    const int baseHop = stream.mBaseHop.load(std::memory_order_relaxed);
+    if (!heuristic && hop <= baseHop) {
+        return;     // Not shedding
+    }
+
+    if (lag * 4 >= mConfig.maxLag) {
+        stream.mOnTimeFrames = 0;
+        return;
+    }
+    if (++stream.mOnTimeFrames < mConfig.recoveryFrames) {
+        return;
+    }
+
+    // Caught up for a while: step back one level
+    stream.mOnTimeFrames = 0;
+    if (heuristic) {
+        stream.mUseHeuristic.store(false, std::memory_order_relaxed);
+    } else {
+        stream.mAssembler.setHop(smallerHop(hop, baseHop, stream.mAssembler.getFrameSize()));
+    }
+}
+
+void InferenceService::runBatch(AiInference& engine, Batch& batch)
+{
+    const int numStreams = static_cast<int>(batch.streams.size());
+    const bool stateful = engine.getStateSize() > 0;
+
+    // Each stream's recurrent state rides in the slot of its frame
+    if (stateful) {
+        for (int i = 0; i < numStreams; ++i) {
+            engine.restoreState(batch.streams[static_cast<size_t>(i)]->mModelState.data(), i);
+        }
+    }
+
+    const auto inferenceStart = LatencyMonitor::Clock::now();
+    const bool success = engine.runStreams(batch.frames.data(), numStreams, batch.results.data());
+    const auto inferenceEnd = LatencyMonitor::Clock::now();
+
+    if (stateful && success) {
+        for (int i = 0; i < numStreams; ++i) {
+            engine.saveState(batch.streams[static_cast<size_t>(i)]->mModelState.data(), i);
+        }
+    }
+
+    mStats.batches.fetch_add(1);
+    mStats.batchedFrames.fetch_add(static_cast<uint64_t>(numStreams));
+
+    for (int i = 0; i < numStreams; ++i) {
+        Stream& stream = *batch.streams[static_cast<size_t>(i)];
+        AiInference::InferenceResult& result = batch.results[static_cast<size_t>(i)];
+        result.frameIndex = stream.mNextFrameIndex - 1;
+
+        if (success) {
+            deliver(stream, result, result.confidence);
+        } else {
+            stream.mStats.droppedFrames.fetch_add(1);
+        }
+
+        if (LatencyMonitor* monitor = stream.mLatencyMonitor.get()) {
+            monitor->record(LatencyStage::Inference, inferenceEnd - inferenceStart);
+            monitor->record(LatencyStage::EndToEnd, stream.mLag + (LatencyMonitor::Clock::now() - batch.collectedAt));
+        }
+        stream.release();
+    }
+}
+
+void InferenceService::deliver(Stream& stream, AiInference::InferenceResult& result, float rawConfidence)
+{
+    LatencyMonitor* monitor = stream.mLatencyMonitor.get();
+    const auto start = monitor ? LatencyMonitor::Clock::now() : LatencyMonitor::Clock::time_point();
+    const float threshold = stream.mThreshold.load(std::memory_order_relaxed);
+    if (threshold != stream.mPostProcessor->getConfig().threshold) {
+        stream.mPostProcessor->setThreshold(threshold);
+    }
+    stream.mLastConfidence = rawConfidence;
+    result.confidence = stream.mPostProcessor->processConfidence(rawConfidence);
+    result.label = stream.mPostProcessor->hasHit() ? AiInference::Label::Detected : AiInference::Label::NotDetected;
+    if (monitor) {
+        monitor->record(LatencyStage::PostProcessing, LatencyMonitor::Clock::now() - start);
+    }
+
+    if (stream.mCallback) {
+        stream.mCallback(result, stream.mCallbackContext);
+    }
+    stream.mStats.framesProcessed.fetch_add(1);
+}
+
+int InferenceService::getDefaultWorkerCount()
+{
+    const int hardwareThreads = static_cast<int>(std::thread::hardware_concurrency());
+    return std::clamp(hardwareThreads / 4, 1, 4);
+}
+
+bool InferenceService::configureShared(const Config& config)
+{
+    std::lock_guard<std::mutex> lock(sharedConfigMutex());
+    if (gSharedCreated) {
+        return false;
+    }
+    gSharedConfig = config;
+    return true;
+}
+
+InferenceService& InferenceService::getShared()
+{
+    static InferenceService service([] {
+        std::lock_guard<std::mutex> lock(sharedConfigMutex());
+        gSharedCreated = true;
+        return gSharedConfig;
+    }());
+    return service;
+}
+
+} // namespace KhDetector
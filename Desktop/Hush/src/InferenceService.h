@@ -0,0 +1,377 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "AiInference.h"
+#include "FeatureExtractor.h"
+#include "FrameAssembler.h"
+#include "LatencyHistogram.h"
+#include "LightweightSemaphore.h"
+#include "ModelLoader.h"
+#include "RingBuffer.h"
+
+namespace KhDetector {
+
+/**
+ * @brief Process-wide inference workers shared by every plugin instance
+ *
+ * A RealtimeThreadPool per instance means a session with dozens of tracks
+ * runs hundreds of inference threads against the host's audio threads. The
+ * service instead runs a fixed number of workers for the whole process.
+ * Every instance registers a Stream on its ring buffer, and a worker that
+ * wakes up takes the next frame of every ready stream, up to maxBatch of
+ * them, and evaluates them in one AiInference::runStreams() call, so a
+ * layer's weights are read once for the batch rather than once per
+ * instance.
+ *
+ * Streams with the same model (path, frame size, feature input and
+ * normalization) share a model group. Each worker has its own engine for
+ * each group, loaded by ModelLoader, and the weights are shared through
+ * ModelRegistry. Everything that belongs to one instance stays with its
+ * stream: frame assembly, the activity gate, the post-processor and, for a
+ * streaming model, the recurrent state, which is swapped into the batch
+ * slot the stream gets.
+ * For a model trained on features (ModelConfig::featureInput) the stream
+ * also runs a FeatureExtractor over its audio, and the model sees the
+ * newest feature frame instead of the samples; frames that complete no
+ * feature frame repeat the last confidence.
+ * A stream is worked on by at most one worker at a time, so its frames are
+ * evaluated in order.
+ *
+ * When the workers fall behind, each stream sheds load instead of letting
+ * its ring buffer overflow. A frame's lag is how old the newest sample
+ * queued behind it is when a worker takes it, and its deadline is
+ * Config::maxLag. When the frames queued behind the one a worker takes
+ * would miss theirs before a worker is back (their lag plus the time since
+ * the stream's last visit), the stream skips to the newest frame and drops
+ * the backlog. Each further miss escalates: the hop is doubled up to the
+ * frame size, and after that frames are scored by a cheap heuristic
+ * instead of the model. After Config::recoveryFrames frames
+ * well within the deadline the stream steps back one level.
+ */
+class InferenceService
+{
+public:
+    struct Config
+    {
+        int numWorkers = getDefaultWorkerCount();
+        int maxBatch = 32;              // Streams evaluated per model call
+
+        // Load shedding, off with a maxLag of 0
+        std::chrono::microseconds maxLag = std::chrono::milliseconds(60);
+        int recoveryFrames = 100;       // Frames within a quarter of maxLag before shedding steps back
+    };
+
+    struct Statistics
+    {
+        std::atomic<uint64_t> batches{0};           // Model calls
+        std::atomic<uint64_t> batchedFrames{0};     // Frames evaluated in them
+        std::atomic<uint64_t> gatedFrames{0};       // Kept from the model by a stream's activity gate
+        std::atomic<uint64_t> unreadyFrames{0};     // Discarded while the group's engines were loading
+        std::atomic<uint64_t> skippedFrames{0};     // Shed by skipping to a stream's newest frame
+        std::atomic<uint64_t> heuristicFrames{0};   // Scored by the fallback heuristic instead of the model
+        std::atomic<uint64_t> heldFrames{0};        // Completed no feature frame and repeated the last confidence
+        std::atomic<uint64_t> overflowSamples{0};   // Lost because a stream's ring buffer was full
+        std::atomic<uint64_t> maxLagUs{0};          // Worst lag of a frame when a worker took or skipped it
+    };
+
+    /**
+     * @brief One plugin instance's audio stream
+     *
+     * Owned by the instance; destroying it unregisters the stream (after
+     * any batch it is in has finished). Unless noted, methods are for the
+     * host's non-realtime threads.
+     */
+    class Stream
+    {
+    public:
+        struct Statistics
+        {
+            std::atomic<uint64_t> framesProcessed{0};   // Including gated frames
+            std::atomic<uint64_t> gatedFrames{0};
+            std::atomic<uint64_t> unreadyFrames{0};
+            std::atomic<uint64_t> droppedFrames{0};     // The model call failed
+            std::atomic<uint64_t> skippedFrames{0};
+            std::atomic<uint64_t> heuristicFrames{0};
+            std::atomic<uint64_t> heldFrames{0};
+            std::atomic<uint64_t> overflowSamples{0};
+            std::atomic<uint64_t> maxLagUs{0};
+        };
+
+        ~Stream();
+
+        Stream(const Stream&) = delete;
+        Stream& operator=(const Stream&) = delete;
+
+        /**
+         * @brief Start or stop processing the ring buffer
+         *
+         * Activating starts a fresh stream (empty frame history, closed
+         * gate, reset post-processor and model state) and wakes a worker for
+         * input already in the ring buffer. Waits for a batch the stream is
+         * in, so after setActive(false) no worker touches the ring buffer
+         * until the stream is activated again.
+         */
+        void setActive(bool active);
+        bool isActive() const { return mActive.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Tell the service the producer committed samples to the ring buffer (audio thread)
+         *
+         * Wakes a worker when a hop boundary is crossed and no wake-up is
+         * already pending (a woken worker scans every stream before it sleeps
+         * again); wait-free unless a worker is asleep.
+         */
+        void notifyInputCommitted(size_t numSamples) noexcept;
+
+        /**
+         * @brief Count samples the producer lost to a full ring buffer (audio thread)
+         */
+        void noteInputDropped(size_t numSamples) noexcept;
+
+        /**
+         * @brief Samples between frame starts; see FrameAssembler::setHop()
+         *
+         * Load shedding may run the stream at a larger hop for a while, and
+         * returns to this one when it recovers.
+         */
+        bool setHopSize(int hopSize);
+
+        /**
+         * @brief Hop in force, including one raised by load shedding
+         */
+        int getHopSize() const { return mAssembler.getHop(); }
+
+        /**
+         * @brief Whether load shedding currently scores frames with the fallback heuristic
+         */
+        bool isUsingHeuristic() const { return mUseHeuristic.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Load state of the workers' engines for this stream's model
+         *
+         * Loading until every engine is published, then Ready with a trained
+         * model, Heuristic without one; Failed if any load failed.
+         */
+        ModelHandle::State getModelState() const;
+
+        /**
+         * @brief Whether the workers' engines are loaded and run a trained model
+         */
+        bool isModelReady() const { return getModelState() == ModelHandle::State::Ready; }
+
+        /**
+         * @brief Whether the stream's post-processor reports a hit (any thread)
+         */
+        bool hasHit() const { return mPostProcessor->hasHit(); }
+
+        /**
+         * @brief Move the post-processor's hit threshold, e.g. from a sensitivity parameter (any thread)
+         *
+         * Starts as ModelConfig::confidenceThreshold; the worker applies a
+         * new value before the stream's next result.
+         */
+        void setThreshold(float threshold) noexcept
+        {
+            mThreshold.store(std::clamp(threshold, 0.0f, 1.0f), std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Called on a worker thread with every result of this stream; see AiInference::setInferenceCallback()
+         *
+         * Runs without the service's lock, so it may register streams or
+         * query the service, but not destroy its own stream. Set while the
+         * stream is inactive.
+         */
+        void setInferenceCallback(AiInference::InferenceCallback callback, void* context = nullptr);
+
+        /**
+         * @brief Record queue wait, feature extraction, inference, post-processing and end-to-end latency of the stream's frames
+         *
+         * The queue wait is the time since the producer last called
+         * LatencyMonitor::markInputCommitted(). Set while the stream is inactive.
+         */
+        void setLatencyMonitor(std::shared_ptr<LatencyMonitor> monitor) { mLatencyMonitor = std::move(monitor); }
+
+        const Statistics& getStatistics() const { return mStats; }
+
+    private:
+        friend class InferenceService;
+
+        struct ModelGroup;
+
+        Stream(InferenceService& service, ModelGroup& group, RingBuffer<float, 2048>* ringBuffer,
+               const AiInference::ModelConfig& config, int hopSize);
+
+        /**
+         * @brief Take the stream for one worker (or setActive())
+         */
+        bool tryClaim() noexcept { return !mBusy.exchange(true, std::memory_order_acquire); }
+        void release() noexcept { mBusy.store(false, std::memory_order_release); }
+
+        void resetForStart();
+
+        /**
+         * @brief Lag of a frame with queuedBehind samples still queued after it
+         */
+        LatencyMonitor::Clock::duration measureLag(size_t queuedBehind, LatencyMonitor::Clock::time_point now) const;
+
+        InferenceService& mService;
+        ModelGroup& mGroup;
+        RingBuffer<float, 2048>* mRingBuffer;
+        double mSampleRate;
+
+        std::atomic<bool> mActive{false};
+        std::atomic<bool> mBusy{false};
+        uint64_t mCommittedSamples = 0;                 // Audio thread only
+        std::atomic<LatencyMonitor::Clock::rep> mLastCommit{0};
+        std::atomic<int> mBaseHop;                      // Set by setHopSize()
+        std::atomic<float> mThreshold;                  // Set by setThreshold()
+
+        // Worker that claimed the stream only
+        FrameAssembler mAssembler;
+        std::unique_ptr<ActivityGate> mActivityGate;
+        std::unique_ptr<PostProcessor> mPostProcessor;
+        std::unique_ptr<FeatureExtractor> mFeatureExtractor;   // Feature-input models only
+        std::vector<float> mFeatures;                   // Frames the last hop completed
+        int mNumFeatureFrames = 0;
+        float mLastConfidence = 0.0f;                   // Raw confidence of the last result
+        std::vector<float> mModelState;                 // Recurrent state between batches
+        bool mResetModelState = false;                  // The model missed frames since it last ran
+        uint64_t mNextFrameIndex = 0;
+        LatencyMonitor::Clock::duration mLag{};         // Of the frame in the current batch
+        LatencyMonitor::Clock::time_point mLastVisit{};
+        std::atomic<bool> mUseHeuristic{false};
+        int mOnTimeFrames = 0;                          // In a row, while shedding
+
+        AiInference::InferenceCallback mCallback = nullptr;
+        void* mCallbackContext = nullptr;
+        std::shared_ptr<LatencyMonitor> mLatencyMonitor;
+        Statistics mStats;
+    };
+
+    InferenceService();
+    explicit InferenceService(const Config& config);
+
+    /**
+     * @brief Stop the workers; every stream must have been destroyed
+     */
+    ~InferenceService();
+
+    InferenceService(const InferenceService&) = delete;
+    InferenceService& operator=(const InferenceService&) = delete;
+
+    /**
+     * @brief Register a stream that reads frames of modelConfig.inputSize samples from ringBuffer
+     *
+     * The stream starts inactive. The first stream of a model loads an
+     * engine per worker in the background; until they are published the
+     * stream's frames are consumed and discarded. Allocates.
+     *
+     * @param hopSize Samples between frame starts; 0 for disjoint frames
+     * @return nullptr without a ring buffer
+     */
+    std::unique_ptr<Stream> registerStream(RingBuffer<float, 2048>* ringBuffer,
+                                           const AiInference::ModelConfig& modelConfig, int hopSize = 0);
+
+    int getWorkerCount() const { return static_cast<int>(mWorkers.size()); }
+    int getMaxBatch() const { return mConfig.maxBatch; }
+    size_t getStreamCount() const;
+
+    const Statistics& getStatistics() const { return mStats; }
+
+    /**
+     * @brief A quarter of the hardware threads, 1 to 4
+     */
+    static int getDefaultWorkerCount();
+
+    /**
+     * @brief Set the configuration of getShared() before its first use
+     *
+     * @return false if the shared service already exists
+     */
+    static bool configureShared(const Config& config);
+
+    /**
+     * @brief Service shared by all plugin instances in the process
+     */
+    static InferenceService& getShared();
+
+private:
+    struct Batch;
+
+    void workerThreadMain(int worker);
+
+    /**
+     * @brief Claim the ready streams of one model group, then evaluate their frames and deliver the results
+     *
+     * Only the claims are made under mMutex. Reading the ring buffers, the
+     * gate, the model call and the callbacks run without it, so workers
+     * overlap and a callback may call into the service.
+     *
+     * @return false if no stream had a frame
+     */
+    bool processReadyStreams(int worker, Batch& batch);
+
+    /**
+     * @brief Move a stream's ready frames into the batch, handling gated and unready frames on the spot
+     */
+    void collectFrame(Stream& stream, AiInference* engine, Batch& batch);
+
+    void runBatch(AiInference& engine, Batch& batch);
+
+    /**
+     * @brief Drop a stream's backlog but its newest frame, and escalate its shedding
+     */
+    void skipToNewestFrame(Stream& stream);
+
+    /**
+     * @brief Fold a lag into the stream's and the service's worst case
+     */
+    void recordLag(Stream& stream, LatencyMonitor::Clock::duration lag);
+
+    /**
+     * @brief Count a frame's lag, and step shedding back after enough frames on time
+     */
+    void trackLag(Stream& stream, LatencyMonitor::Clock::duration lag);
+
+    /**
+     * @brief Post-process a result and hand it to the stream's callback
+     */
+    void deliver(Stream& stream, AiInference::InferenceResult& result, float rawConfidence);
+
+    void unregisterStream(Stream& stream);
+
+    Config mConfig;
+    std::vector<std::thread> mWorkers;
+    std::atomic<bool> mShouldStop{false};
+    LightweightSemaphore mWorkAvailable;
+
+    mutable std::mutex mMutex;                      // Groups, their stream lists and claiming streams
+    std::vector<std::unique_ptr<Stream::ModelGroup>> mGroups;
+    size_t mNextGroup = 0;
+
+    Statistics mStats;
+};
+
+/**
+ * @brief Streams of one model, and an engine per worker to evaluate them
+ */
+struct InferenceService::Stream::ModelGroup
+{
+    AiInference::ModelConfig config;
+    std::vector<std::shared_ptr<ModelHandle>> engines;     // Indexed by worker
+    std::vector<Stream*> streams;                           // Those workers may claim
+    size_t members = 0;                                     // Registered streams, until their last batch is done
+    size_t nextStream = 0;                                  // Where the next scan starts, for fairness
+};
+
+} // namespace KhDetector
@@ -40,6 +40,10 @@ tresult PLUGIN_API KhDetectorController::initialize(FUnknown* context)
     // Add sensitivity parameter (0.0 - 1.0, default 0.6)
     parameters.addParameter(STR16("Sensitivity"), STR16("%"), 0, 0.6,
                           ParameterInfo::kCanAutomate, kSensitivity);
+    
+    // Model status (read-only): Loading, No Model (heuristic fallback) or Ready
+    parameters.addParameter(STR16("Model Ready"), nullptr, 2, 0,
+                          ParameterInfo::kIsReadOnly, kModelReady);
 
     return result;
 }
@@ -143,6 +147,15 @@ tresult PLUGIN_API KhDetectorController::getParamStringByValue(ParamID tag, Para
                 Steinberg::UString(string, 128).fromAscii("---");
             return kResultTrue;
             
+        case kModelReady:
+            if (valueNormalized > 0.75)
+                Steinberg::UString(string, 128).fromAscii("Ready");
+            else if (valueNormalized > 0.25)
+                Steinberg::UString(string, 128).fromAscii("No Model");
+            else
+                Steinberg::UString(string, 128).fromAscii("Loading");
+            return kResultTrue;
+            
         case kSensitivity:
         {
             char text[32];
@@ -76,6 +76,7 @@ private:
         kBypass = 0,
         kHitDetected,
         kSensitivity,
+        kModelReady,
         kNumParameters
     };
     
@@ -4,6 +4,7 @@
 
 #include "base/source/fstreamer.h"
 #include "pluginterfaces/vst/ivstparameterchanges.h"
+#include <algorithm>
 #include <cmath>
 #include <vector>
 
@@ -11,22 +12,26 @@ using namespace Steinberg;
 
 //------------------------------------------------------------------------
 KhDetectorProcessor::KhDetectorProcessor()
-    : mDecimatedSamples(1024)  // Initial size, will be resized as needed
-    , mProcessingFrame(kFrameSize)
+    : mProcessingFrame(kFrameSize)
 {
     // Register its editor class (the same as used in vstgui4)
     setControllerClass(kKhDetectorControllerUID);
     
-    // Initialize AI inference engine
+    // Latency histograms shared by the audio thread and the inference service
+    mLatencyMonitor = std::make_shared<KhDetector::LatencyMonitor>();
+    
+    // Run inference on the process-wide service, which batches this instance's
+    // frames with every other instance's; the first instance of the model
+    // loads and warms up the engines in the background
     auto aiConfig = KhDetector::createDefaultModelConfig();
     aiConfig.inputSize = kFrameSize;  // 20ms frames at 16kHz
-    mAiInference = KhDetector::createAiInference(aiConfig);
-    
-    // Initialize thread pool with low priority (below audio thread)
-    mThreadPool = std::make_unique<KhDetector::RealtimeThreadPool>(
-        KhDetector::RealtimeThreadPool::Priority::Low, 
-        kFrameSize
-    );
+    aiConfig.useActivityGate = true;  // Skip the model on silence and voiced-only frames
+    aiConfig.activityGate.hangoverFrames = 200 / kHopSizeMs;  // Hold open for 200 ms
+    aiConfig.featureInput = !aiConfig.modelPath.empty();  // The shipped model is trained on FeatureExtractor frames
+    mInferenceStream = KhDetector::InferenceService::getShared().registerStream(&mDecimatedBuffer, aiConfig, kHopSize);
+    if (mInferenceStream) {
+        mInferenceStream->setLatencyMonitor(mLatencyMonitor);
+    }
     
     // Initialize MIDI event handler
     KhDetector::MidiEventHandler::Config midiConfig;
@@ -46,10 +51,8 @@ KhDetectorProcessor::KhDetectorProcessor()
 //------------------------------------------------------------------------
 KhDetectorProcessor::~KhDetectorProcessor()
 {
-    // Stop thread pool before destroying other components
-    if (mThreadPool) {
-        mThreadPool->stop();
-    }
+    // Unregister from the inference service before the ring buffer goes away
+    mInferenceStream.reset();
 }
 
 //------------------------------------------------------------------------
@@ -82,10 +85,10 @@ tresult PLUGIN_API KhDetectorProcessor::setActive(TBool state)
 {
     if (state)
     {
-        // Plugin is being activated - start thread pool
-        if (mThreadPool && mAiInference)
+        // Plugin is being activated - start inference on a fresh stream
+        if (mInferenceStream)
         {
-            mThreadPool->start(&mDecimatedBuffer, mAiInference.get(), kFrameSizeMs);
+            mInferenceStream->setActive(true);
         }
         
         // Reset MIDI handler state
@@ -99,10 +102,10 @@ tresult PLUGIN_API KhDetectorProcessor::setActive(TBool state)
     }
     else
     {
-        // Plugin is being deactivated - stop thread pool  
-        if (mThreadPool)
+        // Plugin is being deactivated - the service stops reading our ring buffer
+        if (mInferenceStream)
         {
-            mThreadPool->stop();
+            mInferenceStream->setActive(false);
         }
         
         // Reset MIDI handler to send any pending note offs
@@ -191,7 +194,6 @@ tresult PLUGIN_API KhDetectorProcessor::process(ProcessData& data)
 
     // Get audio buffers
     uint32 sampleFramesSize = getSampleFramesSizeInBytes(processSetup, data.numSamples);
-    void** in = getChannelBuffersPointer(processSetup, data.inputs[0]);
     void** out = getChannelBuffersPointer(processSetup, data.outputs[0]);
 
     if (mBypass)
@@ -202,76 +204,23 @@ tresult PLUGIN_API KhDetectorProcessor::process(ProcessData& data)
             memset(out[i], 0, sampleFramesSize);
         }
     }
+    else if (processSetup.symbolicSampleSize == kSample64)
+    {
+        // Double-precision hosts: the decimators convert to float as they
+        // read the input, so both sample sizes produce the same detections
+        processAudio<Sample64>(data.inputs[0].channelBuffers64, data.outputs[0].channelBuffers64,
+                               numChannels, data.numSamples);
+    }
     else
     {
-        // Process audio through decimation pipeline
-        if (numChannels >= 2)
-        {
-            // Process stereo input
-            float* leftChannel = (float*)in[0];
-            float* rightChannel = (float*)in[1];
-            
-            // Ensure we have enough space for decimated samples
-            int maxDecimatedSamples = (data.numSamples / DECIM_FACTOR) + 1;
-            if (mDecimatedSamples.size() < maxDecimatedSamples)
-            {
-                mDecimatedSamples.resize(maxDecimatedSamples);
-            }
-            
-            // Decimate stereo to mono
-            int decimatedCount = mDecimator.processStereoToMono(
-                leftChannel, rightChannel, 
-                mDecimatedSamples.data(), 
-                data.numSamples
-            );
-            
-            // Enqueue decimated samples into ring buffer
-            // The thread pool will consume these samples asynchronously
-            for (int i = 0; i < decimatedCount; ++i)
-            {
-                float sample = mDecimatedSamples[i];
-                
-                if (!mDecimatedBuffer.push(sample))
-                {
-                    // Buffer overflow - this shouldn't happen with proper sizing
-                    // but we handle it gracefully by dropping the sample
-                }
-                
-                // Create waveform sample for visualization
-                if (mWaveformBuffer) {
-                    // Calculate additional features for the sample
-                    float rms = std::abs(sample); // Simple RMS approximation
-                    float zcr = 0.0f; // Zero crossing rate (would need history for accurate calculation)
-                    float spectralCentroid = 0.0f; // Would need spectral analysis
-                    
-                    // Check if this is a hit sample
-                    bool isHit = mHadHit.load();
-                    
-                    KhDetector::WaveformSample waveformSample(sample, rms, spectralCentroid, zcr, isHit);
-                    mWaveformBuffer->push(waveformSample);
-                }
-            }
-        }
-        
-        // Copy input to output (pass-through for now)
-        if (in != out)
-        {
-            for (int32 i = 0; i < numChannels; i++)
-            {
-                if (in[i] != out[i])
-                {
-                    memcpy(out[i], in[i], sampleFramesSize);
-                }
-            }
-        }
+        processAudio<Sample32>(data.inputs[0].channelBuffers32, data.outputs[0].channelBuffers32,
+                               numChannels, data.numSamples);
     }
 
-    // Synchronize hit state with AI inference (non-blocking check)
-    bool currentHit = false;
-    if (mAiInference) {
-        currentHit = mAiInference->hasHit();
-        mHadHit.store(currentHit);
-    }
+    // Synchronize hit state with AI inference (non-blocking check);
+    // no hits while the model is still loading
+    const bool currentHit = mInferenceStream && mInferenceStream->hasHit();
+    mHadHit.store(currentHit);
     
     // Generate MIDI events for hit state changes
     if (mMidiHandler && data.outputEvents) {
@@ -308,6 +257,19 @@ tresult PLUGIN_API KhDetectorProcessor::process(ProcessData& data)
         if (paramQueue) {
             paramQueue->addPoint(0, mHadHit.load() ? 1.0 : 0.0, index);
         }
+        
+        // Tell the host/GUI once the model has been published: 1 with a trained
+        // model, 0.5 when the heuristic runs in its place (no model or a failed load)
+        const KhDetector::ModelHandle::State modelState = getModelState();
+        if (modelState != mReportedModelState) {
+            paramQueue = data.outputParameterChanges->addParameterData(kModelReady, index);
+            if (paramQueue) {
+                const double value = modelState == KhDetector::ModelHandle::State::Ready ? 1.0
+                                   : modelState == KhDetector::ModelHandle::State::Loading ? 0.0 : 0.5;
+                paramQueue->addPoint(0, value, index);
+                mReportedModelState = modelState;
+            }
+        }
     }
 
     return kResultOk;
@@ -346,12 +308,53 @@ tresult PLUGIN_API KhDetectorProcessor::getState(IBStream* state)
 template<typename SampleType>
 void KhDetectorProcessor::processAudio(SampleType** inputs, SampleType** outputs, int32 numChannels, int32 sampleFrames)
 {
-    // Simple pass-through for now
+    // Process audio through decimation pipeline
+    if (numChannels >= 2)
+    {
+        const SampleType* leftChannel = inputs[0];
+        const SampleType* rightChannel = inputs[1];
+        const auto decimationStart = KhDetector::LatencyMonitor::Clock::now();
+        
+        // Reserve space in the ring buffer and decimate straight into it.
+        // The inference service will consume these samples asynchronously.
+        const int expectedCount = mDecimator.getOutputCount(sampleFrames);
+        auto writeSpans = mDecimatedBuffer.acquire_write(static_cast<size_t>(expectedCount));
+        
+        // If the ring buffer is full the surplus samples are dropped by
+        // the decimator; the inference service sheds load well before
+        // that happens, but any loss is counted in its statistics
+        int decimatedCount = mDecimator.processStereoToMono(leftChannel, rightChannel, writeSpans, sampleFrames);
+        if (decimatedCount < expectedCount && mInferenceStream) {
+            mInferenceStream->noteInputDropped(static_cast<size_t>(expectedCount - decimatedCount));
+        }
+        
+        // Feed waveform visualization from the reserved region before
+        // handing it over to the consumer
+        if (mWaveformBuffer && decimatedCount > 0) {
+            const bool isHit = mHadHit.load();
+            const size_t firstCount = std::min(writeSpans.first.size, static_cast<size_t>(decimatedCount));
+            mWaveformBuffer->pushBlock(writeSpans.first.data, firstCount, isHit);
+            mWaveformBuffer->pushBlock(writeSpans.second.data, decimatedCount - firstCount, isHit);
+        }
+        
+        mDecimatedBuffer.commit_write(static_cast<size_t>(decimatedCount));
+        
+        const auto decimationEnd = KhDetector::LatencyMonitor::Clock::now();
+        mLatencyMonitor->record(KhDetector::LatencyStage::Decimation, decimationEnd - decimationStart);
+        mLatencyMonitor->markInputCommitted(decimationEnd);
+        
+        // Wake an inference worker once a whole hop is queued
+        if (mInferenceStream) {
+            mInferenceStream->notifyInputCommitted(static_cast<size_t>(decimatedCount));
+        }
+    }
+    
+    // Copy input to output (pass-through for now)
     for (int32 i = 0; i < numChannels; i++)
     {
-        for (int32 j = 0; j < sampleFrames; j++)
+        if (inputs[i] != outputs[i])
         {
-            outputs[i][j] = inputs[i][j];
+            memcpy(outputs[i], inputs[i], sampleFrames * sizeof(SampleType));
         }
     }
 }
@@ -361,22 +364,12 @@ void KhDetectorProcessor::initializeForSampleRate(double sampleRate)
 {
     mCurrentSampleRate = sampleRate;
     
-    // Reset decimator for new sample rate
-    mDecimator.reset();
+    // Choose the decimation path for the new rate; unsupported rates feed
+    // the model at sampleRate / DECIM_FACTOR instead of 16kHz
+    mDecimator.configure(sampleRate);
     
     // Clear ring buffer
     mDecimatedBuffer.clear();
-    
-    // Calculate expected decimation factor based on sample rate
-    double expectedDecimationFactor = sampleRate / kTargetSampleRate;
-    
-    // For now, we handle 48kHz (factor=3) optimally
-    // TODO: Add support for 44.1kHz with fractional decimation or cascade of decimators
-    if (std::abs(expectedDecimationFactor - DECIM_FACTOR) > 0.1)
-    {
-        // Log warning about non-optimal decimation factor
-        // In a real implementation, you might want to adjust the filter or use a different approach
-    }
 }
 
 //------------------------------------------------------------------------
@@ -7,9 +7,10 @@
 #include "pluginterfaces/vst/ivstprocesscontext.h"
 #include "pluginterfaces/vst/ivstevents.h"
 #include "RingBuffer.h"
-#include "PolyphaseDecimator.h"
-#include "RealtimeThreadPool.h"
+#include "HostRateDecimator.h"
 #include "AiInference.h"
+#include "InferenceService.h"
+#include "LatencyHistogram.h"
 #include "MidiEventHandler.h"
 #include "WaveformData.h"
 
@@ -55,6 +56,27 @@ public:
      * @brief Get waveform buffer for GUI visualization
      */
     std::shared_ptr<KhDetector::WaveformBuffer4K> getWaveformBuffer() { return mWaveformBuffer; }
+    
+    /**
+     * @brief Get per-stage latency histograms for a diagnostics dump or in-process tooling
+     *
+     * The controller and editor do not read it: they only see the processor
+     * through parameters, like Model Ready.
+     */
+    std::shared_ptr<KhDetector::LatencyMonitor> getLatencyMonitor() { return mLatencyMonitor; }
+    
+    /**
+     * @brief Whether the background model load has published inference engines that run a trained model
+     */
+    bool isModelReady() const { return mInferenceStream && mInferenceStream->isModelReady(); }
+
+    /**
+     * @brief Load state of the inference engines, Loading until the stream exists
+     */
+    KhDetector::ModelHandle::State getModelState() const
+    {
+        return mInferenceStream ? mInferenceStream->getModelState() : KhDetector::ModelHandle::State::Loading;
+    }
 
 protected:
     // Processing
@@ -67,6 +89,7 @@ private:
     {
         kBypass = 0,
         kHitDetected,
+        kModelReady = 3,    // After the controller's kSensitivity
         kNumParameters
     };
 
@@ -74,6 +97,8 @@ private:
     static constexpr int kTargetSampleRate = 16000;
     static constexpr int kFrameSizeMs = 20;
     static constexpr int kFrameSize = (kTargetSampleRate * kFrameSizeMs) / 1000; // 320 samples at 16kHz
+    static constexpr int kHopSizeMs = 10;   // 50% overlap between frames
+    static constexpr int kHopSize = (kTargetSampleRate * kHopSizeMs) / 1000;     // 160 samples at 16kHz
     static constexpr size_t kRingBufferSize = 2048; // Must be power of 2, larger than frame size
 
     // State
@@ -82,12 +107,13 @@ private:
     std::atomic<bool> mHadHit{false};  // Exposed to GUI/controller
     
     // Audio processing components
-    KhDetector::PolyphaseDecimator<DECIM_FACTOR> mDecimator;
+    KhDetector::HostRateDecimator mDecimator;    // Host rate -> 16kHz mono
     KhDetector::RingBuffer<float, kRingBufferSize> mDecimatedBuffer;
     
     // AI processing components
-    std::unique_ptr<KhDetector::AiInference> mAiInference;
-    std::unique_ptr<KhDetector::RealtimeThreadPool> mThreadPool;
+    std::shared_ptr<KhDetector::LatencyMonitor> mLatencyMonitor;
+    std::unique_ptr<KhDetector::InferenceService::Stream> mInferenceStream;    // Audio passes through until the model is ready
+    KhDetector::ModelHandle::State mReportedModelState = KhDetector::ModelHandle::State::Loading;
     
     // MIDI event handling
     std::unique_ptr<KhDetector::MidiEventHandler> mMidiHandler;
@@ -98,7 +124,6 @@ private:
     std::unique_ptr<KhDetector::SpectralAnalyzer> mSpectralAnalyzer;
     
     // Working buffers
-    std::vector<float> mDecimatedSamples;
     std::vector<float> mProcessingFrame;
     
     // Frame processing
@@ -0,0 +1,185 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+
+namespace KhDetector {
+
+namespace {
+
+int highestBit(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    for (int step = 32; step > 0; step /= 2) {
+        if (value >> step) {
+            value >>= step;
+            bit += step;
+        }
+    }
+    return bit;
+#endif
+}
+
+} // namespace
+
+int LatencyHistogram::getBucketIndex(uint64_t value) noexcept
+{
+    if (value < kSubBuckets) {
+        return static_cast<int>(value);
+    }
+    // The top kSubBucketBits + 1 bits select the bucket: octave, then position within it
+    const int shift = highestBit(value) - kSubBucketBits;
+    return (shift + 1) * kSubBuckets + static_cast<int>((value >> shift) - kSubBuckets);
+}
+
+uint64_t LatencyHistogram::getBucketUpperBound(int index) noexcept
+{
+    if (index < kSubBuckets) {
+        return static_cast<uint64_t>(index);
+    }
+    const int shift = index / kSubBuckets - 1;
+    const uint64_t lower = static_cast<uint64_t>(kSubBuckets + index % kSubBuckets) << shift;
+    return lower + ((uint64_t{1} << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t nanoseconds) noexcept
+{
+    mCounts[getBucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    mTotal.fetch_add(1, std::memory_order_relaxed);
+    mSum.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+    uint64_t min = mMin.load(std::memory_order_relaxed);
+    while (nanoseconds < min && !mMin.compare_exchange_weak(min, nanoseconds, std::memory_order_relaxed)) {
+    }
+    uint64_t max = mMax.load(std::memory_order_relaxed);
+    while (nanoseconds > max && !mMax.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t LatencyHistogram::readCounts(Counts& counts) const
+{
+    uint64_t total = 0;
+    for (int i = 0; i < kNumBuckets; ++i) {
+        counts[i] = mCounts[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    return total;
+}
+
+uint64_t LatencyHistogram::valueAtRank(const Counts& counts, uint64_t rank)
+{
+    uint64_t seen = 0;
+    for (int i = 0; i < kNumBuckets; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return getBucketUpperBound(i);
+        }
+    }
+    return 0;
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::getSnapshot() const
+{
+    Snapshot snapshot;
+    Counts counts;
+    const uint64_t total = readCounts(counts);
+    if (total == 0) {
+        return snapshot;
+    }
+
+    // Bucket bounds never report beyond the exact extremes, once a
+    // concurrent first record() has set both
+    snapshot.count = total;
+    snapshot.minNs = mMin.load(std::memory_order_relaxed);
+    snapshot.maxNs = mMax.load(std::memory_order_relaxed);
+    const bool haveExtremes = snapshot.minNs <= snapshot.maxNs;
+    const auto percentile = [&](double p) {
+        const auto rank = static_cast<uint64_t>(std::ceil(p / 100.0 * static_cast<double>(total)));
+        const uint64_t value = valueAtRank(counts, std::max<uint64_t>(rank, 1));
+        return haveExtremes ? std::clamp(value, snapshot.minNs, snapshot.maxNs) : value;
+    };
+    snapshot.p50Ns = percentile(50.0);
+    snapshot.p99Ns = percentile(99.0);
+    snapshot.p999Ns = percentile(99.9);
+    if (!haveExtremes) {
+        snapshot.minNs = snapshot.p50Ns;
+        snapshot.maxNs = snapshot.p999Ns;
+    }
+
+    const uint64_t recorded = mTotal.load(std::memory_order_relaxed);
+    snapshot.meanNs = recorded > 0
+        ? static_cast<double>(mSum.load(std::memory_order_relaxed)) / static_cast<double>(recorded) : 0.0;
+    return snapshot;
+}
+
+uint64_t LatencyHistogram::getValueAtPercentile(double percentile) const
+{
+    Counts counts;
+    const uint64_t total = readCounts(counts);
+    if (total == 0) {
+        return 0;
+    }
+    const auto rank = static_cast<uint64_t>(std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * total));
+    return std::min(valueAtRank(counts, std::max<uint64_t>(rank, 1)), mMax.load(std::memory_order_relaxed));
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto& count : mCounts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    mTotal.store(0, std::memory_order_relaxed);
+    mSum.store(0, std::memory_order_relaxed);
+    mMin.store(UINT64_MAX, std::memory_order_relaxed);
+    mMax.store(0, std::memory_order_relaxed);
+}
+
+const char* getLatencyStageName(LatencyStage stage)
+{
+    switch (stage) {
+        case LatencyStage::Decimation:        return "decimation";
+        case LatencyStage::QueueWait:         return "queue_wait";
+        case LatencyStage::FeatureExtraction: return "feature_extraction";
+        case LatencyStage::Inference:         return "inference";
+        case LatencyStage::PostProcessing:    return "post_processing";
+        case LatencyStage::EndToEnd:          return "end_to_end";
+    }
+    return "unknown";
+}
+
+void LatencyMonitor::reset()
+{
+    for (auto& histogram : mHistograms) {
+        histogram.reset();
+    }
+}
+
+void LatencyMonitor::dump(std::ostream& stream) const
+{
+    const auto micros = [](uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+
+    const std::ios_base::fmtflags flags = stream.flags();
+    const std::streamsize precision = stream.precision();
+
+    stream << std::left << std::setw(20) << "stage (us)" << std::right << std::setw(10) << "count"
+           << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10) << "p99.9"
+           << std::setw(10) << "max" << '\n';
+    stream << std::fixed << std::setprecision(1);
+    for (int stage = 0; stage < kNumLatencyStages; ++stage) {
+        const LatencyHistogram::Snapshot snapshot = mHistograms[stage].getSnapshot();
+        stream << std::left << std::setw(20) << getLatencyStageName(static_cast<LatencyStage>(stage))
+               << std::right << std::setw(10) << snapshot.count
+               << std::setw(10) << micros(snapshot.p50Ns) << std::setw(10) << micros(snapshot.p99Ns)
+               << std::setw(10) << micros(snapshot.p999Ns) << std::setw(10) << micros(snapshot.maxNs) << '\n';
+    }
+
+    stream.flags(flags);
+    stream.precision(precision);
+}
+
+} // namespace KhDetector
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+
+namespace KhDetector {
+
+/**
+ * @brief Lock-free, log-bucketed latency histogram (HDR-style)
+ *
+ * Values are nanoseconds. Below 16 ns every value has its own bucket;
+ * above, each power of two is split into 16 buckets, so a percentile is
+ * reported within 1/16 (6.25%) above the true value, over the whole 64-bit
+ * range, in a fixed 976 counters.
+ *
+ * record() is a handful of relaxed atomic increments and never blocks,
+ * allocates or fails, so it is safe on the audio thread and from several
+ * threads at once. Readers take a snapshot at any time; it is not an
+ * atomic cut across buckets, but its percentiles are computed from the
+ * counts it read, so they are consistent with each other.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kNumBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Writers must never take a lock");
+
+    struct Snapshot
+    {
+        uint64_t count = 0;
+        uint64_t minNs = 0;
+        uint64_t maxNs = 0;
+        double meanNs = 0.0;
+        uint64_t p50Ns = 0;
+        uint64_t p99Ns = 0;
+        uint64_t p999Ns = 0;
+    };
+
+    LatencyHistogram() { reset(); }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(uint64_t nanoseconds) noexcept;
+
+    void record(std::chrono::nanoseconds duration) noexcept
+    {
+        record(duration.count() > 0 ? static_cast<uint64_t>(duration.count()) : 0);
+    }
+
+    Snapshot getSnapshot() const;
+
+    /**
+     * @brief Smallest bucket bound at or above the given percentile (0 - 100) of the recorded values
+     */
+    uint64_t getValueAtPercentile(double percentile) const;
+
+    /**
+     * @brief Clear all counts (values recorded concurrently may be lost)
+     */
+    void reset();
+
+    static int getBucketIndex(uint64_t value) noexcept;
+
+    /**
+     * @brief Largest value that falls into a bucket
+     */
+    static uint64_t getBucketUpperBound(int index) noexcept;
+
+private:
+    using Counts = std::array<uint64_t, kNumBuckets>;
+
+    uint64_t readCounts(Counts& counts) const;
+    static uint64_t valueAtRank(const Counts& counts, uint64_t rank);
+
+    std::array<std::atomic<uint64_t>, kNumBuckets> mCounts;
+    std::atomic<uint64_t> mTotal{0};
+    std::atomic<uint64_t> mSum{0};
+    std::atomic<uint64_t> mMin{UINT64_MAX};
+    std::atomic<uint64_t> mMax{0};
+};
+
+/**
+ * @brief Pipeline stages with their own latency histogram
+ */
+enum class LatencyStage
+{
+    Decimation,         // Host block to 16 kHz samples in the ring buffer (audio thread)
+    QueueWait,          // Newest sample of a frame waiting in the ring buffer
+    FeatureExtraction,  // Gate measurement and input normalization
+    Inference,          // Model evaluation
+    PostProcessing,     // Median filter and hit detection
+    EndToEnd            // Newest sample committed to result available
+};
+
+constexpr int kNumLatencyStages = static_cast<int>(LatencyStage::EndToEnd) + 1;
+
+/**
+ * @brief Printable name of a stage ("decimation", "queue_wait", ...)
+ */
+const char* getLatencyStageName(LatencyStage stage);
+
+/**
+ * @brief One histogram per pipeline stage, shared by the processor, the thread pool and the inference engine
+ *
+ * Writers record from the audio and inference threads; the GUI or a
+ * diagnostics dump reads snapshots from any thread. The monitor also keeps
+ * the time the audio thread last committed samples to the ring buffer, from
+ * which the inference thread measures how long a frame waited.
+ */
+class LatencyMonitor
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void record(LatencyStage stage, Clock::duration duration) noexcept
+    {
+        mHistograms[static_cast<int>(stage)].record(std::chrono::duration_cast<std::chrono::nanoseconds>(duration));
+    }
+
+    LatencyHistogram& getHistogram(LatencyStage stage) { return mHistograms[static_cast<int>(stage)]; }
+    const LatencyHistogram& getHistogram(LatencyStage stage) const { return mHistograms[static_cast<int>(stage)]; }
+
+    LatencyHistogram::Snapshot getSnapshot(LatencyStage stage) const { return getHistogram(stage).getSnapshot(); }
+
+    /**
+     * @brief Note that the audio thread has just committed samples (audio thread)
+     */
+    void markInputCommitted(Clock::time_point time) noexcept
+    {
+        mLastInput.store(time.time_since_epoch().count(), std::memory_order_release);
+    }
+
+    Clock::time_point getLastInputTime() const noexcept
+    {
+        return Clock::time_point(Clock::duration(mLastInput.load(std::memory_order_acquire)));
+    }
+
+    void reset();
+
+    /**
+     * @brief Write a table of count, p50, p99, p99.9 and max per stage, in microseconds
+     */
+    void dump(std::ostream& stream) const;
+
+private:
+    std::array<LatencyHistogram, kNumLatencyStages> mHistograms;
+    std::atomic<Clock::rep> mLastInput{0};
+};
+
+} // namespace KhDetector
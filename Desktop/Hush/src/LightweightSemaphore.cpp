@@ -0,0 +1,164 @@
+#include "LightweightSemaphore.h"
+
+#include <cerrno>
+#include <climits>
+#include <ctime>
+
+#ifdef _WIN32
+    #include <windows.h>
+#elif defined(__APPLE__)
+    #include <mach/mach.h>
+    #include <mach/task.h>
+#endif
+
+namespace KhDetector {
+
+LightweightSemaphore::LightweightSemaphore(int initialCount)
+    : mCount(initialCount)
+{
+#ifdef _WIN32
+    mSemaphore = CreateSemaphoreW(nullptr, 0, LONG_MAX, nullptr);
+#elif defined(__APPLE__)
+    semaphore_create(mach_task_self(), &mSemaphore, SYNC_POLICY_FIFO, 0);
+#else
+    sem_init(&mSemaphore, 0, 0);
+#endif
+}
+
+LightweightSemaphore::~LightweightSemaphore()
+{
+#ifdef _WIN32
+    CloseHandle(mSemaphore);
+#elif defined(__APPLE__)
+    semaphore_destroy(mach_task_self(), mSemaphore);
+#else
+    sem_destroy(&mSemaphore);
+#endif
+}
+
+void LightweightSemaphore::post(int count) noexcept
+{
+    if (count <= 0) {
+        return;
+    }
+    // Only threads that already went below zero are asleep in the kernel
+    const int previous = mCount.fetch_add(count, std::memory_order_release);
+    const int waiters = previous < 0 ? -previous : 0;
+    const int toWake = waiters < count ? waiters : count;
+    if (toWake > 0) {
+        kernelSignal(toWake);
+    }
+}
+
+bool LightweightSemaphore::tryWait() noexcept
+{
+    int count = mCount.load(std::memory_order_relaxed);
+    while (count > 0) {
+        if (mCount.compare_exchange_weak(count, count - 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void LightweightSemaphore::wait()
+{
+    waitWithTimeout(-1);
+}
+
+bool LightweightSemaphore::waitFor(std::chrono::microseconds timeout)
+{
+    return waitWithTimeout(timeout.count() > 0 ? timeout.count() : 0);
+}
+
+bool LightweightSemaphore::waitWithTimeout(int64_t timeoutUs)
+{
+    for (int spin = 0; spin < kSpinCount; ++spin) {
+        if (tryWait()) {
+            return true;
+        }
+    }
+
+    if (mCount.fetch_sub(1, std::memory_order_acquire) > 0) {
+        return true;
+    }
+    if (timeoutUs != 0 && kernelWait(timeoutUs)) {
+        return true;
+    }
+
+    // Timed out: withdraw as a waiter, unless a post() already counted us and signalled
+    while (true) {
+        int count = mCount.load(std::memory_order_acquire);
+        if (count >= 0 && kernelTryWait()) {
+            return true;
+        }
+        if (count < 0 && mCount.compare_exchange_strong(count, count + 1, std::memory_order_relaxed)) {
+            return false;
+        }
+    }
+}
+
+bool LightweightSemaphore::kernelWait(int64_t timeoutUs)
+{
+#ifdef _WIN32
+    const DWORD milliseconds = timeoutUs < 0 ? INFINITE : static_cast<DWORD>((timeoutUs + 999) / 1000);
+    return WaitForSingleObject(mSemaphore, milliseconds) == WAIT_OBJECT_0;
+#elif defined(__APPLE__)
+    if (timeoutUs < 0) {
+        while (semaphore_wait(mSemaphore) == KERN_ABORTED) {
+        }
+        return true;
+    }
+    mach_timespec_t timeout;
+    timeout.tv_sec = static_cast<unsigned int>(timeoutUs / 1000000);
+    timeout.tv_nsec = static_cast<clock_res_t>((timeoutUs % 1000000) * 1000);
+    return semaphore_timedwait(mSemaphore, timeout) == KERN_SUCCESS;
+#else
+    if (timeoutUs < 0) {
+        while (sem_wait(&mSemaphore) != 0 && errno == EINTR) {
+        }
+        return true;
+    }
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += static_cast<time_t>(timeoutUs / 1000000);
+    deadline.tv_nsec += static_cast<long>((timeoutUs % 1000000) * 1000);
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_nsec -= 1000000000L;
+        ++deadline.tv_sec;
+    }
+    int result;
+    while ((result = sem_timedwait(&mSemaphore, &deadline)) != 0 && errno == EINTR) {
+    }
+    return result == 0;
+#endif
+}
+
+bool LightweightSemaphore::kernelTryWait()
+{
+#ifdef _WIN32
+    return WaitForSingleObject(mSemaphore, 0) == WAIT_OBJECT_0;
+#elif defined(__APPLE__)
+    mach_timespec_t zero = { 0, 0 };
+    return semaphore_timedwait(mSemaphore, zero) == KERN_SUCCESS;
+#else
+    return sem_trywait(&mSemaphore) == 0;
+#endif
+}
+
+void LightweightSemaphore::kernelSignal(int count)
+{
+#ifdef _WIN32
+    ReleaseSemaphore(mSemaphore, count, nullptr);
+#elif defined(__APPLE__)
+    while (count-- > 0) {
+        semaphore_signal(mSemaphore);
+    }
+#else
+    while (count-- > 0) {
+        sem_post(&mSemaphore);
+    }
+#endif
+}
+
+} // namespace KhDetector
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#ifdef _WIN32
+    // HANDLE is kept as void* so <windows.h> stays out of this header
+#elif defined(__APPLE__)
+    #include <mach/semaphore.h>
+#else
+    #include <semaphore.h>
+#endif
+
+namespace KhDetector {
+
+/**
+ * @brief Counting semaphore whose post() is wait-free while nobody is blocked
+ *
+ * The count lives in an atomic; it goes negative by the number of threads
+ * blocked in wait(), and only then does post() make one kernel call (futex
+ * on Linux through sem_post, a Mach semaphore on macOS, a Win32 semaphore on
+ * Windows) to wake them. That makes post() cheap enough for the audio
+ * thread: no lock, no allocation, and usually no system call at all.
+ * wait() spins briefly before it sleeps in the kernel.
+ */
+class LightweightSemaphore
+{
+public:
+    explicit LightweightSemaphore(int initialCount = 0);
+    ~LightweightSemaphore();
+
+    LightweightSemaphore(const LightweightSemaphore&) = delete;
+    LightweightSemaphore& operator=(const LightweightSemaphore&) = delete;
+
+    /**
+     * @brief Add count to the semaphore, waking as many blocked waiters
+     */
+    void post(int count = 1) noexcept;
+
+    /**
+     * @brief Take one count without blocking
+     */
+    bool tryWait() noexcept;
+
+    /**
+     * @brief Block until a count is available
+     */
+    void wait();
+
+    /**
+     * @brief Block until a count is available or the timeout expires
+     *
+     * @return false on timeout
+     */
+    bool waitFor(std::chrono::microseconds timeout);
+
+    /**
+     * @brief Counts available right now (negative: threads blocked)
+     */
+    int getCount() const noexcept { return mCount.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr int kSpinCount = 1000;
+
+    bool waitWithTimeout(int64_t timeoutUs);
+
+    // Kernel semaphore, used only when a waiter has to sleep
+    bool kernelWait(int64_t timeoutUs);
+    bool kernelTryWait();
+    void kernelSignal(int count);
+
+    std::atomic<int> mCount;
+
+#ifdef _WIN32
+    void* mSemaphore = nullptr;
+#elif defined(__APPLE__)
+    semaphore_t mSemaphore;
+#else
+    sem_t mSemaphore;
+#endif
+};
+
+} // namespace KhDetector
@@ -0,0 +1,266 @@
+#include "MlpModel.h"
+#include "DspKernels.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace KhDetector {
+
+namespace {
+
+constexpr size_t kHeaderSize = 16;
+constexpr size_t kLayerHeaderSize = 16;
+
+constexpr uint32_t kActivationRelu = 1;
+constexpr uint32_t kActivationGru = 2;
+
+uint32_t readUint32(const unsigned char* data)
+{
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8)
+         | (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+} // namespace
+
+bool MlpModel::load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "MlpModel: Cannot open " << path << std::endl;
+        return false;
+    }
+
+    const std::vector<char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!loadFromMemory(contents.data(), contents.size())) {
+        std::cerr << "MlpModel: " << path << " is not a valid model file" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const MlpWeights> MlpWeights::fromMemory(const void* data, size_t size)
+{
+    std::shared_ptr<MlpWeights> weights(new MlpWeights());
+    const float* parameters = weights->parse(data, size);
+    if (!parameters) {
+        return nullptr;
+    }
+
+    weights->mOwnedParameters.resize(weights->mNumParameters);
+    std::memcpy(weights->mOwnedParameters.data(), parameters, weights->getParameterBytes());
+    weights->mParameters = weights->mOwnedParameters.data();
+    return weights;
+}
+
+std::shared_ptr<const MlpWeights> MlpWeights::fromBuffer(std::shared_ptr<const void> keepAlive,
+                                                         const void* data, size_t size)
+{
+    std::shared_ptr<MlpWeights> weights(new MlpWeights());
+    weights->mParameters = weights->parse(data, size);
+    if (!weights->mParameters || reinterpret_cast<uintptr_t>(weights->mParameters) % alignof(float) != 0) {
+        return nullptr;
+    }
+    weights->mKeepAlive = std::move(keepAlive);
+    return weights;
+}
+
+const float* MlpWeights::parse(const void* data, size_t size)
+{
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    if (!bytes || size < kHeaderSize || std::memcmp(bytes, "KHML", 4) != 0 || readUint32(bytes + 4) != MlpModel::kVersion) {
+        return nullptr;
+    }
+
+    const uint32_t numLayers = readUint32(bytes + 8);
+    if (numLayers == 0 || numLayers > MlpModel::kMaxLayers || size < kHeaderSize + numLayers * kLayerHeaderSize) {
+        return nullptr;
+    }
+
+    std::vector<Layer> layers(numLayers);
+    size_t numParameters = 0;
+    int maxOutputs = 0;
+    int maxGateOutputs = 0;
+    int stateSize = 0;
+    for (uint32_t l = 0; l < numLayers; ++l) {
+        const unsigned char* header = bytes + kHeaderSize + l * kLayerHeaderSize;
+        const uint32_t numInputs = readUint32(header);
+        const uint32_t numOutputs = readUint32(header + 4);
+        const uint32_t activation = readUint32(header + 8);
+
+        // Layers must chain, and sizes stay small enough for int arithmetic
+        if (numInputs == 0 || numOutputs == 0 || numInputs > 65536 || numOutputs > 65536
+            || activation > kActivationGru
+            || (l > 0 && static_cast<int>(numInputs) != layers[l - 1].numOutputs)) {
+            return nullptr;
+        }
+
+        Layer& layer = layers[l];
+        layer.numInputs = static_cast<int>(numInputs);
+        layer.numOutputs = static_cast<int>(numOutputs);
+        layer.paddedOutputs = (layer.numOutputs + 7) / 8 * 8;
+        layer.offset = numParameters;
+        if (activation == kActivationGru) {
+            layer.type = LayerType::Gru;
+            layer.gateOutputs = (3 * layer.numOutputs + 7) / 8 * 8;
+            layer.stateOffset = stateSize;
+            numParameters += static_cast<size_t>(layer.gateOutputs) * (2 + layer.numInputs + layer.numOutputs);
+            stateSize += layer.numOutputs;
+            maxGateOutputs = std::max(maxGateOutputs, layer.gateOutputs);
+        } else {
+            layer.type = activation == kActivationRelu ? LayerType::DenseRelu : LayerType::Dense;
+            numParameters += static_cast<size_t>(layer.paddedOutputs) * (1 + layer.numInputs);
+        }
+        maxOutputs = std::max(maxOutputs, layer.paddedOutputs);
+    }
+
+    const size_t payloadOffset = kHeaderSize + numLayers * kLayerHeaderSize;
+    if (size != payloadOffset + numParameters * sizeof(float)) {
+        return nullptr;
+    }
+
+    mLayers = std::move(layers);
+    mNumParameters = numParameters;
+    mMaxOutputs = maxOutputs;
+    mMaxGateOutputs = maxGateOutputs;
+    mStateSize = stateSize;
+    return reinterpret_cast<const float*>(bytes + payloadOffset);
+}
+
+bool MlpModel::loadFromMemory(const void* data, size_t size)
+{
+    return setWeights(MlpWeights::fromMemory(data, size));
+}
+
+bool MlpModel::setWeights(std::shared_ptr<const MlpWeights> weights)
+{
+    if (!weights) {
+        return false;
+    }
+
+    mWeights = std::move(weights);
+    mActivationStride = mWeights->mMaxOutputs;
+    for (auto& activations : mActivations) {
+        activations.assign(mActivationStride, 0.0f);
+    }
+    mInputGates.assign(mWeights->mMaxGateOutputs, 0.0f);
+    mHiddenGates.assign(mWeights->mMaxGateOutputs, 0.0f);
+    mStateSize = mWeights->mStateSize;
+    setNumStreams(1);
+    return true;
+}
+
+void MlpModel::run(const float* input, float* output)
+{
+    runBatch(input, 1, output);
+}
+
+void MlpModel::runBatch(const float* input, int numFrames, float* output)
+{
+    runFrames(input, numFrames, output, 0);
+}
+
+void MlpModel::runStreams(const float* input, int numStreams, float* output)
+{
+    runFrames(input, std::min(numStreams, mNumStreams), output, 1);
+}
+
+void MlpModel::setNumStreams(int numStreams)
+{
+    mNumStreams = std::max(1, numStreams);
+    mState.assign(static_cast<size_t>(mNumStreams) * mStateSize, 0.0f);
+}
+
+void MlpModel::resetState()
+{
+    std::fill(mState.begin(), mState.end(), 0.0f);
+}
+
+void MlpModel::resetState(int stream)
+{
+    if (stream >= 0 && stream < mNumStreams) {
+        std::fill_n(mState.begin() + static_cast<size_t>(stream) * mStateSize, mStateSize, 0.0f);
+    }
+}
+
+void MlpModel::saveState(int stream, float* state) const
+{
+    if (stream >= 0 && stream < mNumStreams && state) {
+        std::copy_n(mState.begin() + static_cast<size_t>(stream) * mStateSize, mStateSize, state);
+    }
+}
+
+void MlpModel::restoreState(int stream, const float* state)
+{
+    if (stream >= 0 && stream < mNumStreams && state) {
+        std::copy_n(state, mStateSize, mState.begin() + static_cast<size_t>(stream) * mStateSize);
+    }
+}
+
+void MlpModel::runFrames(const float* input, int numFrames, float* output, int streamStep)
+{
+    if (!mWeights || numFrames <= 0) {
+        return;
+    }
+
+    const size_t batchSize = static_cast<size_t>(numFrames) * mActivationStride;
+    if (mActivations[0].size() < batchSize) {
+        for (auto& activations : mActivations) {
+            activations.resize(batchSize);
+        }
+    }
+
+    const DspKernels& kernels = getDspKernels();
+    const std::vector<Layer>& layers = mWeights->mLayers;
+    const float* layerInput = input;
+    size_t inputStride = layers.front().numInputs;
+
+    for (size_t l = 0; l < layers.size(); ++l) {
+        const Layer& layer = layers[l];
+        const float* bias = mWeights->mParameters + layer.offset;
+        float* layerOutput = mActivations[l % 2].data();
+        for (int frame = 0; frame < numFrames; ++frame) {
+            const float* frameInput = layerInput + frame * inputStride;
+            float* frameOutput = layerOutput + frame * static_cast<size_t>(mActivationStride);
+            if (layer.type == LayerType::Gru) {
+                // Frames of one stream go through in order, each from the state the previous one left
+                float* hidden = mState.data() + static_cast<size_t>(frame * streamStep) * mStateSize + layer.stateOffset;
+                runGru(layer, frameInput, hidden, frameOutput);
+            } else {
+                kernels.denseLayer(bias + layer.paddedOutputs, bias, frameInput, layer.numInputs, frameOutput,
+                                   layer.paddedOutputs, layer.type == LayerType::DenseRelu);
+            }
+        }
+        layerInput = layerOutput;
+        inputStride = mActivationStride;
+    }
+
+    const int numOutputs = layers.back().numOutputs;
+    for (int frame = 0; frame < numFrames; ++frame) {
+        const float* frameOutput = layerInput + frame * inputStride;
+        std::copy(frameOutput, frameOutput + numOutputs, output + frame * numOutputs);
+    }
+}
+
+void MlpModel::runGru(const Layer& layer, const float* input, float* hidden, float* output)
+{
+    const DspKernels& kernels = getDspKernels();
+    const int gates = layer.gateOutputs;
+    const float* inputBias = mWeights->mParameters + layer.offset;
+    const float* inputWeights = inputBias + gates;
+    const float* hiddenBias = inputWeights + static_cast<size_t>(gates) * layer.numInputs;
+    const float* hiddenWeights = hiddenBias + gates;
+
+    kernels.denseLayer(inputWeights, inputBias, input, layer.numInputs, mInputGates.data(), gates, false);
+    kernels.denseLayer(hiddenWeights, hiddenBias, hidden, layer.numOutputs, mHiddenGates.data(), gates, false);
+
+    const int size = layer.numOutputs;
+    kernels.gruUpdate(mInputGates.data(), mHiddenGates.data(), hidden, size);
+
+    std::copy(hidden, hidden + size, output);
+    std::fill(output + size, output + layer.paddedOutputs, 0.0f);
+}
+
+} // namespace KhDetector
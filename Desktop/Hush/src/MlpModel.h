@@ -0,0 +1,255 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace KhDetector {
+
+/**
+ * @brief Read-only parameters of a .khmlp model, shareable between models
+ *
+ * The file stores its weights in the packed order DspKernels::denseLayer()
+ * reads, so the parameters can be used in place: fromBuffer() keeps a view
+ * into a buffer (a memory-mapped file, say) owned by keepAlive, and
+ * fromMemory() copies. Either way the weights never change after creation,
+ * so any number of MlpModels, on any threads, can run from one instance
+ * while each keeps its own activations and recurrent state.
+ */
+class MlpWeights
+{
+public:
+    /**
+     * @brief Parse a buffer holding the file contents and copy its parameters
+     *
+     * @return nullptr if the contents are malformed
+     */
+    static std::shared_ptr<const MlpWeights> fromMemory(const void* data, size_t size);
+
+    /**
+     * @brief Parse a buffer and use its parameters in place
+     *
+     * @param keepAlive Owner of the buffer; held as long as the weights are
+     * @return nullptr if the contents are malformed or data is not 4-byte aligned
+     */
+    static std::shared_ptr<const MlpWeights> fromBuffer(std::shared_ptr<const void> keepAlive,
+                                                        const void* data, size_t size);
+
+    int getInputSize() const { return mLayers.front().numInputs; }
+    int getOutputSize() const { return mLayers.back().numOutputs; }
+    int getNumLayers() const { return static_cast<int>(mLayers.size()); }
+
+    /**
+     * @brief Bytes of parameters
+     */
+    size_t getParameterBytes() const { return mNumParameters * sizeof(float); }
+
+    /**
+     * @brief Whether the parameters live in a caller's buffer (fromBuffer()) rather than a copy
+     */
+    bool isBorrowed() const { return mOwnedParameters.empty(); }
+
+private:
+    friend class MlpModel;
+
+    enum class LayerType
+    {
+        Dense,
+        DenseRelu,
+        Gru
+    };
+
+    struct Layer
+    {
+        int numInputs = 0;
+        int numOutputs = 0;
+        int paddedOutputs = 0;
+        int gateOutputs = 0;    // GRU: 3 numOutputs rounded up to a multiple of 8
+        LayerType type = LayerType::Dense;
+        size_t offset = 0;      // Bias position in the parameters; the weights follow
+        int stateOffset = 0;    // GRU: hidden state position within a stream's state
+    };
+
+    MlpWeights() = default;
+
+    /**
+     * @brief Read the layer table; returns the parameter payload or nullptr if malformed
+     */
+    const float* parse(const void* data, size_t size);
+
+    std::vector<Layer> mLayers;
+    const float* mParameters = nullptr;
+    size_t mNumParameters = 0;
+    std::vector<float> mOwnedParameters;
+    std::shared_ptr<const void> mKeepAlive;
+    int mMaxOutputs = 0;
+    int mMaxGateOutputs = 0;
+    int mStateSize = 0;
+};
+
+/**
+ * @brief Native evaluator for small fully connected and recurrent models
+ *
+ * Runs a stack of dense layers (bias and optional ReLU fused) with
+ * DspKernels::denseLayer(), with no inference runtime involved. The weights
+ * come from training/export_native_model.py, which folds the inference-time
+ * batch norms of LightweightHetDetector into the following layer and writes
+ * them in the packed order the kernel reads.
+ *
+ * A layer can also be a GRU (PyTorch's nn.GRU cell), which makes the model
+ * stateful: each call then consumes one hop of a stream and the hidden
+ * state carries the history, so short hops do not re-run overlapping
+ * windows. State is kept per stream (setNumStreams()), can be reset, and
+ * can be saved and restored.
+ *
+ * File layout (little-endian):
+ *
+ *     char     magic[4]      "KHML"
+ *     uint32   version       1
+ *     uint32   numLayers
+ *     uint32   reserved      0
+ *     numLayers x { uint32 numInputs, uint32 numOutputs, uint32 activation (0 none, 1 ReLU, 2 GRU), uint32 reserved }
+ *     numLayers x { float bias[P], float weights[P * numInputs] }                 (dense)
+ *               | { float bias[G], float weights[G * numInputs],
+ *                   float hiddenBias[G], float hiddenWeights[G * numOutputs] }    (GRU)
+ *
+ * where P is numOutputs rounded up to a multiple of 8 (padding is zero) and
+ * weight (o, i) is stored at ((o / 8) * numInputs + i) * 8 + o % 8. A GRU
+ * with numOutputs = H hidden units packs its input and hidden projections
+ * the same way as dense layers of 3 H outputs (G is 3 H rounded up to 8),
+ * gates in PyTorch's order: reset, update, new.
+ *
+ * The parameters are held as shared MlpWeights (setWeights()), so models
+ * built from one file can share a single copy, or a single memory-mapped
+ * view (ModelRegistry); activations and state belong to each model.
+ *
+ * run() only touches buffers sized at load time, so it never allocates.
+ */
+class MlpModel
+{
+public:
+    static constexpr uint32_t kVersion = 1;
+    static constexpr int kMaxLayers = 16;
+
+    /**
+     * @brief Load a model file
+     *
+     * @return false (and keeps any previous model) if the file is missing or malformed
+     */
+    bool load(const std::string& path);
+
+    /**
+     * @brief Load a model from a buffer holding the file contents
+     */
+    bool loadFromMemory(const void* data, size_t size);
+
+    /**
+     * @brief Run from weights shared with other models; sizes this model's own buffers
+     *
+     * @return false (and keeps any previous model) for nullptr
+     */
+    bool setWeights(std::shared_ptr<const MlpWeights> weights);
+    const std::shared_ptr<const MlpWeights>& getWeights() const { return mWeights; }
+
+    bool isLoaded() const { return mWeights != nullptr; }
+
+    int getInputSize() const { return isLoaded() ? mWeights->getInputSize() : 0; }
+    int getOutputSize() const { return isLoaded() ? mWeights->getOutputSize() : 0; }
+    int getNumLayers() const { return isLoaded() ? mWeights->getNumLayers() : 0; }
+
+    /**
+     * @brief Evaluate the model on one frame
+     *
+     * @param input getInputSize() floats
+     * @param output getOutputSize() floats
+     */
+    void run(const float* input, float* output);
+
+    /**
+     * @brief Evaluate the model on a batch of frames
+     *
+     * Runs the batch one layer at a time, so each layer's weights are read
+     * from cache for every frame of the batch instead of once per frame.
+     * For a stateful model the frames are consecutive hops of stream 0.
+     * Allocates only when numFrames is larger than any earlier batch.
+     *
+     * @param input numFrames x getInputSize() floats, frame by frame
+     * @param output numFrames x getOutputSize() floats, frame by frame
+     */
+    void runBatch(const float* input, int numFrames, float* output);
+
+    /**
+     * @brief Advance several streams by one hop each
+     *
+     * Frame s of the batch is the next hop of stream s, evaluated with and
+     * updating that stream's state, one layer at a time for all streams.
+     * Allocates only when numStreams is larger than any earlier batch.
+     *
+     * @param input numStreams x getInputSize() floats
+     * @param numStreams At most getNumStreams()
+     * @param output numStreams x getOutputSize() floats
+     */
+    void runStreams(const float* input, int numStreams, float* output);
+
+    /**
+     * @brief Whether the model has recurrent state
+     */
+    bool isStateful() const { return mStateSize > 0; }
+
+    /**
+     * @brief Floats of state per stream (0 for a stateless model)
+     */
+    int getStateSize() const { return mStateSize; }
+
+    /**
+     * @brief Number of streams with their own state (1 after load)
+     *
+     * Resizes the state storage and resets every stream; allocates.
+     */
+    void setNumStreams(int numStreams);
+    int getNumStreams() const { return mNumStreams; }
+
+    /**
+     * @brief Clear the state of every stream, or of one stream
+     */
+    void resetState();
+    void resetState(int stream);
+
+    /**
+     * @brief Copy a stream's state to or from getStateSize() floats
+     *
+     * A snapshot can be restored into any stream of a model loaded from the
+     * same file.
+     */
+    void saveState(int stream, float* state) const;
+    void restoreState(int stream, const float* state);
+
+private:
+    using Layer = MlpWeights::Layer;
+    using LayerType = MlpWeights::LayerType;
+
+    /**
+     * @brief Evaluate frames layer by layer; frame f uses the state of stream f * streamStep
+     */
+    void runFrames(const float* input, int numFrames, float* output, int streamStep);
+
+    /**
+     * @brief One GRU step: update hidden from input and write it to output
+     */
+    void runGru(const Layer& layer, const float* input, float* hidden, float* output);
+
+    std::shared_ptr<const MlpWeights> mWeights;
+    std::vector<float> mActivations[2];     // Ping-pong between layers, frame by frame
+    int mActivationStride = 0;              // Floats per frame in mActivations
+
+    // Recurrent state, mStateSize floats per stream
+    std::vector<float> mState;
+    int mStateSize = 0;
+    int mNumStreams = 1;
+    std::vector<float> mInputGates;         // GRU scratch, one step
+    std::vector<float> mHiddenGates;
+};
+
+} // namespace KhDetector
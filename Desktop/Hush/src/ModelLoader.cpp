@@ -0,0 +1,152 @@
+#include "ModelLoader.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace KhDetector {
+
+bool ModelHandle::wait(std::chrono::milliseconds timeout) const
+{
+    std::unique_lock<std::mutex> lock(mWaitMutex);
+    const auto finished = [this] { return getState() != State::Loading; };
+    if (timeout == std::chrono::milliseconds::max()) {
+        mWaitCondition.wait(lock, finished);
+    } else {
+        mWaitCondition.wait_for(lock, timeout, finished);
+    }
+    return isReady();
+}
+
+void ModelHandle::publish(std::unique_ptr<AiInference> engine)
+{
+    {
+        std::lock_guard<std::mutex> lock(mWaitMutex);
+        mOwnedEngine = std::move(engine);
+        const State state = mOwnedEngine->hasModel() ? State::Ready : State::Heuristic;
+        mEngine.store(mOwnedEngine.get(), std::memory_order_release);
+        mState.store(state, std::memory_order_release);
+    }
+    mWaitCondition.notify_all();
+}
+
+void ModelHandle::fail()
+{
+    {
+        std::lock_guard<std::mutex> lock(mWaitMutex);
+        mState.store(State::Failed, std::memory_order_release);
+    }
+    mWaitCondition.notify_all();
+}
+
+ModelLoader::ModelLoader(int numThreads, int warmupRuns)
+    : mWarmupRuns(std::max(0, warmupRuns))
+{
+    for (int i = 0; i < std::max(1, numThreads); ++i) {
+        mThreads.emplace_back(&ModelLoader::loaderThreadMain, this);
+    }
+}
+
+ModelLoader::~ModelLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mShouldStop = true;
+        for (auto& request : mQueue) {
+            request.handle->fail();
+        }
+        mQueue.clear();
+    }
+    mCondition.notify_all();
+
+    for (auto& thread : mThreads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+std::shared_ptr<ModelHandle> ModelLoader::load(const AiInference::ModelConfig& config, PrepareFunction prepare)
+{
+    auto handle = std::make_shared<ModelHandle>();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mShouldStop) {
+            handle->fail();
+            return handle;
+        }
+        mQueue.push_back({ handle, config, std::move(prepare) });
+    }
+    mCondition.notify_one();
+    return handle;
+}
+
+size_t ModelLoader::getPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mQueue.size() + mActive;
+}
+
+ModelLoader& ModelLoader::getShared()
+{
+    static ModelLoader loader;
+    return loader;
+}
+
+void ModelLoader::loaderThreadMain()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        mCondition.wait(lock, [this] { return mShouldStop || !mQueue.empty(); });
+        if (mShouldStop) {
+            return;
+        }
+
+        Request request = std::move(mQueue.front());
+        mQueue.pop_front();
+        ++mActive;
+
+        lock.unlock();
+        runRequest(request);
+        request = Request();
+        lock.lock();
+
+        --mActive;
+    }
+}
+
+void ModelLoader::runRequest(Request& request)
+{
+    // The instance that asked for this engine is gone
+    if (request.handle.use_count() == 1) {
+        request.handle->fail();
+        return;
+    }
+
+    std::unique_ptr<AiInference> engine = createAiInference(request.config);
+    if (!engine) {
+        std::cerr << "ModelLoader: Could not load model "
+                  << (request.config.modelPath.empty() ? "(none)" : request.config.modelPath) << std::endl;
+        request.handle->fail();
+        return;
+    }
+
+    // Page in weights and working buffers, then start the stream afresh
+    if (mWarmupRuns > 0) {
+        engine->warmup(mWarmupRuns);
+    }
+    engine->resetState();
+    engine->resetStatistics();
+    if (engine->getPostProcessor()) {
+        engine->getPostProcessor()->reset();
+    }
+
+    if (request.prepare) {
+        request.prepare(*engine);
+    }
+    if (!engine->hasModel()) {
+        std::cerr << "ModelLoader: No model file, publishing the heuristic engine" << std::endl;
+    }
+    request.handle->publish(std::move(engine));
+}
+
+} // namespace KhDetector
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "AiInference.h"
+
+namespace KhDetector {
+
+/**
+ * @brief An inference engine that becomes available once a background load finishes
+ *
+ * get() is a single acquire load, safe on the audio thread: it returns
+ * nullptr while the model is loading (or failed to load) and the fully
+ * initialized, warmed-up engine once the loader has published it. The
+ * engine is published once and lives as long as the handle.
+ *
+ * An engine configured without a model file is still published, so
+ * callers keep scoring frames with its heuristic, but in the Heuristic
+ * state: isReady() only reports engines that run a trained model.
+ */
+class ModelHandle
+{
+public:
+    enum class State
+    {
+        Loading,
+        Ready,      // Published, running a trained model
+        Heuristic,  // Published without a model; scores frames with ActivityGate::fricativeConfidence()
+        Failed
+    };
+
+    ModelHandle() = default;
+    ModelHandle(const ModelHandle&) = delete;
+    ModelHandle& operator=(const ModelHandle&) = delete;
+
+    /**
+     * @brief The published engine (Ready or Heuristic), or nullptr until then
+     */
+    AiInference* get() const noexcept { return mEngine.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Whether the published engine runs a trained model
+     */
+    bool isReady() const noexcept { return getState() == State::Ready; }
+
+    State getState() const noexcept { return mState.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Block until the load has finished or failed (never on the audio thread)
+     *
+     * @return true if an engine with a trained model is ready
+     */
+    bool wait(std::chrono::milliseconds timeout = std::chrono::milliseconds::max()) const;
+
+private:
+    friend class ModelLoader;
+
+    void publish(std::unique_ptr<AiInference> engine);
+    void fail();
+
+    std::unique_ptr<AiInference> mOwnedEngine;
+    std::atomic<AiInference*> mEngine{nullptr};
+    std::atomic<State> mState{State::Loading};
+
+    mutable std::mutex mWaitMutex;
+    mutable std::condition_variable mWaitCondition;
+};
+
+/**
+ * @brief Background loader that builds, warms up and publishes inference engines
+ *
+ * Loading a model (file read, initialization, warmup) takes tens of
+ * milliseconds per engine, too long for a plugin constructor when a project
+ * opens dozens of instances. load() only queues the work and returns a
+ * handle; a loader thread creates the engine, runs warmup frames through it
+ * so its weights and working buffers are paged in before the audio path
+ * touches them, resets its stream state and statistics, and then publishes
+ * it with an atomic store. Requests whose handle nobody holds any more by
+ * the time they are reached are skipped.
+ */
+class ModelLoader
+{
+public:
+    /**
+     * @brief Called on the loader thread before the engine is published, e.g. to attach a latency monitor
+     */
+    using PrepareFunction = std::function<void(AiInference& engine)>;
+
+    /**
+     * @param numThreads Loads run in parallel on this many threads (at least 1)
+     * @param warmupRuns Frames run through every engine before it is published
+     */
+    explicit ModelLoader(int numThreads = 1, int warmupRuns = 5);
+
+    /**
+     * @brief Stop the loader threads; queued loads never finish
+     */
+    ~ModelLoader();
+
+    ModelLoader(const ModelLoader&) = delete;
+    ModelLoader& operator=(const ModelLoader&) = delete;
+
+    /**
+     * @brief Queue an engine load and return immediately
+     */
+    std::shared_ptr<ModelHandle> load(const AiInference::ModelConfig& config, PrepareFunction prepare = nullptr);
+
+    /**
+     * @brief Loads queued or in progress
+     */
+    size_t getPendingCount() const;
+
+    /**
+     * @brief Process-wide loader shared by all plugin instances
+     */
+    static ModelLoader& getShared();
+
+private:
+    struct Request
+    {
+        std::shared_ptr<ModelHandle> handle;
+        AiInference::ModelConfig config;
+        PrepareFunction prepare;
+    };
+
+    void loaderThreadMain();
+    void runRequest(Request& request);
+
+    int mWarmupRuns;
+    std::vector<std::thread> mThreads;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<Request> mQueue;
+    size_t mActive = 0;
+    bool mShouldStop = false;
+};
+
+} // namespace KhDetector
@@ -0,0 +1,222 @@
+#include "ModelRegistry.h"
+
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace KhDetector {
+
+namespace {
+
+/**
+ * @brief Read-only mapping of a whole file, unmapped on destruction
+ */
+class MappedFile
+{
+public:
+    static std::shared_ptr<MappedFile> open(const std::string& path)
+    {
+        std::shared_ptr<MappedFile> file(new MappedFile());
+#ifdef _WIN32
+        HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                    FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) {
+            return nullptr;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+            CloseHandle(handle);
+            return nullptr;
+        }
+        HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(handle);
+        if (!mapping) {
+            return nullptr;
+        }
+        file->mData = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        file->mSize = static_cast<size_t>(size.QuadPart);
+#else
+        const int descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0) {
+            return nullptr;
+        }
+        struct stat info;
+        if (fstat(descriptor, &info) != 0 || info.st_size <= 0) {
+            ::close(descriptor);
+            return nullptr;
+        }
+        void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        ::close(descriptor);
+        file->mData = data == MAP_FAILED ? nullptr : data;
+        file->mSize = static_cast<size_t>(info.st_size);
+#endif
+        return file->mData ? file : nullptr;
+    }
+
+    ~MappedFile()
+    {
+        if (!mData) {
+            return;
+        }
+#ifdef _WIN32
+        UnmapViewOfFile(mData);
+#else
+        munmap(mData, mSize);
+#endif
+    }
+
+    const void* getData() const { return mData; }
+    size_t getSize() const { return mSize; }
+
+private:
+    MappedFile() = default;
+
+    void* mData = nullptr;
+    size_t mSize = 0;
+};
+
+} // namespace
+
+std::shared_ptr<const MlpWeights> ModelRegistry::acquire(const std::string& path)
+{
+    FileStamp stamp;
+    if (!readFileStamp(path, stamp)) {
+        std::cerr << "ModelRegistry: Cannot open " << path << std::endl;
+        return nullptr;
+    }
+
+    // Unchanged since it was last hashed: no need to read it again
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto known = mKnownFiles.find(path);
+        if (known != mKnownFiles.end() && known->second.stamp == stamp) {
+            if (auto weights = findLive(Key(path, known->second.hash))) {
+                return weights;
+            }
+        }
+    }
+
+    std::shared_ptr<MappedFile> file = MappedFile::open(path);
+    if (!file) {
+        std::cerr << "ModelRegistry: Cannot map " << path << std::endl;
+        return nullptr;
+    }
+    const Key key(path, hashContents(file->getData(), file->getSize()));
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mKnownFiles[path] = { stamp, key.second };
+        if (auto weights = findLive(key)) {
+            return weights;
+        }
+    }
+
+    // Parse outside the lock; a concurrent first acquire of the same file may win
+    auto weights = MlpWeights::fromBuffer(file, file->getData(), file->getSize());
+    if (!weights) {
+        std::cerr << "ModelRegistry: " << path << " is not a valid model file" << std::endl;
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    pruneExpired();
+    std::weak_ptr<const MlpWeights>& entry = mModels[key];
+    if (auto existing = entry.lock()) {
+        return existing;
+    }
+    entry = weights;
+    return weights;
+}
+
+size_t ModelRegistry::getNumModels() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    size_t live = 0;
+    for (const auto& model : mModels) {
+        live += model.second.expired() ? 0 : 1;
+    }
+    return live;
+}
+
+uint64_t ModelRegistry::hashContents(const void* data, size_t size)
+{
+    constexpr uint64_t kPrime = 1099511628211ull;
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = 14695981039346656037ull;
+
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * kPrime;
+    }
+    for (; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * kPrime;
+    }
+    return hash;
+}
+
+bool ModelRegistry::readFileStamp(const std::string& path, FileStamp& stamp)
+{
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    BY_HANDLE_FILE_INFORMATION info;
+    const bool found = GetFileInformationByHandle(handle, &info) != 0;
+    CloseHandle(handle);
+    if (!found) {
+        return false;
+    }
+    stamp.size = (static_cast<uint64_t>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+    stamp.modified = (static_cast<uint64_t>(info.ftLastWriteTime.dwHighDateTime) << 32)
+                   | info.ftLastWriteTime.dwLowDateTime;
+    stamp.identity = (static_cast<uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+#else
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+    stamp.size = static_cast<uint64_t>(info.st_size);
+#if defined(__APPLE__)
+    stamp.modified = static_cast<uint64_t>(info.st_mtimespec.tv_sec) * 1000000000ull + info.st_mtimespec.tv_nsec;
+#else
+    stamp.modified = static_cast<uint64_t>(info.st_mtim.tv_sec) * 1000000000ull + info.st_mtim.tv_nsec;
+#endif
+    stamp.identity = static_cast<uint64_t>(info.st_ino);
+#endif
+    return true;
+}
+
+ModelRegistry& ModelRegistry::getShared()
+{
+    static ModelRegistry registry;
+    return registry;
+}
+
+std::shared_ptr<const MlpWeights> ModelRegistry::findLive(const Key& key) const
+{
+    auto found = mModels.find(key);
+    return found != mModels.end() ? found->second.lock() : nullptr;
+}
+
+void ModelRegistry::pruneExpired()
+{
+    for (auto it = mModels.begin(); it != mModels.end();) {
+        it = it->second.expired() ? mModels.erase(it) : std::next(it);
+    }
+}
+
+} // namespace KhDetector
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "MlpModel.h"
+
+namespace KhDetector {
+
+/**
+ * @brief Process-wide, reference-counted cache of memory-mapped model weights
+ *
+ * Every plugin instance in a project runs the same model. Instead of each
+ * reading its own copy, acquire() maps the .khmlp file read-only and hands
+ * out one MlpWeights per file path and content hash; the weights are used
+ * straight from the mapping, since the file already stores them in the
+ * packed order the kernels read. Each instance keeps its own activations
+ * and state in its MlpModel, so only the parameters are shared.
+ *
+ * The mapping lives as long as any model holds the weights. A later
+ * acquire() of the same path costs a stat() while the file's size,
+ * modification time and identity are unchanged; otherwise the file is
+ * mapped and hashed again, and gets new weights only if its contents
+ * changed.
+ * Replace a model by renaming a new file over it (as export_native_model.py
+ * does): rewriting a mapped file in place changes the weights of the
+ * instances already running it. Thread-safe.
+ */
+class ModelRegistry
+{
+public:
+    ModelRegistry() = default;
+    ModelRegistry(const ModelRegistry&) = delete;
+    ModelRegistry& operator=(const ModelRegistry&) = delete;
+
+    /**
+     * @brief Shared weights of a .khmlp file
+     *
+     * @return nullptr if the file is missing or not a valid model
+     */
+    std::shared_ptr<const MlpWeights> acquire(const std::string& path);
+
+    /**
+     * @brief Models currently held by at least one instance
+     */
+    size_t getNumModels() const;
+
+    /**
+     * @brief 64-bit FNV-1a hash of a buffer, eight bytes per step
+     */
+    static uint64_t hashContents(const void* data, size_t size);
+
+    /**
+     * @brief Registry shared by all plugin instances in the process
+     */
+    static ModelRegistry& getShared();
+
+private:
+    /**
+     * @brief Size, modification time and file identity (inode or file index)
+     */
+    struct FileStamp
+    {
+        uint64_t size = 0;
+        uint64_t modified = 0;
+        uint64_t identity = 0;
+
+        bool operator==(const FileStamp& other) const
+        {
+            return size == other.size && modified == other.modified && identity == other.identity;
+        }
+    };
+
+    /**
+     * @return false if the file does not exist
+     */
+    static bool readFileStamp(const std::string& path, FileStamp& stamp);
+
+    using Key = std::pair<std::string, uint64_t>;     // Path, content hash
+
+    struct KnownFile
+    {
+        FileStamp stamp;
+        uint64_t hash = 0;
+    };
+
+    std::shared_ptr<const MlpWeights> findLive(const Key& key) const;
+    void pruneExpired();
+
+    mutable std::mutex mMutex;
+    std::map<Key, std::weak_ptr<const MlpWeights>> mModels;
+    std::map<std::string, KnownFile> mKnownFiles;       // Content hash as of the last stamp seen
+};
+
+} // namespace KhDetector
@@ -0,0 +1,280 @@
+#pragma once
+
+#include "PolyphaseDecimator.h"
+
+#include <array>
+#include <cstring>
+
+namespace KhDetector {
+
+/**
+ * @brief Decimator for up to MaxChannels channels with a weighted downmix
+ *
+ * Runs the same prototype filter as PolyphaseDecimator (FilterDesign.h) two
+ * ways:
+ *
+ * - processToMono() applies the downmix weights first and decimates the mix
+ *   with a single PolyphaseDecimator. Filtering is linear, so this equals
+ *   decimating every channel and mixing afterwards, and N channels cost one
+ *   channel's filter plus N multiply-adds per input sample.
+ * - processChannels() keeps every channel. Input is interleaved into frames
+ *   of kLanes floats and DspKernels::firLanes() filters all channels at once,
+ *   vectorized across channels: each coefficient is broadcast once for 8 or
+ *   16 channels. The downmix of the filtered channels is produced alongside.
+ *
+ * The two paths keep separate filter state, so use one of them per stream.
+ * Output alignment, output counts and group delay match PolyphaseDecimator.
+ * All storage is fixed-size; processing never allocates.
+ *
+ * @tparam MaxChannels Channel capacity; lanes are rounded up to a multiple of 8
+ * @tparam DecimationFactor The integer decimation factor
+ * @tparam FilterLength The total FIR filter length
+ * @tparam Phase Linear (default) or minimum-phase prototype filter
+ */
+template<int MaxChannels = 8, int DecimationFactor = DECIM_FACTOR, int FilterLength = DecimationFactor * 16,
+         FilterPhase Phase = FilterPhase::Linear>
+class MultichannelDecimator
+{
+public:
+    using MonoDecimator = PolyphaseDecimator<DecimationFactor, FilterLength, Phase>;
+
+    static constexpr int kMaxChannels = MaxChannels;
+    static constexpr int kLanes = (MaxChannels + 7) / 8 * 8;
+    static constexpr int kDecimationFactor = DecimationFactor;
+    static constexpr int kFilterLength = FilterLength;
+
+    static_assert(MaxChannels > 0, "Need at least one channel");
+
+    /**
+     * @brief Construct with an equal-weight downmix of numChannels channels
+     */
+    explicit MultichannelDecimator(int numChannels = MaxChannels)
+        : coeffs_(laneCoefficients().data())
+    {
+        setNumChannels(std::max(1, std::min(numChannels, MaxChannels)));
+    }
+
+    /**
+     * @brief Set the number of active channels
+     *
+     * Resets the filter state and the downmix to equal weights of 1 / numChannels
+     * (the average, as in PolyphaseDecimator::processStereoToMono()).
+     *
+     * @return false if numChannels is outside [1, MaxChannels] (nothing changes)
+     */
+    bool setNumChannels(int numChannels)
+    {
+        if (numChannels < 1 || numChannels > MaxChannels) {
+            return false;
+        }
+
+        numChannels_ = numChannels;
+        weights_.fill(0.0f);
+        for (int c = 0; c < numChannels; ++c) {
+            weights_[c] = 1.0f / numChannels;
+        }
+        reset();
+        return true;
+    }
+
+    int getNumChannels() const
+    {
+        return numChannels_;
+    }
+
+    /**
+     * @brief Set the downmix weight of every active channel
+     *
+     * Takes effect from the next processed sample; the filter state is kept.
+     *
+     * @param weights getNumChannels() gains, e.g. {0.7, 0.7, 1.0, 0, 0.5, 0.5} for a 5.1 dialogue mix
+     */
+    void setDownmixWeights(const float* weights)
+    {
+        for (int c = 0; c < numChannels_; ++c) {
+            weights_[c] = weights[c];
+        }
+    }
+
+    float getDownmixWeight(int channel) const
+    {
+        return weights_[channel];
+    }
+
+    /**
+     * @brief Decimate the weighted downmix of all channels
+     *
+     * @param inputs getNumChannels() input channel pointers
+     * @param output Output buffer for decimated mono samples
+     * @param numInputSamples Number of input samples per channel
+     * @return Number of output samples produced
+     */
+    int processToMono(const float* const* inputs, float* output, int numInputSamples)
+    {
+        const DspKernels& kernels = getDspKernels();
+        int outputCount = 0;
+
+        for (int offset = 0; offset < numInputSamples; offset += kBlockFrames) {
+            const int count = std::min(kBlockFrames, numInputSamples - offset);
+
+            float* mix = mixBuffer_.data();
+            std::fill(mix, mix + count, 0.0f);
+            for (int c = 0; c < numChannels_; ++c) {
+                kernels.multiplyAccumulate(inputs[c] + offset, weights_[c], mix, count);
+            }
+
+            outputCount += monoStage_.processMono(mix, output + outputCount, count);
+            advancePhase(count);
+        }
+
+        return outputCount;
+    }
+
+    /**
+     * @brief Decimate every channel, optionally producing the downmix as well
+     *
+     * @param inputs getNumChannels() input channel pointers
+     * @param outputs getNumChannels() output channel pointers, or nullptr for downmix only
+     * @param downmix Output buffer for the weighted downmix, or nullptr
+     * @param numInputSamples Number of input samples per channel
+     * @return Number of output samples produced per channel
+     */
+    int processChannels(const float* const* inputs, float* const* outputs, float* downmix, int numInputSamples)
+    {
+        const DspKernels& kernels = getDspKernels();
+        int outputCount = 0;
+
+        for (int offset = 0; offset < numInputSamples; offset += kBlockFrames) {
+            const int count = std::min(kBlockFrames, numInputSamples - offset);
+
+            // Interleave the block behind the history; unused lanes stay zero
+            float* frames = frames_.data() + kHistory * kLanes;
+            for (int c = 0; c < numChannels_; ++c) {
+                const float* input = inputs[c] + offset;
+                for (int i = 0; i < count; ++i) {
+                    frames[i * kLanes + c] = input[i];
+                }
+            }
+
+            // Outputs fall on block frames phase_, phase_ + D, ...; the window
+            // of the one at block frame j starts j frames into frames_
+            const int numOutputs = count > phase_ ? (count - 1 - phase_) / DecimationFactor + 1 : 0;
+            kernels.firLanes(coeffs_, FilterLength, frames_.data() + phase_ * kLanes, kLanes, DecimationFactor,
+                             laneOutput_.data(), numOutputs);
+
+            if (outputs) {
+                for (int c = 0; c < numChannels_; ++c) {
+                    float* output = outputs[c] + outputCount;
+                    for (int k = 0; k < numOutputs; ++k) {
+                        output[k] = laneOutput_[k * kLanes + c];
+                    }
+                }
+            }
+            if (downmix) {
+                for (int k = 0; k < numOutputs; ++k) {
+                    const float* lanes = laneOutput_.data() + k * kLanes;
+                    float sum = 0.0f;
+                    for (int c = 0; c < numChannels_; ++c) {
+                        sum += weights_[c] * lanes[c];
+                    }
+                    downmix[outputCount + k] = sum;
+                }
+            }
+
+            std::memmove(frames_.data(), frames_.data() + count * kLanes, kHistory * kLanes * sizeof(float));
+            outputCount += numOutputs;
+            advancePhase(count);
+        }
+
+        return outputCount;
+    }
+
+    /**
+     * @brief Reset the filter state of both paths
+     */
+    void reset()
+    {
+        frames_.fill(0.0f);
+        monoStage_.reset();
+        phase_ = 0;
+    }
+
+    /**
+     * @brief Number of output samples the next call will produce
+     *
+     * @param numInputSamples Number of input samples per channel in the next block
+     */
+    int getOutputCount(int numInputSamples) const
+    {
+        if (numInputSamples <= phase_) {
+            return 0;
+        }
+        return (numInputSamples - phase_ - 1) / DecimationFactor + 1;
+    }
+
+    /**
+     * @brief Group delay in output samples (same filter as PolyphaseDecimator)
+     */
+    double getGroupDelay() const
+    {
+        return monoStage_.getGroupDelay();
+    }
+
+private:
+    static constexpr int kBlockFrames = 128 * DecimationFactor;
+    static constexpr int kHistory = FilterLength - 1;
+
+    // Interleaved frames: kHistory frames of history followed by one block
+    alignas(64) std::array<float, (kHistory + kBlockFrames) * kLanes> frames_;
+    alignas(64) std::array<float, (kBlockFrames / DecimationFactor) * kLanes> laneOutput_;
+    alignas(64) std::array<float, kBlockFrames> mixBuffer_;
+
+    std::array<float, MaxChannels> weights_{};
+    const float* coeffs_;   // Prototype taps, oldest sample first
+
+    MonoDecimator monoStage_;
+    int numChannels_ = 0;
+    int phase_ = 0;         // Input samples before the next output-aligned sample
+
+    void advancePhase(int count)
+    {
+        phase_ = ((phase_ - count) % DecimationFactor + DecimationFactor) % DecimationFactor;
+    }
+
+    /**
+     * @brief Prototype taps in window order, shared by every instance
+     *
+     * Built from the same design as PolyphaseDecimator; like its table the
+     * linear-phase version is a compile-time constant and the minimum-phase
+     * one is built on first use.
+     */
+    static const std::array<float, FilterLength>& laneCoefficients()
+    {
+        if constexpr (Phase == FilterPhase::Linear) {
+            alignas(64) static constexpr std::array<float, FilterLength> coeffs =
+                reverseTaps(designWindowedSinc<FilterLength>(MonoDecimator::kCutoff));
+            return coeffs;
+        } else {
+            alignas(64) static const std::array<float, FilterLength> coeffs =
+                reverseTaps(toMinimumPhase(designWindowedSinc<FilterLength>(MonoDecimator::kCutoff)));
+            return coeffs;
+        }
+    }
+
+    static constexpr std::array<float, FilterLength> reverseTaps(const std::array<double, FilterLength>& h)
+    {
+        std::array<float, FilterLength> coeffs{};
+        for (int t = 0; t < FilterLength; ++t) {
+            coeffs[t] = static_cast<float>(h[FilterLength - 1 - t]);
+        }
+        return coeffs;
+    }
+};
+
+/**
+ * @brief 48kHz -> 16kHz decimators for surround stems
+ */
+using SurroundDecimator48to16 = MultichannelDecimator<8, 3, 48>;      // Up to 7.1
+using ImmersiveDecimator48to16 = MultichannelDecimator<16, 3, 48>;    // Up to 9.1.6
+
+} // namespace KhDetector
@@ -0,0 +1,219 @@
+#include "OnnxBackend.h"
+
+#include <iostream>
+
+#ifdef KHDETECTOR_WITH_ONNXRUNTIME
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+#include <onnxruntime_cxx_api.h>
+#endif
+
+namespace KhDetector {
+
+#ifdef KHDETECTOR_WITH_ONNXRUNTIME
+
+namespace {
+
+Ort::Env& getOrtEnv()
+{
+    // One environment per process; every session shares its logger and thread state
+    static Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "KhDetector");
+    return env;
+}
+
+/**
+ * @brief Per-frame size of a [batch, N] float tensor, or 0 for any other shape
+ */
+int64_t frameSize(const Ort::TypeInfo& typeInfo)
+{
+    const auto tensorInfo = typeInfo.GetTensorTypeAndShapeInfo();
+    if (tensorInfo.GetElementType() != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+        return 0;
+    }
+
+    const std::vector<int64_t> shape = tensorInfo.GetShape();
+    if (shape.size() != 2 || shape[1] <= 0) {
+        return 0;
+    }
+    return shape[1];
+}
+
+} // namespace
+
+struct OnnxBackend::Session
+{
+    Ort::Session session{nullptr};
+    Ort::IoBinding binding{nullptr};
+    Ort::RunOptions runOptions;
+    Ort::MemoryInfo memoryInfo = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+
+    // Tensors viewing the caller's buffers, kept alive while bound
+    Ort::Value input{nullptr};
+    Ort::Value output{nullptr};
+
+    std::string inputName;
+    std::string outputName;
+    int64_t inputSize = 0;
+    int64_t outputSize = 0;
+};
+
+OnnxBackend::OnnxBackend() = default;
+
+OnnxBackend::~OnnxBackend() = default;
+
+bool OnnxBackend::isAvailable()
+{
+    return true;
+}
+
+bool OnnxBackend::load(const std::string& modelPath, int numThreads)
+{
+    mSession.reset();
+
+    try {
+        Ort::SessionOptions options;
+        options.SetIntraOpNumThreads(std::max(1, numThreads));
+        options.SetInterOpNumThreads(1);
+        options.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
+        options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+        // Idle pool threads sleep instead of spinning next to the audio thread
+        options.AddConfigEntry("session.intra_op.allow_spinning", "0");
+
+        auto session = std::make_unique<Session>();
+        const std::filesystem::path path = std::filesystem::u8path(modelPath);
+        session->session = Ort::Session(getOrtEnv(), path.c_str(), options);
+
+        if (session->session.GetInputCount() != 1 || session->session.GetOutputCount() != 1) {
+            std::cerr << "OnnxBackend: " << modelPath << " must have exactly one input and one output" << std::endl;
+            return false;
+        }
+
+        session->inputSize = frameSize(session->session.GetInputTypeInfo(0));
+        session->outputSize = frameSize(session->session.GetOutputTypeInfo(0));
+        if (session->inputSize == 0 || session->outputSize == 0) {
+            std::cerr << "OnnxBackend: " << modelPath << " is not a [batch, N] -> [batch, M] float model" << std::endl;
+            return false;
+        }
+
+        Ort::AllocatorWithDefaultOptions allocator;
+        session->inputName = session->session.GetInputNameAllocated(0, allocator).get();
+        session->outputName = session->session.GetOutputNameAllocated(0, allocator).get();
+        session->binding = Ort::IoBinding(session->session);
+
+        mSession = std::move(session);
+    } catch (const Ort::Exception& e) {
+        std::cerr << "OnnxBackend: Failed to load " << modelPath << ": " << e.what() << std::endl;
+        return false;
+    }
+
+    std::cout << "OnnxBackend: Loaded " << modelPath << " (" << mSession->inputSize << " -> "
+              << mSession->outputSize << ", " << std::max(1, numThreads) << " thread(s))" << std::endl;
+    return true;
+}
+
+bool OnnxBackend::isLoaded() const
+{
+    return mSession != nullptr;
+}
+
+int OnnxBackend::getInputSize() const
+{
+    return mSession ? static_cast<int>(mSession->inputSize) : 0;
+}
+
+int OnnxBackend::getOutputSize() const
+{
+    return mSession ? static_cast<int>(mSession->outputSize) : 0;
+}
+
+bool OnnxBackend::bind(float* input, float* output, int batchSize)
+{
+    if (!mSession || !input || !output || batchSize <= 0) {
+        return false;
+    }
+
+    Session& s = *mSession;
+    try {
+        const int64_t inputShape[] = { batchSize, s.inputSize };
+        const int64_t outputShape[] = { batchSize, s.outputSize };
+        s.input = Ort::Value::CreateTensor<float>(s.memoryInfo, input, static_cast<size_t>(batchSize * s.inputSize),
+                                                  inputShape, 2);
+        s.output = Ort::Value::CreateTensor<float>(s.memoryInfo, output, static_cast<size_t>(batchSize * s.outputSize),
+                                                   outputShape, 2);
+
+        s.binding.ClearBoundInputs();
+        s.binding.ClearBoundOutputs();
+        s.binding.BindInput(s.inputName.c_str(), s.input);
+        s.binding.BindOutput(s.outputName.c_str(), s.output);
+    } catch (const Ort::Exception& e) {
+        std::cerr << "OnnxBackend: Failed to bind buffers: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool OnnxBackend::run()
+{
+    if (!mSession || !mSession->input) {
+        return false;
+    }
+
+    try {
+        mSession->session.Run(mSession->runOptions, mSession->binding);
+    } catch (const Ort::Exception& e) {
+        std::cerr << "OnnxBackend: Inference failed: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#else // KHDETECTOR_WITH_ONNXRUNTIME
+
+struct OnnxBackend::Session
+{
+};
+
+OnnxBackend::OnnxBackend() = default;
+
+OnnxBackend::~OnnxBackend() = default;
+
+bool OnnxBackend::isAvailable()
+{
+    return false;
+}
+
+bool OnnxBackend::load(const std::string& modelPath, int)
+{
+    std::cerr << "OnnxBackend: Cannot load " << modelPath << ": built without ONNX Runtime" << std::endl;
+    return false;
+}
+
+bool OnnxBackend::isLoaded() const
+{
+    return false;
+}
+
+int OnnxBackend::getInputSize() const
+{
+    return 0;
+}
+
+int OnnxBackend::getOutputSize() const
+{
+    return 0;
+}
+
+bool OnnxBackend::bind(float*, float*, int)
+{
+    return false;
+}
+
+bool OnnxBackend::run()
+{
+    return false;
+}
+
+#endif // KHDETECTOR_WITH_ONNXRUNTIME
+
+} // namespace KhDetector
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+namespace KhDetector {
+
+/**
+ * @brief ONNX Runtime session for one model
+ *
+ * Compiled against ONNX Runtime when the project is configured with it
+ * (cmake/OnnxRuntime.cmake defines KHDETECTOR_WITH_ONNXRUNTIME). Without it
+ * isAvailable() is false and load() fails, so callers keep their fallback.
+ *
+ * Models take a [batch, inputSize] float tensor and produce a
+ * [batch, outputSize] float tensor, as exported by
+ * training/train_het_detector.py. Input and output tensors are bound once
+ * over caller-owned buffers; run() then reads and writes those buffers in
+ * place and, once the session's arena has grown to its working size,
+ * allocates nothing.
+ */
+class OnnxBackend
+{
+public:
+    OnnxBackend();
+    ~OnnxBackend();
+
+    OnnxBackend(const OnnxBackend&) = delete;
+    OnnxBackend& operator=(const OnnxBackend&) = delete;
+
+    /**
+     * @brief Whether this build includes ONNX Runtime
+     */
+    static bool isAvailable();
+
+    /**
+     * @brief Create the session for a model file
+     *
+     * Replaces any previous session and drops its bindings.
+     *
+     * @param modelPath Path to the .onnx file (UTF-8)
+     * @param numThreads Intra-op threads; 1 runs every operator on the calling thread
+     * @return false if the file cannot be loaded or is not a [batch, N] -> [batch, M] float model
+     */
+    bool load(const std::string& modelPath, int numThreads);
+
+    bool isLoaded() const;
+
+    /**
+     * @brief Floats per frame in the model input (N)
+     */
+    int getInputSize() const;
+
+    /**
+     * @brief Floats per frame in the model output (M)
+     */
+    int getOutputSize() const;
+
+    /**
+     * @brief Bind the model input and output to caller buffers
+     *
+     * The buffers must stay valid, and must not move, until the next bind()
+     * or load() or until the backend is destroyed.
+     *
+     * @param input batchSize * getInputSize() floats
+     * @param output batchSize * getOutputSize() floats
+     * @param batchSize Frames per run()
+     */
+    bool bind(float* input, float* output, int batchSize);
+
+    /**
+     * @brief Run the model on the bound buffers
+     */
+    bool run();
+
+private:
+    struct Session;
+    std::unique_ptr<Session> mSession;
+};
+
+} // namespace KhDetector
@@ -5,27 +5,10 @@
 #include <cmath>
 #include <algorithm>
 #include <cstring>
+#include <type_traits>
 
-// SIMD includes
-#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
-    #include <emmintrin.h>
-    #define KHDETECTOR_USE_SSE2 1
-#endif
-
-#if defined(__SSE4_1__) || (defined(_MSC_VER) && _MSC_VER >= 1600)
-    #include <smmintrin.h>
-    #define KHDETECTOR_USE_SSE41 1
-#endif
-
-#if defined(__AVX__) || (defined(_MSC_VER) && _MSC_VER >= 1700)
-    #include <immintrin.h>
-    #define KHDETECTOR_USE_AVX 1
-#endif
-
-#if defined(__ARM_NEON) || defined(__ARM_NEON__)
-    #include <arm_neon.h>
-    #define KHDETECTOR_USE_NEON 1
-#endif
+#include "DspKernels.h"
+#include "FilterDesign.h"
 
 #ifndef DECIM_FACTOR
     #define DECIM_FACTOR 3  // Default: 48kHz -> 16kHz
@@ -33,66 +16,206 @@
 
 namespace KhDetector {
 
+namespace detail {
+
+/**
+ * @brief Dot product of a coefficient row with a window of input samples
+ * 
+ * Used by stages that need one output at a time (e.g. a different
+ * coefficient row for every output). Runs the SIMD variant bound at load
+ * time; see DspKernels.h.
+ */
+inline float dotProduct(const float* coeffs, const float* samples, int length)
+{
+    return getDspKernels().dotProduct(coeffs, samples, length);
+}
+
+/**
+ * @brief Run a bank of short FIR rows over a block of outputs
+ * 
+ * output[k] = sum_r sum_t coeffs[r * coeffStride + t] * samples[r * sampleStride + k + t]
+ * for k in [0, numOutputs). Each coefficient is broadcast and multiplied into
+ * the windows of a whole vector of consecutive outputs, so there is no
+ * horizontal reduction per output and no store-to-load dependency on freshly
+ * written history. Rows hold their taps oldest sample first.
+ */
+inline void firBlockRows(const float* coeffs, int coeffStride,
+                         const float* samples, int sampleStride,
+                         int numRows, int numTaps,
+                         float* output, int numOutputs)
+{
+    getDspKernels().firBlockRows(coeffs, coeffStride, samples, sampleStride,
+                                 numRows, numTaps, output, numOutputs);
+}
+
+/**
+ * @brief Average of a stereo pair as a float sample
+ * 
+ * Double input (64-bit host processing) is averaged in double precision and
+ * rounded once, so both sample sizes feed the filters the same value to
+ * within one float ulp.
+ */
+template<typename SampleType>
+inline float stereoToMono(SampleType left, SampleType right)
+{
+    static_assert(std::is_same<SampleType, float>::value || std::is_same<SampleType, double>::value,
+                  "Input samples must be float or double");
+    return static_cast<float>((left + right) * static_cast<SampleType>(0.5));
+}
+
+/**
+ * @brief Run a single short FIR over a block of outputs
+ */
+inline void firBlock(const float* coeffs, int numTaps, const float* samples, float* output, int numOutputs)
+{
+    firBlockRows(coeffs, 0, samples, 0, 1, numTaps, output, numOutputs);
+}
+
+} // namespace detail
+
 /**
  * @brief Poly-phase FIR decimator for efficient downsampling
  * 
  * This class implements a polyphase FIR filter for decimation, which is more
- * efficient than filtering followed by downsampling. It uses SIMD instructions
- * where available for optimal performance.
+ * efficient than filtering followed by downsampling. The FIR kernels run on the
+ * fastest instruction set the CPU supports, chosen at load time (DspKernels.h).
+ * 
+ * Input is handled a block at a time: each block is split over
+ * DecimationFactor phase streams, and only the output samples are computed,
+ * each being the sum of one short FIR per phase. Every phase stream keeps its
+ * history at the front of a linear buffer, so the tap window of any output is
+ * one contiguous run of memory, and detail::firBlockRows() computes a whole
+ * vector of outputs per coefficient without gathering or modulo indexing.
+ * 
+ * The linear-phase filter is designed at compile time into one aligned,
+ * read-only table per (DecimationFactor, FilterLength) instantiation, so
+ * construction only clears the histories. The minimum-phase variant has the
+ * same magnitude response and a much lower group delay at the cost of a
+ * frequency-dependent delay; its table is built once per process, on first
+ * construction.
+ * 
+ * Output samples are aligned to the input sample that completes each group of
+ * DecimationFactor samples at the group's start (input indices 0, D, 2D, ...),
+ * so the delay between input and output is exactly getGroupDelay() output
+ * samples (at DC for the minimum-phase variant).
  * 
  * @tparam DecimationFactor The integer decimation factor (e.g., 3 for 48kHz->16kHz)
  * @tparam FilterLength The total FIR filter length
+ * @tparam Phase Linear (default) or minimum-phase prototype filter
  */
-template<int DecimationFactor = DECIM_FACTOR, int FilterLength = DecimationFactor * 16>
+template<int DecimationFactor = DECIM_FACTOR, int FilterLength = DecimationFactor * 16,
+         FilterPhase Phase = FilterPhase::Linear>
 class PolyphaseDecimator
 {
 public:
     static constexpr int kDecimationFactor = DecimationFactor;
     static constexpr int kFilterLength = FilterLength;
     static constexpr int kPhaseLength = FilterLength / DecimationFactor;
+    static constexpr FilterPhase kPhase = Phase;
+    
+    // Normalized cutoff (1.0 = input Nyquist) that keeps the output free of aliasing
+    static constexpr double kCutoff = 0.45 < 1.0 / DecimationFactor ? 0.45 : 1.0 / DecimationFactor;
     
     static_assert(DecimationFactor > 0, "Decimation factor must be positive");
     static_assert(FilterLength % DecimationFactor == 0, "Filter length must be divisible by decimation factor");
 
-    /**
-     * @brief Construct a new Polyphase Decimator
-     * 
-     * @param cutoffFreq Normalized cutoff frequency (0.0 to 1.0, where 1.0 = Nyquist)
-     * @param transitionWidth Normalized transition width for the filter
-     */
-    PolyphaseDecimator(float cutoffFreq = 0.45f, float transitionWidth = 0.1f)
-        : inputBuffer_(FilterLength, 0.0f)
-        , bufferIndex_(0)
+    PolyphaseDecimator()
+        : polyphaseFilters_(filterTable().taps.data())
+        , groupDelay_(filterTable().groupDelay)
     {
-        designLowpassFilter(cutoffFreq, transitionWidth);
-        createPolyphaseFilters();
+        reset();
     }
 
     /**
      * @brief Process stereo input and produce mono decimated output
      * 
+     * SampleType is float or double (the host's 64-bit sample size). Double
+     * input is averaged in double precision and converted as the samples are
+     * split into the phase streams, so it needs no conversion buffer.
+     * 
      * @param leftInput Left channel input samples
      * @param rightInput Right channel input samples
      * @param output Output buffer for decimated mono samples
      * @param numInputSamples Number of input samples per channel
      * @return Number of output samples produced
      */
-    int processStereoToMono(const float* leftInput, const float* rightInput, 
+    template<typename SampleType>
+    int processStereoToMono(const SampleType* leftInput, const SampleType* rightInput,
                            float* output, int numInputSamples)
     {
         int outputCount = 0;
         
-        for (int i = 0; i < numInputSamples; ++i) {
-            // Convert stereo to mono (simple average)
-            float monoSample = (leftInput[i] + rightInput[i]) * 0.5f;
+        for (int offset = 0; offset < numInputSamples; offset += kBlockInputs) {
+            const int count = std::min(kBlockInputs, numInputSamples - offset);
+            
+            // Convert stereo to mono (simple average) while splitting into phases
+            distributeBlock(count, [&](int i) {
+                return detail::stereoToMono(leftInput[offset + i], rightInput[offset + i]);
+            });
+            outputCount += computeBlock(output + outputCount);
+        }
+        
+        return outputCount;
+    }
+
+    /**
+     * @brief Process stereo input straight into a pair of writable spans
+     * 
+     * Output samples are written into output.first and then output.second
+     * (e.g. the wrap split returned by RingBuffer::acquire_write()), so the
+     * caller can decimate directly into its destination without an
+     * intermediate buffer. Samples that do not fit are dropped, but the
+     * filter state still advances.
+     * 
+     * @param leftInput Left channel input samples (float or double)
+     * @param rightInput Right channel input samples (float or double)
+     * @param output Span pair exposing first/second {data, size}
+     * @param numInputSamples Number of input samples per channel
+     * @return Number of output samples written into the spans
+     */
+    template<typename SampleType, typename OutputSpans>
+    int processStereoToMono(const SampleType* leftInput, const SampleType* rightInput,
+                           const OutputSpans& output, int numInputSamples)
+    {
+        float* const regions[2] = { output.first.data, output.second.data };
+        const size_t regionSizes[2] = { output.first.size, output.second.size };
+        int region = 0;
+        size_t regionCount = 0;
+        int outputCount = 0;
+        
+        for (int offset = 0; offset < numInputSamples; offset += kBlockInputs) {
+            const int count = std::min(kBlockInputs, numInputSamples - offset);
+            
+            distributeBlock(count, [&](int i) {
+                return detail::stereoToMono(leftInput[offset + i], rightInput[offset + i]);
+            });
             
-            // Add to circular buffer
-            inputBuffer_[bufferIndex_] = monoSample;
-            bufferIndex_ = (bufferIndex_ + 1) % FilterLength;
+            // Compute straight into the current region when the block fits
+            // there, otherwise go through the block buffer
+            const int due = pendingOutputs();
+            while (region < 2 && regionCount == regionSizes[region]) {
+                ++region;
+                regionCount = 0;
+            }
             
-            // Check if we should produce an output sample
-            if ((i % DecimationFactor) == (DecimationFactor - 1)) {
-                output[outputCount++] = computeFilteredSample();
+            if (region < 2 && regionSizes[region] - regionCount >= static_cast<size_t>(due)) {
+                computeBlock(regions[region] + regionCount);
+                regionCount += due;
+                outputCount += due;
+                continue;
+            }
+            
+            computeBlock(blockOutput_.data());
+            for (int i = 0; i < due; ++i) {
+                while (region < 2 && regionCount == regionSizes[region]) {
+                    ++region;
+                    regionCount = 0;
+                }
+                if (region == 2) {
+                    break;
+                }
+                regions[region][regionCount++] = blockOutput_[i];
+                ++outputCount;
             }
         }
         
@@ -102,6 +225,8 @@ public:
     /**
      * @brief Process mono input and produce decimated output
      * 
+     * input and output may be the same buffer (in-place decimation).
+     * 
      * @param input Input samples
      * @param output Output buffer for decimated samples
      * @param numInputSamples Number of input samples
@@ -111,15 +236,10 @@ public:
     {
         int outputCount = 0;
         
-        for (int i = 0; i < numInputSamples; ++i) {
-            // Add to circular buffer
-            inputBuffer_[bufferIndex_] = input[i];
-            bufferIndex_ = (bufferIndex_ + 1) % FilterLength;
-            
-            // Check if we should produce an output sample
-            if ((i % DecimationFactor) == (DecimationFactor - 1)) {
-                output[outputCount++] = computeFilteredSample();
-            }
+        for (int offset = 0; offset < numInputSamples; offset += kBlockInputs) {
+            const int count = std::min(kBlockInputs, numInputSamples - offset);
+            distributeBlock(count, [&](int i) { return input[offset + i]; });
+            outputCount += computeBlock(output + outputCount);
         }
         
         return outputCount;
@@ -130,262 +250,542 @@ public:
      */
     void reset()
     {
-        std::fill(inputBuffer_.begin(), inputBuffer_.end(), 0.0f);
-        bufferIndex_ = 0;
+        streams_.fill(0.0f);
+        
+        // Phase 0 completes each output period, so the other phases' newest
+        // sample for output k arrives one period earlier: they start with one
+        // extra (zero) sample standing in for the period before the first output
+        streamLength_.fill(kStreamHistory + 1);
+        streamLength_[0] = kStreamHistory;
+        nextPhase_ = 0;
     }
 
     /**
-     * @brief Get the group delay of the filter in samples
+     * @brief Number of output samples the next call will produce
+     * 
+     * The decimation phase carries over between calls, so this depends on
+     * how many input samples are still pending from previous blocks.
+     * 
+     * @param numInputSamples Number of input samples in the next block
      */
-    constexpr int getGroupDelay() const
+    int getOutputCount(int numInputSamples) const
     {
-        return kPhaseLength / 2;
+        if (numInputSamples <= nextPhase_) {
+            return 0;
+        }
+        return (numInputSamples - nextPhase_ - 1) / DecimationFactor + 1;
+    }
+
+    /**
+     * @brief Get the group delay of the filter in output samples
+     * 
+     * The linear-phase prototype is symmetric around tap FilterLength / 2, so
+     * this is exactly FilterLength / 2 input samples. For the minimum-phase
+     * variant it is the delay at DC.
+     */
+    double getGroupDelay() const
+    {
+        return groupDelay_;
     }
 
 private:
-    std::vector<float> inputBuffer_;
-    int bufferIndex_;
+    // Outputs per internal block; larger blocks are processed in pieces
+    static constexpr int kBlockOutputs = 128;
+    static constexpr int kBlockInputs = kBlockOutputs * DecimationFactor;
+    
+    // Each phase stream holds kPhaseLength - 1 samples of history, at most
+    // one sample belonging to the next output period, and one block
+    static constexpr int kStreamHistory = kPhaseLength - 1;
+    static constexpr int kStreamStride = kStreamHistory + 1 + kBlockOutputs;
     
-    // Polyphase filter coefficients
-    std::array<std::vector<float>, DecimationFactor> polyphaseFilters_;
+    // Phase-major streams: [phase][kStreamStride]
+    alignas(32) std::array<float, DecimationFactor * kStreamStride> streams_;
+    std::array<int, DecimationFactor> streamLength_;
     
     /**
-     * @brief Design a lowpass FIR filter using windowed sinc method
+     * @brief Polyphase coefficients shared by every instance
      */
-    void designLowpassFilter(float cutoffFreq, float transitionWidth)
+    struct FilterTable
     {
-        std::vector<float> h(FilterLength);
-        
-        // Design lowpass filter with cutoff at 1/DecimationFactor to prevent aliasing
-        float fc = std::min(cutoffFreq, 1.0f / DecimationFactor);
-        
-        // Generate windowed sinc filter
-        for (int n = 0; n < FilterLength; ++n) {
-            int m = n - FilterLength / 2;
-            
-            if (m == 0) {
-                h[n] = 2.0f * fc;
-            } else {
-                h[n] = std::sin(2.0f * M_PI * fc * m) / (M_PI * m);
+        alignas(64) std::array<float, FilterLength> taps;
+        double groupDelay;  // In output samples
+    };
+    
+    // Polyphase filter coefficients, phase-major and time-reversed so that
+    // tap j of a phase multiplies the j-th oldest sample of its window
+    const float* polyphaseFilters_;
+    double groupDelay_;
+    
+    // Scratch for span output that straddles the wrap point
+    std::array<float, kBlockOutputs> blockOutput_;
+    
+    int nextPhase_ = 0;     // Phase stream receiving the next input sample
+    
+    /**
+     * @brief Append up to kBlockInputs samples to their phase streams
+     * 
+     * Samples of one output period arrive for phases D-1, ..., 1, 0; phase 0
+     * completes the period.
+     */
+    template<typename SampleSource>
+    void distributeBlock(int count, SampleSource&& sampleAt)
+    {
+        // Input i of the block goes to phase (nextPhase_ - i) mod D, so each
+        // phase takes every D-th sample starting at (nextPhase_ - phase) mod D
+        for (int phase = 0; phase < DecimationFactor; ++phase) {
+            float* stream = streams_.data() + phase * kStreamStride + streamLength_[phase];
+            int first = nextPhase_ - phase;
+            if (first < 0) {
+                first += DecimationFactor;
             }
             
-            // Apply Hamming window
-            h[n] *= 0.54f - 0.46f * std::cos(2.0f * M_PI * n / (FilterLength - 1));
+            int appended = 0;
+            for (int i = first; i < count; i += DecimationFactor) {
+                stream[appended++] = sampleAt(i);
+            }
+            streamLength_[phase] += appended;
         }
         
-        // Normalize
-        float sum = 0.0f;
-        for (float coeff : h) {
-            sum += coeff;
+        nextPhase_ = (nextPhase_ - count % DecimationFactor + DecimationFactor) % DecimationFactor;
+    }
+    
+    /**
+     * @brief Number of complete output periods waiting in the streams
+     */
+    int pendingOutputs() const
+    {
+        return streamLength_[0] - kStreamHistory;
+    }
+    
+    /**
+     * @brief Compute every complete output period and retire its samples
+     * 
+     * Output k is the sum over phases of the FIR over stream[k, k + kPhaseLength).
+     * Afterwards each stream keeps its last kStreamHistory samples plus any
+     * sample that already belongs to the next output period.
+     * 
+     * @return Number of output samples written
+     */
+    int computeBlock(float* output)
+    {
+        const int numOutputs = pendingOutputs();
+        if (numOutputs == 0) {
+            return 0;
         }
         
-        for (int n = 0; n < FilterLength; ++n) {
-            h[n] /= sum;
+        detail::firBlockRows(polyphaseFilters_, kPhaseLength,
+                             streams_.data(), kStreamStride,
+                             DecimationFactor, kPhaseLength,
+                             output, numOutputs);
+        
+        for (int phase = 0; phase < DecimationFactor; ++phase) {
+            float* stream = streams_.data() + phase * kStreamStride;
+            const int keep = streamLength_[phase] - numOutputs;
+            std::memmove(stream, stream + numOutputs, keep * sizeof(float));
+            streamLength_[phase] = keep;
         }
         
-        // Store coefficients for polyphase decomposition
-        filterCoeffs_ = std::move(h);
+        return numOutputs;
     }
     
     /**
-     * @brief Create polyphase filter banks from the prototype filter
+     * @brief Coefficient table for this instantiation
+     * 
+     * The linear-phase table is a compile-time constant. The minimum-phase
+     * design needs several FFTs, more than Clang and MSVC evaluate by default
+     * at compile time, so it runs once on first use instead.
      */
-    void createPolyphaseFilters()
+    static const FilterTable& filterTable()
     {
-        for (int phase = 0; phase < DecimationFactor; ++phase) {
-            polyphaseFilters_[phase].resize(kPhaseLength);
-            
-            for (int i = 0; i < kPhaseLength; ++i) {
-                int coeffIndex = i * DecimationFactor + phase;
-                polyphaseFilters_[phase][i] = filterCoeffs_[coeffIndex];
-            }
+        if constexpr (Phase == FilterPhase::Linear) {
+            static constexpr FilterTable table = {
+                makePolyphaseTable<DecimationFactor>(designWindowedSinc<FilterLength>(kCutoff)),
+                (FilterLength / 2) / static_cast<double>(DecimationFactor)
+            };
+            return table;
+        } else {
+            static const FilterTable table = [] {
+                const auto prototype = toMinimumPhase(designWindowedSinc<FilterLength>(kCutoff));
+                return FilterTable{
+                    makePolyphaseTable<DecimationFactor>(prototype),
+                    dcGroupDelay(prototype) / DecimationFactor
+                };
+            }();
+            return table;
+        }
+    }
+};
+
+/**
+ * @brief 2:1 half-band FIR decimator
+ * 
+ * A half-band lowpass (cutoff at a quarter of the input rate) has every
+ * other coefficient equal to zero apart from the centre tap of 0.5. Split
+ * into two phases, one phase is a dense 2 * HalfTaps filter and the other is
+ * a pure delay, so each output costs 2 * HalfTaps multiplies instead of the
+ * 4 * HalfTaps - 1 of the full filter.
+ * 
+ * The filter is short, so rather than one dot product per output the input
+ * is split into its two phase streams a block at a time and the dense phase
+ * is run with detail::firBlock(), which computes a vector of outputs per
+ * coefficient. Both streams keep their history at the front of a linear
+ * buffer, so every window is contiguous.
+ * 
+ * Outputs are aligned to inputs 0, 2, 4, ... and delayed by getGroupDelay()
+ * output samples (half-integer).
+ * 
+ * @tparam HalfTaps Non-zero taps on each side of the centre tap
+ */
+template<int HalfTaps = 8>
+class HalfBandDecimator
+{
+public:
+    static constexpr int kDecimationFactor = 2;
+    static constexpr int kDenseTaps = 2 * HalfTaps;
+    static constexpr int kFilterLength = 4 * HalfTaps - 1;
+    
+    static_assert(HalfTaps > 0, "Half-band filter needs at least one tap per side");
+    
+    HalfBandDecimator()
+    {
+        reset();
+    }
+    
+    /**
+     * @brief Process mono input and produce decimated output
+     * 
+     * input and output may be the same buffer (in-place decimation).
+     * 
+     * @return Number of output samples produced
+     */
+    int processMono(const float* input, float* output, int numInputSamples)
+    {
+        int outputCount = 0;
+        
+        for (int offset = 0; offset < numInputSamples; offset += kBlockSize) {
+            const int count = std::min(kBlockSize, numInputSamples - offset);
+            outputCount += processBlock(count, [&](int i) { return input[offset + i]; },
+                                        output + outputCount);
         }
+        
+        return outputCount;
     }
     
     /**
-     * @brief Compute filtered sample using current polyphase
+     * @brief Process stereo input (float or double) and produce mono decimated output
+     * 
+     * @return Number of output samples produced
      */
-    float computeFilteredSample()
+    template<typename SampleType>
+    int processStereoToMono(const SampleType* leftInput, const SampleType* rightInput,
+                           float* output, int numInputSamples)
     {
-        // Determine which polyphase filter to use
-        int phase = (DecimationFactor - 1) - (bufferIndex_ % DecimationFactor);
+        int outputCount = 0;
+        
+        for (int offset = 0; offset < numInputSamples; offset += kBlockSize) {
+            const int count = std::min(kBlockSize, numInputSamples - offset);
+            outputCount += processBlock(count, [&](int i) {
+                return detail::stereoToMono(leftInput[offset + i], rightInput[offset + i]);
+            }, output + outputCount);
+        }
         
-        return computeConvolution(polyphaseFilters_[phase]);
+        return outputCount;
     }
     
     /**
-     * @brief Compute convolution with SIMD optimization where possible
+     * @brief Reset the decimator state
      */
-    float computeConvolution(const std::vector<float>& coeffs)
+    void reset()
     {
-#if defined(KHDETECTOR_USE_AVX)
-        return computeConvolutionAVX(coeffs);
-#elif defined(KHDETECTOR_USE_SSE2)
-        return computeConvolutionSSE(coeffs);
-#elif defined(KHDETECTOR_USE_NEON)
-        return computeConvolutionNEON(coeffs);
-#else
-        return computeConvolutionScalar(coeffs);
-#endif
+        denseStream_.fill(0.0f);
+        centreStream_.fill(0.0f);
+        denseNext_ = true;
     }
     
-#if defined(KHDETECTOR_USE_AVX)
     /**
-     * @brief AVX-optimized convolution
+     * @brief Number of output samples the next call will produce
+     */
+    int getOutputCount(int numInputSamples) const
+    {
+        return denseNext_ ? (numInputSamples + 1) / 2 : numInputSamples / 2;
+    }
+    
+    /**
+     * @brief Group delay in output samples
+     */
+    static constexpr double getGroupDelay()
+    {
+        return (kFilterLength - 1) / 4.0;
+    }
+    
+private:
+    static constexpr int kBlockSize = 256;
+    static constexpr int kDenseHistory = kDenseTaps - 1;
+    
+    // Phase streams: history followed by the current block's samples
+    std::array<float, kDenseHistory + kBlockSize / 2 + 1> denseStream_;
+    std::array<float, HalfTaps + kBlockSize / 2 + 1> centreStream_;
+    
+    bool denseNext_ = true;  // Next input belongs to the dense phase (and completes an output)
+    
+    /**
+     * @brief Decimate up to kBlockSize input samples
+     * 
+     * Output k of the block is the dense filter over denseStream_[k ...] plus
+     * half the centre-stream sample HalfTaps positions back, which lands at
+     * centreStream_[k] when the block starts on the dense phase and one
+     * further on otherwise.
      */
-    float computeConvolutionAVX(const std::vector<float>& coeffs)
+    template<typename SampleSource>
+    int processBlock(int count, SampleSource&& sampleAt, float* output)
     {
-        __m256 sum = _mm256_setzero_ps();
-        const int simdLength = (kPhaseLength / 8) * 8;
+        const int centreOffset = denseNext_ ? 0 : 1;
+        int numDense = 0;
+        int numCentre = 0;
         
-        for (int i = 0; i < simdLength; i += 8) {
-            // Load 8 coefficients
-            __m256 c = _mm256_loadu_ps(&coeffs[i]);
-            
-            // Load 8 input samples (with circular buffer handling)
-            __m256 x = loadInputSamplesAVX(i);
-            
-            // Multiply and accumulate
-            sum = _mm256_fmadd_ps(x, c, sum);
+        // Split the block into its phase streams
+        float* dense = denseStream_.data() + kDenseHistory;
+        float* centre = centreStream_.data() + HalfTaps;
+        for (int i = centreOffset; i < count; i += 2) {
+            dense[numDense++] = sampleAt(i);
+        }
+        for (int i = 1 - centreOffset; i < count; i += 2) {
+            centre[numCentre++] = sampleAt(i);
+        }
+        if (count % 2 != 0) {
+            denseNext_ = !denseNext_;
         }
         
-        // Horizontal sum
-        float result[8];
-        _mm256_storeu_ps(result, sum);
-        float total = result[0] + result[1] + result[2] + result[3] + 
-                     result[4] + result[5] + result[6] + result[7];
-        
-        // Handle remaining samples
-        for (int i = simdLength; i < kPhaseLength; ++i) {
-            int bufferIdx = (bufferIndex_ - 1 - i + FilterLength) % FilterLength;
-            total += inputBuffer_[bufferIdx] * coeffs[i];
+        detail::firBlock(denseCoeffs().data(), kDenseTaps, denseStream_.data(), output, numDense);
+        const float* centreTaps = centreStream_.data() + centreOffset;
+        for (int k = 0; k < numDense; ++k) {
+            output[k] += 0.5f * centreTaps[k];
         }
         
-        return total;
+        // Keep the newest samples of each stream as history for the next block
+        std::memmove(denseStream_.data(), denseStream_.data() + numDense, kDenseHistory * sizeof(float));
+        std::memmove(centreStream_.data(), centreStream_.data() + numCentre, HalfTaps * sizeof(float));
+        
+        return numDense;
     }
     
-    __m256 loadInputSamplesAVX(int offset)
+    /**
+     * @brief Dense phase taps, time-reversed (oldest sample first)
+     */
+    static const std::array<float, kDenseTaps>& denseCoeffs()
     {
-        float samples[8];
-        for (int i = 0; i < 8; ++i) {
-            int bufferIdx = (bufferIndex_ - 1 - offset - i + FilterLength) % FilterLength;
-            samples[i] = inputBuffer_[bufferIdx];
-        }
-        return _mm256_loadu_ps(samples);
+        alignas(64) static constexpr std::array<float, kDenseTaps> coeffs = designHalfBandFilter();
+        return coeffs;
     }
-#endif
-
-#if defined(KHDETECTOR_USE_SSE2)
+    
     /**
-     * @brief SSE2-optimized convolution
+     * @brief Design the Blackman-windowed half-band filter at compile time
+     * 
+     * Only the even taps (odd distance from the centre) are non-zero; they
+     * are normalized to sum to 0.5 so DC gain is exactly one and the
+     * half-band symmetry is preserved.
      */
-    float computeConvolutionSSE(const std::vector<float>& coeffs)
+    static constexpr std::array<float, kDenseTaps> designHalfBandFilter()
     {
-        __m128 sum = _mm_setzero_ps();
-        const int simdLength = (kPhaseLength / 4) * 4;
-        
-        for (int i = 0; i < simdLength; i += 4) {
-            // Load 4 coefficients
-            __m128 c = _mm_loadu_ps(&coeffs[i]);
-            
-            // Load 4 input samples
-            __m128 x = loadInputSamplesSSE(i);
-            
-            // Multiply and accumulate
-            sum = _mm_add_ps(sum, _mm_mul_ps(x, c));
-        }
+        using namespace constmath;
         
-        // Horizontal sum
-        float result[4];
-        _mm_storeu_ps(result, sum);
-        float total = result[0] + result[1] + result[2] + result[3];
+        constexpr int centre = kFilterLength / 2;
+        std::array<double, kDenseTaps> h{};
+        double sum = 0.0;
         
-        // Handle remaining samples
-        for (int i = simdLength; i < kPhaseLength; ++i) {
-            int bufferIdx = (bufferIndex_ - 1 - i + FilterLength) % FilterLength;
-            total += inputBuffer_[bufferIdx] * coeffs[i];
+        for (int j = 0; j < kDenseTaps; ++j) {
+            int n = 2 * j;
+            int m = n - centre;
+            double window = 0.42 - 0.5 * cos(2.0 * kPi * (n + 1) / (kFilterLength + 1))
+                                 + 0.08 * cos(4.0 * kPi * (n + 1) / (kFilterLength + 1));
+            h[j] = sin(kPi * m / 2.0) / (kPi * m) * window;
+            sum += h[j];
         }
         
-        return total;
+        // Tap j multiplies the j-th newest dense sample; store oldest first
+        std::array<float, kDenseTaps> coeffs{};
+        for (int j = 0; j < kDenseTaps; ++j) {
+            coeffs[kDenseTaps - 1 - j] = static_cast<float>(0.5 * h[j] / sum);
+        }
+        return coeffs;
     }
+};
+
+/**
+ * @brief Cascade of half-band 2:1 stages followed by a polyphase stage
+ * 
+ * For high host rates a single-stage decimator needs a filter whose length
+ * grows with the decimation factor to keep the same transition band. The
+ * early half-band stages only have to reject what would alias into the final
+ * passband, so they get away with a handful of taps, and the final
+ * PolyphaseDecimator runs at a low input rate.
+ * 
+ * Blocks are pushed through the stages in fixed-size chunks via a member
+ * scratch buffer, so processing never allocates.
+ * 
+ * @tparam NumHalfBands Number of 2:1 half-band stages
+ * @tparam FinalFactor Decimation factor of the final polyphase stage
+ * @tparam FinalLength Filter length of the final polyphase stage
+ * @tparam HalfTaps Taps per side of each half-band stage
+ * @tparam FinalPhase Phase response of the final stage (half-band stages are always linear phase)
+ */
+template<int NumHalfBands, int FinalFactor = 3, int FinalLength = FinalFactor * 16, int HalfTaps = 8,
+         FilterPhase FinalPhase = FilterPhase::Linear>
+class CascadeDecimator
+{
+public:
+    static constexpr int kDecimationFactor = (1 << NumHalfBands) * FinalFactor;
+    
+    static_assert(NumHalfBands >= 1, "Use PolyphaseDecimator directly without half-band stages");
     
-    __m128 loadInputSamplesSSE(int offset)
+    /**
+     * @brief Process stereo input and produce mono decimated output
+     * 
+     * Double input is converted by the first half-band stage as it splits
+     * its phases; every later stage runs in float.
+     * 
+     * @return Number of output samples produced
+     */
+    template<typename SampleType>
+    int processStereoToMono(const SampleType* leftInput, const SampleType* rightInput,
+                           float* output, int numInputSamples)
     {
-        float samples[4];
-        for (int i = 0; i < 4; ++i) {
-            int bufferIdx = (bufferIndex_ - 1 - offset - i + FilterLength) % FilterLength;
-            samples[i] = inputBuffer_[bufferIdx];
+        int outputCount = 0;
+        
+        for (int offset = 0; offset < numInputSamples; offset += kChunkSize) {
+            const int count = std::min(kChunkSize, numInputSamples - offset);
+            outputCount += runStages(leftInput + offset, rightInput + offset, count, output + outputCount);
         }
-        return _mm_loadu_ps(samples);
+        
+        return outputCount;
     }
-#endif
-
-#if defined(KHDETECTOR_USE_NEON)
+    
     /**
-     * @brief NEON-optimized convolution
+     * @brief Process stereo input straight into a pair of writable spans
+     * 
+     * Same contract as PolyphaseDecimator::processStereoToMono() with spans:
+     * samples that do not fit are dropped but the filter state still advances.
      */
-    float computeConvolutionNEON(const std::vector<float>& coeffs)
+    template<typename SampleType, typename OutputSpans>
+    int processStereoToMono(const SampleType* leftInput, const SampleType* rightInput,
+                           const OutputSpans& output, int numInputSamples)
     {
-        float32x4_t sum = vdupq_n_f32(0.0f);
-        const int simdLength = (kPhaseLength / 4) * 4;
+        float* const regions[2] = { output.first.data, output.second.data };
+        const size_t regionSizes[2] = { output.first.size, output.second.size };
+        int region = 0;
+        size_t regionCount = 0;
+        int outputCount = 0;
         
-        for (int i = 0; i < simdLength; i += 4) {
-            // Load 4 coefficients
-            float32x4_t c = vld1q_f32(&coeffs[i]);
-            
-            // Load 4 input samples
-            float32x4_t x = loadInputSamplesNEON(i);
-            
-            // Multiply and accumulate
-            sum = vmlaq_f32(sum, x, c);
+        for (int offset = 0; offset < numInputSamples; offset += kChunkSize) {
+            const int count = std::min(kChunkSize, numInputSamples - offset);
+            const int produced = runStages(leftInput + offset, rightInput + offset, count, finalBuffer_.data());
+            for (int i = 0; i < produced; ++i) {
+                while (region < 2 && regionCount == regionSizes[region]) {
+                    ++region;
+                    regionCount = 0;
+                }
+                if (region == 2) {
+                    break;
+                }
+                regions[region][regionCount++] = finalBuffer_[i];
+                ++outputCount;
+            }
         }
         
-        // Horizontal sum
-        float32x2_t sum_pair = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
-        float total = vget_lane_f32(vpadd_f32(sum_pair, sum_pair), 0);
+        return outputCount;
+    }
+    
+    /**
+     * @brief Process mono input and produce decimated output
+     * 
+     * @return Number of output samples produced
+     */
+    int processMono(const float* input, float* output, int numInputSamples)
+    {
+        int outputCount = 0;
         
-        // Handle remaining samples
-        for (int i = simdLength; i < kPhaseLength; ++i) {
-            int bufferIdx = (bufferIndex_ - 1 - i + FilterLength) % FilterLength;
-            total += inputBuffer_[bufferIdx] * coeffs[i];
+        for (int offset = 0; offset < numInputSamples; offset += kChunkSize) {
+            const int count = std::min(kChunkSize, numInputSamples - offset);
+            outputCount += runStages(input + offset, input + offset, count, output + outputCount);
         }
         
-        return total;
+        return outputCount;
     }
     
-    float32x4_t loadInputSamplesNEON(int offset)
+    /**
+     * @brief Reset all stages
+     */
+    void reset()
     {
-        float samples[4];
-        for (int i = 0; i < 4; ++i) {
-            int bufferIdx = (bufferIndex_ - 1 - offset - i + FilterLength) % FilterLength;
-            samples[i] = inputBuffer_[bufferIdx];
+        for (auto& stage : halfBands_) {
+            stage.reset();
         }
-        return vld1q_f32(samples);
+        finalStage_.reset();
     }
-#endif
-
+    
     /**
-     * @brief Scalar (non-SIMD) convolution fallback
+     * @brief Number of output samples the next call will produce
      */
-    float computeConvolutionScalar(const std::vector<float>& coeffs)
+    int getOutputCount(int numInputSamples) const
     {
-        float sum = 0.0f;
-        
-        for (int i = 0; i < kPhaseLength; ++i) {
-            int bufferIdx = (bufferIndex_ - 1 - i + FilterLength) % FilterLength;
-            sum += inputBuffer_[bufferIdx] * coeffs[i];
+        int count = numInputSamples;
+        for (const auto& stage : halfBands_) {
+            count = stage.getOutputCount(count);
         }
-        
-        return sum;
+        return finalStage_.getOutputCount(count);
     }
     
-    std::vector<float> filterCoeffs_;
+    /**
+     * @brief Total group delay of all stages in output samples
+     * 
+     * Each stage's delay is scaled by the decimation that follows it.
+     */
+    double getGroupDelay() const
+    {
+        double delay = finalStage_.getGroupDelay();
+        int laterFactor = FinalFactor;
+        for (int stage = NumHalfBands - 1; stage >= 0; --stage) {
+            delay += HalfBandDecimator<HalfTaps>::getGroupDelay() / laterFactor;
+            laterFactor *= 2;
+        }
+        return delay;
+    }
+    
+private:
+    static constexpr int kChunkSize = 256;
+    
+    std::array<HalfBandDecimator<HalfTaps>, NumHalfBands> halfBands_;
+    PolyphaseDecimator<FinalFactor, FinalLength, FinalPhase> finalStage_;
+    
+    std::array<float, kChunkSize / 2 + 1> stageBuffer_;
+    std::array<float, kChunkSize / FinalFactor + 1> finalBuffer_;
+    
+    /**
+     * @brief Run one chunk through every stage
+     * 
+     * The first half-band stage downmixes while decimating into stageBuffer_
+     * (mono input passes the same channel twice), later half-band stages
+     * decimate in place and the final stage writes to output.
+     */
+    template<typename SampleType>
+    int runStages(const SampleType* leftInput, const SampleType* rightInput, int count, float* output)
+    {
+        count = halfBands_[0].processStereoToMono(leftInput, rightInput, stageBuffer_.data(), count);
+        for (int stage = 1; stage < NumHalfBands; ++stage) {
+            count = halfBands_[stage].processMono(stageBuffer_.data(), stageBuffer_.data(), count);
+        }
+        return finalStage_.processMono(stageBuffer_.data(), output, count);
+    }
 };
 
 /**
  * @brief Specialized decimator for common audio sample rates
+ * 
+ * Rates that are not an integer multiple of 16kHz (44.1kHz, 88.2kHz, ...)
+ * go through RationalResampler instead.
  */
 using Decimator48to16 = PolyphaseDecimator<3, 48>;   // 48kHz -> 16kHz
-using Decimator44to16 = PolyphaseDecimator<3, 48>;   // 44.1kHz -> ~14.7kHz (approximate)
+using Decimator96to16 = CascadeDecimator<1, 3, 48>;   // 96kHz -> 48kHz -> 16kHz
+using Decimator192to16 = CascadeDecimator<2, 3, 48>;  // 192kHz -> 96kHz -> 48kHz -> 16kHz
 
-} // namespace KhDetector 
\ No newline at end of file
+} // namespace KhDetector
@@ -1,11 +1,26 @@
 #include "PostProcessor.h"
+#include "DspKernels.h"
 #include <algorithm>
 #include <numeric>
 #include <iostream>
 #include <cmath>
+#include <chrono>
 
 namespace KhDetector {
 
+PostProcessor::Statistics::Statistics(const Statistics& other)
+    : totalFramesProcessed(other.totalFramesProcessed.load())
+    , totalHits(other.totalHits.load())
+    , falsePositives(other.falsePositives.load())
+    , debouncedHits(other.debouncedHits.load())
+    , averageConfidence(other.averageConfidence.load())
+    , averageSmoothedConfidence(other.averageSmoothedConfidence.load())
+    , peakConfidence(other.peakConfidence.load())
+    , currentHitDuration(other.currentHitDuration.load())
+    , isCurrentlyHit(other.isCurrentlyHit.load())
+{
+}
+
 PostProcessor::PostProcessor(const Config& config) 
     : mConfig(config)
 {
@@ -121,6 +136,16 @@ void PostProcessor::updateConfig(const Config& config)
     std::cout << "PostProcessor: Configuration updated" << std::endl;
 }
 
+void PostProcessor::setThreshold(float threshold)
+{
+    mConfig.threshold = std::clamp(threshold, 0.0f, 1.0f);
+    if (mConfig.enableHysteresis) {
+        const float width = mConfig.hysteresisHigh - mConfig.hysteresisLow;
+        mConfig.hysteresisHigh = mConfig.threshold;
+        mConfig.hysteresisLow = std::max(0.0f, mConfig.threshold - width);
+    }
+}
+
 void PostProcessor::setHitCallback(HitCallback callback)
 {
     mHitCallback = std::move(callback);
@@ -154,30 +179,9 @@ float PostProcessor::applyMedianFilter()
         return mConfidenceHistory[(mHistoryIndex - 1 + mConfig.medianFilterSize) % mConfig.medianFilterSize];
     }
     
-    // Create a copy for sorting (don't modify original circular buffer)
-    std::vector<float> sortBuffer;
-    
-    if (mHistoryFilled) {
-        sortBuffer = mConfidenceHistory;
-    } else {
-        // Only use filled portion
-        sortBuffer.assign(mConfidenceHistory.begin(), mConfidenceHistory.begin() + mHistoryIndex);
-    }
-    
-    // Find median
-    size_t n = sortBuffer.size();
-    std::nth_element(sortBuffer.begin(), sortBuffer.begin() + n/2, sortBuffer.end());
-    
-    if (n % 2 == 1) {
-        // Odd number of elements
-        return sortBuffer[n/2];
-    } else {
-        // Even number of elements - average of two middle values
-        float median1 = sortBuffer[n/2];
-        std::nth_element(sortBuffer.begin(), sortBuffer.begin() + n/2 - 1, sortBuffer.end());
-        float median2 = sortBuffer[n/2 - 1];
-        return (median1 + median2) * 0.5f;
-    }
+    // The median is order independent, so the circular buffer can be used as is
+    const int count = mHistoryFilled ? static_cast<int>(mConfidenceHistory.size()) : mHistoryIndex;
+    return getDspKernels().median(mConfidenceHistory.data(), count);
 }
 
 void PostProcessor::updateHitDetection(float smoothedConfidence)
@@ -200,7 +204,11 @@ void PostProcessor::updateHitDetection(float smoothedConfidence)
         mPeakConfidenceInHit = smoothedConfidence;
         mHitStartTime = std::chrono::steady_clock::now();
         
-        // Don't trigger external hit state yet - wait for minimum duration
+        // Don't trigger external hit state yet - wait for minimum duration,
+        // unless a single frame is enough
+        if (mHitFrameCount >= mConfig.minHitDuration) {
+            triggerHitStateChange(true, smoothedConfidence);
+        }
         
     } else if (thresholdMet && mCurrentHitState) {
         // Continue existing hit
@@ -282,9 +290,6 @@ void PostProcessor::triggerHitStateChange(bool newState, float smoothedConfidenc
             std::cerr << "PostProcessor: Hit callback exception: " << e.what() << std::endl;
         }
     }
-    
-    std::cout << "PostProcessor: Hit state changed to " << (newState ? "HIT" : "NO_HIT") 
-              << " (confidence: " << smoothedConfidence << ", duration: " << mHitFrameCount << " frames)" << std::endl;
 }
 
 void PostProcessor::updateStatistics(float confidence, float smoothedConfidence)
@@ -2,6 +2,8 @@
 
 #include <vector>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
 
@@ -28,7 +30,8 @@ public:
     {
         int medianFilterSize = 5;           // Size of median filter (odd numbers preferred)
         float threshold = 0.6f;             // Hit detection threshold (0.0-1.0)
-        float hysteresisLower = 0.55f;      // Lower threshold for hysteresis
+        float hysteresisHigh = 0.6f;        // Upper threshold for hysteresis (starts a hit)
+        float hysteresisLow = 0.55f;        // Lower threshold for hysteresis (ends a hit)
         bool enableHysteresis = false;      // Enable hysteresis thresholding
         int minHitDuration = 3;             // Minimum hit duration in frames
         int maxHitDuration = 100;           // Maximum hit duration before auto-reset
@@ -41,11 +44,11 @@ public:
      */
     struct HitEvent 
     {
-        bool isHit = false;
-        float confidence = 0.0f;
+        bool isActive = false;
         float peakConfidence = 0.0f;
-        int duration = 0;
-        uint64_t timestamp = 0;
+        float smoothedConfidence = 0.0f;
+        int hitDurationFrames = 0;
+        std::chrono::steady_clock::time_point timestamp;    // Start of the hit
     };
 
     /**
@@ -53,6 +56,9 @@ public:
      */
     struct Statistics 
     {
+        Statistics() = default;
+        Statistics(const Statistics& other);
+        
         std::atomic<uint64_t> totalFramesProcessed{0};
         std::atomic<uint64_t> totalHits{0};
         std::atomic<uint64_t> falsePositives{0};
@@ -72,7 +78,8 @@ public:
     /**
      * Constructor
      */
-    explicit PostProcessor(const Config& config = Config{});
+    PostProcessor() : PostProcessor(Config()) {}
+    explicit PostProcessor(const Config& config);
 
     /**
      * Process a confidence value and return smoothed result
@@ -105,6 +112,12 @@ public:
      */
     void updateConfig(const Config& config);
 
+    /**
+     * Move the hit threshold without resetting the filter or the hit state;
+     * with hysteresis the band moves with it and keeps its width
+     */
+    void setThreshold(float threshold);
+
     /**
      * Get current configuration
      */
@@ -145,6 +158,7 @@ private:
     int mHitFrameCount = 0;
     int mDebounceFrameCount = 0;
     float mPeakConfidenceInHit = 0.0f;
+    std::chrono::steady_clock::time_point mHitStartTime;
     HitEvent mLastHitEvent;
     
     // Thread-safe state
@@ -0,0 +1,361 @@
+#pragma once
+
+#include "PolyphaseDecimator.h"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace KhDetector {
+
+/**
+ * @brief Up/down factors that take a host sample rate to 16 kHz
+ */
+struct RationalRate
+{
+    double inputRate;    ///< Host sample rate in Hz
+    int upFactor;        ///< Interpolation factor L
+    int downFactor;      ///< Decimation factor M
+    int tapsPerPhase;    ///< Filter taps per polyphase branch (multiple of 8)
+};
+
+/**
+ * @brief Precomputed conversion ratios to the 16 kHz model rate
+ *
+ * Taps per phase scale with M / L so the filter spans the same 16 output
+ * samples (and has the same transition band) at every rate.
+ */
+inline constexpr RationalRate kRatesTo16k[] = {
+    {  32000.0,   1,   2,  32 },
+    {  44100.0, 160, 441,  48 },
+    {  48000.0,   1,   3,  48 },
+    {  88200.0,  80, 441,  96 },
+    {  96000.0,   1,   6,  96 },
+    { 176400.0,  40, 441, 176 },
+    { 192000.0,   1,  12, 192 },
+};
+
+/**
+ * @brief Look up the 16 kHz conversion ratio for a host sample rate
+ *
+ * @return Matching table entry, or nullptr if the rate is not supported
+ */
+inline const RationalRate* findRateTo16k(double sampleRate)
+{
+    for (const auto& rate : kRatesTo16k) {
+        if (std::abs(rate.inputRate - sampleRate) < 1.0) {
+            return &rate;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Polyphase rational L/M resampler
+ *
+ * Converts between rates related by a rational factor (e.g. 160/441 for
+ * 44.1kHz -> 16kHz) without ever forming the upsampled signal: each output
+ * sample is a single tapsPerPhase-long dot product between one polyphase
+ * branch of the prototype lowpass and the newest input samples. The per-output
+ * cost is therefore the same as the integer PolyphaseDecimator with the same
+ * number of taps.
+ *
+ * All coefficient and history storage is sized at compile time, so configure()
+ * and the process calls never allocate. The coefficient store is bounded by
+ * the total L * tapsPerPhase rather than per dimension, since rates with many
+ * phases need few taps per phase and vice versa. configure() designs the
+ * filter and is meant to be called from setupProcessing(), not from the
+ * audio thread.
+ *
+ * Output sample n corresponds to input time n * M / L, delayed by
+ * getGroupDelay() output samples.
+ *
+ * @tparam MaxTapsPerPhase Capacity for taps per polyphase branch (multiple of 8)
+ * @tparam MaxCoefficients Capacity for L * tapsPerPhase
+ */
+template<int MaxTapsPerPhase = 192, int MaxCoefficients = 160 * 48>
+class RationalResampler
+{
+public:
+    static constexpr int kMaxTapsPerPhase = MaxTapsPerPhase;
+    static constexpr int kMaxCoefficients = MaxCoefficients;
+
+    static_assert(MaxTapsPerPhase > 0 && MaxTapsPerPhase % 8 == 0, "Taps per phase must be a positive multiple of 8");
+    static_assert(MaxCoefficients >= MaxTapsPerPhase, "Coefficient capacity must hold at least one phase");
+
+    RationalResampler()
+    {
+        configure(1, 3, 48);
+    }
+
+    /**
+     * @brief Configure for a host rate from the kRatesTo16k table
+     *
+     * @return false if the rate is not in the table (state is left unchanged)
+     */
+    bool configure(double sampleRate)
+    {
+        const RationalRate* rate = findRateTo16k(sampleRate);
+        if (!rate) {
+            return false;
+        }
+        return configure(rate->upFactor, rate->downFactor, rate->tapsPerPhase);
+    }
+
+    /**
+     * @brief Configure an arbitrary L/M ratio
+     *
+     * @param upFactor Interpolation factor L (>= 1)
+     * @param downFactor Decimation factor M (>= 1)
+     * @param tapsPerPhase Taps per branch, rounded up to a multiple of 8
+     * @param cutoffScale Cutoff relative to the lower of the two Nyquist rates
+     * @return false if the ratio exceeds the compile-time capacity
+     */
+    bool configure(int upFactor, int downFactor, int tapsPerPhase, double cutoffScale = 1.0)
+    {
+        tapsPerPhase = (tapsPerPhase + 7) / 8 * 8;
+
+        if (upFactor < 1 || downFactor < 1 ||
+            tapsPerPhase < 8 || tapsPerPhase > MaxTapsPerPhase ||
+            upFactor > MaxCoefficients / tapsPerPhase) {
+            return false;
+        }
+
+        upFactor_ = upFactor;
+        downFactor_ = downFactor;
+        tapsPerPhase_ = tapsPerPhase;
+        inputStep_ = downFactor / upFactor;
+        phaseStep_ = downFactor % upFactor;
+
+        designFilter(cutoffScale);
+        reset();
+        return true;
+    }
+
+    /**
+     * @brief Process stereo input and produce mono resampled output
+     *
+     * Double input is averaged and converted as it is copied into the
+     * filter window, so it needs no conversion buffer.
+     *
+     * @param leftInput Left channel input samples (float or double)
+     * @param rightInput Right channel input samples (float or double)
+     * @param output Output buffer, at least getOutputCount(numInputSamples) long
+     * @param numInputSamples Number of input samples per channel
+     * @return Number of output samples produced
+     */
+    template<typename SampleType>
+    int processStereoToMono(const SampleType* leftInput, const SampleType* rightInput,
+                           float* output, int numInputSamples)
+    {
+        return run(numInputSamples,
+                   [&](int i) { return detail::stereoToMono(leftInput[i], rightInput[i]); },
+                   [&](int k, float sample) { output[k] = sample; });
+    }
+
+    /**
+     * @brief Process stereo input straight into a pair of writable spans
+     *
+     * Same contract as PolyphaseDecimator::processStereoToMono() with spans:
+     * samples that do not fit are dropped but the filter state still advances.
+     */
+    template<typename SampleType, typename OutputSpans>
+    int processStereoToMono(const SampleType* leftInput, const SampleType* rightInput,
+                           const OutputSpans& output, int numInputSamples)
+    {
+        const size_t firstSize = output.first.size;
+        const size_t totalSize = firstSize + output.second.size;
+        const int produced = run(numInputSamples,
+            [&](int i) { return detail::stereoToMono(leftInput[i], rightInput[i]); },
+            [&](int k, float sample) {
+                const size_t index = static_cast<size_t>(k);
+                if (index < firstSize) {
+                    output.first.data[index] = sample;
+                } else if (index < totalSize) {
+                    output.second.data[index - firstSize] = sample;
+                }
+            });
+        return static_cast<int>(std::min(static_cast<size_t>(produced), totalSize));
+    }
+
+    /**
+     * @brief Process mono input and produce resampled output
+     */
+    int processMono(const float* input, float* output, int numInputSamples)
+    {
+        return run(numInputSamples,
+                   [&](int i) { return input[i]; },
+                   [&](int k, float sample) { output[k] = sample; });
+    }
+
+    /**
+     * @brief Reset the history and output phase
+     */
+    void reset()
+    {
+        window_.fill(0.0f);
+        phase_ = 0;
+    }
+
+    /**
+     * @brief Number of output samples the next call will produce
+     */
+    int getOutputCount(int numInputSamples) const
+    {
+        const int64_t span = static_cast<int64_t>(numInputSamples) * upFactor_;
+        if (span <= phase_) {
+            return 0;
+        }
+        return static_cast<int>((span - phase_ - 1) / downFactor_ + 1);
+    }
+
+    /**
+     * @brief Group delay of the prototype filter in output samples
+     *
+     * The prototype is symmetric around tap L * tapsPerPhase / 2 of the
+     * upsampled signal; the delay is fractional unless M divides that.
+     */
+    double getGroupDelay() const
+    {
+        return static_cast<double>(upFactor_) * tapsPerPhase_ / (2.0 * downFactor_);
+    }
+
+    int getUpFactor() const { return upFactor_; }
+    int getDownFactor() const { return downFactor_; }
+    int getTapsPerPhase() const { return tapsPerPhase_; }
+
+private:
+    // Input samples per internal block; larger blocks are processed in pieces
+    static constexpr int kBlockInputs = 512;
+
+    // Linear input window: tapsPerPhase_ - 1 samples of history followed by
+    // the current block, so every output's taps are one contiguous run
+    alignas(32) std::array<float, MaxTapsPerPhase - 1 + kBlockInputs> window_{};
+
+    // Polyphase branches, [phase][tapsPerPhase_], time-reversed so tap j
+    // multiplies the j-th oldest sample of the window
+    alignas(32) std::array<float, MaxCoefficients> polyphaseFilters_{};
+
+    int upFactor_ = 1;
+    int downFactor_ = 3;
+    int tapsPerPhase_ = 48;
+    int inputStep_ = 3;     // Whole inputs between outputs (M / L)
+    int phaseStep_ = 0;     // Remaining upsampled steps between outputs (M % L)
+
+    int phase_ = 0;         // Upsampled offset of the next output from the newest input
+
+    // Outputs queued for one firGather() call
+    static constexpr int kGatherOutputs = 64;
+    std::array<int, kGatherOutputs> coeffOffsets_{};
+    std::array<int, kGatherOutputs> sampleOffsets_{};
+    std::array<float, kGatherOutputs> gatherOutput_{};
+
+    /**
+     * @brief Resample numInputSamples samples a block at a time
+     *
+     * Each block is copied behind the history first, so the outputs only
+     * read memory and never wait on freshly stored samples. The (phase, input)
+     * pair of every output is queued and the dot products are run in batches
+     * of kGatherOutputs through one kernel call.
+     *
+     * @param sampleAt Returns input sample i
+     * @param emit Receives output index and value
+     * @return Number of output samples produced
+     */
+    template<typename SampleSource, typename OutputSink>
+    int run(int numInputSamples, SampleSource&& sampleAt, OutputSink&& emit)
+    {
+        const int history = tapsPerPhase_ - 1;
+        const DspKernels& kernels = getDspKernels();
+        int outputCount = 0;
+        int pending = 0;
+
+        auto flush = [&]() {
+            kernels.firGather(polyphaseFilters_.data(), coeffOffsets_.data(),
+                              window_.data(), sampleOffsets_.data(),
+                              tapsPerPhase_, gatherOutput_.data(), pending);
+            for (int k = 0; k < pending; ++k) {
+                emit(outputCount++, gatherOutput_[k]);
+            }
+            pending = 0;
+        };
+
+        for (int offset = 0; offset < numInputSamples; offset += kBlockInputs) {
+            const int count = std::min(kBlockInputs, numInputSamples - offset);
+
+            float* block = window_.data() + history;
+            for (int i = 0; i < count; ++i) {
+                block[i] = sampleAt(offset + i);
+            }
+
+            // Walk the outputs rather than the inputs: each output advances
+            // M upsampled steps, i.e. skip whole inputs plus step phases, and
+            // the branchless wrap keeps the irregular L/M pattern from costing
+            // a mispredict per output. Input i is the newest sample of the
+            // window starting at i.
+            int i = phase_ / upFactor_;
+            int phase = phase_ % upFactor_;
+            while (i < count) {
+                coeffOffsets_[pending] = phase * tapsPerPhase_;
+                sampleOffsets_[pending] = i;
+                if (++pending == kGatherOutputs) {
+                    flush();
+                }
+                phase += phaseStep_;
+                const int wrap = phase >= upFactor_ ? 1 : 0;
+                phase -= wrap * upFactor_;
+                i += inputStep_ + wrap;
+            }
+            phase_ = (i - count) * upFactor_ + phase;
+            flush();
+
+            std::memmove(window_.data(), window_.data() + count, history * sizeof(float));
+        }
+
+        return outputCount;
+    }
+
+    /**
+     * @brief Design the Blackman-windowed sinc prototype and split it into phases
+     *
+     * The prototype has L * tapsPerPhase taps at the upsampled rate, is
+     * centred on its middle tap with a zero first tap (exactly symmetric), and
+     * is scaled by L to make up for the zero-stuffing.
+     */
+    void designFilter(double cutoffScale)
+    {
+        const int length = upFactor_ * tapsPerPhase_;
+        const double fc = std::min(cutoffScale, 1.0) / std::max(upFactor_, downFactor_);
+
+        auto prototype = [length, fc](int n) {
+            if (n == 0) {
+                return 0.0;
+            }
+            int m = n - length / 2;
+            double h = (m == 0) ? fc : std::sin(M_PI * fc * m) / (M_PI * m);
+            return h * (0.42 - 0.5 * std::cos(2.0 * M_PI * n / length)
+                             + 0.08 * std::cos(4.0 * M_PI * n / length));
+        };
+
+        double sum = 0.0;
+        for (int n = 0; n < length; ++n) {
+            sum += prototype(n);
+        }
+        const double gain = upFactor_ / sum;
+
+        for (int phase = 0; phase < upFactor_; ++phase) {
+            float* row = polyphaseFilters_.data() + phase * tapsPerPhase_;
+            for (int j = 0; j < tapsPerPhase_; ++j) {
+                row[tapsPerPhase_ - 1 - j] = static_cast<float>(prototype(phase + j * upFactor_) * gain);
+            }
+        }
+    }
+};
+
+/**
+ * @brief Resampler sized for every rate in kRatesTo16k
+ */
+using ResamplerTo16k = RationalResampler<192, 160 * 48>;
+
+} // namespace KhDetector
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "DspKernels.h"
+#include "FilterDesign.h"
+
+#include <array>
+#include <cmath>
+
+namespace KhDetector {
+
+namespace detail {
+
+constexpr int nextPowerOfTwo(int value)
+{
+    int size = 1;
+    while (size < value) {
+        size <<= 1;
+    }
+    return size;
+}
+
+/**
+ * @brief Real-input FFT of a fixed power-of-two size
+ *
+ * forward() turns Size real samples into the Size / 2 + 1 non-redundant
+ * bins; inverse() takes them back, scaled by Size / 2. Both run a complex FFT
+ * of half the size on the even/odd samples packed as real/imaginary parts
+ * and untangle the two halves with one pass of twiddles. The bit-reversal
+ * and twiddle tables are shared by every instance of a size and are built on
+ * first construction; the transforms themselves never allocate.
+ */
+template<int Size>
+class RealFft
+{
+public:
+    static constexpr int kSize = Size;
+    static constexpr int kNumBins = Size / 2 + 1;
+
+    static_assert(Size >= 16 && (Size & (Size - 1)) == 0, "FFT size must be a power of two of at least 16");
+
+    RealFft()
+        : tables_(&tables())
+    {
+    }
+
+    /**
+     * @brief Spectrum of Size real samples into kNumBins bins (split real/imaginary)
+     */
+    void forward(const float* input, float* re, float* im)
+    {
+        // Even samples as real, odd as imaginary parts, in bit-reversed order
+        const int* bitReverse = tables_->bitReverse.data();
+        for (int n = 0; n < kHalf; ++n) {
+            zRe_[bitReverse[n]] = input[2 * n];
+            zIm_[bitReverse[n]] = input[2 * n + 1];
+        }
+        transform(false);
+
+        // X[k] = E[k] + W^k O[k] and X[N/2 - k] = conj(E[k] - W^k O[k]), with E
+        // and O the spectra of the even and odd samples
+        re[0] = zRe_[0] + zIm_[0];
+        im[0] = 0.0f;
+        re[kHalf] = zRe_[0] - zIm_[0];
+        im[kHalf] = 0.0f;
+        for (int k = 1; k <= kHalf / 2; ++k) {
+            const int j = kHalf - k;
+            const float evenRe = 0.5f * (zRe_[k] + zRe_[j]);
+            const float evenIm = 0.5f * (zIm_[k] - zIm_[j]);
+            const float oddRe = 0.5f * (zIm_[k] + zIm_[j]);
+            const float oddIm = -0.5f * (zRe_[k] - zRe_[j]);
+            const float wRe = tables_->splitRe[k];
+            const float wIm = tables_->splitIm[k];
+            const float tRe = wRe * oddRe - wIm * oddIm;
+            const float tIm = wRe * oddIm + wIm * oddRe;
+            re[k] = evenRe + tRe;
+            im[k] = evenIm + tIm;
+            re[j] = evenRe - tRe;
+            im[j] = tIm - evenIm;
+        }
+    }
+
+    /**
+     * @brief Size real samples, scaled by Size / 2, from kNumBins bins
+     */
+    void inverse(const float* re, const float* im, float* output)
+    {
+        // Undo the even/odd split (inverse of the loop in forward()), writing
+        // the half-size spectrum in bit-reversed order
+        const int* bitReverse = tables_->bitReverse.data();
+        for (int k = 0; k <= kHalf / 2; ++k) {
+            const int j = kHalf - k;
+            const float evenRe = 0.5f * (re[k] + re[j]);
+            const float evenIm = 0.5f * (im[k] - im[j]);
+            const float diffRe = 0.5f * (re[k] - re[j]);
+            const float diffIm = 0.5f * (im[k] + im[j]);
+            const float wRe = tables_->splitRe[k];
+            const float wIm = tables_->splitIm[k];
+            const float oddRe = diffRe * wRe + diffIm * wIm;
+            const float oddIm = diffIm * wRe - diffRe * wIm;
+            zRe_[bitReverse[k]] = evenRe - oddIm;
+            zIm_[bitReverse[k]] = evenIm + oddRe;
+            if (k != 0 && k != j) {
+                // Bin N/2 - k: E -> conj(E), O -> -conj(O)
+                zRe_[bitReverse[j]] = evenRe + oddIm;
+                zIm_[bitReverse[j]] = oddRe - evenIm;
+            }
+        }
+        transform(true);
+
+        for (int n = 0; n < kHalf; ++n) {
+            output[2 * n] = zRe_[n];
+            output[2 * n + 1] = zIm_[n];
+        }
+    }
+
+private:
+    static constexpr int kHalf = Size / 2;
+
+    struct Tables
+    {
+        std::array<int, kHalf> bitReverse;
+        // Per-stage twiddles exp(-2 pi i k / (2h)), k < h, stored from offset h - 1
+        std::array<float, kHalf> twiddleRe;
+        std::array<float, kHalf> twiddleImForward;
+        std::array<float, kHalf> twiddleImInverse;
+        // exp(-2 pi i k / Size) for the even/odd split
+        std::array<float, kHalf + 1> splitRe;
+        std::array<float, kHalf + 1> splitIm;
+    };
+
+    const Tables* tables_;
+    alignas(32) std::array<float, kHalf> zRe_;
+    alignas(32) std::array<float, kHalf> zIm_;
+
+    static const Tables& tables()
+    {
+        static const Tables table = [] {
+            Tables t{};
+            int bits = 0;
+            while ((1 << bits) < kHalf) {
+                ++bits;
+            }
+            for (int i = 0; i < kHalf; ++i) {
+                int reversed = 0;
+                for (int b = 0; b < bits; ++b) {
+                    reversed |= ((i >> b) & 1) << (bits - 1 - b);
+                }
+                t.bitReverse[i] = reversed;
+            }
+            for (int h = 1; h < kHalf; h <<= 1) {
+                for (int k = 0; k < h; ++k) {
+                    const double angle = -constmath::kPi * k / h;
+                    t.twiddleRe[h - 1 + k] = static_cast<float>(std::cos(angle));
+                    t.twiddleImForward[h - 1 + k] = static_cast<float>(std::sin(angle));
+                    t.twiddleImInverse[h - 1 + k] = static_cast<float>(-std::sin(angle));
+                }
+            }
+            for (int k = 0; k <= kHalf; ++k) {
+                const double angle = -2.0 * constmath::kPi * k / Size;
+                t.splitRe[k] = static_cast<float>(std::cos(angle));
+                t.splitIm[k] = static_cast<float>(std::sin(angle));
+            }
+            return t;
+        }();
+        return table;
+    }
+
+    /**
+     * @brief Unscaled in-place radix-2 complex FFT of zRe_/zIm_, input in bit-reversed order
+     *
+     * The first two stages only need twiddles of 1 and -i (i for the
+     * inverse), so they run as one multiply-free radix-4 pass, and the third
+     * keeps its four twiddles in registers; every later stage has at least 8
+     * butterflies per group and runs through DspKernels::fftButterflies().
+     */
+    void transform(bool inverse)
+    {
+        float* re = zRe_.data();
+        float* im = zIm_.data();
+
+        const float sign = inverse ? -1.0f : 1.0f;
+        for (int start = 0; start < kHalf; start += 4) {
+            float* r = re + start;
+            float* m = im + start;
+            const float r0 = r[0] + r[1], m0 = m[0] + m[1];
+            const float r1 = r[0] - r[1], m1 = m[0] - m[1];
+            const float r2 = r[2] + r[3], m2 = m[2] + m[3];
+            // (r[2] - r[3], m[2] - m[3]) times -i (forward) or i (inverse)
+            const float r3 = sign * (m[2] - m[3]), m3 = -sign * (r[2] - r[3]);
+            r[0] = r0 + r2;
+            m[0] = m0 + m2;
+            r[2] = r0 - r2;
+            m[2] = m0 - m2;
+            r[1] = r1 + r3;
+            m[1] = m1 + m3;
+            r[3] = r1 - r3;
+            m[3] = m1 - m3;
+        }
+
+        const float* twiddleIm = inverse ? tables_->twiddleImInverse.data() : tables_->twiddleImForward.data();
+        float wRe[4];
+        float wIm[4];
+        for (int k = 0; k < 4; ++k) {
+            wRe[k] = tables_->twiddleRe[3 + k];
+            wIm[k] = twiddleIm[3 + k];
+        }
+        for (int start = 0; start < kHalf; start += 8) {
+            float* aRe = re + start;
+            float* aIm = im + start;
+            for (int k = 0; k < 4; ++k) {
+                const float tRe = aRe[k + 4] * wRe[k] - aIm[k + 4] * wIm[k];
+                const float tIm = aRe[k + 4] * wIm[k] + aIm[k + 4] * wRe[k];
+                aRe[k + 4] = aRe[k] - tRe;
+                aIm[k + 4] = aIm[k] - tIm;
+                aRe[k] += tRe;
+                aIm[k] += tIm;
+            }
+        }
+
+        const DspKernels& kernels = getDspKernels();
+        for (int h = 8; h < kHalf; h <<= 1) {
+            kernels.fftButterflies(re, im, tables_->twiddleRe.data() + h - 1, twiddleIm + h - 1, kHalf, h);
+        }
+    }
+};
+
+} // namespace detail
+
+} // namespace KhDetector
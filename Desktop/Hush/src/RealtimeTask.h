@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace KhDetector {
+
+/**
+ * @brief Move-only void() callable that keeps its captures inline
+ *
+ * Stands in for std::function where a task is created on the audio thread:
+ * the callable is stored in a fixed buffer inside the task, so constructing,
+ * moving and destroying one never allocates. A callable whose captures do not
+ * fit is a compile error rather than a silent heap allocation; capture a
+ * pointer or an index into preallocated storage instead of a container.
+ * A whole task is one cache line.
+ */
+class RealtimeTask
+{
+public:
+    static constexpr size_t kCapacity = 48;    // Bytes of captures
+
+    RealtimeTask() noexcept = default;
+    RealtimeTask(std::nullptr_t) noexcept {}
+
+    template<typename F,
+             typename Fn = std::decay_t<F>,
+             typename = std::enable_if_t<!std::is_same<Fn, RealtimeTask>::value && std::is_invocable<Fn&>::value>>
+    RealtimeTask(F&& function) noexcept(std::is_nothrow_constructible<Fn, F&&>::value)
+    {
+        static_assert(sizeof(Fn) <= kCapacity, "Task captures too large for RealtimeTask; capture a pointer instead");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t), "Task captures over-aligned for RealtimeTask");
+        static_assert(std::is_nothrow_move_constructible<Fn>::value, "Task captures must be nothrow movable");
+        ::new (static_cast<void*>(mStorage)) Fn(std::forward<F>(function));
+        mOps = &OpsFor<Fn>::kOps;
+    }
+
+    RealtimeTask(RealtimeTask&& other) noexcept
+    {
+        moveFrom(other);
+    }
+
+    RealtimeTask& operator=(RealtimeTask&& other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    RealtimeTask(const RealtimeTask&) = delete;
+    RealtimeTask& operator=(const RealtimeTask&) = delete;
+
+    ~RealtimeTask() { reset(); }
+
+    /**
+     * @brief Destroy the callable, leaving an empty task
+     */
+    void reset() noexcept
+    {
+        if (mOps) {
+            mOps->destroy(mStorage);
+            mOps = nullptr;
+        }
+    }
+
+    explicit operator bool() const noexcept { return mOps != nullptr; }
+
+    /**
+     * @brief Run the callable (must not be empty)
+     */
+    void operator()() { mOps->invoke(mStorage); }
+
+private:
+    struct Ops
+    {
+        void (*invoke)(void* storage);
+        void (*relocate)(void* destination, void* source) noexcept;    // Move-construct, then destroy the source
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template<typename Fn>
+    struct OpsFor
+    {
+        static void invoke(void* storage) { (*static_cast<Fn*>(storage))(); }
+
+        static void relocate(void* destination, void* source) noexcept
+        {
+            Fn* from = static_cast<Fn*>(source);
+            ::new (destination) Fn(std::move(*from));
+            from->~Fn();
+        }
+
+        static void destroy(void* storage) noexcept { static_cast<Fn*>(storage)->~Fn(); }
+
+        static constexpr Ops kOps = { &invoke, &relocate, &destroy };
+    };
+
+    void moveFrom(RealtimeTask& other) noexcept
+    {
+        if (other.mOps) {
+            other.mOps->relocate(mStorage, other.mStorage);
+            mOps = other.mOps;
+            other.mOps = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char mStorage[kCapacity];
+    const Ops* mOps = nullptr;
+};
+
+static_assert(sizeof(RealtimeTask) <= 64, "RealtimeTask should fit a cache line");
+
+} // namespace KhDetector
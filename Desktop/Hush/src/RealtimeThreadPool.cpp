@@ -3,6 +3,10 @@
 #include <iostream>
 #include <cmath>
 
+#if defined(__linux__)
+    #include <unistd.h>
+#endif
+
 namespace KhDetector {
 
 // Thread-local storage for processing buffers
@@ -17,12 +21,12 @@ RealtimeThreadPool::RealtimeThreadPool(int numThreads, Priority priority, int fr
     : mFrameSize(frameSize)
     , mPriority(priority)
     , mProcessingIntervalMs(20)
+    , mScheduler(clampThreadCount(numThreads) - 1)
+    , mAssembler(frameSize)
     , mLastStatsUpdate(std::chrono::steady_clock::now())
     , mLastProcessingTime(std::chrono::steady_clock::now())
 {
-    // Ensure we have at least 1 thread but not more than hardware threads - 1
-    int maxThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
-    numThreads = std::clamp(numThreads, 1, maxThreads);
+    numThreads = clampThreadCount(numThreads);
     
     mWorkerThreads.reserve(numThreads);
     
@@ -49,9 +53,41 @@ void RealtimeThreadPool::start(RingBuffer<float, 2048>* ringBuffer,
         return;
     }
     
+    launch(ringBuffer, aiInference, nullptr, processingIntervalMs);
+}
+
+void RealtimeThreadPool::start(RingBuffer<float, 2048>* ringBuffer,
+                               std::shared_ptr<const ModelHandle> model,
+                               int processingIntervalMs)
+{
+    if (mRunning.load()) {
+        std::cout << "RealtimeThreadPool: Already running" << std::endl;
+        return;
+    }
+    
+    if (!ringBuffer || !model) {
+        std::cout << "RealtimeThreadPool: Invalid ring buffer or model handle" << std::endl;
+        return;
+    }
+    
+    // The AI thread picks the engine up from the handle once it is published
+    launch(ringBuffer, nullptr, std::move(model), processingIntervalMs);
+}
+
+void RealtimeThreadPool::launch(RingBuffer<float, 2048>* ringBuffer,
+                                AiInference* aiInference,
+                                std::shared_ptr<const ModelHandle> model,
+                                int processingIntervalMs)
+{
     mRingBuffer = ringBuffer;
     mAiInference = aiInference;
+    mModel = std::move(model);
     mProcessingIntervalMs = processingIntervalMs;
+    mAssembler.reset();
+    mCommittedSamples = 0;
+    mFrameNotifications.store(false);
+    while (mFrameReady.tryWait()) {
+    }
     mRunning.store(true);
     mShouldStop.store(false);
     
@@ -62,12 +98,13 @@ void RealtimeThreadPool::start(RingBuffer<float, 2048>* ringBuffer,
             mWorkerThreads.emplace_back(&RealtimeThreadPool::aiProcessingThreadMain, this);
         } else {
             // Other threads are general purpose workers
-            mWorkerThreads.emplace_back(&RealtimeThreadPool::workerThreadMain, this);
+            mWorkerThreads.emplace_back(&RealtimeThreadPool::workerThreadMain, this, static_cast<int>(i) - 1);
         }
     }
     
     std::cout << "RealtimeThreadPool: Started with " << mWorkerThreads.size() 
-              << " threads, processing interval: " << processingIntervalMs << "ms" << std::endl;
+              << " threads, processing interval: " << processingIntervalMs << "ms"
+              << (getEngine() ? "" : " (model loading)") << std::endl;
 }
 
 void RealtimeThreadPool::stop()
@@ -82,7 +119,8 @@ void RealtimeThreadPool::stop()
     mRunning.store(false);
     
     // Wake up all waiting threads
-    mTaskCondition.notify_all();
+    mScheduler.wakeAll();
+    mFrameReady.post();
     
     // Wait for all threads to finish
     for (auto& thread : mWorkerThreads) {
@@ -94,12 +132,7 @@ void RealtimeThreadPool::stop()
     mWorkerThreads.clear();
     
     // Clear any remaining tasks
-    {
-        std::lock_guard<std::mutex> lock(mTaskMutex);
-        while (!mTaskQueue.empty()) {
-            mTaskQueue.pop();
-        }
-    }
+    mScheduler.clear();
     
     std::cout << "RealtimeThreadPool: Stopped" << std::endl;
 }
@@ -110,22 +143,7 @@ bool RealtimeThreadPool::submitTask(Task task)
         return false;
     }
     
-    {
-        std::lock_guard<std::mutex> lock(mTaskMutex);
-        if (mTaskQueue.size() >= kMaxQueueSize) {
-            return false; // Queue is full
-        }
-        mTaskQueue.push(std::move(task));
-    }
-    
-    mTaskCondition.notify_one();
-    return true;
-}
-
-size_t RealtimeThreadPool::getQueueSize() const
-{
-    std::lock_guard<std::mutex> lock(mTaskMutex);
-    return mTaskQueue.size();
+    return mScheduler.submit(std::move(task)); // false if the queue is full
 }
 
 void RealtimeThreadPool::resetStatistics()
@@ -133,8 +151,8 @@ void RealtimeThreadPool::resetStatistics()
     mStats.framesProcessed.store(0);
     mStats.totalProcessingTimeUs.store(0);
     mStats.droppedFrames.store(0);
-    mStats.averageProcessingTimeMs.store(0.0);
-    mStats.cpuUsagePercent.store(0.0);
+    mStats.gatedFrames.store(0);
+    mStats.unreadyFrames.store(0);
     mLastStatsUpdate = std::chrono::steady_clock::now();
 }
 
@@ -150,6 +168,13 @@ int RealtimeThreadPool::getOptimalThreadCount()
     return std::min(hardwareThreads - 1, 6);
 }
 
+int RealtimeThreadPool::clampThreadCount(int numThreads)
+{
+    // Ensure we have at least 1 thread but not more than hardware threads - 1
+    int maxThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    return std::clamp(numThreads, 1, maxThreads);
+}
+
 void RealtimeThreadPool::setThreadPriority(Priority priority)
 {
     try {
@@ -228,7 +253,7 @@ void RealtimeThreadPool::setThreadPriority(Priority priority)
     }
 }
 
-void RealtimeThreadPool::workerThreadMain()
+void RealtimeThreadPool::workerThreadMain(int worker)
 {
     // Set thread priority
     setThreadPriority(mPriority);
@@ -240,24 +265,15 @@ void RealtimeThreadPool::workerThreadMain()
     
     std::cout << "RealtimeThreadPool: Worker thread started" << std::endl;
     
+    mScheduler.bindWorker(worker);
+    
     while (!mShouldStop.load()) {
         Task task;
         
-        // Wait for a task
-        {
-            std::unique_lock<std::mutex> lock(mTaskMutex);
-            mTaskCondition.wait(lock, [this] { 
-                return mShouldStop.load() || !mTaskQueue.empty(); 
-            });
-            
-            if (mShouldStop.load()) {
-                break;
-            }
-            
-            if (!mTaskQueue.empty()) {
-                task = std::move(mTaskQueue.front());
-                mTaskQueue.pop();
-            }
+        // Own deque, then the injection queue, then steal; sleep if all are empty
+        if (!mScheduler.take(worker, task)) {
+            mScheduler.waitForWork();
+            continue;
         }
         
         // Execute the task
@@ -278,61 +294,76 @@ void RealtimeThreadPool::aiProcessingThreadMain()
     // Set thread priority
     setThreadPriority(mPriority);
     
-    // Initialize thread-local processing buffer
-    if (tProcessingFrame.size() != static_cast<size_t>(mFrameSize)) {
-        tProcessingFrame.resize(mFrameSize);
-    }
-    
     std::cout << "RealtimeThreadPool: AI processing thread started" << std::endl;
     
     while (!mShouldStop.load()) {
-        if (!shouldProcessNextFrame()) {
-            // Wait a bit before checking again
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        const bool notified = mFrameNotifications.load(std::memory_order_relaxed);
+        const size_t samplesNeeded = mAssembler.getSamplesNeeded();
+        const bool frameAvailable = mRingBuffer && mRingBuffer->size() >= samplesNeeded;
+        
+        if (!frameAvailable && notified) {
+            // Sleep until the audio thread completes a frame (or stop() wakes us)
+            mFrameReady.wait();
             continue;
         }
         
-        // Try to get a frame from the ring buffer
-        if (mRingBuffer && mRingBuffer->size() >= static_cast<size_t>(mFrameSize)) {
+        if (!notified && (!frameAvailable || !shouldProcessNextFrame())) {
+            // Producer does not notify: poll, one frame per processing interval
+            mFrameReady.waitFor(std::chrono::milliseconds(1));
+            continue;
+        }
+        
+        // Move the new hop from the ring buffer into the frame history
+        {
             auto startTime = std::chrono::high_resolution_clock::now();
             
-            // Pop frame from ring buffer
-            size_t samplesPopped = mRingBuffer->pop_bulk(tProcessingFrame.data(), mFrameSize);
+            mAssembler.commit(mRingBuffer->pop_bulk(mAssembler.getWritePointer(), samplesNeeded));
             
-            if (samplesPopped == static_cast<size_t>(mFrameSize)) {
+            FrameAssembler::Frame frame;
+            if (!mAssembler.nextFrame(frame)) {
+                continue;
+            }
+            
+            AiInference* engine = getEngine();
+            if (!engine) {
+                // Model still loading: keep the ring buffer flowing
+                mStats.unreadyFrames.fetch_add(1);
+            } else {
+                const LatencyMonitor::Clock::duration queueWait = measureQueueWait();
+                
                 // Process the frame
-                processAudioFrame(tProcessingFrame.data(), mFrameSize);
+                processAudioFrame(*engine, frame);
                 
                 auto endTime = std::chrono::high_resolution_clock::now();
                 auto processingTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
+                if (mLatencyMonitor) {
+                    mLatencyMonitor->record(LatencyStage::EndToEnd, queueWait + processingTime);
+                }
                 
                 updateStatistics(processingTime);
-                mLastProcessingTime = endTime;
-            } else {
-                // Not enough samples available
-                mStats.droppedFrames.fetch_add(1);
+                mLastProcessingTime = std::chrono::steady_clock::now();
             }
-        } else {
-            // Ring buffer is empty or doesn't have enough samples
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
         }
     }
     
     std::cout << "RealtimeThreadPool: AI processing thread finished" << std::endl;
 }
 
-void RealtimeThreadPool::processAudioFrame(const float* frameData, int frameSize)
+void RealtimeThreadPool::processAudioFrame(AiInference& engine, const FrameAssembler::Frame& frame)
 {
-    if (!mAiInference || !frameData || frameSize <= 0) {
+    if (!frame.samples || frame.numSamples <= 0) {
         return;
     }
     
     try {
         // Run AI inference on the audio frame
-        auto result = mAiInference->run(frameData, frameSize);
+        auto result = engine.run(frame.samples, frame.numSamples);
         
         if (result.success) {
             mStats.framesProcessed.fetch_add(1);
+            if (result.gated) {
+                mStats.gatedFrames.fetch_add(1);
+            }
             
             // For demonstration, we could log significant results
             if (result.confidence > 0.8f) {
@@ -347,20 +378,54 @@ void RealtimeThreadPool::processAudioFrame(const float* frameData, int frameSize
     }
 }
 
-void RealtimeThreadPool::updateStatistics(std::chrono::microseconds processingTime)
+void RealtimeThreadPool::notifyInputCommitted(size_t numSamples) noexcept
 {
-    auto totalTime = mStats.totalProcessingTimeUs.fetch_add(processingTime.count()) + processingTime.count();
-    auto totalFrames = mStats.framesProcessed.load();
+    // Frames end on multiples of the hop
+    const uint64_t hopSize = static_cast<uint64_t>(mAssembler.getHop());
+    const uint64_t framesBefore = mCommittedSamples / hopSize;
+    mCommittedSamples += numSamples;
+    const uint64_t framesCompleted = mCommittedSamples / hopSize - framesBefore;
+    if (framesCompleted == 0) {
+        return;
+    }
     
-    if (totalFrames > 0) {
-        double avgTimeMs = static_cast<double>(totalTime) / (totalFrames * 1000.0);
-        mStats.averageProcessingTimeMs.store(avgTimeMs);
-        
-        // Calculate CPU usage percentage
-        double expectedTimeMs = static_cast<double>(mProcessingIntervalMs);
-        double cpuUsage = (avgTimeMs / expectedTimeMs) * 100.0;
-        mStats.cpuUsagePercent.store(std::min(cpuUsage, 100.0));
+    if (!mFrameNotifications.load(std::memory_order_relaxed)) {
+        mFrameNotifications.store(true, std::memory_order_relaxed);
+    }
+    mFrameReady.post(static_cast<int>(framesCompleted));
+}
+
+LatencyMonitor::Clock::duration RealtimeThreadPool::measureQueueWait()
+{
+    if (!mLatencyMonitor) {
+        return LatencyMonitor::Clock::duration::zero();
+    }
+    
+    const auto lastInput = mLatencyMonitor->getLastInputTime();
+    if (lastInput.time_since_epoch().count() == 0) {
+        return LatencyMonitor::Clock::duration::zero();
     }
+    
+    // Samples still queued arrived after this frame's newest one, at one frame per interval
+    const double samplesPerSecond = mFrameSize * 1000.0 / std::max(1, mProcessingIntervalMs);
+    const auto queuedBehind = std::chrono::duration_cast<LatencyMonitor::Clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(mRingBuffer->size()) / samplesPerSecond));
+    const auto wait = std::max(LatencyMonitor::Clock::duration::zero(),
+                               LatencyMonitor::Clock::now() - lastInput) + queuedBehind;
+    
+    mLatencyMonitor->record(LatencyStage::QueueWait, wait);
+    return wait;
+}
+
+void RealtimeThreadPool::updateStatistics(std::chrono::microseconds processingTime)
+{
+    mStats.totalProcessingTimeUs.fetch_add(static_cast<uint64_t>(processingTime.count()));
+}
+
+double RealtimeThreadPool::getCpuUsagePercent() const
+{
+    const double cpuUsage = mStats.getAverageProcessingTimeMs() / std::max(1, mProcessingIntervalMs) * 100.0;
+    return std::min(cpuUsage, 100.0);
 }
 
 bool RealtimeThreadPool::shouldProcessNextFrame()
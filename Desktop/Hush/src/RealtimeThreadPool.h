@@ -3,10 +3,6 @@
 #include <thread>
 #include <vector>
 #include <atomic>
-#include <mutex>
-#include <condition_variable>
-#include <functional>
-#include <queue>
 #include <chrono>
 
 // Platform-specific includes for thread priority
@@ -24,6 +20,12 @@
 
 #include "RingBuffer.h"
 #include "AiInference.h"
+#include "FrameAssembler.h"
+#include "LatencyHistogram.h"
+#include "LightweightSemaphore.h"
+#include "ModelLoader.h"
+#include "RealtimeTask.h"
+#include "TaskScheduler.h"
 
 namespace KhDetector {
 
@@ -40,8 +42,11 @@ class RealtimeThreadPool
 public:
     /**
      * @brief Task function type
+     * 
+     * Captures are stored inline (at most RealtimeTask::kCapacity bytes), so
+     * creating a task on the audio thread does not allocate.
      */
-    using Task = std::function<void()>;
+    using Task = RealtimeTask;
 
     /**
      * @brief Thread priority levels
@@ -93,6 +98,21 @@ public:
                AiInference* aiInference,
                int processingIntervalMs = 20);
 
+    /**
+     * @brief Start the thread pool on an engine that may still be loading
+     * 
+     * Frames that arrive before the handle publishes its engine are
+     * consumed and discarded (counted in unreadyFrames), so the ring
+     * buffer keeps flowing; the first frame after the swap goes to the model.
+     * 
+     * @param ringBuffer Ring buffer to process frames from
+     * @param model Handle from ModelLoader::load()
+     * @param processingIntervalMs Interval between processing batches (default: 20ms)
+     */
+    void start(RingBuffer<float, 2048>* ringBuffer,
+               std::shared_ptr<const ModelHandle> model,
+               int processingIntervalMs = 20);
+
     /**
      * @brief Stop the thread pool gracefully
      */
@@ -116,12 +136,26 @@ public:
         std::atomic<uint64_t> framesProcessed{0};
         std::atomic<uint64_t> totalProcessingTimeUs{0};
         std::atomic<uint64_t> droppedFrames{0};
-        std::atomic<double> averageProcessingTimeMs{0.0};
-        std::atomic<double> cpuUsagePercent{0.0};
+        std::atomic<uint64_t> gatedFrames{0};      // Processed frames the activity gate kept from the model
+        std::atomic<uint64_t> unreadyFrames{0};    // Discarded while the model was still loading
+
+        /**
+         * @brief Derived on read from the counters, which workers only ever add to
+         */
+        double getAverageProcessingTimeMs() const
+        {
+            const uint64_t frames = framesProcessed.load();
+            return frames > 0 ? static_cast<double>(totalProcessingTimeUs.load()) / (frames * 1000.0) : 0.0;
+        }
     };
 
     const Statistics& getStatistics() const { return mStats; }
 
+    /**
+     * @brief Average processing time as a share of the processing interval, at most 100
+     */
+    double getCpuUsagePercent() const;
+
     /**
      * @brief Reset statistics counters
      */
@@ -130,6 +164,10 @@ public:
     /**
      * @brief Submit a custom task to the thread pool
      * 
+     * Safe on the audio thread: no lock, no allocation, and no system call
+     * unless a worker is asleep (see TaskScheduler). Tasks submitted from a
+     * task run on the same worker unless an idle one steals them.
+     * 
      * @param task Task to execute
      * @return true if task was queued, false if queue is full
      */
@@ -138,7 +176,43 @@ public:
     /**
      * @brief Get current task queue size
      */
-    size_t getQueueSize() const;
+    size_t getQueueSize() const { return mScheduler.size(); }
+
+    /**
+     * @brief Record queue wait and end-to-end latency of every frame
+     * 
+     * The wait of a frame is the age of its newest sample when the frame
+     * is popped: the time since the audio thread last committed input
+     * (LatencyMonitor::markInputCommitted()) plus the samples still queued
+     * behind it at the pool's frame rate. End to end adds the processing
+     * time up to the result. Set before start().
+     */
+    void setLatencyMonitor(std::shared_ptr<LatencyMonitor> monitor) { mLatencyMonitor = std::move(monitor); }
+
+    /**
+     * @brief Tell the pool that the producer committed samples to the ring buffer (audio thread)
+     * 
+     * Posts the AI thread's semaphore once per frame boundary crossed, so it
+     * sleeps until a whole frame is there and starts on it right away. The
+     * post is wait-free unless the AI thread is asleep, and then costs one
+     * kernel call. Once a producer notifies, the pool no longer polls the
+     * ring buffer or spaces frames by the processing interval; producers
+     * that never call this are still polled every millisecond.
+     */
+    void notifyInputCommitted(size_t numSamples) noexcept;
+
+    /**
+     * @brief Samples between the starts of consecutive frames (any thread)
+     * 
+     * Frames are frameSize samples long and start every hopSize samples:
+     * frameSize / 2 gives the 50% overlap the plugin runs with, frameSize
+     * disjoint frames (the default). The hop must divide the frame size and
+     * takes effect at the next frame boundary that is a multiple of it.
+     * 
+     * @return false if hopSize does not divide the frame size
+     */
+    bool setHopSize(int hopSize) { return mAssembler.setHop(hopSize); }
+    int getHopSize() const { return mAssembler.getHop(); }
 
 private:
     // Configuration
@@ -151,15 +225,20 @@ private:
     std::atomic<bool> mRunning{false};
     std::atomic<bool> mShouldStop{false};
     
-    // Task queue
-    mutable std::mutex mTaskMutex;
-    std::condition_variable mTaskCondition;
-    std::queue<Task> mTaskQueue;
-    static constexpr size_t kMaxQueueSize = 64;
+    // Task queues, one deque per worker (every thread but the AI thread)
+    TaskScheduler mScheduler;
     
     // Audio processing
     RingBuffer<float, 2048>* mRingBuffer = nullptr;
     AiInference* mAiInference = nullptr;
+    std::shared_ptr<const ModelHandle> mModel;
+    std::shared_ptr<LatencyMonitor> mLatencyMonitor;
+    FrameAssembler mAssembler;                      // AI thread, apart from the hop
+    
+    // Frame hand-off from the audio thread
+    LightweightSemaphore mFrameReady;
+    std::atomic<bool> mFrameNotifications{false};  // Producer notifies; no polling
+    uint64_t mCommittedSamples = 0;                 // Audio thread only
     
     // Statistics
     mutable Statistics mStats;
@@ -173,15 +252,26 @@ private:
      */
     static int getOptimalThreadCount();
     
+    /**
+     * @brief Limit a requested thread count to 1..CPU_CORES-1
+     */
+    static int clampThreadCount(int numThreads);
+    
     /**
      * @brief Set thread priority for current thread
      */
     void setThreadPriority(Priority priority);
     
+    /**
+     * @brief Spawn the threads on an engine or a model handle
+     */
+    void launch(RingBuffer<float, 2048>* ringBuffer, AiInference* aiInference,
+                std::shared_ptr<const ModelHandle> model, int processingIntervalMs);
+    
     /**
      * @brief Main worker thread function
      */
-    void workerThreadMain();
+    void workerThreadMain(int worker);
     
     /**
      * @brief Main AI processing thread function
@@ -191,7 +281,17 @@ private:
     /**
      * @brief Process a single audio frame with AI inference
      */
-    void processAudioFrame(const float* frameData, int frameSize);
+    void processAudioFrame(AiInference& engine, const FrameAssembler::Frame& frame);
+    
+    /**
+     * @brief Engine given to start(), or the model handle's once it is ready
+     */
+    AiInference* getEngine() const { return mAiInference ? mAiInference : (mModel ? mModel->get() : nullptr); }
+    
+    /**
+     * @brief Record how long the frame just popped waited (zero without a monitor)
+     */
+    LatencyMonitor::Clock::duration measureQueueWait();
     
     /**
      * @brief Update performance statistics
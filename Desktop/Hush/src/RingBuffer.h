@@ -2,7 +2,9 @@
 
 #include <atomic>
 #include <array>
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <type_traits>
 
 namespace KhDetector {
@@ -14,6 +16,13 @@ namespace KhDetector {
  * produces data and another consumes it without blocking. It uses atomic operations
  * for thread safety without locks.
  * 
+ * Besides the single-element push/pop, the buffer exposes a zero-copy bulk API:
+ * acquire_write()/acquire_read() return up to two contiguous spans (the second
+ * one is non-empty only when the region wraps past the end of the storage),
+ * and commit_write()/commit_read() publish the result with a single atomic
+ * store. Each side keeps a cached copy of the opposite index so that the
+ * shared cache line is only touched when the cached view runs out.
+ * 
  * @tparam T The type of elements stored in the buffer
  * @tparam Size The size of the buffer (must be power of 2 for optimal performance)
  */
@@ -25,10 +34,39 @@ class RingBuffer
     static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable for lock-free operation");
 
 public:
+    /**
+     * @brief Contiguous region of the buffer storage
+     */
+    template<typename U>
+    struct Span
+    {
+        U* data = nullptr;
+        size_t size = 0;
+    };
+
+    /**
+     * @brief Up to two contiguous regions covering a logical range
+     * 
+     * The second span is only non-empty when the range wraps around the end
+     * of the underlying storage.
+     */
+    template<typename U>
+    struct SpanPair
+    {
+        Span<U> first;
+        Span<U> second;
+
+        size_t size() const { return first.size + second.size; }
+        bool empty() const { return size() == 0; }
+    };
+
+    using WriteSpans = SpanPair<T>;
+    using ReadSpans = SpanPair<const T>;
+
     /**
      * @brief Construct a new Ring Buffer object
      */
-    RingBuffer() : readIndex_(0), writeIndex_(0) {}
+    RingBuffer() : readIndex_(0), cachedWriteIndex_(0), writeIndex_(0), cachedReadIndex_(0) {}
 
     /**
      * @brief Destroy the Ring Buffer object
@@ -52,9 +90,12 @@ public:
         const size_t currentWrite = writeIndex_.load(std::memory_order_relaxed);
         const size_t nextWrite = increment(currentWrite);
         
-        if (nextWrite == readIndex_.load(std::memory_order_acquire)) {
-            // Buffer is full
-            return false;
+        if (nextWrite == cachedReadIndex_) {
+            cachedReadIndex_ = readIndex_.load(std::memory_order_acquire);
+            if (nextWrite == cachedReadIndex_) {
+                // Buffer is full
+                return false;
+            }
         }
         
         buffer_[currentWrite] = item;
@@ -73,9 +114,12 @@ public:
         const size_t currentWrite = writeIndex_.load(std::memory_order_relaxed);
         const size_t nextWrite = increment(currentWrite);
         
-        if (nextWrite == readIndex_.load(std::memory_order_acquire)) {
-            // Buffer is full
-            return false;
+        if (nextWrite == cachedReadIndex_) {
+            cachedReadIndex_ = readIndex_.load(std::memory_order_acquire);
+            if (nextWrite == cachedReadIndex_) {
+                // Buffer is full
+                return false;
+            }
         }
         
         buffer_[currentWrite] = std::move(item);
@@ -93,9 +137,12 @@ public:
     {
         const size_t currentRead = readIndex_.load(std::memory_order_relaxed);
         
-        if (currentRead == writeIndex_.load(std::memory_order_acquire)) {
-            // Buffer is empty
-            return false;
+        if (currentRead == cachedWriteIndex_) {
+            cachedWriteIndex_ = writeIndex_.load(std::memory_order_acquire);
+            if (currentRead == cachedWriteIndex_) {
+                // Buffer is empty
+                return false;
+            }
         }
         
         item = buffer_[currentRead];
@@ -177,6 +224,74 @@ public:
     {
         readIndex_.store(0, std::memory_order_relaxed);
         writeIndex_.store(0, std::memory_order_relaxed);
+        cachedReadIndex_ = 0;
+        cachedWriteIndex_ = 0;
+    }
+
+    /**
+     * @brief Reserve writable space without copying (producer side)
+     * 
+     * Returns up to @p maxCount free slots as one or two contiguous spans.
+     * Nothing becomes visible to the consumer until commit_write() is called.
+     * 
+     * @param maxCount Maximum number of slots to reserve
+     * @return Writable spans (total size may be smaller than maxCount)
+     */
+    WriteSpans acquire_write(size_t maxCount)
+    {
+        const size_t currentWrite = writeIndex_.load(std::memory_order_relaxed);
+        size_t available = freeSlots(currentWrite, cachedReadIndex_);
+        
+        if (available < maxCount) {
+            cachedReadIndex_ = readIndex_.load(std::memory_order_acquire);
+            available = freeSlots(currentWrite, cachedReadIndex_);
+        }
+        
+        return makeSpans<T>(buffer_.data(), currentWrite, std::min(maxCount, available));
+    }
+
+    /**
+     * @brief Publish slots previously obtained from acquire_write()
+     * 
+     * @param count Number of slots written, must not exceed the acquired size
+     */
+    void commit_write(size_t count)
+    {
+        const size_t currentWrite = writeIndex_.load(std::memory_order_relaxed);
+        writeIndex_.store((currentWrite + count) & (Size - 1), std::memory_order_release);
+    }
+
+    /**
+     * @brief Expose readable elements without copying (consumer side)
+     * 
+     * Returns up to @p maxCount elements as one or two contiguous spans.
+     * The slots stay owned by the consumer until commit_read() is called.
+     * 
+     * @param maxCount Maximum number of elements to expose
+     * @return Readable spans (total size may be smaller than maxCount)
+     */
+    ReadSpans acquire_read(size_t maxCount)
+    {
+        const size_t currentRead = readIndex_.load(std::memory_order_relaxed);
+        size_t available = usedSlots(cachedWriteIndex_, currentRead);
+        
+        if (available < maxCount) {
+            cachedWriteIndex_ = writeIndex_.load(std::memory_order_acquire);
+            available = usedSlots(cachedWriteIndex_, currentRead);
+        }
+        
+        return makeSpans<const T>(buffer_.data(), currentRead, std::min(maxCount, available));
+    }
+
+    /**
+     * @brief Release elements previously obtained from acquire_read()
+     * 
+     * @param count Number of elements consumed, must not exceed the acquired size
+     */
+    void commit_read(size_t count)
+    {
+        const size_t currentRead = readIndex_.load(std::memory_order_relaxed);
+        readIndex_.store((currentRead + count) & (Size - 1), std::memory_order_release);
     }
 
     /**
@@ -190,13 +305,12 @@ public:
     {
         if (!items || count == 0) return 0;
         
-        size_t pushed = 0;
-        for (size_t i = 0; i < count; ++i) {
-            if (!push(items[i])) {
-                break;
-            }
-            ++pushed;
-        }
+        WriteSpans spans = acquire_write(count);
+        std::memcpy(spans.first.data, items, spans.first.size * sizeof(T));
+        std::memcpy(spans.second.data, items + spans.first.size, spans.second.size * sizeof(T));
+        
+        const size_t pushed = spans.size();
+        commit_write(pushed);
         return pushed;
     }
 
@@ -211,13 +325,12 @@ public:
     {
         if (!items || count == 0) return 0;
         
-        size_t popped = 0;
-        for (size_t i = 0; i < count; ++i) {
-            if (!pop(items[i])) {
-                break;
-            }
-            ++popped;
-        }
+        ReadSpans spans = acquire_read(count);
+        std::memcpy(items, spans.first.data, spans.first.size * sizeof(T));
+        std::memcpy(items + spans.first.size, spans.second.data, spans.second.size * sizeof(T));
+        
+        const size_t popped = spans.size();
+        commit_read(popped);
         return popped;
     }
 
@@ -233,13 +346,45 @@ private:
         return (index + 1) & (Size - 1);
     }
 
+    /**
+     * @brief Number of free slots as seen from the producer
+     */
+    static constexpr size_t freeSlots(size_t write, size_t read)
+    {
+        return (read - write - 1) & (Size - 1);
+    }
+
+    /**
+     * @brief Number of readable elements as seen from the consumer
+     */
+    static constexpr size_t usedSlots(size_t write, size_t read)
+    {
+        return (write - read) & (Size - 1);
+    }
+
+    /**
+     * @brief Split a logical range starting at @p start into contiguous spans
+     */
+    template<typename U>
+    static SpanPair<U> makeSpans(U* base, size_t start, size_t count)
+    {
+        SpanPair<U> spans;
+        const size_t firstCount = std::min(count, Size - start);
+        spans.first = {base + start, firstCount};
+        spans.second = {base, count - firstCount};
+        return spans;
+    }
+
     // Buffer storage
     std::array<T, Size> buffer_;
     
     // Atomic indices for lock-free operation
-    // Aligned to cache line boundaries to avoid false sharing
+    // Aligned to cache line boundaries to avoid false sharing. Each side's
+    // cached copy of the opposite index lives on its own side's cache line.
     alignas(64) std::atomic<size_t> readIndex_;
+    size_t cachedWriteIndex_;           // Consumer-owned
     alignas(64) std::atomic<size_t> writeIndex_;
+    size_t cachedReadIndex_;            // Producer-owned
 };
 
 } // namespace KhDetector 
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "TaskScheduler.h"
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+namespace KhDetector {
+
+namespace {
+
+// Worker identity of the calling thread, set by bindWorker()
+thread_local const TaskScheduler* tScheduler = nullptr;
+thread_local int tWorker = -1;
+
+uint32_t lowestSetBit(uint64_t mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward64(&index, mask);
+    return static_cast<uint32_t>(index);
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(mask));
+#endif
+}
+
+} // namespace
+
+TaskScheduler::TaskScheduler(int numWorkers)
+    : mDeques(static_cast<size_t>(std::max(0, numWorkers)))
+{
+    for (size_t i = 0; i < kCapacity; ++i) {
+        mInjection[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+void TaskScheduler::bindWorker(int worker) noexcept
+{
+    tScheduler = this;
+    tWorker = worker;
+}
+
+bool TaskScheduler::submit(RealtimeTask&& task) noexcept
+{
+    if (!task) {
+        return false;
+    }
+
+    uint32_t slot = kNoSlot;
+    if (!claimSlot(slot)) {
+        return false;
+    }
+    mTasks[slot] = std::move(task);
+    mQueued.fetch_add(1, std::memory_order_relaxed);
+
+    // Workers keep what they spawn; everyone else goes through the injection queue
+    const bool fromWorker = tScheduler == this && tWorker >= 0 && tWorker < getWorkerCount();
+    if (!(fromWorker && mDeques[static_cast<size_t>(tWorker)].push(slot)) && !inject(slot)) {
+        // Unreachable while every queue holds kCapacity, but leave the task with the caller
+        task = std::move(mTasks[slot]);
+        mQueued.fetch_sub(1, std::memory_order_relaxed);
+        releaseSlot(slot);
+        return false;
+    }
+
+    mWorkAvailable.post();
+    return true;
+}
+
+bool TaskScheduler::take(int worker, RealtimeTask& task) noexcept
+{
+    const int numWorkers = getWorkerCount();
+    const bool isWorker = worker >= 0 && worker < numWorkers;
+    uint32_t slot = kNoSlot;
+
+    if ((isWorker && mDeques[static_cast<size_t>(worker)].pop(slot)) || popInjected(slot)) {
+        takeFrom(slot, task);
+        return true;
+    }
+
+    // Steal the oldest task of the next busy worker along
+    for (int i = 1; i <= numWorkers; ++i) {
+        const int victim = ((isWorker ? worker : 0) + i) % numWorkers;
+        if (victim != worker && mDeques[static_cast<size_t>(victim)].steal(slot)) {
+            mSteals.fetch_add(1, std::memory_order_relaxed);
+            takeFrom(slot, task);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::clear() noexcept
+{
+    uint32_t slot = kNoSlot;
+    RealtimeTask dropped;
+    for (auto& deque : mDeques) {
+        while (deque.pop(slot)) {
+            takeFrom(slot, dropped);
+            dropped.reset();
+        }
+    }
+    while (popInjected(slot)) {
+        takeFrom(slot, dropped);
+        dropped.reset();
+    }
+    while (mWorkAvailable.tryWait()) {
+    }
+}
+
+bool TaskScheduler::claimSlot(uint32_t& slot) noexcept
+{
+    uint64_t free = mFreeSlots.load(std::memory_order_relaxed);
+    while (free != 0) {
+        const uint64_t bit = free & (~free + 1);
+        const uint64_t previous = mFreeSlots.fetch_and(~bit, std::memory_order_acquire);
+        if (previous & bit) {
+            slot = lowestSetBit(bit);
+            return true;
+        }
+        // Another producer got there first; try the next free slot
+        free = previous & ~bit;
+    }
+    return false;
+}
+
+void TaskScheduler::releaseSlot(uint32_t slot) noexcept
+{
+    mFreeSlots.fetch_or(uint64_t{1} << slot, std::memory_order_release);
+}
+
+bool TaskScheduler::inject(uint32_t slot) noexcept
+{
+    uint64_t position = mInjectPosition.load(std::memory_order_relaxed);
+    for (;;) {
+        InjectionCell& cell = mInjection[position & (kCapacity - 1)];
+        const int64_t lag = static_cast<int64_t>(cell.sequence.load(std::memory_order_acquire) - position);
+        if (lag == 0) {
+            if (mInjectPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                cell.slot = slot;
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (lag < 0) {
+            return false;
+        } else {
+            position = mInjectPosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool TaskScheduler::popInjected(uint32_t& slot) noexcept
+{
+    uint64_t position = mTakePosition.load(std::memory_order_relaxed);
+    for (;;) {
+        InjectionCell& cell = mInjection[position & (kCapacity - 1)];
+        const int64_t lag = static_cast<int64_t>(cell.sequence.load(std::memory_order_acquire) - (position + 1));
+        if (lag == 0) {
+            if (mTakePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                slot = cell.slot;
+                cell.sequence.store(position + kCapacity, std::memory_order_release);
+                return true;
+            }
+        } else if (lag < 0) {
+            return false;
+        } else {
+            position = mTakePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void TaskScheduler::takeFrom(uint32_t slot, RealtimeTask& task) noexcept
+{
+    task = std::move(mTasks[slot]);
+    mQueued.fetch_sub(1, std::memory_order_relaxed);
+    releaseSlot(slot);
+}
+
+} // namespace KhDetector
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "LightweightSemaphore.h"
+#include "RealtimeTask.h"
+#include "WorkStealingDeque.h"
+
+namespace KhDetector {
+
+/**
+ * @brief Lock-free task queues behind RealtimeThreadPool::submitTask()
+ *
+ * Tasks live in a fixed table of kCapacity slots; the queues pass slot
+ * indices around. A slot is claimed from a bit mask and released once its
+ * task has been moved out to run, so at most kCapacity tasks wait at a time
+ * and submit() fails when they are all taken.
+ *
+ * Threads that are not workers (the audio thread, the host) submit through
+ * a bounded multi-producer injection queue. Submitting takes no lock, never
+ * allocates and makes no system call unless a worker is asleep: claiming a
+ * slot and a place in the queue are one atomic operation each, retried only
+ * when another producer took the same one at the same instant. A task
+ * submitted from a worker goes to that worker's own Chase-Lev deque, and
+ * idle workers steal from the others' deques, so tasks that fan out spread
+ * over the pool without going through shared state.
+ *
+ * Workers sleep on a LightweightSemaphore posted once per task.
+ */
+class TaskScheduler
+{
+public:
+    static constexpr size_t kCapacity = 64;
+
+    /**
+     * @param numWorkers Threads that will call take(), with indices 0..numWorkers-1
+     */
+    explicit TaskScheduler(int numWorkers);
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    /**
+     * @brief Mark the calling thread as worker `worker`, so its submissions go to its deque
+     */
+    void bindWorker(int worker) noexcept;
+
+    /**
+     * @brief Queue a task (any thread)
+     *
+     * @return false if the task is empty or all kCapacity slots are taken
+     */
+    bool submit(RealtimeTask&& task) noexcept;
+
+    /**
+     * @brief Find a task for worker `worker`: its own deque, then the injection queue, then the other deques
+     *
+     * @return false if every queue looked empty
+     */
+    bool take(int worker, RealtimeTask& task) noexcept;
+
+    /**
+     * @brief Sleep until a task may be available (worker thread)
+     */
+    void waitForWork() { mWorkAvailable.wait(); }
+
+    /**
+     * @brief Wake every sleeping worker, e.g. to let them see a stop request
+     */
+    void wakeAll() noexcept { mWorkAvailable.post(static_cast<int>(mDeques.size())); }
+
+    /**
+     * @brief Drop every queued task; no worker may be running
+     */
+    void clear() noexcept;
+
+    /**
+     * @brief Tasks queued and not yet taken
+     */
+    size_t size() const noexcept { return static_cast<size_t>(std::max<int64_t>(0, mQueued.load(std::memory_order_relaxed))); }
+
+    /**
+     * @brief Tasks taken from another worker's deque
+     */
+    uint64_t getStealCount() const noexcept { return mSteals.load(std::memory_order_relaxed); }
+
+    int getWorkerCount() const noexcept { return static_cast<int>(mDeques.size()); }
+
+private:
+    static_assert(kCapacity == 64, "Free slots are tracked in one 64-bit mask");
+    static constexpr uint32_t kNoSlot = UINT32_MAX;
+
+    bool claimSlot(uint32_t& slot) noexcept;
+    void releaseSlot(uint32_t slot) noexcept;
+
+    // Vyukov's bounded MPMC queue of slot indices
+    bool inject(uint32_t slot) noexcept;
+    bool popInjected(uint32_t& slot) noexcept;
+
+    // Move the task out of its slot and release the slot
+    void takeFrom(uint32_t slot, RealtimeTask& task) noexcept;
+
+    struct InjectionCell
+    {
+        std::atomic<uint64_t> sequence{0};
+        uint32_t slot = kNoSlot;
+    };
+
+    std::array<RealtimeTask, kCapacity> mTasks;
+    std::atomic<uint64_t> mFreeSlots{~uint64_t{0}};
+
+    std::array<InjectionCell, kCapacity> mInjection;
+    alignas(64) std::atomic<uint64_t> mInjectPosition{0};
+    alignas(64) std::atomic<uint64_t> mTakePosition{0};
+
+    std::vector<WorkStealingDeque<uint32_t, kCapacity>> mDeques;
+
+    LightweightSemaphore mWorkAvailable;
+    alignas(64) std::atomic<int64_t> mQueued{0};
+    std::atomic<uint64_t> mSteals{0};
+};
+
+} // namespace KhDetector
@@ -6,6 +6,7 @@
 #include <chrono>
 #include <memory>
 #include <mutex>
+#include <cmath>
 
 namespace KhDetector {
 
@@ -101,6 +102,41 @@ public:
         return true;
     }
     
+    /**
+     * @brief Add a block of raw amplitudes (producer thread)
+     * 
+     * Takes the lock and the timestamp once for the whole block instead of
+     * once per sample. RMS is approximated by the absolute amplitude.
+     */
+    void pushBlock(const float* amplitudes, size_t count, bool isHit) {
+        if (!amplitudes || count == 0) return;
+        
+        const auto timestamp = std::chrono::high_resolution_clock::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        size_t write = writeIndex_;
+        size_t read = readIndex_;
+        for (size_t i = 0; i < count; ++i) {
+            size_t nextWrite = (write + 1) & (Capacity - 1);
+            if (nextWrite == read) {
+                // Buffer full, overwrite oldest
+                read = (read + 1) & (Capacity - 1);
+            }
+            
+            WaveformSample& sample = buffer_[write];
+            sample.amplitude = amplitudes[i];
+            sample.rms = std::abs(amplitudes[i]);
+            sample.spectralCentroid = 0.0f;
+            sample.zeroCrossingRate = 0.0f;
+            sample.timestamp = timestamp;
+            sample.isHit = isHit;
+            write = nextWrite;
+        }
+        
+        writeIndex_ = write;
+        readIndex_ = read;
+    }
+    
     /**
      * @brief Get samples for rendering (consumer thread)
      */
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace KhDetector {
+
+/**
+ * @brief Bounded Chase-Lev work-stealing deque
+ *
+ * The owning thread pushes and pops at the bottom (LIFO, so it works on what
+ * it just produced while that is still in cache); any other thread steals
+ * from the top (FIFO, the oldest work). Owner operations only contend with
+ * thieves for the last element; a steal is a single compare-and-swap on the
+ * top index. The capacity is fixed, so push() fails instead of growing.
+ *
+ * Items are read speculatively by thieves before their CAS decides who owns
+ * them, so T must be a small trivially copyable type held in an atomic (an
+ * index or a pointer to the real work). Follows Lê, Pop, Cohen and Nardelli,
+ * "Correct and Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013),
+ * with release/acquire on the bottom index so the items' targets are visible
+ * to thieves without relying on fences alone.
+ */
+template<typename T, size_t Capacity>
+class WorkStealingDeque
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+    static_assert(std::is_trivially_copyable<T>::value, "Items are copied speculatively by thieves");
+
+public:
+    WorkStealingDeque() = default;
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    /**
+     * @brief Add an item at the bottom (owner thread)
+     *
+     * @return false if the deque is full
+     */
+    bool push(T item) noexcept
+    {
+        const int64_t bottom = mBottom.load(std::memory_order_relaxed);
+        const int64_t top = mTop.load(std::memory_order_acquire);
+        if (bottom - top >= static_cast<int64_t>(Capacity)) {
+            return false;
+        }
+        mItems[static_cast<size_t>(bottom) & kMask].store(item, std::memory_order_relaxed);
+        mBottom.store(bottom + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Take the newest item (owner thread)
+     *
+     * @return false if the deque is empty or a thief took the last item
+     */
+    bool pop(T& item) noexcept
+    {
+        const int64_t bottom = mBottom.load(std::memory_order_relaxed) - 1;
+        mBottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = mTop.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            mBottom.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        item = mItems[static_cast<size_t>(bottom) & kMask].load(std::memory_order_relaxed);
+        if (top == bottom) {
+            // Last item: race the thieves for it
+            const bool won = mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                          std::memory_order_relaxed);
+            mBottom.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Take the oldest item (any thread)
+     *
+     * @return false if the deque is empty or another thread took the item first
+     */
+    bool steal(T& item) noexcept
+    {
+        int64_t top = mTop.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t bottom = mBottom.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return false;
+        }
+
+        const T candidate = mItems[static_cast<size_t>(top) & kMask].load(std::memory_order_relaxed);
+        if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false;
+        }
+        item = candidate;
+        return true;
+    }
+
+    /**
+     * @brief Items in the deque (approximate while other threads use it)
+     */
+    size_t size() const noexcept
+    {
+        const int64_t bottom = mBottom.load(std::memory_order_relaxed);
+        const int64_t top = mTop.load(std::memory_order_relaxed);
+        return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+
+private:
+    static constexpr size_t kMask = Capacity - 1;
+
+    // Thieves hammer the top, the owner the bottom: keep them on separate lines
+    alignas(64) std::atomic<int64_t> mTop{0};
+    alignas(64) std::atomic<int64_t> mBottom{0};
+    alignas(64) std::array<std::atomic<T>, Capacity> mItems{};
+};
+
+} // namespace KhDetector
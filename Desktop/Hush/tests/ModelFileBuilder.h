@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "MlpModel.h"
+
+namespace KhDetector {
+
+/**
+ * @brief Writes .khmlp model files for tests (layout in MlpModel.h)
+ *
+ * Layers are described unpacked, one row of weights per output, and pack()
+ * lays them out the way training/export_native_model.py does: outputs padded
+ * to blocks of 8, each block's weights interleaved input by input.
+ */
+class ModelFileBuilder
+{
+public:
+    struct Layer
+    {
+        int numInputs = 0;
+        int numOutputs = 0;
+        bool relu = false;
+        bool gru = false;               // GRU of numOutputs hidden units: 3 numOutputs gate rows (r, z, n)
+        std::vector<float> weights;     // Row-major [numOutputs][numInputs], or [3 numOutputs][numInputs]
+        std::vector<float> bias;
+        std::vector<float> hiddenWeights;   // GRU: [3 numOutputs][numOutputs]
+        std::vector<float> hiddenBias;
+    };
+
+    /**
+     * @brief Dense layer with zero parameters
+     */
+    static Layer dense(int numInputs, int numOutputs, bool relu)
+    {
+        Layer layer;
+        layer.numInputs = numInputs;
+        layer.numOutputs = numOutputs;
+        layer.relu = relu;
+        layer.weights.assign(static_cast<size_t>(numOutputs) * numInputs, 0.0f);
+        layer.bias.assign(numOutputs, 0.0f);
+        return layer;
+    }
+
+    /**
+     * @brief GRU layer of numHidden units with zero parameters
+     */
+    static Layer gru(int numInputs, int numHidden)
+    {
+        Layer layer = dense(numInputs, 3 * numHidden, false);
+        layer.numOutputs = numHidden;
+        layer.gru = true;
+        layer.hiddenWeights.assign(3u * numHidden * numHidden, 0.0f);
+        layer.hiddenBias.assign(3u * numHidden, 0.0f);
+        return layer;
+    }
+
+    /**
+     * @brief Dense layers of the given sizes, ReLU on all but the last
+     */
+    static std::vector<Layer> denseStack(const std::vector<int>& sizes)
+    {
+        std::vector<Layer> layers;
+        for (size_t l = 0; l + 1 < sizes.size(); ++l) {
+            layers.push_back(dense(sizes[l], sizes[l + 1], l + 2 < sizes.size()));
+        }
+        return layers;
+    }
+
+    /**
+     * @brief Set every parameter from next(): weights, bias, then the GRU's hidden weights and bias
+     */
+    template<typename Next>
+    static void fill(Layer& layer, Next&& next)
+    {
+        for (std::vector<float>* values : { &layer.weights, &layer.bias, &layer.hiddenWeights, &layer.hiddenBias }) {
+            for (float& value : *values) {
+                value = next();
+            }
+        }
+    }
+
+    /**
+     * @brief Contents of a .khmlp file holding the layers
+     */
+    static std::vector<char> pack(const std::vector<Layer>& layers)
+    {
+        std::vector<char> data = { 'K', 'H', 'M', 'L' };
+        appendUint32(data, MlpModel::kVersion);
+        appendUint32(data, static_cast<uint32_t>(layers.size()));
+        appendUint32(data, 0);
+
+        for (const Layer& layer : layers) {
+            appendUint32(data, layer.numInputs);
+            appendUint32(data, layer.numOutputs);
+            appendUint32(data, layer.gru ? 2 : layer.relu ? 1 : 0);
+            appendUint32(data, 0);
+        }
+
+        for (const Layer& layer : layers) {
+            if (layer.gru) {
+                packDense(data, layer.weights, layer.bias, layer.numInputs, 3 * layer.numOutputs);
+                packDense(data, layer.hiddenWeights, layer.hiddenBias, layer.numOutputs, 3 * layer.numOutputs);
+            } else {
+                packDense(data, layer.weights, layer.bias, layer.numInputs, layer.numOutputs);
+            }
+        }
+        return data;
+    }
+
+    static bool write(const std::string& path, const std::vector<char>& data)
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        return static_cast<bool>(file);
+    }
+
+    static bool write(const std::string& path, const std::vector<Layer>& layers)
+    {
+        return write(path, pack(layers));
+    }
+
+    static void appendUint32(std::vector<char>& data, uint32_t value)
+    {
+        for (int shift = 0; shift < 32; shift += 8) {
+            data.push_back(static_cast<char>((value >> shift) & 0xFF));
+        }
+    }
+
+    static void appendFloat(std::vector<char>& data, float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        appendUint32(data, bits);
+    }
+
+private:
+    static void packDense(std::vector<char>& data, const std::vector<float>& weights, const std::vector<float>& bias,
+                          int numInputs, int numOutputs)
+    {
+        const int padded = (numOutputs + 7) / 8 * 8;
+        for (int o = 0; o < padded; ++o) {
+            appendFloat(data, o < numOutputs ? bias[o] : 0.0f);
+        }
+        for (int block = 0; block < padded; block += 8) {
+            for (int i = 0; i < numInputs; ++i) {
+                for (int o = block; o < block + 8; ++o) {
+                    appendFloat(data, o < numOutputs ? weights[static_cast<size_t>(o) * numInputs + i] : 0.0f);
+                }
+            }
+        }
+    }
+};
+
+} // namespace KhDetector
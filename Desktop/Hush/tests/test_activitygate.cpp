@@ -0,0 +1,321 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "ActivityGate.h"
+#include "AiInference.h"
+#include "DspKernels.h"
+#include "MlpModel.h"
+#include "ModelFileBuilder.h"
+
+using namespace KhDetector;
+
+class ActivityGateTest : public ::testing::Test
+{
+protected:
+    static constexpr int kFrameSize = 320;     // 20 ms at 16 kHz
+    static constexpr double kSampleRate = 16000.0;
+    static constexpr double kPi = 3.14159265358979323846;
+
+    void TearDown() override
+    {
+        if (!modelPath.empty()) {
+            std::remove(modelPath.c_str());
+        }
+    }
+
+    static float dbToGain(double db)
+    {
+        return static_cast<float>(std::pow(10.0, db / 20.0));
+    }
+
+    static std::vector<float> makeTone(double frequency, double levelDb, int numSamples = kFrameSize)
+    {
+        // Peak amplitude for an RMS of levelDb
+        const double amplitude = std::sqrt(2.0) * dbToGain(levelDb);
+        std::vector<float> samples(numSamples);
+        for (int n = 0; n < numSamples; ++n) {
+            samples[n] = static_cast<float>(amplitude * std::sin(2.0 * kPi * frequency * n / kSampleRate + 0.3));
+        }
+        return samples;
+    }
+
+    // A vowel: 140 Hz glottal harmonics falling off at 12 dB per octave
+    static std::vector<float> makeVowel(double levelDb, int numSamples = kFrameSize)
+    {
+        std::vector<float> samples(numSamples, 0.0f);
+        for (int k = 1; k <= 12; ++k) {
+            const std::vector<float> harmonic = makeTone(140.0 * k, levelDb - 40.0 * std::log10(k), numSamples);
+            for (int n = 0; n < numSamples; ++n) {
+                samples[n] += harmonic[n];
+            }
+        }
+        return samples;
+    }
+
+    // White noise, optionally through a two-pole resonator (a uvular fricative peaks around 1-2 kHz)
+    static std::vector<float> makeNoise(double levelDb, unsigned seed, double resonance = 0.0,
+                                        int numSamples = kFrameSize)
+    {
+        std::mt19937 rng(seed);
+        std::normal_distribution<float> dist(0.0f, 1.0f);
+        std::vector<float> samples(numSamples);
+        const double radius = 0.9;
+        const double a1 = 2.0 * radius * std::cos(2.0 * kPi * resonance / kSampleRate);
+        const double a2 = -radius * radius;
+        double y1 = 0.0;
+        double y2 = 0.0;
+        double sumSquares = 0.0;
+        for (int n = 0; n < numSamples; ++n) {
+            double y = dist(rng);
+            if (resonance > 0.0) {
+                y += a1 * y1 + a2 * y2;
+                y2 = y1;
+                y1 = y;
+            }
+            samples[n] = static_cast<float>(y);
+            sumSquares += y * y;
+        }
+        const double scale = dbToGain(levelDb) / std::sqrt(sumSquares / numSamples);
+        for (float& sample : samples) {
+            sample = static_cast<float>(sample * scale);
+        }
+        return samples;
+    }
+
+    /**
+     * @brief Write a random ReLU MLP of the given layer sizes as a .khmlp file
+     */
+    void writeModel(const std::vector<int>& sizes)
+    {
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> dist(-0.1f, 0.1f);
+        std::vector<ModelFileBuilder::Layer> layers = ModelFileBuilder::denseStack(sizes);
+        for (ModelFileBuilder::Layer& layer : layers) {
+            ModelFileBuilder::fill(layer, [&] { return dist(rng); });
+        }
+
+        modelPath = ::testing::TempDir() + "activitygate_test.khmlp";
+        ModelFileBuilder::write(modelPath, layers);
+    }
+
+    std::string modelPath;
+};
+
+TEST_F(ActivityGateTest, MeasuresMatchAnalyticValues)
+{
+    // A tone at f crosses zero 2 f / fs times per sample and has a high-band ratio of sin^2(pi f / fs)
+    const std::vector<float> tone = makeTone(1000.0, -20.0, 3200);
+    const auto toneMeasures = ActivityGate::measure(tone.data(), static_cast<int>(tone.size()));
+    EXPECT_NEAR(toneMeasures.levelDb, -20.0f, 0.05f);
+    EXPECT_NEAR(toneMeasures.zeroCrossingRate, 2000.0 / kSampleRate, 0.002);
+    EXPECT_NEAR(toneMeasures.highBandRatio, std::pow(std::sin(kPi * 1000.0 / kSampleRate), 2.0), 0.002);
+
+    const std::vector<float> noise = makeNoise(-30.0, 1, 0.0, 3200);
+    const auto noiseMeasures = ActivityGate::measure(noise.data(), static_cast<int>(noise.size()));
+    EXPECT_NEAR(noiseMeasures.levelDb, -30.0f, 0.05f);
+    EXPECT_NEAR(noiseMeasures.zeroCrossingRate, 0.5f, 0.03f);
+    EXPECT_NEAR(noiseMeasures.highBandRatio, 0.5f, 0.03f);
+
+    const std::vector<float> silence(kFrameSize, 0.0f);
+    const auto silenceMeasures = ActivityGate::measure(silence.data(), kFrameSize);
+    EXPECT_LT(silenceMeasures.levelDb, -150.0f);
+    EXPECT_EQ(silenceMeasures.highBandRatio, 0.0f);
+}
+
+TEST_F(ActivityGateTest, PassesFricativesOnly)
+{
+    ActivityGate::Config config;
+    config.hangoverFrames = 0;
+    ActivityGate gate(config);
+
+    const std::vector<float> silence(kFrameSize, 0.0f);
+    EXPECT_FALSE(gate.process(silence.data(), kFrameSize));
+    EXPECT_FALSE(gate.process(makeNoise(-70.0, 2).data(), kFrameSize)) << "room tone";
+    EXPECT_FALSE(gate.process(makeTone(50.0, -10.0).data(), kFrameSize)) << "mains hum";
+    EXPECT_FALSE(gate.process(makeVowel(-15.0).data(), kFrameSize)) << "vowel";
+
+    EXPECT_TRUE(gate.process(makeNoise(-30.0, 3).data(), kFrameSize)) << "broadband fricative";
+    EXPECT_TRUE(gate.process(makeNoise(-30.0, 4, 1500.0).data(), kFrameSize)) << "uvular fricative";
+    EXPECT_TRUE(gate.isOpen());
+
+    const auto& statistics = gate.getStatistics();
+    EXPECT_EQ(statistics.activeFrames.load(), 2u);
+    EXPECT_EQ(statistics.closedFrames.load(), 4u);
+    EXPECT_NEAR(statistics.getOpenRatio(), 2.0 / 6.0, 1e-9);
+}
+
+TEST_F(ActivityGateTest, HangoverHoldsTheGateOpen)
+{
+    ActivityGate::Config config;
+    config.hangoverFrames = 3;
+    ActivityGate gate(config);
+
+    const std::vector<float> fricative = makeNoise(-30.0, 5);
+    const std::vector<float> silence(kFrameSize, 0.0f);
+    EXPECT_TRUE(gate.process(fricative.data(), kFrameSize));
+    for (int frame = 0; frame < config.hangoverFrames; ++frame) {
+        EXPECT_TRUE(gate.process(silence.data(), kFrameSize)) << "hangover frame " << frame;
+    }
+    EXPECT_FALSE(gate.process(silence.data(), kFrameSize));
+    EXPECT_FALSE(gate.isOpen());
+
+    // An active frame during the hangover restarts it
+    EXPECT_TRUE(gate.process(fricative.data(), kFrameSize));
+    EXPECT_TRUE(gate.process(silence.data(), kFrameSize));
+    EXPECT_TRUE(gate.process(fricative.data(), kFrameSize));
+    for (int frame = 0; frame < config.hangoverFrames; ++frame) {
+        EXPECT_TRUE(gate.process(silence.data(), kFrameSize));
+    }
+    EXPECT_FALSE(gate.process(silence.data(), kFrameSize));
+
+    const auto& statistics = gate.getStatistics();
+    EXPECT_EQ(statistics.activeFrames.load(), 3u);
+    EXPECT_EQ(statistics.heldFrames.load(), 7u);
+    EXPECT_EQ(statistics.closedFrames.load(), 2u);
+
+    gate.process(fricative.data(), kFrameSize);
+    gate.reset();
+    EXPECT_FALSE(gate.isOpen());
+    EXPECT_FALSE(gate.process(silence.data(), kFrameSize));
+}
+
+TEST_F(ActivityGateTest, GatedFramesSkipTheModel)
+{
+    writeModel({ kFrameSize, 16, 2 });
+    AiInference::ModelConfig config = createDefaultModelConfig();
+    config.modelPath = modelPath;
+    config.useActivityGate = true;
+    config.activityGate.hangoverFrames = 1;
+    AiInference inference(config);
+    ASSERT_TRUE(inference.initialize(config));
+    ASSERT_NE(inference.getActivityGate(), nullptr);
+
+    const std::vector<float> silence(kFrameSize, 0.0f);
+    const std::vector<float> fricative = makeNoise(-30.0, 6);
+
+    auto result = inference.run(silence.data(), kFrameSize);
+    EXPECT_TRUE(result.success);
+    EXPECT_TRUE(result.gated);
+    EXPECT_EQ(result.numPredictions, 0);
+    EXPECT_EQ(result.label, AiInference::Label::NotDetected);
+
+    result = inference.run(fricative.data(), kFrameSize);
+    EXPECT_FALSE(result.gated);
+    EXPECT_EQ(result.numPredictions, 2);
+    EXPECT_FALSE(inference.run(silence.data(), kFrameSize).gated) << "hangover";
+    EXPECT_TRUE(inference.run(silence.data(), kFrameSize).gated);
+
+    const auto& statistics = inference.getStatistics();
+    EXPECT_EQ(statistics.gatedFrames.load(), 2u);
+    EXPECT_EQ(statistics.totalInferences.load(), 2u);
+    EXPECT_EQ(result.frameIndex + 3, inference.run(silence.data(), kFrameSize).frameIndex);
+
+    // Without the option the model sees every frame
+    AiInference ungated(createDefaultModelConfig());
+    ASSERT_TRUE(ungated.initialize(createDefaultModelConfig()));
+    EXPECT_EQ(ungated.getActivityGate(), nullptr);
+    EXPECT_FALSE(ungated.run(silence.data(), kFrameSize).gated);
+}
+
+TEST_F(ActivityGateTest, BatchesAreGatedLikeSingleFrames)
+{
+    writeModel({ kFrameSize, 16, 2 });
+    AiInference::ModelConfig config = createDefaultModelConfig();
+    config.modelPath = modelPath;
+    config.useActivityGate = true;
+    config.activityGate.hangoverFrames = 1;
+    AiInference single(config);
+    AiInference batched(config);
+    ASSERT_TRUE(single.initialize(config));
+    ASSERT_TRUE(batched.initialize(config));
+
+    // Silence, a fricative with its hangover frame, more silence, then a second fricative
+    const std::vector<float> silence(kFrameSize, 0.0f);
+    std::vector<float> frames;
+    unsigned seed = 20;
+    for (bool active : { false, true, false, false, false, true, true, false, false }) {
+        const std::vector<float> frame = active ? makeNoise(-30.0, seed++) : silence;
+        frames.insert(frames.end(), frame.begin(), frame.end());
+    }
+    const int numFrames = static_cast<int>(frames.size() / kFrameSize);
+
+    std::vector<AiInference::InferenceResult> batch(static_cast<size_t>(numFrames));
+    ASSERT_TRUE(batched.runBatch(frames.data(), numFrames, batch.data()));
+    for (int frame = 0; frame < numFrames; ++frame) {
+        const auto expected = single.run(frames.data() + static_cast<size_t>(frame) * kFrameSize, kFrameSize);
+        const auto& result = batch[static_cast<size_t>(frame)];
+        EXPECT_TRUE(result.success);
+        EXPECT_EQ(result.gated, expected.gated) << "frame " << frame;
+        EXPECT_EQ(result.numPredictions, expected.numPredictions);
+        EXPECT_FLOAT_EQ(result.confidence, expected.confidence);
+        EXPECT_EQ(result.label, expected.label);
+    }
+
+    EXPECT_EQ(batched.getStatistics().gatedFrames.load(), 4u);
+    EXPECT_EQ(batched.getStatistics().gatedFrames.load(), single.getStatistics().gatedFrames.load());
+    EXPECT_EQ(batched.getStatistics().totalInferences.load(), single.getStatistics().totalInferences.load());
+}
+
+TEST_F(ActivityGateTest, PerformanceBenchmark_LongFormSession)
+{
+    // Ten minutes of dialogue: mostly room tone and pauses, then voiced speech, few fricatives
+    constexpr int kNumFrames = 10 * 60 * 50;
+    std::mt19937 rng(8);
+    std::discrete_distribution<int> segmentKind({ 55.0, 33.0, 12.0 });
+    std::uniform_int_distribution<int> segmentLength(3, 40);
+
+    std::vector<float> session;
+    session.reserve(static_cast<size_t>(kNumFrames) * kFrameSize);
+    unsigned seed = 100;
+    while (session.size() < static_cast<size_t>(kNumFrames) * kFrameSize) {
+        const int kind = segmentKind(rng);
+        const int length = kind == 2 ? 3 + segmentLength(rng) / 8 : segmentLength(rng);
+        for (int frame = 0; frame < length; ++frame) {
+            const std::vector<float> samples = kind == 0 ? makeNoise(-65.0, seed++)
+                                             : kind == 1 ? makeVowel(-20.0)
+                                                         : makeNoise(-30.0, seed++, 1500.0);
+            session.insert(session.end(), samples.begin(), samples.end());
+        }
+    }
+    session.resize(static_cast<size_t>(kNumFrames) * kFrameSize);
+
+    writeModel({ kFrameSize, 64, 32, 16, 2 });
+    double seconds[2] = {};
+    double openRatio = 1.0;
+    for (bool useGate : { false, true }) {
+        AiInference::ModelConfig config = createDefaultModelConfig();
+        config.modelPath = modelPath;
+        config.useActivityGate = useGate;
+        AiInference inference(config);
+        ASSERT_TRUE(inference.initialize(config));
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (int frame = 0; frame < kNumFrames; ++frame) {
+            inference.run(session.data() + static_cast<size_t>(frame) * kFrameSize, kFrameSize);
+        }
+        const auto end = std::chrono::high_resolution_clock::now();
+        seconds[useGate] = std::chrono::duration<double>(end - start).count();
+        if (useGate) {
+            openRatio = inference.getActivityGate()->getStatistics().getOpenRatio();
+            EXPECT_EQ(inference.getStatistics().gatedFrames.load() + inference.getStatistics().totalInferences.load(),
+                      static_cast<uint64_t>(kNumFrames));
+        }
+    }
+
+    std::cout << "Ten-minute session, " << getSimdLevelName(getDspKernels().level) << ", MLP 320-64-32-16-2:" << std::endl
+              << "  without gate: " << std::fixed << std::setprecision(1) << seconds[0] * 1e3 << " ms" << std::endl
+              << "  with gate:    " << seconds[1] * 1e3 << " ms, "
+              << std::setprecision(0) << openRatio * 100.0 << "% of frames reach the model" << std::endl;
+
+    EXPECT_LT(openRatio, 0.5);
+    EXPECT_LT(seconds[1], seconds[0]);
+}
@@ -0,0 +1,397 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "AiInference.h"
+#include "MlpModel.h"
+#include "ModelFileBuilder.h"
+#include "PostProcessor.h"
+
+using namespace KhDetector;
+
+/**
+ * Heap allocations are counted by interposing the C allocator, which
+ * operator new also goes through, so library code is caught as well as
+ * ours. Only the thread that enables counting is counted. The interposer
+ * forwards to glibc's own entry points, so the check runs on glibc only.
+ */
+#if defined(__GLIBC__)
+#define KHDETECTOR_COUNTS_ALLOCATIONS 1
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace {
+
+thread_local bool tCountAllocations = false;
+thread_local size_t tAllocations = 0;
+
+void countAllocation()
+{
+    if (tCountAllocations) {
+        ++tAllocations;
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+void* malloc(size_t size) noexcept
+{
+    countAllocation();
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept
+{
+    countAllocation();
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept
+{
+    countAllocation();
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept
+{
+    countAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept
+{
+    countAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) noexcept
+{
+    countAllocation();
+    *ptr = __libc_memalign(alignment, size);
+    return *ptr ? 0 : ENOMEM;
+}
+
+void free(void* ptr) noexcept
+{
+    __libc_free(ptr);
+}
+
+} // extern "C"
+#else
+#define KHDETECTOR_COUNTS_ALLOCATIONS 0
+#endif
+
+class AiInferenceTest : public ::testing::Test
+{
+protected:
+    static constexpr int kInputSize = 40;
+
+    void TearDown() override
+    {
+        std::remove(modelPath.c_str());
+    }
+
+    /**
+     * @brief Write a one-layer .khmlp model
+     *
+     * Output 0 is a zero logit and output 1 is gain times the input mean, so
+     * as a two-class model the detection probability follows the input level.
+     * Further outputs are zero.
+     */
+    void writeModel(int numOutputs, float gain)
+    {
+        ModelFileBuilder::Layer layer = ModelFileBuilder::dense(kInputSize, numOutputs, false);
+        std::fill_n(layer.weights.begin() + kInputSize, kInputSize, gain / kInputSize);
+
+        modelPath = ::testing::TempDir() + "aiinference_test.khmlp";
+        ModelFileBuilder::write(modelPath, { layer });
+    }
+
+    /**
+     * @brief Write a one-GRU-layer .khmlp model with two hidden units
+     *
+     * Unit 0 stays at zero and unit 1 moves halfway from its state towards
+     * tanh(gain times the input mean) on every hop, so the detection
+     * probability depends on the hops the stream has seen.
+     */
+    void writeStreamingModel(float gain)
+    {
+        constexpr int kHidden = 2;
+        ModelFileBuilder::Layer layer = ModelFileBuilder::gru(kInputSize, kHidden);
+
+        // Only the input weights of unit 1's new gate row are set
+        const int newGateRow = 2 * kHidden + 1;
+        std::fill_n(layer.weights.begin() + newGateRow * kInputSize, kInputSize, gain / kInputSize);
+
+        modelPath = ::testing::TempDir() + "aiinference_test.khmlp";
+        ModelFileBuilder::write(modelPath, { layer });
+    }
+
+    AiInference::ModelConfig makeConfig() const
+    {
+        AiInference::ModelConfig config = createDefaultModelConfig();
+        config.inputSize = kInputSize;
+        config.modelPath = modelPath;
+        return config;
+    }
+
+    // Alternating bursts of loud (detected) and quiet (not detected) frames
+    static std::vector<float> makeFrames(int numFrames, int burstLength)
+    {
+        std::vector<float> frames(static_cast<size_t>(numFrames) * kInputSize);
+        for (int frame = 0; frame < numFrames; ++frame) {
+            const float level = (frame / burstLength) % 2 == 0 ? 1.0f : -1.0f;
+            std::fill_n(frames.begin() + static_cast<size_t>(frame) * kInputSize, kInputSize, level);
+        }
+        return frames;
+    }
+
+    static void countResult(const AiInference::InferenceResult& result, void* context) noexcept
+    {
+        static_cast<std::vector<uint64_t>*>(context)->push_back(result.frameIndex);
+    }
+
+    static void countCall(const AiInference::InferenceResult&, void* context) noexcept
+    {
+        ++*static_cast<int*>(context);
+    }
+
+    std::string modelPath;
+};
+
+TEST_F(AiInferenceTest, RunAllocatesNothingPerFrame)
+{
+#if KHDETECTOR_COUNTS_ALLOCATIONS
+    writeModel(2, 10.0f);
+    AiInference inference(makeConfig());
+    ASSERT_TRUE(inference.initialize(makeConfig()));
+
+    int callbacks = 0;
+    int hitChanges = 0;
+    inference.setInferenceCallback(countCall, &callbacks);
+    inference.getPostProcessor()->setHitCallback([&](bool, const PostProcessor::HitEvent&) { ++hitChanges; });
+    auto monitor = std::make_shared<LatencyMonitor>();
+    inference.setLatencyMonitor(monitor);
+
+    const int numFrames = 400;
+    const std::vector<float> frames = makeFrames(numFrames, 20);
+    std::vector<AiInference::InferenceResult> batch(numFrames);
+
+    // First batch of this size sizes the batch buffers
+    ASSERT_TRUE(inference.runBatch(frames.data(), numFrames, batch.data()));
+
+    tAllocations = 0;
+    tCountAllocations = true;
+    for (int frame = 0; frame < numFrames; ++frame) {
+        const auto result = inference.run(frames.data() + static_cast<size_t>(frame) * kInputSize, kInputSize);
+        ASSERT_TRUE(result.success);
+    }
+    ASSERT_TRUE(inference.runBatch(frames.data(), numFrames, batch.data()));
+    inference.run(frames.data(), kInputSize - 1);
+    const auto statistics = inference.getPostProcessor()->getStatistics();
+    const uint64_t inferences = inference.getStatistics().totalInferences.load();
+    tCountAllocations = false;
+
+    EXPECT_EQ(tAllocations, 0u) << "Heap allocation on the inference path";
+
+    // The counted frames went through every stage
+    EXPECT_EQ(callbacks, 3 * numFrames);
+    EXPECT_GE(hitChanges, 20);
+    EXPECT_EQ(statistics.totalFramesProcessed.load(), 3u * numFrames);
+    EXPECT_EQ(monitor->getSnapshot(LatencyStage::Inference).count, static_cast<uint64_t>(numFrames));
+    EXPECT_EQ(inferences, 3u * numFrames);
+#else
+    GTEST_SKIP() << "Allocation counting needs glibc";
+#endif
+}
+
+TEST_F(AiInferenceTest, ResultsCarryLabelsAndFrameIndices)
+{
+    writeModel(2, 10.0f);
+    AiInference inference(makeConfig());
+    ASSERT_TRUE(inference.initialize(makeConfig()));
+
+    std::vector<uint64_t> seen;
+    seen.reserve(200);
+    inference.setInferenceCallback(countResult, &seen);
+
+    const std::vector<float> frames = makeFrames(40, 20);
+    uint64_t expectedIndex = 0;
+    bool detected = false;
+    for (int frame = 0; frame < 20; ++frame) {
+        const auto result = inference.run(frames.data() + static_cast<size_t>(frame) * kInputSize, kInputSize);
+        ASSERT_TRUE(result.success);
+        EXPECT_EQ(result.frameIndex, expectedIndex++);
+        ASSERT_EQ(result.numPredictions, 2);
+        EXPECT_NEAR(result.predictions[0] + result.predictions[1], 1.0f, 1e-5f);
+        EXPECT_GT(result.predictions[1], 0.99f);
+        detected = detected || result.label == AiInference::Label::Detected;
+    }
+    EXPECT_TRUE(detected);
+    EXPECT_STREQ(getLabelName(AiInference::Label::Detected), "detected");
+
+    // Rejected frames still take an index
+    const auto rejected = inference.run(frames.data(), kInputSize + 1);
+    EXPECT_FALSE(rejected.success);
+    EXPECT_EQ(rejected.frameIndex, expectedIndex++);
+    EXPECT_EQ(inference.getStatistics().rejectedFrames.load(), 1u);
+    EXPECT_GT(inference.getStatistics().getAverageConfidence(), 0.0);
+    EXPECT_LE(inference.getStatistics().getAverageConfidence(), 1.0);
+    EXPECT_GE(inference.getStatistics().getAverageProcessingTimeMs(), 0.0);
+
+    std::vector<AiInference::InferenceResult> batch(20);
+    ASSERT_TRUE(inference.runBatch(frames.data() + 20 * kInputSize, 20, batch.data()));
+    for (const auto& result : batch) {
+        EXPECT_EQ(result.frameIndex, expectedIndex++);
+        EXPECT_LT(result.predictions[1], 0.01f);
+    }
+    EXPECT_EQ(batch.back().label, AiInference::Label::NotDetected);
+    EXPECT_STREQ(getLabelName(batch.back().label), "not_detected");
+
+    // The callback sees successful frames only, in order
+    ASSERT_EQ(seen.size(), 40u);
+    EXPECT_TRUE(std::is_sorted(seen.begin(), seen.end()));
+    EXPECT_EQ(std::adjacent_find(seen.begin(), seen.end()), seen.end());
+}
+
+TEST_F(AiInferenceTest, RejectsModelsWithTooManyOutputs)
+{
+    writeModel(AiInference::InferenceResult::kMaxPredictions + 1, 1.0f);
+    AiInference inference(makeConfig());
+    EXPECT_FALSE(inference.initialize(makeConfig()));
+
+    writeModel(AiInference::InferenceResult::kMaxPredictions, 1.0f);
+    AiInference::ModelConfig config = makeConfig();
+    EXPECT_TRUE(inference.initialize(config));
+    EXPECT_EQ(inference.getConfig().outputSize, AiInference::InferenceResult::kMaxPredictions);
+
+    const std::vector<float> frames = makeFrames(1, 1);
+    const auto result = inference.run(frames.data(), kInputSize);
+    ASSERT_TRUE(result.success);
+    EXPECT_EQ(result.numPredictions, AiInference::InferenceResult::kMaxPredictions);
+}
+
+TEST_F(AiInferenceTest, WithoutModelScoresFramesWithTheHeuristic)
+{
+    AiInference::ModelConfig config = makeConfig();
+    config.modelPath.clear();
+    AiInference inference(config);
+    ASSERT_TRUE(inference.initialize(config));
+
+    // Silence, white noise and a low tone
+    std::vector<float> frames(3 * kInputSize, 0.0f);
+    uint32_t seed = 1;
+    for (int i = 0; i < kInputSize; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        frames[kInputSize + i] = 0.25f * (static_cast<float>(seed >> 8) / 8388608.0f - 1.0f);
+        frames[2 * kInputSize + i] = 0.25f * std::sin(0.05f * i);
+    }
+
+    std::vector<AiInference::InferenceResult> first(3);
+    std::vector<AiInference::InferenceResult> second(3);
+    ASSERT_TRUE(inference.runBatch(frames.data(), 3, first.data()));
+    ASSERT_TRUE(inference.runBatch(frames.data(), 3, second.data()));
+
+    // Deterministic, and the same score ActivityGate::fricativeConfidence() gives
+    for (int frame = 0; frame < 3; ++frame) {
+        const float expected = ActivityGate::fricativeConfidence(frames.data() + frame * kInputSize,
+                                                                  kInputSize, config.activityGate);
+        EXPECT_EQ(first[frame].predictions[0], second[frame].predictions[0]) << "frame " << frame;
+        EXPECT_FLOAT_EQ(first[frame].predictions[0], expected) << "frame " << frame;
+    }
+    EXPECT_EQ(first[0].predictions[0], 0.0f);
+    EXPECT_GT(first[1].predictions[0], 0.9f);
+    EXPECT_EQ(first[2].predictions[0], 0.0f);
+}
+
+TEST_F(AiInferenceTest, DefaultModelPathHonoursEnvironment)
+{
+#ifndef _WIN32
+    const char* previous = std::getenv("KHDETECTOR_MODEL");
+    const std::string saved = previous ? previous : "";
+
+    setenv("KHDETECTOR_MODEL", "/models/custom.khmlp", 1);
+    EXPECT_EQ(findDefaultModelPath(), "/models/custom.khmlp");
+    EXPECT_EQ(createDefaultModelConfig().modelPath, "/models/custom.khmlp");
+
+    // Empty runs without a model
+    setenv("KHDETECTOR_MODEL", "", 1);
+    EXPECT_TRUE(findDefaultModelPath().empty());
+
+    if (previous) {
+        setenv("KHDETECTOR_MODEL", saved.c_str(), 1);
+    } else {
+        unsetenv("KHDETECTOR_MODEL");
+    }
+#else
+    GTEST_SKIP() << "Uses setenv()";
+#endif
+}
+
+TEST_F(AiInferenceTest, StreamingModelCarriesStatePerStream)
+{
+    writeStreamingModel(10.0f);
+    AiInference inference(makeConfig());
+    ASSERT_TRUE(inference.initialize(makeConfig()));
+    ASSERT_TRUE(inference.isStreaming());
+    ASSERT_EQ(inference.getStateSize(), 2);
+
+    const std::vector<float> loud = makeFrames(1, 1);
+    std::vector<float> detection;
+    for (int hop = 0; hop < 4; ++hop) {
+        const auto result = inference.run(loud.data(), kInputSize);
+        ASSERT_TRUE(result.success);
+        detection.push_back(result.predictions[1]);
+    }
+    // Each loud hop moves the state further towards detection
+    EXPECT_TRUE(std::is_sorted(detection.begin(), detection.end()));
+    EXPECT_GT(detection.back(), detection.front() + 0.05f);
+
+    // A snapshot rewinds the stream
+    std::vector<float> snapshot(inference.getStateSize());
+    ASSERT_TRUE(inference.saveState(snapshot.data()));
+    const float next = inference.run(loud.data(), kInputSize).predictions[1];
+    inference.run(loud.data(), kInputSize);
+    ASSERT_TRUE(inference.restoreState(snapshot.data()));
+    EXPECT_FLOAT_EQ(inference.run(loud.data(), kInputSize).predictions[1], next);
+    EXPECT_FALSE(inference.saveState(snapshot.data(), 1));
+
+    inference.resetState();
+    EXPECT_FLOAT_EQ(inference.run(loud.data(), kInputSize).predictions[1], detection.front());
+
+    // Streams advance independently: stream 0 loud throughout, stream 1 quiet then loud
+    ASSERT_TRUE(inference.setNumStreams(2));
+    std::vector<float> hops = makeFrames(2, 1);
+    std::vector<AiInference::InferenceResult> results(2);
+    ASSERT_TRUE(inference.runStreams(hops.data(), 2, results.data()));
+    EXPECT_FLOAT_EQ(results[0].predictions[1], detection.front());
+    EXPECT_LT(results[1].predictions[1], 0.5f);
+    EXPECT_EQ(results[0].frameIndex, results[1].frameIndex);
+
+    std::copy(loud.begin(), loud.end(), hops.begin() + kInputSize);
+    ASSERT_TRUE(inference.runStreams(hops.data(), 2, results.data()));
+    EXPECT_FLOAT_EQ(results[0].predictions[1], detection[1]);
+    EXPECT_LT(results[1].predictions[1], results[0].predictions[1]);
+
+    hops.resize(3 * kInputSize);
+    results.resize(3);
+    EXPECT_FALSE(inference.runStreams(hops.data(), 3, results.data()));
+    EXPECT_FALSE(results[2].success);
+}
@@ -0,0 +1,416 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "DspKernels.h"
+#include "PolyphaseDecimator.h"
+#include "RationalResampler.h"
+
+using namespace KhDetector;
+
+class DspKernelsTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        // Every variant this build and CPU can run, scalar reference first
+        for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2,
+                                 SimdLevel::AVX512, SimdLevel::NEON }) {
+            if (const DspKernels* kernels = getDspKernelsFor(level)) {
+                available.push_back(kernels);
+            }
+        }
+        reference = available.front();
+    }
+
+    void TearDown() override
+    {
+        // Tests may rebind the process-wide kernels
+        forceSimdLevel(detectSimdLevel());
+    }
+
+    std::vector<float> randomSignal(size_t size, unsigned seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+        std::vector<float> signal(size);
+        for (auto& sample : signal) {
+            sample = dist(rng);
+        }
+        return signal;
+    }
+
+    std::vector<const DspKernels*> available;
+    const DspKernels* reference = nullptr;
+};
+
+TEST_F(DspKernelsTest, ScalarAlwaysAvailableAndBestIsBound)
+{
+    ASSERT_NE(reference, nullptr);
+    EXPECT_EQ(reference->level, SimdLevel::Scalar);
+
+    const DspKernels* best = getDspKernelsFor(detectSimdLevel());
+    ASSERT_NE(best, nullptr);
+    EXPECT_EQ(&getDspKernels(), best);
+    EXPECT_EQ(best, available.back());
+
+    std::cout << "Available kernel variants:";
+    for (const DspKernels* kernels : available) {
+        std::cout << " " << getSimdLevelName(kernels->level);
+    }
+    std::cout << " (bound: " << getSimdLevelName(getDspKernels().level) << ")" << std::endl;
+}
+
+TEST_F(DspKernelsTest, ForceSimdLevel)
+{
+    for (const DspKernels* kernels : available) {
+        ASSERT_TRUE(forceSimdLevel(kernels->level));
+        EXPECT_EQ(&getDspKernels(), kernels);
+    }
+
+    // Unavailable variants leave the binding alone
+    for (SimdLevel level : { SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512, SimdLevel::NEON }) {
+        if (!getDspKernelsFor(level)) {
+            const DspKernels* before = &getDspKernels();
+            EXPECT_FALSE(forceSimdLevel(level));
+            EXPECT_EQ(&getDspKernels(), before);
+        }
+    }
+}
+
+TEST_F(DspKernelsTest, DotProductAgreesAcrossVariants)
+{
+    auto coeffs = randomSignal(256, 1);
+    auto samples = randomSignal(260, 2);
+
+    for (const DspKernels* kernels : available) {
+        SCOPED_TRACE(getSimdLevelName(kernels->level));
+        for (int length : { 0, 1, 3, 4, 7, 8, 15, 16, 17, 31, 32, 33, 48, 96, 192, 255 }) {
+            // Misaligned sample windows, as used by the rational resampler
+            for (int offset : { 0, 1, 3 }) {
+                float expected = reference->dotProduct(coeffs.data(), samples.data() + offset, length);
+                float actual = kernels->dotProduct(coeffs.data(), samples.data() + offset, length);
+                EXPECT_NEAR(actual, expected, 1e-5f * (1.0f + length)) << "length " << length;
+            }
+        }
+    }
+}
+
+TEST_F(DspKernelsTest, FirBlockRowsAgreesAcrossVariants)
+{
+    const int maxRows = 12;
+    const int maxTaps = 64;
+    const int maxOutputs = 150;
+    const int sampleStride = maxTaps + maxOutputs;
+    auto coeffs = randomSignal(maxRows * maxTaps, 3);
+    auto samples = randomSignal(maxRows * sampleStride, 4);
+    std::vector<float> expected(maxOutputs);
+    std::vector<float> actual(maxOutputs);
+
+    for (const DspKernels* kernels : available) {
+        SCOPED_TRACE(getSimdLevelName(kernels->level));
+        for (int rows : { 1, 2, 3, 12 }) {
+            for (int taps : { 1, 5, 8, 16, 17, 32, 64 }) {
+                for (int outputs : { 0, 1, 7, 8, 15, 16, 31, 32, 63, 64, 65, 128, 150 }) {
+                    reference->firBlockRows(coeffs.data(), maxTaps, samples.data(), sampleStride,
+                                            rows, taps, expected.data(), outputs);
+                    kernels->firBlockRows(coeffs.data(), maxTaps, samples.data(), sampleStride,
+                                          rows, taps, actual.data(), outputs);
+                    for (int k = 0; k < outputs; ++k) {
+                        ASSERT_NEAR(actual[k], expected[k], 1e-5f * (1.0f + rows * taps))
+                            << "rows " << rows << ", taps " << taps << ", outputs " << outputs << ", k " << k;
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_F(DspKernelsTest, FirGatherAgreesAcrossVariants)
+{
+    const int rows = 7;
+    const int maxTaps = 56;
+    auto coeffs = randomSignal(rows * maxTaps, 8);
+    auto samples = randomSignal(512, 9);
+    std::vector<int> coeffOffsets(70);
+    std::vector<int> sampleOffsets(70);
+    for (size_t k = 0; k < coeffOffsets.size(); ++k) {
+        coeffOffsets[k] = static_cast<int>((k * 3) % rows) * maxTaps;
+        sampleOffsets[k] = static_cast<int>(k * 5 + k % 3);
+    }
+    std::vector<float> expected(coeffOffsets.size());
+    std::vector<float> actual(coeffOffsets.size());
+
+    for (const DspKernels* kernels : available) {
+        SCOPED_TRACE(getSimdLevelName(kernels->level));
+        for (int taps : { 1, 8, 13, 16, 24, 48, 56 }) {
+            for (int outputs : { 0, 1, 3, 4, 7, 8, 9, 17, 64, 70 }) {
+                reference->firGather(coeffs.data(), coeffOffsets.data(), samples.data(), sampleOffsets.data(),
+                                     taps, expected.data(), outputs);
+                kernels->firGather(coeffs.data(), coeffOffsets.data(), samples.data(), sampleOffsets.data(),
+                                   taps, actual.data(), outputs);
+                for (int k = 0; k < outputs; ++k) {
+                    ASSERT_NEAR(actual[k], expected[k], 1e-5f * (1.0f + taps))
+                        << "taps " << taps << ", outputs " << outputs << ", k " << k;
+                }
+            }
+        }
+    }
+}
+
+TEST_F(DspKernelsTest, FirLanesAgreesAcrossVariants)
+{
+    const int maxLanes = 24;
+    const int maxTaps = 96;
+    const int maxOutputs = 20;
+    const int frameStep = 3;
+    auto coeffs = randomSignal(maxTaps, 10);
+    auto frames = randomSignal((maxOutputs * frameStep + maxTaps) * maxLanes, 11);
+    std::vector<float> expected(maxOutputs * maxLanes);
+    std::vector<float> actual(maxOutputs * maxLanes);
+
+    for (const DspKernels* kernels : available) {
+        SCOPED_TRACE(getSimdLevelName(kernels->level));
+        for (int lanes : { 8, 16, 24 }) {
+            for (int taps : { 1, 3, 4, 17, 48, 96 }) {
+                for (int outputs : { 0, 1, 5, 20 }) {
+                    reference->firLanes(coeffs.data(), taps, frames.data(), lanes, frameStep,
+                                        expected.data(), outputs);
+                    kernels->firLanes(coeffs.data(), taps, frames.data(), lanes, frameStep,
+                                      actual.data(), outputs);
+                    for (int i = 0; i < outputs * lanes; ++i) {
+                        ASSERT_NEAR(actual[i], expected[i], 1e-5f * (1.0f + taps))
+                            << "lanes " << lanes << ", taps " << taps << ", outputs " << outputs << ", i " << i;
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_F(DspKernelsTest, NormalizeMatchesExactly)
+{
+    auto input = randomSignal(1027, 5);
+    std::vector<float> expected(input.size());
+    std::vector<float> actual(input.size());
+
+    for (const DspKernels* kernels : available) {
+        SCOPED_TRACE(getSimdLevelName(kernels->level));
+        for (int n : { 0, 1, 5, 16, 1027 }) {
+            reference->normalize(input.data(), expected.data(), n, 0.125f, 1.0f / 0.3f);
+            kernels->normalize(input.data(), actual.data(), n, 0.125f, 1.0f / 0.3f);
+            for (int i = 0; i < n; ++i) {
+                ASSERT_EQ(actual[i], expected[i]) << "n " << n << ", i " << i;
+            }
+        }
+
+        // In place
+        std::vector<float> inPlace = input;
+        kernels->normalize(inPlace.data(), inPlace.data(), static_cast<int>(inPlace.size()), 0.125f, 1.0f / 0.3f);
+        reference->normalize(input.data(), expected.data(), static_cast<int>(input.size()), 0.125f, 1.0f / 0.3f);
+        EXPECT_EQ(inPlace, expected);
+    }
+}
+
+TEST_F(DspKernelsTest, MultiplyAccumulateMatchesExactly)
+{
+    auto input = randomSignal(1031, 12);
+    auto initial = randomSignal(1031, 13);
+
+    for (const DspKernels* kernels : available) {
+        SCOPED_TRACE(getSimdLevelName(kernels->level));
+        for (int n : { 0, 1, 7, 16, 33, 1031 }) {
+            std::vector<float> expected = initial;
+            std::vector<float> actual = initial;
+            reference->multiplyAccumulate(input.data(), 0.7f, expected.data(), n);
+            kernels->multiplyAccumulate(input.data(), 0.7f, actual.data(), n);
+            for (int i = 0; i < n; ++i) {
+                // One rounding with FMA, two without
+                ASSERT_NEAR(actual[i], expected[i], 1e-6f) << "n " << n << ", i " << i;
+            }
+            EXPECT_TRUE(std::equal(actual.begin() + n, actual.end(), initial.begin() + n)) << "wrote past n";
+        }
+    }
+}
+
+TEST_F(DspKernelsTest, FftButterfliesAgreeAcrossVariants)
+{
+    auto initialRe = randomSignal(256, 14);
+    auto initialIm = randomSignal(256, 15);
+    auto twiddleRe = randomSignal(128, 16);
+    auto twiddleIm = randomSignal(128, 17);
+
+    for (const DspKernels* kernels : available) {
+        SCOPED_TRACE(getSimdLevelName(kernels->level));
+        for (int half : { 8, 16, 32, 64, 128 }) {
+            std::vector<float> expectedRe = initialRe;
+            std::vector<float> expectedIm = initialIm;
+            std::vector<float> actualRe = initialRe;
+            std::vector<float> actualIm = initialIm;
+            reference->fftButterflies(expectedRe.data(), expectedIm.data(), twiddleRe.data(), twiddleIm.data(),
+                                      256, half);
+            kernels->fftButterflies(actualRe.data(), actualIm.data(), twiddleRe.data(), twiddleIm.data(), 256, half);
+            for (int i = 0; i < 256; ++i) {
+                ASSERT_NEAR(actualRe[i], expectedRe[i], 1e-5f) << "half " << half << ", i " << i;
+                ASSERT_NEAR(actualIm[i], expectedIm[i], 1e-5f) << "half " << half << ", i " << i;
+            }
+        }
+    }
+}
+
+TEST_F(DspKernelsTest, DenseLayerAgreesAcrossVariants)
+{
+    auto weights = randomSignal(64 * 41, 18);
+    auto bias = randomSignal(64, 19);
+    auto input = randomSignal(41, 20);
+
+    for (const DspKernels* kernels : available) {
+        SCOPED_TRACE(getSimdLevelName(kernels->level));
+        // Odd input counts and every mix of 32-, 16- and 8-output passes
+        for (int numInputs : { 1, 2, 3, 16, 40, 41 }) {
+            for (int numOutputs : { 8, 16, 24, 32, 40, 64 }) {
+                for (bool relu : { false, true }) {
+                    std::vector<float> expected(numOutputs);
+                    std::vector<float> actual(numOutputs);
+                    reference->denseLayer(weights.data(), bias.data(), input.data(), numInputs,
+                                          expected.data(), numOutputs, relu);
+                    kernels->denseLayer(weights.data(), bias.data(), input.data(), numInputs,
+                                        actual.data(), numOutputs, relu);
+                    for (int o = 0; o < numOutputs; ++o) {
+                        ASSERT_NEAR(actual[o], expected[o], 1e-5f)
+                            << numInputs << " -> " << numOutputs << (relu ? " relu" : "") << ", output " << o;
+                        if (relu) {
+                            ASSERT_GE(actual[o], 0.0f);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_F(DspKernelsTest, GruUpdateMatchesExactGates)
+{
+    // Gate pre-activations well past the tanh clamp, so saturation is covered
+    auto inputGates = randomSignal(3 * 33, 21);
+    auto hiddenGates = randomSignal(3 * 33, 22);
+    auto state = randomSignal(33, 23);
+    for (auto& value : inputGates) {
+        value *= 12.0f;
+    }
+
+    const auto sigmoid = [](double v) { return 1.0 / (1.0 + std::exp(-v)); };
+
+    for (const DspKernels* kernels : available) {
+        SCOPED_TRACE(getSimdLevelName(kernels->level));
+        // Whole vectors, tails only and both
+        for (int size : { 1, 3, 7, 8, 20, 33 }) {
+            std::vector<float> x(inputGates.begin(), inputGates.begin() + 3 * size);
+            std::vector<float> h(hiddenGates.begin(), hiddenGates.begin() + 3 * size);
+            std::vector<float> expected(state.begin(), state.begin() + size);
+            std::vector<float> actual = expected;
+            std::vector<float> scalar = expected;
+
+            reference->gruUpdate(x.data(), h.data(), scalar.data(), size);
+            kernels->gruUpdate(x.data(), h.data(), actual.data(), size);
+            for (int j = 0; j < size; ++j) {
+                const double reset = sigmoid(x[j] + h[j]);
+                const double update = sigmoid(x[size + j] + h[size + j]);
+                const double candidate = std::tanh(x[2 * size + j] + reset * h[2 * size + j]);
+                expected[j] = static_cast<float>((1.0 - update) * candidate + update * expected[j]);
+
+                ASSERT_NEAR(actual[j], expected[j], 2e-6f) << "size " << size << ", unit " << j;
+                ASSERT_NEAR(actual[j], scalar[j], 1e-6f) << "size " << size << ", unit " << j;
+            }
+        }
+    }
+}
+
+TEST_F(DspKernelsTest, FrameFeaturesAgreeAcrossVariants)
+{
+    auto samples = randomSignal(4099, 6);
+
+    for (const DspKernels* kernels : available) {
+        SCOPED_TRACE(getSimdLevelName(kernels->level));
+        for (int n : { 0, 1, 2, 9, 17, 64, 1024, 4099 }) {
+            FrameFeatures expected;
+            FrameFeatures actual;
+            reference->frameFeatures(samples.data(), n, expected);
+            kernels->frameFeatures(samples.data(), n, actual);
+
+            EXPECT_NEAR(actual.sumSquares, expected.sumSquares, 1e-4f * (1.0f + expected.sumSquares)) << "n " << n;
+            EXPECT_EQ(actual.zeroCrossings, expected.zeroCrossings) << "n " << n;
+            EXPECT_NEAR(actual.sumMagnitude, expected.sumMagnitude, 1e-4f * (1.0f + expected.sumMagnitude)) << "n " << n;
+            EXPECT_NEAR(actual.weightedMagnitude, expected.weightedMagnitude,
+                        1e-4f * (1.0f + expected.weightedMagnitude)) << "n " << n;
+        }
+    }
+}
+
+TEST_F(DspKernelsTest, MedianMatchesSortedReference)
+{
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> coarse(0, 7);
+
+    for (const DspKernels* kernels : available) {
+        SCOPED_TRACE(getSimdLevelName(kernels->level));
+        EXPECT_EQ(kernels->median(nullptr, 0), 0.0f);
+
+        for (int n = 1; n <= 70; ++n) {
+            // Few distinct values, so ties straddle the middle ranks
+            std::vector<float> values(n);
+            for (auto& value : values) {
+                value = 0.1f * coarse(rng) - 0.3f;
+            }
+            std::vector<float> sorted = values;
+            std::sort(sorted.begin(), sorted.end());
+            float expected = (sorted[(n - 1) / 2] + sorted[n / 2]) * 0.5f;
+
+            std::vector<float> input = values;
+            EXPECT_EQ(kernels->median(input.data(), n), expected) << "n " << n;
+            EXPECT_EQ(input, values) << "median must not reorder its input";
+        }
+    }
+}
+
+TEST_F(DspKernelsTest, ResamplerOutputAgreesOnForcedPaths)
+{
+    std::vector<float> input(4800);
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = 0.5f * std::sin(2.0f * M_PI * 1000.0f * i / 48000.0f);
+    }
+
+    std::vector<float> expected;
+    for (const DspKernels* kernels : available) {
+        SCOPED_TRACE(getSimdLevelName(kernels->level));
+        ASSERT_TRUE(forceSimdLevel(kernels->level));
+
+        PolyphaseDecimator<3, 48> decimator;
+        ResamplerTo16k resampler;
+        ASSERT_TRUE(resampler.configure(44100.0));
+        std::vector<float> output(decimator.getOutputCount(static_cast<int>(input.size())) +
+                                  resampler.getOutputCount(static_cast<int>(input.size())));
+        int produced = 0;
+        for (size_t offset = 0; offset < input.size(); offset += 333) {
+            int count = static_cast<int>(std::min<size_t>(333, input.size() - offset));
+            produced += decimator.processMono(input.data() + offset, output.data() + produced, count);
+        }
+        for (size_t offset = 0; offset < input.size(); offset += 333) {
+            int count = static_cast<int>(std::min<size_t>(333, input.size() - offset));
+            produced += resampler.processMono(input.data() + offset, output.data() + produced, count);
+        }
+        output.resize(produced);
+
+        if (expected.empty()) {
+            expected = output;
+            continue;
+        }
+        ASSERT_EQ(output.size(), expected.size());
+        for (size_t i = 0; i < output.size(); ++i) {
+            ASSERT_NEAR(output[i], expected[i], 1e-5f) << "sample " << i;
+        }
+    }
+}
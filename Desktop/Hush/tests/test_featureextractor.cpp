@@ -0,0 +1,358 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "DspKernels.h"
+#include "FeatureExtractor.h"
+
+using namespace KhDetector;
+
+// Set by the test target; the fallback works when running from Desktop/Hush
+#ifndef KHDETECTOR_TEST_DATA_DIR
+#define KHDETECTOR_TEST_DATA_DIR "tests/data"
+#endif
+
+/**
+ * The reference below re-derives librosa's definitions in double precision
+ * with a direct DFT. The golden file tests/data/features_44100.khfg holds a
+ * clip and its features as training/make_feature_golden.py writes them;
+ * KHDETECTOR_FEATURE_GOLDEN points the test at another one, e.g.
+ *
+ *   KHDETECTOR_FEATURE_GOLDEN=/path/to/features.khfg ./KhDetectorTests --gtest_filter=FeatureExtractor*
+ */
+class FeatureExtractorTest : public ::testing::Test
+{
+protected:
+    using FE = FeatureExtractor;
+
+    void SetUp() override
+    {
+        for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2,
+                                 SimdLevel::AVX512, SimdLevel::NEON }) {
+            if (getDspKernelsFor(level)) {
+                levels.push_back(level);
+            }
+        }
+    }
+
+    void TearDown() override
+    {
+        forceSimdLevel(detectSimdLevel());
+    }
+
+    // Speech-like test clip: a gliding harmonic tone, a noise burst and a
+    // noise floor that keeps every mel band within power_to_db's 80 dB
+    static std::vector<float> makeClip(int numSamples, float sampleRate, unsigned seed)
+    {
+        std::mt19937 gen(seed);
+        std::normal_distribution<float> noise(0.0f, 1.0f);
+        std::vector<float> clip(numSamples);
+        double phase = 0.0;
+        for (int n = 0; n < numSamples; ++n) {
+            const double t = n / sampleRate;
+            phase += 2.0 * M_PI * (150.0 + 100.0 * t) / sampleRate;
+            double value = 0.0;
+            for (int h = 1; h <= 5; ++h) {
+                value += 0.2 / h * std::sin(h * phase);
+            }
+            const bool burst = n > numSamples / 2 && n < numSamples / 2 + numSamples / 8;
+            value += (burst ? 0.1 : 0.003) * noise(gen);
+            clip[n] = static_cast<float>(value);
+        }
+        return clip;
+    }
+
+    static std::vector<float> runStream(const std::vector<float>& samples, float sampleRate, int chunkSize)
+    {
+        FE extractor(sampleRate);
+        std::vector<float> features;
+        for (size_t start = 0; start < samples.size(); start += chunkSize) {
+            const int count = static_cast<int>(std::min<size_t>(chunkSize, samples.size() - start));
+            const size_t offset = features.size();
+            features.resize(offset + extractor.getFrameCount(count) * FE::kNumFeatures);
+            const int frames = extractor.process(samples.data() + start, count, features.data() + offset);
+            EXPECT_EQ(static_cast<size_t>(frames * FE::kNumFeatures), features.size() - offset);
+        }
+        return features;
+    }
+
+    static double hzToMel(double hz)
+    {
+        return hz < 1000.0 ? hz * 3.0 / 200.0 : 15.0 + std::log(hz / 1000.0) * 27.0 / std::log(6.4);
+    }
+
+    static double melToHz(double mel)
+    {
+        return mel < 15.0 ? mel * 200.0 / 3.0 : 1000.0 * std::exp((mel - 15.0) * std::log(6.4) / 27.0);
+    }
+
+    /**
+     * @brief librosa features of every frame that lies fully inside the clip, in double precision
+     */
+    static std::vector<std::vector<double>> referenceFeatures(const std::vector<float>& samples, double sampleRate)
+    {
+        const int n = FE::kFftSize;
+        const int bins = FE::kNumBins;
+        std::vector<double> cosTable(n), sinTable(n), window(n);
+        for (int i = 0; i < n; ++i) {
+            cosTable[i] = std::cos(2.0 * M_PI * i / n);
+            sinTable[i] = std::sin(2.0 * M_PI * i / n);
+            window[i] = 0.5 - 0.5 * std::cos(2.0 * M_PI * i / n);
+        }
+
+        std::vector<double> edges(FE::kNumMels + 2);
+        for (int i = 0; i < FE::kNumMels + 2; ++i) {
+            edges[i] = melToHz(hzToMel(sampleRate / 2.0) * i / (FE::kNumMels + 1));
+        }
+
+        std::vector<std::vector<double>> mfccs;
+        std::vector<std::vector<double>> frames;
+        for (int t = 0; t * FE::kHopLength + n / 2 <= static_cast<int>(samples.size()); ++t) {
+            std::vector<double> frame(n);
+            int firstReal = n;
+            for (int i = 0; i < n; ++i) {
+                const int index = t * FE::kHopLength - n / 2 + i;
+                frame[i] = index >= 0 ? samples[index] : 0.0;
+                if (index >= 0) {
+                    firstReal = std::min(firstReal, i);
+                }
+            }
+
+            std::vector<double> power(bins), magnitude(bins);
+            double energy = 0.0, weighted = 0.0, total = 0.0;
+            for (int k = 0; k < bins; ++k) {
+                double re = 0.0, im = 0.0;
+                for (int i = 0; i < n; ++i) {
+                    const int phase = static_cast<int>((static_cast<long long>(i) * k) % n);
+                    re += frame[i] * window[i] * cosTable[phase];
+                    im -= frame[i] * window[i] * sinTable[phase];
+                }
+                power[k] = re * re + im * im;
+                magnitude[k] = std::sqrt(power[k]);
+                energy += re * re - im * im;
+                weighted += magnitude[k] * k * sampleRate / n;
+                total += magnitude[k];
+            }
+
+            std::vector<double> logMel(FE::kNumMels);
+            double maxDb = -1e300;
+            for (int m = 0; m < FE::kNumMels; ++m) {
+                double sum = 0.0;
+                for (int k = 0; k < bins; ++k) {
+                    const double f = k * sampleRate / n;
+                    const double w = std::max(0.0, std::min((f - edges[m]) / (edges[m + 1] - edges[m]),
+                                                            (edges[m + 2] - f) / (edges[m + 2] - edges[m + 1])));
+                    sum += w * 2.0 / (edges[m + 2] - edges[m]) * power[k];
+                }
+                logMel[m] = 10.0 * std::log10(std::max(1e-10, sum));
+                maxDb = std::max(maxDb, logMel[m]);
+            }
+
+            std::vector<double> mfcc(FE::kNumMfcc);
+            for (int k = 0; k < FE::kNumMfcc; ++k) {
+                double sum = 0.0;
+                for (int m = 0; m < FE::kNumMels; ++m) {
+                    sum += std::max(logMel[m], maxDb - 80.0) * std::cos(M_PI * k * (2 * m + 1) / (2.0 * FE::kNumMels));
+                }
+                mfcc[k] = sum * std::sqrt((k == 0 ? 1.0 : 2.0) / FE::kNumMels);
+            }
+
+            // Zero crossings over the real samples (librosa pads with the edge value)
+            int crossings = 0;
+            for (int i = firstReal + 1; i < n; ++i) {
+                crossings += (frame[i] >= 0.0) != (frame[i - 1] >= 0.0);
+            }
+
+            mfccs.push_back(mfcc);
+            frames.push_back({ total > 0.0 ? weighted / total : 0.0, static_cast<double>(crossings) / n, energy });
+        }
+
+        // Savitzky-Golay deltas; the first four frames take the fifth's (librosa's interp mode)
+        std::vector<std::vector<double>> features;
+        for (int t = 0; t + 4 < static_cast<int>(mfccs.size()); ++t) {
+            const int centre = std::max(t, 4);
+            std::vector<double> feature(mfccs[t]);
+            std::vector<double> delta(FE::kNumMfcc, 0.0), delta2(FE::kNumMfcc, 0.0);
+            for (int c = 0; c < FE::kNumMfcc; ++c) {
+                for (int k = -4; k <= 4; ++k) {
+                    delta[c] += k * mfccs[centre + k][c] / 60.0;
+                    delta2[c] += (k * k - 20.0 / 3.0) * mfccs[centre + k][c] / 154.0;
+                }
+            }
+            feature.insert(feature.end(), delta.begin(), delta.end());
+            feature.insert(feature.end(), delta2.begin(), delta2.end());
+            feature.insert(feature.end(), frames[t].begin(), frames[t].end());
+            features.push_back(feature);
+        }
+        return features;
+    }
+
+    static void expectFeaturesNear(const float* actual, const std::vector<double>& expected, int frame,
+                                   double cepstralTolerance)
+    {
+        for (int i = 0; i < FE::kCentroidIndex; ++i) {
+            EXPECT_NEAR(actual[i], expected[i], cepstralTolerance) << "frame " << frame << ", feature " << i;
+        }
+        EXPECT_NEAR(actual[FE::kCentroidIndex], expected[FE::kCentroidIndex],
+                    1e-3 * expected[FE::kCentroidIndex] + 0.1) << "frame " << frame;
+        EXPECT_NEAR(actual[FE::kZeroCrossingIndex], expected[FE::kZeroCrossingIndex], 1.5 / FE::kFftSize)
+            << "frame " << frame;
+        EXPECT_NEAR(actual[FE::kEnergyIndex], expected[FE::kEnergyIndex], 1e-3 * std::fabs(expected[FE::kEnergyIndex]) + 1e-6)
+            << "frame " << frame;
+    }
+
+    std::vector<SimdLevel> levels;
+};
+
+TEST_F(FeatureExtractorTest, MatchesDoublePrecisionReference)
+{
+    for (float sampleRate : { 44100.0f, 16000.0f }) {
+        const std::vector<float> clip = makeClip(static_cast<int>(sampleRate * 0.4f), sampleRate, 1);
+        const std::vector<std::vector<double>> expected = referenceFeatures(clip, sampleRate);
+        const std::vector<float> features = runStream(clip, sampleRate, static_cast<int>(clip.size()));
+
+        const size_t numFrames = features.size() / FeatureExtractor::kNumFeatures;
+        ASSERT_EQ(numFrames, expected.size());
+        ASSERT_GT(numFrames, 5u);
+        for (size_t t = 0; t < numFrames; ++t) {
+            expectFeaturesNear(features.data() + t * FeatureExtractor::kNumFeatures, expected[t],
+                               static_cast<int>(t), 2e-3);
+        }
+    }
+}
+
+TEST_F(FeatureExtractorTest, ChunkingDoesNotChangeFeatures)
+{
+    const std::vector<float> clip = makeClip(44100, 44100.0f, 2);
+    const std::vector<float> whole = runStream(clip, 44100.0f, static_cast<int>(clip.size()));
+    ASSERT_FALSE(whole.empty());
+
+    for (int chunkSize : { 1, 7, 320, 512, 1024, 4096 }) {
+        EXPECT_EQ(runStream(clip, 44100.0f, chunkSize), whole) << "chunk size " << chunkSize;
+    }
+
+    // reset() starts a new stream from scratch
+    FeatureExtractor extractor(44100.0f);
+    std::vector<float> first(extractor.getFrameCount(10000) * FeatureExtractor::kNumFeatures);
+    extractor.process(clip.data() + 20000, 10000, first.data());
+    extractor.reset();
+    std::vector<float> again(extractor.getFrameCount(static_cast<int>(clip.size())) * FeatureExtractor::kNumFeatures);
+    extractor.process(clip.data(), static_cast<int>(clip.size()), again.data());
+    EXPECT_EQ(again, whole);
+}
+
+TEST_F(FeatureExtractorTest, ReleasesFramesWithDeltaLatency)
+{
+    FeatureExtractor extractor(16000.0f);
+    std::vector<float> features(16 * FeatureExtractor::kNumFeatures);
+
+    // Frame t is released kLatencySamples after its centre, t * hop; frames 0
+    // to 3 wait for frame 4, whose deltas they share
+    const int firstRelease = 4 * FeatureExtractor::kHopLength + FeatureExtractor::kLatencySamples;
+    EXPECT_EQ(extractor.getFrameCount(firstRelease - 1), 0);
+    EXPECT_EQ(extractor.process(std::vector<float>(firstRelease - 1).data(), firstRelease - 1, features.data()), 0);
+    EXPECT_EQ(extractor.getFrameCount(1), 5);
+    EXPECT_EQ(extractor.process(std::vector<float>(1).data(), 1, features.data()), 5);
+    EXPECT_EQ(extractor.getFrameCount(FeatureExtractor::kHopLength - 1), 0);
+    EXPECT_EQ(extractor.getFrameCount(FeatureExtractor::kHopLength), 1);
+    EXPECT_EQ(extractor.getFrameCount(3 * FeatureExtractor::kHopLength), 3);
+
+    // Silence: zero features apart from librosa's -100 dB floor in the first MFCC
+    for (int t = 0; t < 5; ++t) {
+        const float* frame = features.data() + t * FeatureExtractor::kNumFeatures;
+        EXPECT_NEAR(frame[0], -100.0f * std::sqrt(static_cast<float>(FeatureExtractor::kNumMels)), 1e-2f);
+        for (int i = 1; i < FeatureExtractor::kNumFeatures; ++i) {
+            EXPECT_NEAR(frame[i], 0.0f, 1e-3f) << "feature " << i;
+        }
+    }
+}
+
+TEST_F(FeatureExtractorTest, AgreesAcrossSimdLevels)
+{
+    const std::vector<float> clip = makeClip(22050, 44100.0f, 3);
+    ASSERT_TRUE(forceSimdLevel(SimdLevel::Scalar));
+    const std::vector<float> reference = runStream(clip, 44100.0f, 441);
+
+    for (SimdLevel level : levels) {
+        ASSERT_TRUE(forceSimdLevel(level));
+        const std::vector<float> features = runStream(clip, 44100.0f, 441);
+        ASSERT_EQ(features.size(), reference.size());
+        for (size_t i = 0; i < features.size(); ++i) {
+            EXPECT_NEAR(features[i], reference[i], 1e-3f * std::max(1.0f, std::fabs(reference[i])))
+                << getSimdLevelName(level) << ", value " << i;
+        }
+    }
+}
+
+TEST_F(FeatureExtractorTest, MatchesLibrosaGoldenFile)
+{
+    // Layout written by make_feature_golden.py; KHDETECTOR_FEATURE_GOLDEN names another clip's file
+    const char* override = std::getenv("KHDETECTOR_FEATURE_GOLDEN");
+    const std::string path = override ? override : KHDETECTOR_TEST_DATA_DIR "/features_44100.khfg";
+    std::ifstream file(path, std::ios::binary);
+    ASSERT_TRUE(file) << path;
+    char magic[4];
+    uint32_t header[5];
+    file.read(magic, 4);
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    ASSERT_EQ(std::memcmp(magic, "KHFG", 4), 0);
+    ASSERT_EQ(header[0], 1u);
+    const float sampleRate = static_cast<float>(header[1]);
+    const uint32_t numSamples = header[2], numFrames = header[3], numFeatures = header[4];
+    ASSERT_EQ(numFeatures, static_cast<uint32_t>(FeatureExtractor::kNumFeatures));
+
+    std::vector<float> samples(numSamples), golden(static_cast<size_t>(numFrames) * numFeatures);
+    file.read(reinterpret_cast<char*>(samples.data()), samples.size() * sizeof(float));
+    file.read(reinterpret_cast<char*>(golden.data()), golden.size() * sizeof(float));
+    ASSERT_TRUE(file);
+
+    const std::vector<float> features = runStream(samples, sampleRate, 441);
+    const size_t compared = std::min<size_t>(features.size() / numFeatures, numFrames);
+    ASSERT_GT(compared, 5u);
+    for (size_t t = 0; t < compared; ++t) {
+        const std::vector<double> expected(golden.begin() + t * numFeatures, golden.begin() + (t + 1) * numFeatures);
+        // librosa computes in float32 too
+        expectFeaturesNear(features.data() + t * numFeatures, expected, static_cast<int>(t), 2e-2);
+    }
+}
+
+TEST_F(FeatureExtractorTest, PerformanceBenchmark_CostPerHop)
+{
+    const float sampleRate = 44100.0f;
+    const std::vector<float> clip = makeClip(static_cast<int>(sampleRate) * 10, sampleRate, 4);
+    FeatureExtractor extractor(sampleRate);
+    std::vector<float> features(extractor.getFrameCount(static_cast<int>(clip.size())) * FeatureExtractor::kNumFeatures);
+
+    std::cout << "Feature extraction, 10 s at 44.1 kHz:" << std::endl;
+    for (SimdLevel level : levels) {
+        ASSERT_TRUE(forceSimdLevel(level));
+        extractor.reset();
+
+        // 10 ms host blocks
+        const int block = 441;
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (size_t offset = 0; offset + block <= clip.size(); offset += block) {
+            extractor.process(clip.data() + offset, block, features.data());
+        }
+        const auto end = std::chrono::high_resolution_clock::now();
+
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        const double hops = static_cast<double>(clip.size()) / FeatureExtractor::kHopLength;
+        std::cout << "  " << getSimdLevelName(level) << ": " << std::fixed << std::setprecision(2)
+                  << seconds / hops * 1e6 << " us per hop, " << std::setprecision(3) << seconds / 10.0 * 100.0
+                  << "% of one core" << std::endl;
+
+        // A few percent of one core at most
+        EXPECT_LT(seconds / 10.0, 0.05);
+    }
+}
@@ -0,0 +1,273 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "ActivityGate.h"
+#include "AiInference.h"
+#include "FrameAssembler.h"
+#include "RealtimeThreadPool.h"
+
+using namespace KhDetector;
+
+class FrameAssemblerTest : public ::testing::Test
+{
+protected:
+    static constexpr int kFrameSize = 320;
+
+    /**
+     * @brief Sample i is i, so every frame shows where it came from
+     */
+    static std::vector<float> makeRamp(size_t numSamples)
+    {
+        std::vector<float> ramp(numSamples);
+        for (size_t i = 0; i < numSamples; ++i) {
+            ramp[i] = static_cast<float>(i);
+        }
+        return ramp;
+    }
+
+    /**
+     * @brief Noise whose level and brightness change every few hundred samples
+     */
+    static std::vector<float> makeSpeechLike(size_t numSamples, unsigned seed)
+    {
+        std::mt19937 gen(seed);
+        std::normal_distribution<float> noise(0.0f, 1.0f);
+        std::uniform_real_distribution<float> level(0.0f, 0.5f);
+        std::vector<float> signal(numSamples);
+        float gain = 0.0f;
+        float smoothing = 0.0f;
+        float previous = 0.0f;
+        for (size_t i = 0; i < numSamples; ++i) {
+            if (i % 250 == 0) {
+                gain = level(gen);
+                smoothing = level(gen) * 1.8f;   // 0: white, near 1: dark
+            }
+            previous = smoothing * previous + (1.0f - smoothing) * noise(gen);
+            signal[i] = gain * previous;
+        }
+        return signal;
+    }
+
+    /**
+     * @brief Feed a signal in blocks of blockSize and collect every frame as a copy
+     */
+    struct Collected
+    {
+        std::vector<uint64_t> starts;
+        std::vector<std::vector<float>> frames;
+    };
+
+    static Collected collect(FrameAssembler& assembler, const std::vector<float>& signal, size_t blockSize)
+    {
+        Collected collected;
+        size_t position = 0;
+        FrameAssembler::Frame frame;
+        while (position < signal.size()) {
+            const size_t block = std::min(blockSize, signal.size() - position);
+            size_t taken = 0;
+            while (taken < block) {
+                taken += assembler.push(signal.data() + position + taken, block - taken);
+                if (assembler.nextFrame(frame)) {
+                    collected.starts.push_back(frame.startSample);
+                    collected.frames.emplace_back(frame.samples, frame.samples + frame.numSamples);
+                }
+            }
+            position += block;
+        }
+        return collected;
+    }
+};
+
+TEST_F(FrameAssemblerTest, DisjointFramesByDefault)
+{
+    FrameAssembler assembler(kFrameSize);
+    EXPECT_EQ(assembler.getHop(), kFrameSize);
+
+    const std::vector<float> ramp = makeRamp(3 * kFrameSize + 100);
+    const Collected collected = collect(assembler, ramp, 128);
+
+    ASSERT_EQ(collected.starts.size(), 3u);
+    for (size_t f = 0; f < collected.frames.size(); ++f) {
+        EXPECT_EQ(collected.starts[f], f * kFrameSize);
+        EXPECT_EQ(collected.frames[f], std::vector<float>(ramp.begin() + f * kFrameSize,
+                                                          ramp.begin() + (f + 1) * kFrameSize));
+    }
+    EXPECT_EQ(assembler.getTotalSamples(), ramp.size());
+    EXPECT_EQ(assembler.getSamplesNeeded(), static_cast<size_t>(kFrameSize - 100));
+}
+
+TEST_F(FrameAssemblerTest, OverlappingFramesCarryAbsoluteIndices)
+{
+    // Long enough to move the history to the front several times
+    const std::vector<float> ramp = makeRamp(40 * kFrameSize);
+
+    for (int hop : { 80, 160, 320, 1 }) {
+        FrameAssembler assembler(kFrameSize, hop);
+        const Collected collected = collect(assembler, ramp, 37);
+
+        ASSERT_EQ(collected.starts.size(), (ramp.size() - kFrameSize) / hop + 1) << "hop " << hop;
+        for (size_t f = 0; f < collected.frames.size(); ++f) {
+            ASSERT_EQ(collected.starts[f], f * hop);
+            ASSERT_EQ(collected.frames[f].front(), static_cast<float>(f * hop));
+            ASSERT_EQ(collected.frames[f].back(), static_cast<float>(f * hop + kFrameSize - 1));
+        }
+    }
+}
+
+TEST_F(FrameAssemblerTest, HopChangesOnAlignedBoundaries)
+{
+    FrameAssembler assembler(kFrameSize, 80);
+    EXPECT_FALSE(assembler.setHop(0));
+    EXPECT_FALSE(assembler.setHop(100));       // Does not divide the frame
+    EXPECT_FALSE(assembler.setHop(640));
+    EXPECT_EQ(assembler.getHop(), 80);
+
+    const std::vector<float> ramp = makeRamp(2000);
+    std::vector<uint64_t> ends;
+    FrameAssembler::Frame frame;
+    for (size_t i = 0; i < ramp.size(); ++i) {
+        assembler.push(&ramp[i], 1);
+        if (assembler.nextFrame(frame)) {
+            ends.push_back(frame.startSample + frame.numSamples);
+            if (ends.back() == 400) {
+                // 400 is not a multiple of 160: one more frame at the old hop first
+                ASSERT_TRUE(assembler.setHop(160));
+            }
+            ASSERT_EQ(frame.samples[0], static_cast<float>(frame.startSample));
+        }
+    }
+
+    const std::vector<uint64_t> expected = { 320, 400, 480, 640, 800, 960, 1120, 1280, 1440, 1600, 1760, 1920 };
+    EXPECT_EQ(ends, expected);
+    EXPECT_EQ(assembler.getHop(), 160);
+
+    // reset() restarts the count and applies the requested hop at once
+    ASSERT_TRUE(assembler.setHop(320));
+    assembler.reset();
+    EXPECT_EQ(assembler.getHop(), 320);
+    EXPECT_EQ(assembler.getTotalSamples(), 0u);
+    EXPECT_EQ(assembler.getSamplesNeeded(), static_cast<size_t>(kFrameSize));
+}
+
+TEST_F(FrameAssemblerTest, OverlapSeesAnEventOnAFrameBoundaryWhole)
+{
+    // A 20 ms burst centered on the boundary between the first two disjoint frames
+    std::vector<float> signal(4 * kFrameSize, 0.0f);
+    std::mt19937 gen(2);
+    std::normal_distribution<float> noise(0.0f, 0.3f);
+    for (int i = kFrameSize / 2; i < kFrameSize * 3 / 2; ++i) {
+        signal[i] = noise(gen);
+    }
+    float burstEnergy = 0.0f;
+    for (float sample : signal) {
+        burstEnergy += sample * sample;
+    }
+
+    const auto largestShare = [&](int hop) {
+        FrameAssembler assembler(kFrameSize, hop);
+        const Collected collected = collect(assembler, signal, 64);
+        float largest = 0.0f;
+        for (const auto& frame : collected.frames) {
+            float energy = 0.0f;
+            for (float sample : frame) {
+                energy += sample * sample;
+            }
+            largest = std::max(largest, energy / burstEnergy);
+        }
+        return largest;
+    };
+
+    EXPECT_LT(largestShare(kFrameSize), 0.75f);      // Only halves
+    EXPECT_NEAR(largestShare(kFrameSize / 2), 1.0f, 1e-4f);
+}
+
+TEST_F(FrameAssemblerTest, PoolRunsOverlappingFrames)
+{
+    AiInference::ModelConfig config = createDefaultModelConfig();
+    config.inputSize = kFrameSize;
+    config.useActivityGate = true;
+    auto engine = createAiInference(config);
+    ASSERT_TRUE(engine);
+
+    RingBuffer<float, 2048> ringBuffer;
+    RealtimeThreadPool pool(1, RealtimeThreadPool::Priority::Normal, kFrameSize);
+    EXPECT_FALSE(pool.setHopSize(96));
+    ASSERT_TRUE(pool.setHopSize(kFrameSize / 2));
+    pool.start(&ringBuffer, engine.get(), 20);
+
+    const std::vector<float> signal = makeSpeechLike(10 * kFrameSize, 3);
+    for (size_t position = 0; position < signal.size(); position += 128) {
+        while (ringBuffer.size() > 1024) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        const size_t count = ringBuffer.push_bulk(signal.data() + position, std::min<size_t>(128, signal.size() - position));
+        pool.notifyInputCommitted(count);
+    }
+
+    const uint64_t expected = (signal.size() - kFrameSize) / (kFrameSize / 2) + 1;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (pool.getStatistics().framesProcessed.load() < expected && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    pool.stop();
+
+    EXPECT_EQ(pool.getStatistics().framesProcessed.load(), expected);
+    EXPECT_EQ(pool.getStatistics().droppedFrames.load(), 0u);
+    EXPECT_EQ(engine->getActivityGate()->getStatistics().activeFrames.load()
+              + engine->getActivityGate()->getStatistics().heldFrames.load()
+              + engine->getActivityGate()->getStatistics().closedFrames.load(), expected);
+}
+
+TEST_F(FrameAssemblerTest, PerformanceBenchmark_OverlapCost)
+{
+    const std::vector<float> signal = makeSpeechLike(16000 * 60, 4);    // One minute at 16 kHz
+    using Clock = std::chrono::steady_clock;
+    const auto ns = [](Clock::duration time, size_t count) {
+        return std::chrono::duration<double, std::nano>(time).count() / static_cast<double>(count);
+    };
+
+    std::cout << "Frame assembly for one minute of audio in 320-sample frames:" << std::endl;
+    for (int hop : { 320, 160, 80 }) {
+        const size_t numFrames = (signal.size() - kFrameSize) / hop + 1;
+        float checksum = 0.0f;
+        float slidingChecksum = 0.0f;
+
+        // Frames from the history
+        FrameAssembler assembler(kFrameSize, hop);
+        FrameAssembler::Frame frame;
+        const auto assemblerStart = Clock::now();
+        for (size_t position = 0; position < signal.size();) {
+            position += assembler.push(signal.data() + position, signal.size() - position);
+            if (assembler.nextFrame(frame)) {
+                checksum += frame.samples[frame.numSamples / 2];
+            }
+        }
+        const auto assemblerTime = Clock::now() - assemblerStart;
+
+        // For reference: a window buffer slid by the hop, moving the overlap for every frame
+        std::vector<float> window(kFrameSize);
+        const auto slidingStart = Clock::now();
+        std::copy(signal.begin(), signal.begin() + kFrameSize, window.begin());
+        slidingChecksum += window[kFrameSize / 2];
+        for (size_t start = hop; start + kFrameSize <= signal.size(); start += hop) {
+            std::copy(window.begin() + hop, window.end(), window.begin());
+            std::copy(signal.begin() + start + kFrameSize - hop, signal.begin() + start + kFrameSize,
+                      window.end() - hop);
+            slidingChecksum += window[kFrameSize / 2];
+        }
+        const auto slidingTime = Clock::now() - slidingStart;
+
+        std::cout << "  hop " << hop << ": " << numFrames << " frames, " << ns(assemblerTime, numFrames)
+                  << " ns per frame (sliding window " << ns(slidingTime, numFrames) << " ns)" << std::endl;
+
+        EXPECT_EQ(checksum, slidingChecksum);
+        EXPECT_EQ(assembler.getTotalSamples(), signal.size());
+        EXPECT_LT(ns(assemblerTime, numFrames), 1000.0);
+    }
+}
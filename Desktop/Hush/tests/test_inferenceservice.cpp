@@ -0,0 +1,730 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "AiInference.h"
+#include "FeatureExtractor.h"
+#include "InferenceService.h"
+#include "LatencyHistogram.h"
+#include "MlpModel.h"
+#include "ModelFileBuilder.h"
+#include "RealtimeThreadPool.h"
+#include "RingBuffer.h"
+
+using namespace KhDetector;
+
+class InferenceServiceTest : public ::testing::Test
+{
+protected:
+    static constexpr int kFrameSize = 320;    // 20 ms at 16 kHz
+    static constexpr int kHopSize = 160;      // 10 ms
+
+    void TearDown() override
+    {
+        for (const std::string& path : paths) {
+            std::remove(path.c_str());
+        }
+    }
+
+    /**
+     * @brief Write a dense -> GRU -> dense .khmlp model with random parameters, the shape of a streaming detector
+     */
+    std::string writeRecurrentModel(const std::string& name, int numHidden, int numGru, unsigned seed)
+    {
+        std::vector<ModelFileBuilder::Layer> layers = {
+            ModelFileBuilder::dense(kFrameSize, numHidden, true),
+            ModelFileBuilder::gru(numHidden, numGru),
+            ModelFileBuilder::dense(numGru, 2, false)
+        };
+        std::mt19937 gen(seed);
+        for (ModelFileBuilder::Layer& layer : layers) {
+            std::normal_distribution<float> dist(0.0f, 1.0f / std::sqrt(static_cast<float>(layer.numInputs)));
+            ModelFileBuilder::fill(layer, [&] { return dist(gen); });
+        }
+
+        const std::string path = ::testing::TempDir() + name;
+        ModelFileBuilder::write(path, layers);
+        paths.push_back(path);
+        return path;
+    }
+
+    /**
+     * @brief Write a dense .khmlp model wide enough that a batch of 32 frames costs about frameCostUs a frame here
+     */
+    std::string writeCalibratedModel(const std::string& name, double frameCostUs)
+    {
+        constexpr int kNumHidden = 4;
+        constexpr int kBatch = 32;
+        const auto writeWidth = [&](const std::string& fileName, int width) {
+            std::vector<int> sizes(kNumHidden + 1, width);
+            sizes.front() = kFrameSize;
+            sizes.push_back(2);
+            std::vector<ModelFileBuilder::Layer> layers = ModelFileBuilder::denseStack(sizes);
+            std::mt19937 gen(7);
+            for (ModelFileBuilder::Layer& layer : layers) {
+                std::normal_distribution<float> dist(0.0f, 1.0f / std::sqrt(static_cast<float>(layer.numInputs)));
+                ModelFileBuilder::fill(layer, [&] { return dist(gen); });
+            }
+            const std::string path = ::testing::TempDir() + fileName;
+            ModelFileBuilder::write(path, layers);
+            paths.push_back(path);
+            return path;
+        };
+
+        // Time a few batches and rescale: the hidden layers scale with width squared until the
+        // weights fall out of cache, so refine on the model actually measured
+        const std::vector<float> frames = makeNoise(static_cast<size_t>(kBatch) * kFrameSize, 3);
+        std::vector<AiInference::InferenceResult> results(kBatch);
+        int width = 256;
+        for (int attempt = 0; attempt < 3; ++attempt) {
+            AiInference probe;
+            if (!probe.initialize(makeConfig(writeWidth("probe" + std::to_string(attempt) + "_" + name, width)))) {
+                return {};
+            }
+            const int numRuns = 10;
+            probe.runBatch(frames.data(), kBatch, results.data());
+            const auto start = std::chrono::steady_clock::now();
+            for (int run = 0; run < numRuns; ++run) {
+                probe.runBatch(frames.data(), kBatch, results.data());
+            }
+            const double probeUs = std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - start).count() / (numRuns * kBatch);
+            const double scale = std::sqrt(frameCostUs / probeUs);
+            width = std::max(16, static_cast<int>(std::lround(width * scale / 16.0)) * 16);
+        }
+        return writeWidth(name, width);
+    }
+
+    static AiInference::ModelConfig makeConfig(const std::string& modelPath)
+    {
+        AiInference::ModelConfig config = createDefaultModelConfig();
+        config.modelPath = modelPath;
+        config.inputSize = kFrameSize;
+        return config;
+    }
+
+    static std::vector<float> makeNoise(size_t numSamples, unsigned seed)
+    {
+        std::mt19937 gen(seed);
+        std::normal_distribution<float> dist(0.0f, 0.3f);
+        std::vector<float> signal(numSamples);
+        for (float& sample : signal) {
+            sample = dist(gen);
+        }
+        return signal;
+    }
+
+    template<typename Predicate>
+    static bool waitUntil(Predicate predicate, std::chrono::milliseconds timeout = std::chrono::seconds(10))
+    {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!predicate()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        return true;
+    }
+
+    /**
+     * @brief Results a stream delivered, in order
+     */
+    struct Collected
+    {
+        std::vector<AiInference::InferenceResult> results;
+
+        static void callback(const AiInference::InferenceResult& result, void* context) noexcept
+        {
+            static_cast<Collected*>(context)->results.push_back(result);
+        }
+    };
+
+    std::vector<std::string> paths;
+};
+
+TEST_F(InferenceServiceTest, BatchedStreamsMatchDedicatedEngines)
+{
+    const std::string path = writeRecurrentModel("service_gru.khmlp", 32, 16, 1);
+    const AiInference::ModelConfig config = makeConfig(path);
+    const int numStreams = 6;
+    const int numHops = 40;
+    const int prefilledHops = 8;
+    const uint64_t expectedFrames = (numHops * kHopSize - kFrameSize) / kHopSize + 1;
+
+    // No load shedding: the prefilled backlog is older than its deadline
+    InferenceService service(InferenceService::Config{ 2, 4, std::chrono::microseconds(0) });
+    std::vector<std::unique_ptr<RingBuffer<float, 2048>>> rings;
+    std::vector<std::unique_ptr<InferenceService::Stream>> streams;
+    std::vector<Collected> collected(numStreams);
+    std::vector<std::vector<float>> signals;
+    for (int s = 0; s < numStreams; ++s) {
+        rings.push_back(std::make_unique<RingBuffer<float, 2048>>());
+        streams.push_back(service.registerStream(rings.back().get(), config, kHopSize));
+        ASSERT_TRUE(streams.back());
+        collected[s].results.reserve(expectedFrames);
+        streams.back()->setInferenceCallback(&Collected::callback, &collected[s]);
+        signals.push_back(makeNoise(numHops * kHopSize, 10 + s));
+    }
+    EXPECT_EQ(service.getStreamCount(), static_cast<size_t>(numStreams));
+    ASSERT_TRUE(waitUntil([&] { return streams[0]->isModelReady(); }));
+
+    // Queue several hops everywhere before the workers look, so they find many streams ready at once
+    for (int s = 0; s < numStreams; ++s) {
+        rings[s]->push_bulk(signals[s].data(), prefilledHops * kHopSize);
+        streams[s]->setActive(true);
+    }
+    for (int s = 0; s < numStreams; ++s) {
+        streams[s]->notifyInputCommitted(prefilledHops * kHopSize);
+    }
+    for (int hop = prefilledHops; hop < numHops; ++hop) {
+        for (int s = 0; s < numStreams; ++s) {
+            ASSERT_TRUE(waitUntil([&] { return rings[s]->size() <= 1024; }));
+            rings[s]->push_bulk(signals[s].data() + hop * kHopSize, kHopSize);
+            streams[s]->notifyInputCommitted(kHopSize);
+        }
+    }
+    ASSERT_TRUE(waitUntil([&] {
+        return std::all_of(streams.begin(), streams.end(), [&](const auto& stream) {
+            return stream->getStatistics().framesProcessed.load() == expectedFrames;
+        });
+    }));
+
+    // Each stream against an engine of its own, fed the same overlapping frames
+    for (int s = 0; s < numStreams; ++s) {
+        auto engine = createAiInference(config);
+        ASSERT_TRUE(engine);
+        ASSERT_EQ(collected[s].results.size(), expectedFrames);
+        for (uint64_t f = 0; f < expectedFrames; ++f) {
+            const AiInference::InferenceResult expected = engine->run(signals[s].data() + f * kHopSize, kFrameSize);
+            const AiInference::InferenceResult& actual = collected[s].results[f];
+            ASSERT_TRUE(actual.success);
+            EXPECT_EQ(actual.frameIndex, f);
+            EXPECT_NEAR(actual.predictions[1], expected.predictions[1], 1e-4f) << "stream " << s << " frame " << f;
+            EXPECT_NEAR(actual.confidence, expected.confidence, 1e-4f) << "stream " << s << " frame " << f;
+        }
+        EXPECT_EQ(streams[s]->getStatistics().droppedFrames.load(), 0u);
+    }
+
+    const auto& stats = service.getStatistics();
+    EXPECT_EQ(stats.batchedFrames.load(), numStreams * expectedFrames);
+    EXPECT_LT(stats.batches.load(), stats.batchedFrames.load());
+    std::cout << "Frames per model call: " << static_cast<double>(stats.batchedFrames.load()) / stats.batches.load()
+              << std::endl;
+}
+
+TEST_F(InferenceServiceTest, GatedFramesSkipTheBatch)
+{
+    AiInference::ModelConfig config = makeConfig(writeRecurrentModel("service_gated.khmlp", 16, 8, 2));
+    config.useActivityGate = true;
+
+    // No load shedding: the silence is queued at once, older than its deadline
+    InferenceService service(InferenceService::Config{ 1, 8, std::chrono::microseconds(0) });
+    RingBuffer<float, 2048> ring;
+    auto stream = service.registerStream(&ring, config, kHopSize);
+    ASSERT_TRUE(stream);
+    Collected collected;
+    collected.results.reserve(16);
+    stream->setInferenceCallback(&Collected::callback, &collected);
+    auto monitor = std::make_shared<LatencyMonitor>();
+    stream->setLatencyMonitor(monitor);
+    ASSERT_TRUE(waitUntil([&] { return stream->isModelReady(); }));
+    stream->setActive(true);
+
+    // Silence: nothing for the model
+    const std::vector<float> silence(10 * kHopSize, 0.0f);
+    ring.push_bulk(silence.data(), silence.size());
+    stream->notifyInputCommitted(silence.size());
+    const uint64_t expectedFrames = 9;
+    ASSERT_TRUE(waitUntil([&] { return stream->getStatistics().framesProcessed.load() == expectedFrames; }));
+
+    EXPECT_EQ(stream->getStatistics().gatedFrames.load(), expectedFrames);
+    EXPECT_EQ(service.getStatistics().gatedFrames.load(), expectedFrames);
+    EXPECT_EQ(service.getStatistics().batchedFrames.load(), 0u);
+
+    // Gated frames still go through the gate's analysis and the post-processor
+    EXPECT_EQ(monitor->getSnapshot(LatencyStage::FeatureExtraction).count, expectedFrames);
+    EXPECT_EQ(monitor->getSnapshot(LatencyStage::PostProcessing).count, expectedFrames);
+    EXPECT_EQ(monitor->getSnapshot(LatencyStage::Inference).count, 0u);
+    ASSERT_EQ(collected.results.size(), expectedFrames);
+    for (const auto& result : collected.results) {
+        EXPECT_TRUE(result.gated);
+        EXPECT_EQ(result.confidence, 0.0f);
+        EXPECT_EQ(result.label, AiInference::Label::NotDetected);
+    }
+    EXPECT_FALSE(stream->hasHit());
+}
+
+TEST_F(InferenceServiceTest, FeatureInputStreamsSeeExtractorFrames)
+{
+    std::vector<ModelFileBuilder::Layer> layers = ModelFileBuilder::denseStack({ FeatureExtractor::kNumFeatures, 16, 2 });
+    std::mt19937 gen(4);
+    for (ModelFileBuilder::Layer& layer : layers) {
+        std::normal_distribution<float> dist(0.0f, 1.0f / std::sqrt(static_cast<float>(layer.numInputs)));
+        ModelFileBuilder::fill(layer, [&] { return dist(gen); });
+    }
+    const std::string path = ::testing::TempDir() + "service_features.khmlp";
+    ModelFileBuilder::write(path, layers);
+    paths.push_back(path);
+
+    AiInference::ModelConfig config = makeConfig(path);
+    config.featureInput = true;
+    const int numHops = 60;
+    const uint64_t expectedFrames = (numHops * kHopSize - kFrameSize) / kHopSize + 1;
+
+    InferenceService service(InferenceService::Config{ 1, 8, std::chrono::microseconds(0) });
+    RingBuffer<float, 2048> ring;
+    auto stream = service.registerStream(&ring, config, kHopSize);
+    ASSERT_TRUE(stream);
+    Collected collected;
+    collected.results.reserve(expectedFrames);
+    stream->setInferenceCallback(&Collected::callback, &collected);
+    ASSERT_TRUE(waitUntil([&] { return stream->isModelReady(); }));
+    stream->setActive(true);
+
+    const std::vector<float> signal = makeNoise(numHops * kHopSize, 5);
+    for (int hop = 0; hop < numHops; ++hop) {
+        ASSERT_TRUE(waitUntil([&] { return ring.size() <= 1024; }));
+        ring.push_bulk(signal.data() + hop * kHopSize, kHopSize);
+        stream->notifyInputCommitted(kHopSize);
+    }
+    ASSERT_TRUE(waitUntil([&] { return stream->getStatistics().framesProcessed.load() == expectedFrames; }));
+    ASSERT_EQ(collected.results.size(), expectedFrames);
+
+    // The same audio through an extractor of its own, hop by hop, and an engine on its feature frames
+    AiInference::ModelConfig engineConfig = makeConfig(path);
+    engineConfig.inputSize = FeatureExtractor::kNumFeatures;
+    auto engine = createAiInference(engineConfig);
+    ASSERT_TRUE(engine);
+    FeatureExtractor extractor(config.sampleRate);
+    std::vector<float> features(FeatureExtractor::kNumFeatures * (FeatureExtractor::kDeltaWidth / 2 + 2));
+    uint64_t modelFrames = 0;
+    for (uint64_t f = 0; f < expectedFrames; ++f) {
+        const int newSamples = f == 0 ? kFrameSize : kHopSize;
+        const float* hop = signal.data() + f * kHopSize + kFrameSize - newSamples;
+        const int numFeatureFrames = extractor.process(hop, newSamples, features.data());
+        const AiInference::InferenceResult& actual = collected.results[f];
+        ASSERT_TRUE(actual.success);
+        EXPECT_EQ(actual.held, numFeatureFrames == 0) << "frame " << f;
+        if (numFeatureFrames > 0) {
+            const AiInference::InferenceResult expected = engine->run(
+                features.data() + (numFeatureFrames - 1) * FeatureExtractor::kNumFeatures, FeatureExtractor::kNumFeatures);
+            EXPECT_NEAR(actual.predictions[1], expected.predictions[1], 1e-4f) << "frame " << f;
+            ++modelFrames;
+        }
+    }
+
+    // A feature frame per 512 samples, the hops in between repeat the last confidence
+    EXPECT_GT(modelFrames, 0u);
+    EXPECT_EQ(service.getStatistics().batchedFrames.load(), modelFrames);
+    EXPECT_EQ(stream->getStatistics().heldFrames.load(), expectedFrames - modelFrames);
+    EXPECT_EQ(service.getStatistics().heldFrames.load(), expectedFrames - modelFrames);
+}
+
+TEST_F(InferenceServiceTest, ModellessStreamsScoreFramesButAreNotReady)
+{
+    // Model Ready stays off without a trained model, while the heuristic keeps scoring frames
+    InferenceService service(InferenceService::Config{ 1, 8, std::chrono::microseconds(0) });
+    RingBuffer<float, 2048> ring;
+    auto stream = service.registerStream(&ring, makeConfig(""), kHopSize);
+    ASSERT_TRUE(stream);
+    ASSERT_TRUE(waitUntil([&] { return stream->getModelState() != ModelHandle::State::Loading; }));
+    EXPECT_EQ(stream->getModelState(), ModelHandle::State::Heuristic);
+    EXPECT_FALSE(stream->isModelReady());
+    stream->setActive(true);
+
+    const std::vector<float> signal = makeNoise(10 * kHopSize, 4);
+    ring.push_bulk(signal.data(), signal.size());
+    stream->notifyInputCommitted(signal.size());
+    ASSERT_TRUE(waitUntil([&] { return stream->getStatistics().framesProcessed.load() == 9u; }));
+    EXPECT_EQ(service.getStatistics().unreadyFrames.load(), 0u);
+}
+
+TEST_F(InferenceServiceTest, InactiveStreamsLeaveTheirInputAlone)
+{
+    const AiInference::ModelConfig config = makeConfig(writeRecurrentModel("service_lifecycle.khmlp", 16, 8, 3));
+    InferenceService service(InferenceService::Config{ 2, 8 });
+    EXPECT_EQ(service.getWorkerCount(), 2);
+    EXPECT_EQ(service.registerStream(nullptr, config), nullptr);
+
+    RingBuffer<float, 2048> first;
+    RingBuffer<float, 2048> second;
+    auto firstStream = service.registerStream(&first, config, kHopSize);
+    auto secondStream = service.registerStream(&second, config, kHopSize);
+    ASSERT_TRUE(firstStream && secondStream);
+    EXPECT_EQ(service.getStreamCount(), 2u);
+    EXPECT_FALSE(firstStream->setHopSize(96));
+    EXPECT_TRUE(firstStream->setHopSize(kHopSize));
+    ASSERT_TRUE(waitUntil([&] { return firstStream->isModelReady() && secondStream->isModelReady(); }));
+
+    // Registered but not active: the ring buffer is the host's until setActive(true)
+    const std::vector<float> input = makeNoise(4 * kHopSize, 4);
+    first.push_bulk(input.data(), input.size());
+    firstStream->notifyInputCommitted(input.size());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(first.size(), input.size());
+
+    firstStream->setActive(true);
+    secondStream->setActive(true);
+    second.push_bulk(input.data(), input.size());
+    secondStream->notifyInputCommitted(input.size());
+    ASSERT_TRUE(waitUntil([&] { return first.size() == 0 && second.size() == 0; }));
+    EXPECT_EQ(firstStream->getStatistics().framesProcessed.load(), 3u);
+
+    // After setActive(false) returns no worker touches the ring buffer
+    firstStream->setActive(false);
+    EXPECT_FALSE(firstStream->isActive());
+    first.push_bulk(input.data(), input.size());
+    firstStream->notifyInputCommitted(input.size());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(first.size(), input.size());
+
+    // Reactivating starts over
+    firstStream->setActive(true);
+    ASSERT_TRUE(waitUntil([&] { return firstStream->getStatistics().framesProcessed.load() == 6u; }));
+
+    // Streams can go while the others keep running
+    firstStream.reset();
+    EXPECT_EQ(service.getStreamCount(), 1u);
+    second.push_bulk(input.data(), input.size());
+    secondStream->notifyInputCommitted(input.size());
+    ASSERT_TRUE(waitUntil([&] { return secondStream->getStatistics().framesProcessed.load() == 7u; }));
+    secondStream.reset();
+    EXPECT_EQ(service.getStreamCount(), 0u);
+}
+
+TEST_F(InferenceServiceTest, CallbacksMayCallIntoTheService)
+{
+    AiInference::ModelConfig config = makeConfig(writeRecurrentModel("service_reentrant.khmlp", 16, 8, 5));
+    config.useActivityGate = true;
+    InferenceService service(InferenceService::Config{ 2, 8, std::chrono::microseconds(0) });
+
+    // The first result registers a second stream; every result asks for the stream count
+    struct Reentrant
+    {
+        InferenceService* service;
+        const AiInference::ModelConfig* config;
+        RingBuffer<float, 2048> ring;
+        std::unique_ptr<InferenceService::Stream> registered;
+        size_t streamCount = 0;
+
+        static void callback(const AiInference::InferenceResult&, void* context) noexcept
+        {
+            auto* self = static_cast<Reentrant*>(context);
+            if (!self->registered) {
+                self->registered = self->service->registerStream(&self->ring, *self->config, kHopSize);
+            }
+            self->streamCount = self->service->getStreamCount();
+        }
+    };
+    Reentrant reentrant{ &service, &config, {}, nullptr };
+
+    RingBuffer<float, 2048> ring;
+    auto stream = service.registerStream(&ring, config, kHopSize);
+    ASSERT_TRUE(stream);
+    stream->setInferenceCallback(&Reentrant::callback, &reentrant);
+    ASSERT_TRUE(waitUntil([&] { return stream->isModelReady(); }));
+    stream->setActive(true);
+
+    // Gated frames are delivered while the stream's frames are collected, the rest after the model call
+    std::vector<float> input(4 * kHopSize, 0.0f);
+    const std::vector<float> noise = makeNoise(4 * kHopSize, 6);
+    input.insert(input.end(), noise.begin(), noise.end());
+    ring.push_bulk(input.data(), input.size());
+    stream->notifyInputCommitted(input.size());
+    ASSERT_TRUE(waitUntil([&] { return stream->getStatistics().framesProcessed.load() == 7u; }));
+    EXPECT_GT(stream->getStatistics().gatedFrames.load(), 0u);
+    EXPECT_GT(service.getStatistics().batchedFrames.load(), 0u);
+
+    ASSERT_TRUE(reentrant.registered);
+    EXPECT_EQ(reentrant.streamCount, 2u);
+    EXPECT_EQ(service.getStreamCount(), 2u);
+    reentrant.registered.reset();
+    EXPECT_EQ(service.getStreamCount(), 1u);
+}
+
+TEST_F(InferenceServiceTest, LateFramesShedLoadAndRecover)
+{
+    const AiInference::ModelConfig config = makeConfig(writeRecurrentModel("service_shedding.khmlp", 16, 8, 7));
+    InferenceService service(InferenceService::Config{ 1, 8, std::chrono::milliseconds(20), 4 });
+    RingBuffer<float, 2048> ring;
+    auto stream = service.registerStream(&ring, config, kHopSize);
+    ASSERT_TRUE(stream);
+    Collected collected;
+    collected.results.reserve(64);
+    stream->setInferenceCallback(&Collected::callback, &collected);
+    ASSERT_TRUE(waitUntil([&] { return stream->isModelReady(); }));
+    stream->setActive(true);
+
+    const auto& stats = stream->getStatistics();
+    const std::vector<float> input = makeNoise(1600, 8);
+    const auto feed = [&](size_t numSamples) {
+        const uint64_t before = stats.framesProcessed.load();
+        ring.push_bulk(input.data(), numSamples);
+        stream->notifyInputCommitted(numSamples);
+        return waitUntil([&] { return ring.size() == 0 && stats.framesProcessed.load() > before; });
+    };
+
+    // 100 ms arrive at once: every frame but the newest is past its 20 ms deadline
+    ASSERT_TRUE(feed(1600));
+    EXPECT_EQ(stats.framesProcessed.load(), 1u);
+    EXPECT_EQ(stats.skippedFrames.load(), 8u);
+    EXPECT_GE(stats.maxLagUs.load(), 0u);
+    EXPECT_EQ(stream->getHopSize(), kFrameSize);        // Half the frames from now on
+    EXPECT_FALSE(stream->isUsingHeuristic());
+
+    // Late again at the largest hop: the heuristic takes over from the model
+    ASSERT_TRUE(feed(1600));
+    EXPECT_EQ(stats.skippedFrames.load(), 8u + 4u);
+    EXPECT_TRUE(stream->isUsingHeuristic());
+    EXPECT_TRUE(collected.results.back().heuristic);
+
+    // Frames on time: after recoveryFrames each, back to the model and then to the stream's own hop
+    for (int i = 0; i < 12 && stream->getHopSize() != kHopSize; ++i) {
+        ASSERT_TRUE(feed(kFrameSize));
+    }
+    EXPECT_FALSE(stream->isUsingHeuristic());
+    EXPECT_EQ(stream->getHopSize(), kHopSize);
+    EXPECT_FALSE(collected.results.back().heuristic);
+    EXPECT_GE(stats.heuristicFrames.load(), 1u);
+    EXPECT_EQ(service.getStatistics().skippedFrames.load(), stats.skippedFrames.load());
+    EXPECT_EQ(service.getStatistics().heuristicFrames.load(), stats.heuristicFrames.load());
+
+    // Frame indices keep counting frames delivered, however many were shed
+    for (size_t i = 0; i < collected.results.size(); ++i) {
+        EXPECT_EQ(collected.results[i].frameIndex, i);
+    }
+
+    // Overflow is the producer's to report
+    stream->noteInputDropped(100);
+    EXPECT_EQ(stats.overflowSamples.load(), 100u);
+    EXPECT_EQ(service.getStatistics().overflowSamples.load(), 100u);
+}
+
+TEST_F(InferenceServiceTest, PerformanceBenchmark_InstanceScaling)
+{
+    const std::string path = writeRecurrentModel("service_benchmark.khmlp", 64, 32, 5);
+    const AiInference::ModelConfig config = makeConfig(path);
+    const int numHops = 50;                               // 0.5 s of audio, one hop every 10 ms
+    const auto hopPeriod = std::chrono::milliseconds(10);
+    const uint64_t expectedFrames = (numHops * kHopSize - kFrameSize) / kHopSize + 1;
+    const std::vector<float> signal = makeNoise(numHops * kHopSize, 6);
+
+    struct Result
+    {
+        size_t threads = 0;
+        double cpuPercent = 0.0;                          // Of one core, over the run
+        double p99Us = 0.0;                               // Worst instance's end-to-end p99
+        uint64_t frames = 0;
+    };
+
+    // Every instance's audio thread commits a hop per period; feed them all from one thread
+    const auto drive = [&](int numInstances, std::vector<std::unique_ptr<RingBuffer<float, 2048>>>& rings,
+                           std::vector<std::shared_ptr<LatencyMonitor>>& monitors, auto notify) {
+        const std::clock_t cpuStart = std::clock();
+        const auto start = std::chrono::steady_clock::now();
+        auto next = start;
+        for (int hop = 0; hop < numHops; ++hop) {
+            for (int i = 0; i < numInstances; ++i) {
+                rings[i]->push_bulk(signal.data() + hop * kHopSize, kHopSize);
+                monitors[i]->markInputCommitted(LatencyMonitor::Clock::now());
+                notify(i);
+            }
+            next += hopPeriod;
+            std::this_thread::sleep_until(next);
+        }
+        return std::make_pair(cpuStart, start);
+    };
+
+    const auto finish = [](Result& result, std::pair<std::clock_t, std::chrono::steady_clock::time_point> started,
+                           const std::vector<std::shared_ptr<LatencyMonitor>>& monitors) {
+        const double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started.second).count();
+        result.cpuPercent = 100.0 * (std::clock() - started.first) / CLOCKS_PER_SEC / wallSeconds;
+        for (const auto& monitor : monitors) {
+            result.p99Us = std::max(result.p99Us, monitor->getSnapshot(LatencyStage::EndToEnd).p99Ns / 1000.0);
+        }
+    };
+
+    const auto makeInputs = [](int numInstances, std::vector<std::unique_ptr<RingBuffer<float, 2048>>>& rings,
+                               std::vector<std::shared_ptr<LatencyMonitor>>& monitors) {
+        for (int i = 0; i < numInstances; ++i) {
+            rings.push_back(std::make_unique<RingBuffer<float, 2048>>());
+            monitors.push_back(std::make_shared<LatencyMonitor>());
+        }
+    };
+
+    // One shared service, batching across instances
+    const auto measureService = [&](int numInstances) {
+        InferenceService service;
+        std::vector<std::unique_ptr<RingBuffer<float, 2048>>> rings;
+        std::vector<std::shared_ptr<LatencyMonitor>> monitors;
+        std::vector<std::unique_ptr<InferenceService::Stream>> streams;
+        makeInputs(numInstances, rings, monitors);
+        for (int i = 0; i < numInstances; ++i) {
+            streams.push_back(service.registerStream(rings[i].get(), config, kHopSize));
+            streams.back()->setLatencyMonitor(monitors[i]);
+        }
+        EXPECT_TRUE(waitUntil([&] { return streams[0]->isModelReady(); }));
+        for (auto& stream : streams) {
+            stream->setActive(true);
+        }
+
+        const auto started = drive(numInstances, rings, monitors, [&](int i) { streams[i]->notifyInputCommitted(kHopSize); });
+        const auto frames = [&] {
+            uint64_t total = 0;
+            for (const auto& stream : streams) {
+                total += stream->getStatistics().framesProcessed.load();
+            }
+            return total;
+        };
+        waitUntil([&] { return frames() == numInstances * expectedFrames; });
+
+        Result result;
+        result.threads = static_cast<size_t>(service.getWorkerCount());
+        finish(result, started, monitors);
+        result.frames = frames();
+        return result;
+    };
+
+    // One thread pool and engine per instance, as each plugin had before
+    const auto measurePools = [&](int numInstances) {
+        std::vector<std::unique_ptr<RingBuffer<float, 2048>>> rings;
+        std::vector<std::shared_ptr<LatencyMonitor>> monitors;
+        std::vector<std::unique_ptr<AiInference>> engines;
+        std::vector<std::unique_ptr<RealtimeThreadPool>> pools;
+        makeInputs(numInstances, rings, monitors);
+        for (int i = 0; i < numInstances; ++i) {
+            engines.push_back(createAiInference(config));
+            pools.push_back(std::make_unique<RealtimeThreadPool>(1, RealtimeThreadPool::Priority::Low, kFrameSize));
+            pools.back()->setLatencyMonitor(monitors[i]);
+            pools.back()->setHopSize(kHopSize);
+            pools.back()->start(rings[i].get(), engines.back().get(), 10);
+        }
+
+        const auto started = drive(numInstances, rings, monitors, [&](int i) { pools[i]->notifyInputCommitted(kHopSize); });
+        const auto frames = [&] {
+            uint64_t total = 0;
+            for (const auto& pool : pools) {
+                total += pool->getStatistics().framesProcessed.load();
+            }
+            return total;
+        };
+        waitUntil([&] { return frames() == numInstances * expectedFrames; });
+
+        Result result;
+        result.threads = pools.size();
+        finish(result, started, monitors);
+        result.frames = frames();
+        for (auto& pool : pools) {
+            pool->stop();
+        }
+        return result;
+    };
+
+    std::cout << "GRU 320-64-[32]-2, 10 ms hops for 0.5 s per instance ("
+              << InferenceService::getDefaultWorkerCount() << " service workers):" << std::endl;
+    std::cout << "  instances | per-instance pools: threads, CPU, p99 | shared service: threads, CPU, p99" << std::endl;
+    for (int numInstances : { 1, 4, 16, 64, 256 }) {
+        const Result pools = measurePools(numInstances);
+        const Result service = measureService(numInstances);
+        std::cout << std::fixed << std::setprecision(1)
+                  << "  " << std::setw(9) << numInstances
+                  << " | " << std::setw(4) << pools.threads << ", " << std::setw(6) << pools.cpuPercent << "%, "
+                  << std::setw(8) << pools.p99Us << " us"
+                  << " | " << std::setw(2) << service.threads << ", " << std::setw(6) << service.cpuPercent << "%, "
+                  << std::setw(8) << service.p99Us << " us" << std::endl;
+
+        EXPECT_EQ(pools.frames, numInstances * expectedFrames);
+        EXPECT_EQ(service.frames, numInstances * expectedFrames);
+        EXPECT_LE(service.threads, 4u);
+    }
+}
+
+TEST_F(InferenceServiceTest, PerformanceBenchmark_Overload)
+{
+    // A model sized to take 0.31 ms a frame in batches of 32: 64 streams of 10 ms hops need two workers, and get one
+    const AiInference::ModelConfig config = makeConfig(writeCalibratedModel("overload.khmlp", 312.5));
+    const int numStreams = 64;
+    const int numHops = 100;                              // 1 s
+    const auto hopPeriod = std::chrono::milliseconds(10);
+    const std::vector<float> signal = makeNoise(kHopSize, 9);
+
+    struct Result
+    {
+        uint64_t maxLagUs = 0;
+        uint64_t overflowSamples = 0;
+        uint64_t skippedFrames = 0;
+        uint64_t heuristicFrames = 0;
+        uint64_t modelFrames = 0;
+    };
+
+    const auto measure = [&](std::chrono::microseconds maxLag) {
+        InferenceService service(InferenceService::Config{ 1, 32, maxLag, 100 });
+        std::vector<std::unique_ptr<RingBuffer<float, 2048>>> rings;
+        std::vector<std::unique_ptr<InferenceService::Stream>> streams;
+        for (int i = 0; i < numStreams; ++i) {
+            rings.push_back(std::make_unique<RingBuffer<float, 2048>>());
+            streams.push_back(service.registerStream(rings.back().get(), config, kHopSize));
+        }
+        EXPECT_TRUE(waitUntil([&] { return streams[0]->isModelReady(); }));
+        for (auto& stream : streams) {
+            stream->setActive(true);
+        }
+
+        // The audio threads: a hop per period, counting what does not fit like the processor does
+        auto next = std::chrono::steady_clock::now();
+        for (int hop = 0; hop < numHops; ++hop) {
+            for (int i = 0; i < numStreams; ++i) {
+                const size_t pushed = rings[i]->push_bulk(signal.data(), kHopSize);
+                if (pushed < static_cast<size_t>(kHopSize)) {
+                    streams[i]->noteInputDropped(kHopSize - pushed);
+                }
+                streams[i]->notifyInputCommitted(pushed);
+            }
+            next += hopPeriod;
+            std::this_thread::sleep_until(next);
+        }
+
+        const auto& stats = service.getStatistics();
+        Result result;
+        result.maxLagUs = stats.maxLagUs.load();
+        result.overflowSamples = stats.overflowSamples.load();
+        result.skippedFrames = stats.skippedFrames.load();
+        result.heuristicFrames = stats.heuristicFrames.load();
+        result.modelFrames = stats.batchedFrames.load();
+        for (auto& stream : streams) {
+            stream->setActive(false);
+        }
+        return result;
+    };
+
+    const Result unbounded = measure(std::chrono::microseconds(0));
+    const Result shed = measure(std::chrono::milliseconds(60));
+
+    const auto print = [](const char* name, const Result& result) {
+        std::cout << name << "worst lag " << result.maxLagUs / 1000.0 << " ms, " << result.overflowSamples
+                  << " samples lost to full ring buffers, " << result.skippedFrames << " frames skipped, "
+                  << result.heuristicFrames << " scored by the heuristic, " << result.modelFrames
+                  << " by the model" << std::endl;
+    };
+    std::cout << numStreams << " streams for 1 s at twice the capacity of one worker:" << std::endl;
+    print("  no shedding:        ", unbounded);
+    print("  60 ms deadline:     ", shed);
+
+    EXPECT_GT(unbounded.overflowSamples, 0u);
+    EXPECT_EQ(shed.overflowSamples, 0u);
+    EXPECT_LT(shed.maxLagUs, unbounded.maxLagUs);
+    EXPECT_GT(shed.skippedFrames + shed.heuristicFrames, 0u);
+}
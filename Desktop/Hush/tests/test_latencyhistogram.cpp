@@ -0,0 +1,252 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "AiInference.h"
+#include "LatencyHistogram.h"
+
+using namespace KhDetector;
+
+class LatencyHistogramTest : public ::testing::Test
+{
+protected:
+    // Exact percentile of a sorted sample, with the histogram's rank rule
+    static uint64_t exactPercentile(const std::vector<uint64_t>& sorted, double percentile)
+    {
+        const auto rank = static_cast<size_t>(std::ceil(percentile / 100.0 * static_cast<double>(sorted.size())));
+        return sorted[std::max<size_t>(rank, 1) - 1];
+    }
+};
+
+TEST_F(LatencyHistogramTest, BucketsCoverTheRangeWithBoundedError)
+{
+    // Small values are exact
+    for (uint64_t value = 0; value < LatencyHistogram::kSubBuckets; ++value) {
+        const int index = LatencyHistogram::getBucketIndex(value);
+        EXPECT_EQ(LatencyHistogram::getBucketUpperBound(index), value);
+    }
+
+    // Every value lies in its bucket, which is at most 1/16 wide relative to it
+    std::mt19937_64 rng(7);
+    for (int i = 0; i < 100000; ++i) {
+        const uint64_t value = rng() >> (rng() % 64);
+        const int index = LatencyHistogram::getBucketIndex(value);
+        ASSERT_GE(index, 0);
+        ASSERT_LT(index, LatencyHistogram::kNumBuckets);
+
+        const uint64_t upper = LatencyHistogram::getBucketUpperBound(index);
+        ASSERT_GE(upper, value);
+        ASSERT_LE(static_cast<double>(upper - value), static_cast<double>(value) / LatencyHistogram::kSubBuckets);
+        if (index > 0) {
+            ASSERT_LT(LatencyHistogram::getBucketUpperBound(index - 1), value);
+        }
+    }
+
+    EXPECT_EQ(LatencyHistogram::getBucketIndex(UINT64_MAX), LatencyHistogram::kNumBuckets - 1);
+    EXPECT_EQ(LatencyHistogram::getBucketUpperBound(LatencyHistogram::kNumBuckets - 1), UINT64_MAX);
+}
+
+TEST_F(LatencyHistogramTest, PercentilesTrackAKnownDistribution)
+{
+    // Log-normal around 200 us with a rare 5 ms tail, like a preempted thread
+    std::mt19937 rng(11);
+    std::lognormal_distribution<double> body(std::log(200000.0), 0.3);
+    std::uniform_real_distribution<double> tail(4.0e6, 6.0e6);
+    std::bernoulli_distribution spike(0.002);
+
+    LatencyHistogram histogram;
+    std::vector<uint64_t> values;
+    for (int i = 0; i < 200000; ++i) {
+        const auto value = static_cast<uint64_t>(spike(rng) ? tail(rng) : body(rng));
+        values.push_back(value);
+        histogram.record(value);
+    }
+    std::sort(values.begin(), values.end());
+
+    const LatencyHistogram::Snapshot snapshot = histogram.getSnapshot();
+    EXPECT_EQ(snapshot.count, values.size());
+    EXPECT_EQ(snapshot.minNs, values.front());
+    EXPECT_EQ(snapshot.maxNs, values.back());
+
+    const auto expectClose = [](uint64_t reported, uint64_t exact) {
+        EXPECT_GE(reported, exact);
+        EXPECT_LE(static_cast<double>(reported), exact * (1.0 + 1.0 / LatencyHistogram::kSubBuckets));
+    };
+    expectClose(snapshot.p50Ns, exactPercentile(values, 50.0));
+    expectClose(snapshot.p99Ns, exactPercentile(values, 99.0));
+    expectClose(snapshot.p999Ns, exactPercentile(values, 99.9));
+    expectClose(histogram.getValueAtPercentile(90.0), exactPercentile(values, 90.0));
+
+    // The tail shows up in p99.9 but not in the median
+    EXPECT_GT(snapshot.p999Ns, 4000000u);
+    EXPECT_LT(snapshot.p50Ns, 250000u);
+
+    double sum = 0.0;
+    for (uint64_t value : values) {
+        sum += static_cast<double>(value);
+    }
+    EXPECT_NEAR(snapshot.meanNs, sum / values.size(), 1.0);
+
+    histogram.reset();
+    EXPECT_EQ(histogram.getSnapshot().count, 0u);
+    EXPECT_EQ(histogram.getValueAtPercentile(99.0), 0u);
+}
+
+TEST_F(LatencyHistogramTest, ConcurrentWritersLoseNoCounts)
+{
+    LatencyHistogram histogram;
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 250000;
+
+    std::atomic<bool> done{false};
+    std::thread reader([&] {
+        // Snapshots taken mid-write stay ordered
+        while (!done.load()) {
+            const LatencyHistogram::Snapshot snapshot = histogram.getSnapshot();
+            if (snapshot.count > 0) {
+                EXPECT_LE(snapshot.p50Ns, snapshot.p99Ns);
+                EXPECT_LE(snapshot.p99Ns, snapshot.p999Ns);
+            }
+        }
+    });
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < kThreads; ++t) {
+        writers.emplace_back([&histogram, t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                histogram.record(static_cast<uint64_t>(1000 * (t + 1) + i % 100));
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    done = true;
+    reader.join();
+
+    const LatencyHistogram::Snapshot snapshot = histogram.getSnapshot();
+    EXPECT_EQ(snapshot.count, static_cast<uint64_t>(kThreads) * kPerThread);
+    EXPECT_EQ(snapshot.minNs, 1000u);
+    EXPECT_EQ(snapshot.maxNs, 1000u * kThreads + 99);
+}
+
+TEST_F(LatencyHistogramTest, MonitorDumpsEveryStage)
+{
+    LatencyMonitor monitor;
+    monitor.record(LatencyStage::Inference, std::chrono::microseconds(150));
+    monitor.record(LatencyStage::Inference, std::chrono::microseconds(250));
+    monitor.record(LatencyStage::EndToEnd, std::chrono::milliseconds(3));
+
+    EXPECT_EQ(monitor.getSnapshot(LatencyStage::Inference).count, 2u);
+    EXPECT_EQ(monitor.getSnapshot(LatencyStage::Inference).maxNs, 250000u);
+    EXPECT_EQ(monitor.getSnapshot(LatencyStage::QueueWait).count, 0u);
+
+    std::ostringstream stream;
+    stream << std::hex;
+    monitor.dump(stream);
+    const std::string table = stream.str();
+    for (int stage = 0; stage < kNumLatencyStages; ++stage) {
+        EXPECT_NE(table.find(getLatencyStageName(static_cast<LatencyStage>(stage))), std::string::npos);
+    }
+    EXPECT_NE(table.find("3000.0"), std::string::npos) << table;
+    EXPECT_TRUE(stream.flags() & std::ios_base::hex) << "dump() must restore the stream format";
+
+    const auto committed = LatencyMonitor::Clock::now();
+    EXPECT_EQ(monitor.getLastInputTime().time_since_epoch().count(), 0);
+    monitor.markInputCommitted(committed);
+    EXPECT_EQ(monitor.getLastInputTime(), committed);
+
+    monitor.reset();
+    EXPECT_EQ(monitor.getSnapshot(LatencyStage::EndToEnd).count, 0u);
+}
+
+TEST_F(LatencyHistogramTest, InferenceRecordsItsStages)
+{
+    AiInference::ModelConfig config = createDefaultModelConfig();
+    config.inputSize = 320;
+    config.useActivityGate = true;
+    AiInference inference(config);
+    ASSERT_TRUE(inference.initialize(config));
+
+    auto monitor = std::make_shared<LatencyMonitor>();
+    inference.setLatencyMonitor(monitor);
+
+    // A noise frame passes the gate, a silent one does not
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> noise(-0.5f, 0.5f);
+    std::vector<float> loud(config.inputSize);
+    for (float& sample : loud) {
+        sample = noise(rng);
+    }
+    const std::vector<float> silent(config.inputSize, 0.0f);
+
+    const int numFrames = 20;
+    for (int frame = 0; frame < numFrames; ++frame) {
+        EXPECT_TRUE(inference.run(loud.data(), config.inputSize).success);
+    }
+    inference.getActivityGate()->reset();
+    EXPECT_TRUE(inference.run(silent.data(), config.inputSize).gated);
+
+    // Gated frames skip the model but still extract and post-process
+    EXPECT_EQ(monitor->getSnapshot(LatencyStage::FeatureExtraction).count, numFrames + 1u);
+    EXPECT_EQ(monitor->getSnapshot(LatencyStage::Inference).count, static_cast<uint64_t>(numFrames));
+    EXPECT_EQ(monitor->getSnapshot(LatencyStage::PostProcessing).count, numFrames + 1u);
+    EXPECT_GT(monitor->getSnapshot(LatencyStage::Inference).maxNs, 0u);
+
+    inference.setLatencyMonitor(nullptr);
+    inference.run(loud.data(), config.inputSize);
+    EXPECT_EQ(monitor->getSnapshot(LatencyStage::Inference).count, static_cast<uint64_t>(numFrames));
+}
+
+TEST_F(LatencyHistogramTest, PerformanceBenchmark_RecordCost)
+{
+    LatencyHistogram histogram;
+    std::mt19937_64 rng(5);
+    std::vector<uint64_t> values(4096);
+    for (uint64_t& value : values) {
+        value = 50000 + rng() % 2000000;
+    }
+
+    const int iterations = 2000000;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        histogram.record(values[i & 4095]);
+    }
+    const auto singleTime = std::chrono::steady_clock::now() - start;
+
+    // Two threads hitting the same histogram share its cache lines
+    histogram.reset();
+    const auto sharedStart = std::chrono::steady_clock::now();
+    std::thread other([&] {
+        for (int i = 0; i < iterations; ++i) {
+            histogram.record(values[(i * 7) & 4095]);
+        }
+    });
+    for (int i = 0; i < iterations; ++i) {
+        histogram.record(values[i & 4095]);
+    }
+    other.join();
+    const auto sharedTime = std::chrono::steady_clock::now() - sharedStart;
+
+    const auto snapshotStart = std::chrono::steady_clock::now();
+    const LatencyHistogram::Snapshot snapshot = histogram.getSnapshot();
+    const auto snapshotTime = std::chrono::steady_clock::now() - snapshotStart;
+
+    const auto nsPer = [](std::chrono::steady_clock::duration time, int count) {
+        return std::chrono::duration<double, std::nano>(time).count() / count;
+    };
+    std::cout << "LatencyHistogram::record(): " << nsPer(singleTime, iterations) << " ns alone, "
+              << nsPer(sharedTime, iterations) << " ns with a second writer; getSnapshot(): "
+              << nsPer(snapshotTime, 1) / 1000.0 << " us" << std::endl;
+
+    EXPECT_EQ(snapshot.count, 2u * iterations);
+    EXPECT_LT(nsPer(singleTime, iterations), 1000.0);
+}
@@ -0,0 +1,251 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "AiInference.h"
+#include "LatencyHistogram.h"
+#include "LightweightSemaphore.h"
+#include "RealtimeThreadPool.h"
+
+using namespace KhDetector;
+
+class LightweightSemaphoreTest : public ::testing::Test
+{
+protected:
+    static constexpr int kFrameSize = 320;    // 20 ms at 16 kHz
+
+    static std::unique_ptr<AiInference> makeEngine()
+    {
+        AiInference::ModelConfig config = createDefaultModelConfig();
+        config.inputSize = kFrameSize;
+        return createAiInference(config);
+    }
+
+    static std::vector<float> makeFrame(unsigned seed)
+    {
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+        std::vector<float> frame(kFrameSize);
+        for (float& sample : frame) {
+            sample = dist(gen);
+        }
+        return frame;
+    }
+
+    template<typename Predicate>
+    static bool waitUntil(Predicate predicate, std::chrono::milliseconds timeout = std::chrono::seconds(5))
+    {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!predicate()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        return true;
+    }
+};
+
+TEST_F(LightweightSemaphoreTest, CountsPostsAndWaits)
+{
+    LightweightSemaphore semaphore(2);
+    EXPECT_EQ(semaphore.getCount(), 2);
+    EXPECT_TRUE(semaphore.tryWait());
+    EXPECT_TRUE(semaphore.tryWait());
+    EXPECT_FALSE(semaphore.tryWait());
+
+    semaphore.post(3);
+    EXPECT_EQ(semaphore.getCount(), 3);
+    semaphore.wait();
+    EXPECT_TRUE(semaphore.waitFor(std::chrono::milliseconds(1)));
+    EXPECT_TRUE(semaphore.tryWait());
+    EXPECT_EQ(semaphore.getCount(), 0);
+
+    semaphore.post(0);
+    EXPECT_FALSE(semaphore.tryWait());
+}
+
+TEST_F(LightweightSemaphoreTest, TimedWaitExpiresAndWithdraws)
+{
+    LightweightSemaphore semaphore;
+
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(semaphore.waitFor(std::chrono::milliseconds(5)));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(5));
+    EXPECT_FALSE(semaphore.waitFor(std::chrono::microseconds(0)));
+
+    // A waiter that gave up no longer counts, so the next post is kept
+    EXPECT_EQ(semaphore.getCount(), 0);
+    semaphore.post();
+    EXPECT_TRUE(semaphore.tryWait());
+}
+
+TEST_F(LightweightSemaphoreTest, PostWakesBlockedWaiters)
+{
+    LightweightSemaphore semaphore;
+    std::atomic<int> woken{0};
+
+    std::vector<std::thread> waiters;
+    for (int i = 0; i < 3; ++i) {
+        waiters.emplace_back([&] {
+            semaphore.wait();
+            woken.fetch_add(1);
+        });
+    }
+
+    // Let them go to sleep in the kernel before posting
+    ASSERT_TRUE(waitUntil([&] { return semaphore.getCount() == -3; }));
+    semaphore.post(2);
+    ASSERT_TRUE(waitUntil([&] { return woken.load() == 2; }));
+    semaphore.post();
+    for (auto& waiter : waiters) {
+        waiter.join();
+    }
+    EXPECT_EQ(woken.load(), 3);
+    EXPECT_EQ(semaphore.getCount(), 0);
+}
+
+TEST_F(LightweightSemaphoreTest, ManyProducersAndConsumers)
+{
+    LightweightSemaphore semaphore;
+    const int numThreads = 4;
+    const int postsPerThread = 20000;
+    std::atomic<int> taken{0};
+    std::atomic<int> timeouts{0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < postsPerThread; ++i) {
+                semaphore.post();
+            }
+        });
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < postsPerThread; ++i) {
+                // Mix every kind of wait, including ones that time out and retry
+                if (t == 0) {
+                    semaphore.wait();
+                } else if (t == 1) {
+                    while (!semaphore.tryWait()) {
+                    }
+                } else {
+                    while (!semaphore.waitFor(std::chrono::microseconds(50))) {
+                        timeouts.fetch_add(1);
+                    }
+                }
+                taken.fetch_add(1);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(taken.load(), numThreads * postsPerThread);
+    EXPECT_EQ(semaphore.getCount(), 0);
+    EXPECT_FALSE(semaphore.tryWait());
+}
+
+TEST_F(LightweightSemaphoreTest, PoolWakesOnFrameBoundaries)
+{
+    auto engine = makeEngine();
+    ASSERT_TRUE(engine);
+    RingBuffer<float, 2048> ringBuffer;
+    RealtimeThreadPool pool(1, RealtimeThreadPool::Priority::Normal, kFrameSize);
+    pool.start(&ringBuffer, engine.get(), 20);
+
+    // Host blocks that do not line up with frames: a frame goes out as soon as it is complete
+    const std::vector<float> frame = makeFrame(1);
+    const int blockSize = 128;
+    size_t written = 0;
+    for (int frameIndex = 1; frameIndex <= 5; ++frameIndex) {
+        while (written < static_cast<size_t>(frameIndex * kFrameSize)) {
+            const size_t count = ringBuffer.push_bulk(frame.data(), blockSize);
+            written += count;
+            pool.notifyInputCommitted(count);
+        }
+        // No throttling to the processing interval for a notifying producer
+        ASSERT_TRUE(waitUntil([&] { return pool.getStatistics().framesProcessed.load() == static_cast<uint64_t>(frameIndex); },
+                              std::chrono::milliseconds(15)));
+    }
+
+    // stop() wakes the idle thread instead of waiting for another frame
+    const auto stopStart = std::chrono::steady_clock::now();
+    pool.stop();
+    EXPECT_LT(std::chrono::steady_clock::now() - stopStart, std::chrono::milliseconds(100));
+    EXPECT_EQ(pool.getStatistics().droppedFrames.load(), 0u);
+}
+
+TEST_F(LightweightSemaphoreTest, PerformanceBenchmark_FrameHandOff)
+{
+    const int numFrames = 50;
+    const auto framePeriod = std::chrono::milliseconds(20);
+    const auto idlePeriod = std::chrono::milliseconds(500);
+    const std::vector<float> frame = makeFrame(2);
+
+    struct Result
+    {
+        LatencyHistogram::Snapshot wait;
+        double idleCpuPercent = 0.0;
+    };
+
+    // One frame per period, as the audio thread delivers them; notify = false is the 1 ms polling loop
+    const auto measure = [&](bool notify, int processingIntervalMs) {
+        auto engine = makeEngine();
+        auto monitor = std::make_shared<LatencyMonitor>();
+        RingBuffer<float, 2048> ringBuffer;
+        RealtimeThreadPool pool(1, RealtimeThreadPool::Priority::Normal, kFrameSize);
+        pool.setLatencyMonitor(monitor);
+        pool.start(&ringBuffer, engine.get(), processingIntervalMs);
+
+        auto next = std::chrono::steady_clock::now();
+        for (int i = 0; i < numFrames; ++i) {
+            next += framePeriod;
+            std::this_thread::sleep_until(next);
+            ringBuffer.push_bulk(frame.data(), frame.size());
+            monitor->markInputCommitted(LatencyMonitor::Clock::now());
+            if (notify) {
+                pool.notifyInputCommitted(frame.size());
+            }
+        }
+        waitUntil([&] { return pool.getStatistics().framesProcessed.load() == static_cast<uint64_t>(numFrames); });
+
+        // No input: what does the waiting thread cost?
+        const std::clock_t cpuStart = std::clock();
+        std::this_thread::sleep_for(idlePeriod);
+        const std::clock_t cpuEnd = std::clock();
+        pool.stop();
+
+        EXPECT_EQ(pool.getStatistics().framesProcessed.load(), static_cast<uint64_t>(numFrames));
+        Result result;
+        result.wait = monitor->getSnapshot(LatencyStage::QueueWait);
+        result.idleCpuPercent = 100.0 * (cpuEnd - cpuStart) / CLOCKS_PER_SEC
+                              / std::chrono::duration<double>(idlePeriod).count();
+        return result;
+    };
+
+    // The plugin polls with a 20 ms interval; without the interval only the 1 ms sleep remains
+    const Result throttled = measure(false, 20);
+    const Result polling = measure(false, 0);
+    const Result notified = measure(true, 20);
+
+    const auto print = [](const char* name, const Result& result) {
+        std::cout << name << "mean " << result.wait.meanNs / 1000.0 << " us, p99 " << result.wait.p99Ns / 1000.0
+                  << " us, max " << result.wait.maxNs / 1000.0 << " us; idle CPU " << result.idleCpuPercent << "%"
+                  << std::endl;
+    };
+    std::cout << "Frame ready to inference start (" << numFrames << " frames, 20 ms apart):" << std::endl;
+    print("  polling, 20 ms interval: ", throttled);
+    print("  polling, no interval:    ", polling);
+    print("  semaphore:               ", notified);
+
+    EXPECT_EQ(notified.wait.count, static_cast<uint64_t>(numFrames));
+    EXPECT_LT(notified.wait.meanNs, polling.wait.meanNs);
+    EXPECT_LT(notified.wait.meanNs, throttled.wait.meanNs);
+}
@@ -0,0 +1,513 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+#include "DspKernels.h"
+#include "MlpModel.h"
+#include "ModelFileBuilder.h"
+#include "OnnxBackend.h"
+
+using namespace KhDetector;
+
+/**
+ * Models are built here in the file layout documented in MlpModel.h. The
+ * comparison with ONNX Runtime needs both exports of the same trained model
+ * from training/train_het_detector.py, e.g.
+ *
+ *   KHDETECTOR_TEST_MODEL=/path/to/het_detector.onnx \
+ *   KHDETECTOR_TEST_NATIVE_MODEL=/path/to/het_detector.khmlp ./KhDetectorTests --gtest_filter=MlpModel*
+ *
+ * and is skipped otherwise.
+ */
+class MlpModelTest : public ::testing::Test
+{
+protected:
+    using DenseLayer = ModelFileBuilder::Layer;
+
+    void SetUp() override
+    {
+        for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2,
+                                 SimdLevel::AVX512, SimdLevel::NEON }) {
+            if (getDspKernelsFor(level)) {
+                levels.push_back(level);
+            }
+        }
+    }
+
+    void TearDown() override
+    {
+        forceSimdLevel(detectSimdLevel());
+    }
+
+    static std::vector<DenseLayer> makeLayers(const std::vector<int>& sizes, unsigned seed)
+    {
+        std::mt19937 gen(seed);
+        std::vector<DenseLayer> layers = ModelFileBuilder::denseStack(sizes);
+        for (DenseLayer& layer : layers) {
+            std::normal_distribution<float> dist(0.0f, 1.0f / std::sqrt(static_cast<float>(layer.numInputs)));
+            ModelFileBuilder::fill(layer, [&] { return dist(gen); });
+        }
+        return layers;
+    }
+
+    // Dense -> GRU -> dense, the shape of a small streaming detector
+    static std::vector<DenseLayer> makeRecurrentLayers(int numInputs, int numHidden, int numGru, unsigned seed)
+    {
+        std::vector<DenseLayer> layers = makeLayers({ numInputs, numHidden, numGru, 2 }, seed);
+        layers[0].relu = true;
+
+        layers[1] = ModelFileBuilder::gru(numHidden, numGru);
+        std::mt19937 gen(seed + 1);
+        std::normal_distribution<float> dist(0.0f, 1.0f / std::sqrt(static_cast<float>(numGru)));
+        ModelFileBuilder::fill(layers[1], [&] { return dist(gen); });
+        return layers;
+    }
+
+    /**
+     * @brief Double-precision evaluation of consecutive frames, GRU state carried between them (nn.GRU)
+     */
+    static std::vector<std::vector<float>> evaluateSequence(const std::vector<DenseLayer>& layers,
+                                                            const std::vector<std::vector<float>>& inputs)
+    {
+        std::vector<std::vector<double>> states(layers.size());
+        for (size_t l = 0; l < layers.size(); ++l) {
+            states[l].assign(layers[l].gru ? layers[l].numOutputs : 0, 0.0);
+        }
+
+        auto project = [](const std::vector<float>& weights, const std::vector<float>& bias,
+                          const std::vector<double>& values, int row) {
+            const size_t numInputs = values.size();
+            double sum = bias[row];
+            for (size_t i = 0; i < numInputs; ++i) {
+                sum += static_cast<double>(weights[row * numInputs + i]) * values[i];
+            }
+            return sum;
+        };
+
+        std::vector<std::vector<float>> outputs;
+        for (const std::vector<float>& input : inputs) {
+            std::vector<double> values(input.begin(), input.end());
+            for (size_t l = 0; l < layers.size(); ++l) {
+                const DenseLayer& layer = layers[l];
+                std::vector<double> next(layer.numOutputs);
+                if (layer.gru) {
+                    std::vector<double>& hidden = states[l];
+                    const int size = layer.numOutputs;
+                    for (int j = 0; j < size; ++j) {
+                        auto sigmoid = [](double x) { return 1.0 / (1.0 + std::exp(-x)); };
+                        const double reset = sigmoid(project(layer.weights, layer.bias, values, j)
+                                                     + project(layer.hiddenWeights, layer.hiddenBias, hidden, j));
+                        const double update = sigmoid(project(layer.weights, layer.bias, values, size + j)
+                                                      + project(layer.hiddenWeights, layer.hiddenBias, hidden, size + j));
+                        const double candidate = std::tanh(project(layer.weights, layer.bias, values, 2 * size + j)
+                            + reset * project(layer.hiddenWeights, layer.hiddenBias, hidden, 2 * size + j));
+                        next[j] = (1.0 - update) * candidate + update * hidden[j];
+                    }
+                    hidden = next;
+                } else {
+                    for (int o = 0; o < layer.numOutputs; ++o) {
+                        const double sum = project(layer.weights, layer.bias, values, o);
+                        next[o] = layer.relu ? std::max(sum, 0.0) : sum;
+                    }
+                }
+                values = next;
+            }
+            outputs.emplace_back(values.begin(), values.end());
+        }
+        return outputs;
+    }
+
+    static std::vector<float> evaluateReference(const std::vector<DenseLayer>& layers, const std::vector<float>& input)
+    {
+        std::vector<double> values(input.begin(), input.end());
+        for (const DenseLayer& layer : layers) {
+            std::vector<double> next(layer.numOutputs);
+            for (int o = 0; o < layer.numOutputs; ++o) {
+                double sum = layer.bias[o];
+                for (int i = 0; i < layer.numInputs; ++i) {
+                    sum += static_cast<double>(layer.weights[o * layer.numInputs + i]) * values[i];
+                }
+                next[o] = layer.relu ? std::max(sum, 0.0) : sum;
+            }
+            values = next;
+        }
+        return std::vector<float>(values.begin(), values.end());
+    }
+
+    static std::vector<float> makeFeatures(int count, unsigned seed)
+    {
+        std::mt19937 gen(seed);
+        std::normal_distribution<float> dist(0.0f, 1.0f);
+        std::vector<float> features(count);
+        for (float& value : features) {
+            value = dist(gen);
+        }
+        return features;
+    }
+
+    std::vector<SimdLevel> levels;
+};
+
+TEST_F(MlpModelTest, MatchesReferenceAtEverySimdLevel)
+{
+    // LightweightHetDetector's shape, and one with padded, odd-sized layers
+    for (const std::vector<int>& sizes : { std::vector<int>{ 40, 64, 32, 16, 2 }, std::vector<int>{ 13, 20, 9, 3 } }) {
+        const std::vector<DenseLayer> layers = makeLayers(sizes, 7);
+        const std::vector<char> data = ModelFileBuilder::pack(layers);
+
+        MlpModel model;
+        ASSERT_TRUE(model.loadFromMemory(data.data(), data.size()));
+        EXPECT_EQ(model.getInputSize(), sizes.front());
+        EXPECT_EQ(model.getOutputSize(), sizes.back());
+        EXPECT_EQ(model.getNumLayers(), static_cast<int>(sizes.size()) - 1);
+
+        for (SimdLevel level : levels) {
+            ASSERT_TRUE(forceSimdLevel(level));
+            for (unsigned frame = 0; frame < 16; ++frame) {
+                const std::vector<float> input = makeFeatures(sizes.front(), frame);
+                const std::vector<float> expected = evaluateReference(layers, input);
+                std::vector<float> output(model.getOutputSize(), std::nanf(""));
+                model.run(input.data(), output.data());
+
+                for (int o = 0; o < model.getOutputSize(); ++o) {
+                    EXPECT_NEAR(output[o], expected[o], 1e-4f)
+                        << getSimdLevelName(level) << ", frame " << frame << ", output " << o;
+                }
+            }
+        }
+    }
+}
+
+TEST_F(MlpModelTest, RejectsMalformedFiles)
+{
+    const std::vector<DenseLayer> layers = makeLayers({ 8, 16, 2 }, 3);
+    const std::vector<char> valid = ModelFileBuilder::pack(layers);
+
+    MlpModel model;
+    ASSERT_TRUE(model.loadFromMemory(valid.data(), valid.size()));
+
+    auto corrupt = [&valid](size_t offset, uint32_t value) {
+        std::vector<char> data = valid;
+        for (int shift = 0; shift < 32; shift += 8) {
+            data[offset + shift / 8] = static_cast<char>((value >> shift) & 0xFF);
+        }
+        return data;
+    };
+
+    std::vector<std::vector<char>> malformed = {
+        corrupt(0, 0x4C4D4858),                 // Magic
+        corrupt(4, MlpModel::kVersion + 1),     // Version
+        corrupt(8, 0),                          // No layers
+        corrupt(8, MlpModel::kMaxLayers + 1),   // Too many layers
+        corrupt(16 + 8, 3),                     // Unknown activation
+        corrupt(16 + 8, 2),                     // GRU, but sized as a dense layer
+        corrupt(32, 15),                        // Second layer does not chain
+        std::vector<char>(valid.begin(), valid.end() - 4),
+        std::vector<char>(valid.begin(), valid.begin() + 12),
+    };
+    malformed.push_back(valid);
+    malformed.back().push_back(0);
+
+    for (size_t i = 0; i < malformed.size(); ++i) {
+        EXPECT_FALSE(model.loadFromMemory(malformed[i].data(), malformed[i].size())) << "case " << i;
+    }
+    EXPECT_FALSE(model.loadFromMemory(nullptr, 0));
+
+    // Failed loads keep the previous model
+    EXPECT_TRUE(model.isLoaded());
+    EXPECT_EQ(model.getInputSize(), 8);
+    EXPECT_EQ(model.getOutputSize(), 2);
+
+    EXPECT_FALSE(model.load("does_not_exist.khmlp"));
+    EXPECT_TRUE(model.isLoaded());
+
+    MlpModel empty;
+    EXPECT_FALSE(empty.isLoaded());
+    EXPECT_EQ(empty.getInputSize(), 0);
+    EXPECT_EQ(empty.getOutputSize(), 0);
+}
+
+TEST_F(MlpModelTest, LoadsFromFile)
+{
+    const std::vector<DenseLayer> layers = makeLayers({ 40, 64, 32, 16, 2 }, 11);
+    const std::vector<char> data = ModelFileBuilder::pack(layers);
+    const std::string path = ::testing::TempDir() + "mlpmodel_test.khmlp";
+    ASSERT_TRUE(ModelFileBuilder::write(path, data));
+
+    MlpModel fromFile, fromMemory;
+    ASSERT_TRUE(fromFile.load(path));
+    ASSERT_TRUE(fromMemory.loadFromMemory(data.data(), data.size()));
+    std::remove(path.c_str());
+
+    const std::vector<float> input = makeFeatures(40, 5);
+    std::vector<float> a(2), b(2);
+    fromFile.run(input.data(), a.data());
+    fromMemory.run(input.data(), b.data());
+    EXPECT_EQ(a, b);
+}
+
+TEST_F(MlpModelTest, BatchMatchesSingleFrames)
+{
+    const std::vector<DenseLayer> layers = makeLayers({ 13, 20, 9, 3 }, 17);
+    const std::vector<char> data = ModelFileBuilder::pack(layers);
+    MlpModel model;
+    ASSERT_TRUE(model.loadFromMemory(data.data(), data.size()));
+
+    // Growing, shrinking and growing again exercises the batch buffers
+    for (int numFrames : { 1, 7, 64, 3, 100 }) {
+        const std::vector<float> input = makeFeatures(numFrames * 13, numFrames);
+        std::vector<float> output(numFrames * 3, std::nanf(""));
+        model.runBatch(input.data(), numFrames, output.data());
+
+        for (int frame = 0; frame < numFrames; ++frame) {
+            std::vector<float> single(3);
+            model.run(input.data() + frame * 13, single.data());
+            for (int o = 0; o < 3; ++o) {
+                EXPECT_EQ(output[frame * 3 + o], single[o]) << numFrames << " frames, frame " << frame;
+            }
+        }
+    }
+}
+
+TEST_F(MlpModelTest, RecurrentModelMatchesReferenceAtEverySimdLevel)
+{
+    // 3 x 20 gate rows pad to 64, 20 hidden units to 24
+    const std::vector<DenseLayer> layers = makeRecurrentLayers(40, 32, 20, 5);
+    const std::vector<char> data = ModelFileBuilder::pack(layers);
+    MlpModel model;
+    ASSERT_TRUE(model.loadFromMemory(data.data(), data.size()));
+    EXPECT_TRUE(model.isStateful());
+    EXPECT_EQ(model.getStateSize(), 20);
+    EXPECT_EQ(model.getNumStreams(), 1);
+
+    const int numHops = 24;
+    std::vector<std::vector<float>> hops;
+    std::vector<float> batch;
+    for (int hop = 0; hop < numHops; ++hop) {
+        hops.push_back(makeFeatures(40, 100 + hop));
+        batch.insert(batch.end(), hops.back().begin(), hops.back().end());
+    }
+    const std::vector<std::vector<float>> expected = evaluateSequence(layers, hops);
+
+    for (SimdLevel level : levels) {
+        ASSERT_TRUE(forceSimdLevel(level));
+        model.resetState();
+        for (int hop = 0; hop < numHops; ++hop) {
+            std::vector<float> output(2, std::nanf(""));
+            model.run(hops[hop].data(), output.data());
+            for (int o = 0; o < 2; ++o) {
+                EXPECT_NEAR(output[o], expected[hop][o], 1e-4f)
+                    << getSimdLevelName(level) << ", hop " << hop << ", output " << o;
+            }
+        }
+
+        // A batch of one stream's hops carries the state from hop to hop
+        model.resetState();
+        std::vector<float> output(numHops * 2, std::nanf(""));
+        model.runBatch(batch.data(), numHops, output.data());
+        for (int hop = 0; hop < numHops; ++hop) {
+            EXPECT_NEAR(output[hop * 2 + 1], expected[hop][1], 1e-4f) << getSimdLevelName(level) << ", hop " << hop;
+        }
+    }
+
+    // Stateless models report no state
+    const std::vector<char> stateless = ModelFileBuilder::pack(makeLayers({ 8, 16, 2 }, 3));
+    ASSERT_TRUE(model.loadFromMemory(stateless.data(), stateless.size()));
+    EXPECT_FALSE(model.isStateful());
+    EXPECT_EQ(model.getStateSize(), 0);
+}
+
+TEST_F(MlpModelTest, StreamsKeepTheirOwnState)
+{
+    const std::vector<DenseLayer> layers = makeRecurrentLayers(16, 16, 12, 9);
+    const std::vector<char> data = ModelFileBuilder::pack(layers);
+    MlpModel model;
+    ASSERT_TRUE(model.loadFromMemory(data.data(), data.size()));
+    model.setNumStreams(3);
+    ASSERT_EQ(model.getNumStreams(), 3);
+
+    const int numHops = 20;
+    std::vector<std::vector<std::vector<float>>> streams(3);
+    std::vector<std::vector<std::vector<float>>> expected;
+    for (int stream = 0; stream < 3; ++stream) {
+        for (int hop = 0; hop < numHops; ++hop) {
+            streams[stream].push_back(makeFeatures(16, 1000 * stream + hop));
+        }
+        expected.push_back(evaluateSequence(layers, streams[stream]));
+    }
+
+    std::vector<float> snapshot(model.getStateSize());
+    for (int hop = 0; hop < numHops; ++hop) {
+        std::vector<float> input;
+        for (int stream = 0; stream < 3; ++stream) {
+            input.insert(input.end(), streams[stream][hop].begin(), streams[stream][hop].end());
+        }
+        std::vector<float> output(3 * 2, std::nanf(""));
+        model.runStreams(input.data(), 3, output.data());
+        for (int stream = 0; stream < 3; ++stream) {
+            EXPECT_NEAR(output[stream * 2 + 1], expected[stream][hop][1], 1e-4f)
+                << "stream " << stream << ", hop " << hop;
+        }
+        if (hop == numHops / 2) {
+            model.saveState(1, snapshot.data());
+        }
+    }
+
+    // Stream 1's snapshot, restored into stream 2, continues stream 1
+    model.restoreState(2, snapshot.data());
+    for (int hop = numHops / 2 + 1; hop < numHops; ++hop) {
+        std::vector<float> input(16 * 3, 0.0f);
+        std::copy(streams[1][hop].begin(), streams[1][hop].end(), input.begin() + 2 * 16);
+        std::vector<float> output(3 * 2);
+        model.runStreams(input.data(), 3, output.data());
+        EXPECT_NEAR(output[2 * 2 + 1], expected[1][hop][1], 1e-4f) << "hop " << hop;
+    }
+
+    // A reset stream starts over; the others keep their state
+    std::vector<float> before(model.getStateSize());
+    std::vector<float> after(model.getStateSize());
+    model.saveState(1, before.data());
+    model.resetState(0);
+    model.saveState(1, after.data());
+    EXPECT_EQ(before, after);
+
+    std::vector<float> output(2);
+    model.run(streams[0][0].data(), output.data());
+    EXPECT_NEAR(output[1], expected[0][0][1], 1e-4f);
+}
+
+TEST_F(MlpModelTest, PerformanceBenchmark_StreamingHopVersusWindow)
+{
+    // 5 ms hops at 16 kHz through a GRU, against re-running a 20 ms window
+    // MLP every hop, as overlapping windows would need
+    const std::vector<DenseLayer> recurrent = makeRecurrentLayers(80, 32, 32, 21);
+    const std::vector<DenseLayer> window = makeLayers({ 320, 64, 32, 16, 2 }, 21);
+    const std::vector<char> recurrentData = ModelFileBuilder::pack(recurrent);
+    const std::vector<char> windowData = ModelFileBuilder::pack(window);
+    MlpModel streaming;
+    MlpModel windowed;
+    ASSERT_TRUE(streaming.loadFromMemory(recurrentData.data(), recurrentData.size()));
+    ASSERT_TRUE(windowed.loadFromMemory(windowData.data(), windowData.size()));
+
+    const int kRuns = 50000;
+    const std::vector<float> input = makeFeatures(320, 4);
+    std::vector<float> output(2);
+
+    auto measure = [&](MlpModel& model) {
+        for (int i = 0; i < 1000; ++i) {
+            model.run(input.data(), output.data());
+        }
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < kRuns; ++i) {
+            model.run(input.data(), output.data());
+        }
+        const auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / kRuns;
+    };
+
+    const double hop = measure(streaming);
+    const double full = measure(windowed);
+    std::cout << "Per 5 ms hop, " << getSimdLevelName(getDspKernels().level) << " (nanoseconds):" << std::endl
+              << "  GRU 80-32-[32]-2 on the hop:          " << std::fixed << std::setprecision(0) << hop << std::endl
+              << "  MLP 320-64-32-16-2 on the 20 ms window: " << full << std::endl;
+    EXPECT_LT(hop, 50000.0);
+}
+
+TEST_F(MlpModelTest, MatchesOnnxExportOfSameModel)
+{
+    const char* onnxPath = std::getenv("KHDETECTOR_TEST_MODEL");
+    const char* nativePath = std::getenv("KHDETECTOR_TEST_NATIVE_MODEL");
+    OnnxBackend backend;
+    MlpModel model;
+    if (!OnnxBackend::isAvailable() || !onnxPath || !nativePath || !backend.load(onnxPath, 1)) {
+        GTEST_SKIP() << "Needs ONNX Runtime, KHDETECTOR_TEST_MODEL and KHDETECTOR_TEST_NATIVE_MODEL";
+    }
+    ASSERT_TRUE(model.load(nativePath));
+    ASSERT_EQ(model.getInputSize(), backend.getInputSize());
+    ASSERT_EQ(model.getOutputSize(), backend.getOutputSize());
+
+    std::vector<float> input(model.getInputSize());
+    std::vector<float> expected(model.getOutputSize()), output(model.getOutputSize());
+    ASSERT_TRUE(backend.bind(input.data(), expected.data(), 1));
+
+    for (unsigned frame = 0; frame < 64; ++frame) {
+        const std::vector<float> features = makeFeatures(model.getInputSize(), frame);
+        std::copy(features.begin(), features.end(), input.begin());
+        ASSERT_TRUE(backend.run());
+        model.run(input.data(), output.data());
+        for (int o = 0; o < model.getOutputSize(); ++o) {
+            EXPECT_NEAR(output[o], expected[o], 1e-4f) << "frame " << frame << ", output " << o;
+        }
+    }
+}
+
+TEST_F(MlpModelTest, PerformanceBenchmark_SingleFrameLatency)
+{
+    const std::vector<DenseLayer> layers = makeLayers({ 40, 64, 32, 16, 2 }, 1);
+    const std::vector<char> data = ModelFileBuilder::pack(layers);
+    MlpModel model;
+    ASSERT_TRUE(model.loadFromMemory(data.data(), data.size()));
+
+    const int kRuns = 100000;
+    std::vector<float> input = makeFeatures(40, 9);
+    std::vector<float> output(2);
+
+    std::cout << "Native MLP 40-64-32-16-2, one frame (nanoseconds):" << std::endl;
+    for (SimdLevel level : levels) {
+        ASSERT_TRUE(forceSimdLevel(level));
+        for (int i = 0; i < 1000; ++i) {
+            model.run(input.data(), output.data());
+        }
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < kRuns; ++i) {
+            model.run(input.data(), output.data());
+            input[i % 40] += output[0] * 1e-6f;    // Keep each run dependent on the last
+        }
+        const auto end = std::chrono::high_resolution_clock::now();
+        const double mean = std::chrono::duration<double, std::nano>(end - start).count() / kRuns;
+
+        std::cout << "  " << getSimdLevelName(level) << ": " << std::fixed << std::setprecision(0) << mean
+                  << std::endl;
+
+        // Far below the 500 us the heuristic stub sleeps, even unvectorized
+        EXPECT_LT(mean, 50000.0);
+    }
+}
+
+TEST_F(MlpModelTest, PerformanceBenchmark_BatchThroughput)
+{
+    const std::vector<DenseLayer> layers = makeLayers({ 40, 64, 32, 16, 2 }, 1);
+    const std::vector<char> data = ModelFileBuilder::pack(layers);
+    MlpModel model;
+    ASSERT_TRUE(model.loadFromMemory(data.data(), data.size()));
+
+    std::cout << "Native MLP 40-64-32-16-2, " << getSimdLevelName(getDspKernels().level)
+              << " (nanoseconds per frame):" << std::endl;
+    for (int numFrames : { 1, 8, 64, 256 }) {
+        const std::vector<float> input = makeFeatures(numFrames * 40, 3);
+        std::vector<float> output(numFrames * 2);
+        model.runBatch(input.data(), numFrames, output.data());
+
+        const int kRuns = 200000 / numFrames;
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < kRuns; ++i) {
+            model.runBatch(input.data(), numFrames, output.data());
+        }
+        const auto end = std::chrono::high_resolution_clock::now();
+        const double perFrame = std::chrono::duration<double, std::nano>(end - start).count() / (kRuns * numFrames);
+
+        std::cout << "  batch " << std::setw(3) << numFrames << ": " << std::fixed << std::setprecision(0) << perFrame
+                  << std::endl;
+        EXPECT_LT(perFrame, 50000.0);
+    }
+}
@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "AiInference.h"
+#include "LatencyHistogram.h"
+#include "ModelFileBuilder.h"
+#include "ModelLoader.h"
+
+using namespace KhDetector;
+
+class ModelLoaderTest : public ::testing::Test
+{
+protected:
+    static constexpr int kFrameSize = 320;
+
+    void SetUp() override
+    {
+        // A two-class model whose detection logit is the frame mean
+        ModelFileBuilder::Layer layer = ModelFileBuilder::dense(kFrameSize, 2, false);
+        std::fill_n(layer.weights.begin() + kFrameSize, kFrameSize, 1.0f / kFrameSize);
+        modelPath = ::testing::TempDir() + "modelloader_test.khmlp";
+        ModelFileBuilder::write(modelPath, { layer });
+    }
+
+    void TearDown() override
+    {
+        std::remove(modelPath.c_str());
+    }
+
+    AiInference::ModelConfig makeConfig() const
+    {
+        AiInference::ModelConfig config = createDefaultModelConfig();
+        config.modelPath = modelPath;
+        config.inputSize = kFrameSize;
+        config.useActivityGate = true;
+        return config;
+    }
+
+    /**
+     * @brief What a plugin instance does per host process() call
+     *
+     * Passes the audio through and asks the engine for its hit state once it
+     * is published, like KhDetectorProcessor::process().
+     */
+    static bool processBlock(const ModelHandle& model, const std::vector<float>& input, std::vector<float>& output)
+    {
+        std::copy(input.begin(), input.end(), output.begin());
+        const AiInference* engine = model.get();
+        return engine && engine->hasHit();
+    }
+
+    std::string modelPath;
+};
+
+TEST_F(ModelLoaderTest, PublishesAWarmFreshEngine)
+{
+    ModelLoader loader(1, 5);
+    auto monitor = std::make_shared<LatencyMonitor>();
+    int prepared = 0;
+    auto handle = loader.load(makeConfig(), [&](AiInference& engine) {
+        ++prepared;
+        engine.setLatencyMonitor(monitor);
+    });
+
+    ASSERT_TRUE(handle);
+    ASSERT_TRUE(handle->wait(std::chrono::seconds(10)));
+    EXPECT_EQ(handle->getState(), ModelHandle::State::Ready);
+    EXPECT_EQ(loader.getPendingCount(), 0u);
+    EXPECT_EQ(prepared, 1);
+
+    // Warmup frames leave no trace in the published engine
+    AiInference* engine = handle->get();
+    ASSERT_NE(engine, nullptr);
+    EXPECT_TRUE(engine->isReady());
+    EXPECT_EQ(engine->getStatistics().totalInferences.load(), 0u);
+    EXPECT_FALSE(engine->hasHit());
+    EXPECT_EQ(monitor->getSnapshot(LatencyStage::Inference).count, 0u);
+
+    const std::vector<float> frame(kFrameSize, 0.0f);
+    EXPECT_TRUE(engine->run(frame.data(), kFrameSize).success);
+    EXPECT_EQ(monitor->getSnapshot(LatencyStage::FeatureExtraction).count, 1u);
+}
+
+TEST_F(ModelLoaderTest, PublishesModellessEnginesAsHeuristic)
+{
+    ModelLoader loader(1, 1);
+    AiInference::ModelConfig config = makeConfig();
+    config.modelPath.clear();
+
+    // The engine still scores frames, but the handle does not claim a model
+    auto handle = loader.load(config);
+    EXPECT_FALSE(handle->wait(std::chrono::seconds(10)));
+    EXPECT_EQ(handle->getState(), ModelHandle::State::Heuristic);
+    EXPECT_FALSE(handle->isReady());
+    ASSERT_NE(handle->get(), nullptr);
+    EXPECT_FALSE(handle->get()->hasModel());
+
+    const std::vector<float> frame(kFrameSize, 0.0f);
+    EXPECT_TRUE(handle->get()->run(frame.data(), kFrameSize).success);
+}
+
+TEST_F(ModelLoaderTest, ReportsFailedLoads)
+{
+    ModelLoader loader;
+    AiInference::ModelConfig config = makeConfig();
+    config.modelPath = ::testing::TempDir() + "no_such_model.khmlp";
+
+    auto handle = loader.load(config);
+    EXPECT_FALSE(handle->wait(std::chrono::seconds(10)));
+    EXPECT_EQ(handle->getState(), ModelHandle::State::Failed);
+    EXPECT_EQ(handle->get(), nullptr);
+}
+
+TEST_F(ModelLoaderTest, StoppingTheLoaderFailsQueuedLoads)
+{
+    std::vector<std::shared_ptr<ModelHandle>> kept;
+    {
+        ModelLoader loader(1, 1);
+        for (int i = 0; i < 8; ++i) {
+            auto handle = loader.load(makeConfig());
+            if (i % 2 == 0) {
+                kept.push_back(handle);
+            }
+        }
+        ASSERT_TRUE(kept.front()->wait(std::chrono::seconds(10)));
+    }
+
+    // Stopping the loader fails whatever it had not reached, it never hangs a waiter
+    for (const auto& handle : kept) {
+        EXPECT_NE(handle->getState(), ModelHandle::State::Loading);
+        EXPECT_EQ(handle->wait(std::chrono::milliseconds(0)), handle->getState() == ModelHandle::State::Ready);
+    }
+}
+
+TEST_F(ModelLoaderTest, PerformanceBenchmark_InstantiateToFirstProcess)
+{
+    // KHDETECTOR_STARTUP_INSTANCES sets the project size (default 16)
+    int numInstances = 16;
+    if (const char* instances = std::getenv("KHDETECTOR_STARTUP_INSTANCES")) {
+        numInstances = std::max(1, std::atoi(instances));
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const std::vector<float> input(512, 0.1f);
+    std::vector<float> output(512);
+
+    // Before: every constructor initialized its engine before returning
+    const auto syncStart = Clock::now();
+    std::vector<std::unique_ptr<AiInference>> engines;
+    for (int i = 0; i < numInstances; ++i) {
+        engines.push_back(createAiInference(makeConfig()));
+        ASSERT_TRUE(engines.back());
+        std::copy(input.begin(), input.end(), output.begin());
+        engines.back()->hasHit();
+    }
+    const auto syncFirstProcess = Clock::now() - syncStart;
+    engines.clear();
+
+    // After: constructors queue the load and process() passes through until the swap
+    ModelLoader loader;
+    const auto asyncStart = Clock::now();
+    std::vector<std::shared_ptr<ModelHandle>> handles;
+    for (int i = 0; i < numInstances; ++i) {
+        handles.push_back(loader.load(makeConfig()));
+        processBlock(*handles.back(), input, output);
+    }
+    const auto asyncFirstProcess = Clock::now() - asyncStart;
+    int readyAtFirstProcess = 0;
+    for (const auto& handle : handles) {
+        readyAtFirstProcess += handle->isReady() ? 1 : 0;
+    }
+    for (const auto& handle : handles) {
+        ASSERT_TRUE(handle->wait(std::chrono::seconds(30)));
+    }
+    const auto asyncAllReady = Clock::now() - asyncStart;
+
+    const auto ms = [](Clock::duration time) { return std::chrono::duration<double, std::milli>(time).count(); };
+    std::cout << numInstances << " instances, instantiate to first process(): "
+              << ms(syncFirstProcess) << " ms loading in the constructor, "
+              << ms(asyncFirstProcess) << " ms with background loading ("
+              << readyAtFirstProcess << " models ready, all ready after " << ms(asyncAllReady)
+              << " ms, warmup included)" << std::endl;
+
+    EXPECT_LT(asyncFirstProcess, syncFirstProcess);
+}
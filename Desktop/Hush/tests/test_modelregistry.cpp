@@ -0,0 +1,236 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "AiInference.h"
+#include "MlpModel.h"
+#include "ModelFileBuilder.h"
+#include "ModelRegistry.h"
+
+using namespace KhDetector;
+
+class ModelRegistryTest : public ::testing::Test
+{
+protected:
+    void TearDown() override
+    {
+        for (const std::string& path : paths) {
+            std::remove(path.c_str());
+        }
+    }
+
+    /**
+     * @brief Contents of a .khmlp file with dense ReLU layers of the given sizes and random parameters
+     */
+    static std::vector<char> makeModel(const std::vector<int>& sizes, unsigned seed)
+    {
+        std::mt19937 gen(seed);
+        std::normal_distribution<float> dist(0.0f, 0.1f);
+        std::vector<ModelFileBuilder::Layer> layers = ModelFileBuilder::denseStack(sizes);
+        for (ModelFileBuilder::Layer& layer : layers) {
+            ModelFileBuilder::fill(layer, [&] { return dist(gen); });
+        }
+        return ModelFileBuilder::pack(layers);
+    }
+
+    /**
+     * @brief Write a model the way export_native_model.py does: to a new file renamed over the old one
+     */
+    std::string writeModel(const std::string& name, const std::vector<char>& data)
+    {
+        const std::string path = ::testing::TempDir() + name;
+        const std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary);
+            file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        }
+        std::rename(temporary.c_str(), path.c_str());
+        if (std::find(paths.begin(), paths.end(), path) == paths.end()) {
+            paths.push_back(path);
+        }
+        return path;
+    }
+
+    static std::vector<float> runModel(MlpModel& model, unsigned seed)
+    {
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+        std::vector<float> input(model.getInputSize());
+        for (float& sample : input) {
+            sample = dist(gen);
+        }
+        std::vector<float> output(model.getOutputSize());
+        model.run(input.data(), output.data());
+        return output;
+    }
+
+    std::vector<std::string> paths;
+};
+
+TEST_F(ModelRegistryTest, InstancesShareOneMappingPerFile)
+{
+    const std::vector<char> data = makeModel({ 320, 64, 32, 2 }, 1);
+    const std::string path = writeModel("registry_shared.khmlp", data);
+
+    ModelRegistry registry;
+    auto first = registry.acquire(path);
+    auto second = registry.acquire(path);
+    ASSERT_TRUE(first);
+    EXPECT_EQ(first, second);
+    EXPECT_TRUE(first->isBorrowed());
+    EXPECT_EQ(first->getInputSize(), 320);
+    EXPECT_EQ(first->getOutputSize(), 2);
+    EXPECT_EQ(registry.getNumModels(), 1u);
+
+    // Shared weights, own activations: results match a model with its own copy
+    MlpModel copy;
+    ASSERT_TRUE(copy.loadFromMemory(data.data(), data.size()));
+    EXPECT_FALSE(copy.getWeights()->isBorrowed());
+    MlpModel a;
+    MlpModel b;
+    ASSERT_TRUE(a.setWeights(first));
+    ASSERT_TRUE(b.setWeights(second));
+    for (unsigned seed = 0; seed < 4; ++seed) {
+        const std::vector<float> expected = runModel(copy, seed);
+        EXPECT_EQ(runModel(a, seed), expected);
+        EXPECT_EQ(runModel(b, seed + 100), runModel(copy, seed + 100));
+    }
+
+    // The registry does not keep models alive by itself
+    first.reset();
+    second.reset();
+    EXPECT_EQ(registry.getNumModels(), 1u);   // Still held by a and b
+    a.setWeights(copy.getWeights());
+    b.setWeights(copy.getWeights());
+    EXPECT_EQ(registry.getNumModels(), 0u);
+}
+
+TEST_F(ModelRegistryTest, ChangedFileGetsNewWeights)
+{
+    const std::string path = writeModel("registry_changed.khmlp", makeModel({ 16, 8, 2 }, 1));
+
+    ModelRegistry registry;
+    auto original = registry.acquire(path);
+    ASSERT_TRUE(original);
+    MlpModel running;
+    ASSERT_TRUE(running.setWeights(original));
+    const std::vector<float> before = runModel(running, 7);
+
+    writeModel("registry_changed.khmlp", makeModel({ 16, 8, 2 }, 2));
+    auto updated = registry.acquire(path);
+    ASSERT_TRUE(updated);
+    EXPECT_NE(updated, original);
+    EXPECT_EQ(registry.getNumModels(), 2u);
+
+    // Instances already running keep the weights they started with
+    EXPECT_EQ(runModel(running, 7), before);
+    MlpModel reloaded;
+    ASSERT_TRUE(reloaded.setWeights(updated));
+    EXPECT_NE(runModel(reloaded, 7), before);
+}
+
+TEST_F(ModelRegistryTest, RejectsMissingAndMalformedFiles)
+{
+    ModelRegistry registry;
+    EXPECT_FALSE(registry.acquire(::testing::TempDir() + "registry_missing.khmlp"));
+
+    std::vector<char> truncated = makeModel({ 16, 8, 2 }, 1);
+    truncated.resize(truncated.size() - 4);
+    EXPECT_FALSE(registry.acquire(writeModel("registry_truncated.khmlp", truncated)));
+    EXPECT_FALSE(registry.acquire(writeModel("registry_empty.khmlp", {})));
+    EXPECT_EQ(registry.getNumModels(), 0u);
+
+    MlpModel model;
+    EXPECT_FALSE(model.setWeights(nullptr));
+    EXPECT_FALSE(model.isLoaded());
+}
+
+TEST_F(ModelRegistryTest, ConcurrentLoadsShareOneModel)
+{
+    const std::string path = writeModel("registry_concurrent.khmlp", makeModel({ 320, 64, 2 }, 3));
+
+    ModelRegistry registry;
+    std::vector<std::shared_ptr<const MlpWeights>> weights(8);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < weights.size(); ++t) {
+        threads.emplace_back([&, t] { weights[t] = registry.acquire(path); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_TRUE(weights.front());
+    for (const auto& shared : weights) {
+        EXPECT_EQ(shared, weights.front());
+    }
+    EXPECT_EQ(registry.getNumModels(), 1u);
+}
+
+TEST_F(ModelRegistryTest, EnginesLoadThroughTheSharedRegistry)
+{
+    const std::string path = writeModel("registry_engines.khmlp", makeModel({ 320, 64, 2 }, 4));
+    AiInference::ModelConfig config = createDefaultModelConfig();
+    config.inputSize = 320;
+    config.modelPath = path;
+
+    const size_t before = ModelRegistry::getShared().getNumModels();
+    {
+        AiInference first(config);
+        AiInference second(config);
+        ASSERT_TRUE(first.loadModel(path));
+        ASSERT_TRUE(second.loadModel(path));
+        EXPECT_EQ(ModelRegistry::getShared().getNumModels(), before + 1);
+    }
+    EXPECT_EQ(ModelRegistry::getShared().getNumModels(), before);
+}
+
+TEST_F(ModelRegistryTest, PerformanceBenchmark_SecondInstanceLoad)
+{
+    // A larger model than the detector, so file reads and copies show
+    const std::vector<char> data = makeModel({ 320, 1024, 1024, 2 }, 5);
+    const std::string path = writeModel("registry_benchmark.khmlp", data);
+    const int numInstances = 16;
+
+    using Clock = std::chrono::steady_clock;
+    const auto ms = [](Clock::duration time) { return std::chrono::duration<double, std::milli>(time).count(); };
+
+    // Before: every instance reads its own copy
+    std::vector<MlpModel> copies(numInstances);
+    const auto copyStart = Clock::now();
+    ASSERT_TRUE(copies[0].load(path));
+    const auto copyFirst = Clock::now() - copyStart;
+    for (int i = 1; i < numInstances; ++i) {
+        ASSERT_TRUE(copies[i].load(path));
+    }
+    const auto copyRest = (Clock::now() - copyStart - copyFirst) / (numInstances - 1);
+
+    // After: the first instance maps the file, the rest share it
+    ModelRegistry registry;
+    std::vector<MlpModel> shared(numInstances);
+    const auto sharedStart = Clock::now();
+    ASSERT_TRUE(shared[0].setWeights(registry.acquire(path)));
+    const auto sharedFirst = Clock::now() - sharedStart;
+    for (int i = 1; i < numInstances; ++i) {
+        ASSERT_TRUE(shared[i].setWeights(registry.acquire(path)));
+    }
+    const auto sharedRest = (Clock::now() - sharedStart - sharedFirst) / (numInstances - 1);
+
+    EXPECT_EQ(runModel(shared[numInstances - 1], 1), runModel(copies[0], 1));
+
+    const double megabytes = static_cast<double>(copies[0].getWeights()->getParameterBytes()) / (1 << 20);
+    std::cout << numInstances << " instances of a " << megabytes << " MB model:" << std::endl
+              << "  own copy: first " << ms(copyFirst) << " ms, later " << ms(copyRest) << " ms each, "
+              << numInstances * megabytes << " MB of weights" << std::endl
+              << "  shared:   first " << ms(sharedFirst) << " ms, later " << ms(sharedRest) << " ms each, "
+              << megabytes << " MB of weights" << std::endl;
+
+    EXPECT_LT(sharedRest, copyRest);
+}
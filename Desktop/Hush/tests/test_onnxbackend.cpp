@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include "OnnxBackend.h"
+
+using namespace KhDetector;
+
+/**
+ * Model tests need a build with ONNX Runtime and a model exported by
+ * training/train_het_detector.py, e.g.
+ *
+ *   KHDETECTOR_TEST_MODEL=/path/to/het_detector.onnx ./KhDetectorTests --gtest_filter=OnnxBackend*
+ *
+ * and are skipped otherwise.
+ */
+class OnnxBackendTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        const char* path = std::getenv("KHDETECTOR_TEST_MODEL");
+        modelPath = path ? path : "";
+    }
+
+    void TearDown() override
+    {
+    }
+
+    bool loadTestModel(OnnxBackend& backend, int numThreads = 1)
+    {
+        return OnnxBackend::isAvailable() && !modelPath.empty() && backend.load(modelPath, numThreads);
+    }
+
+    static std::vector<float> makeFeatures(int count)
+    {
+        std::mt19937 gen(42);
+        std::normal_distribution<float> dist(0.0f, 1.0f);
+        std::vector<float> features(count);
+        for (float& value : features) {
+            value = dist(gen);
+        }
+        return features;
+    }
+
+    std::string modelPath;
+};
+
+TEST_F(OnnxBackendTest, FailsCleanlyWithoutModel)
+{
+    OnnxBackend backend;
+    std::vector<float> input(40), output(2);
+
+    EXPECT_FALSE(backend.load("does_not_exist.onnx", 1));
+    EXPECT_FALSE(backend.isLoaded());
+    EXPECT_EQ(backend.getInputSize(), 0);
+    EXPECT_EQ(backend.getOutputSize(), 0);
+    EXPECT_FALSE(backend.bind(input.data(), output.data(), 1));
+    EXPECT_FALSE(backend.run());
+}
+
+TEST_F(OnnxBackendTest, RunsBoundBuffersInPlace)
+{
+    OnnxBackend backend;
+    if (!loadTestModel(backend)) {
+        GTEST_SKIP() << "Needs ONNX Runtime and KHDETECTOR_TEST_MODEL";
+    }
+
+    // train_het_detector.py: 40 features in, [other, het] logits out
+    ASSERT_GT(backend.getInputSize(), 0);
+    ASSERT_GT(backend.getOutputSize(), 0);
+
+    const int batchSize = 4;
+    std::vector<float> input = makeFeatures(batchSize * backend.getInputSize());
+    std::vector<float> output(batchSize * backend.getOutputSize(), std::nanf(""));
+    ASSERT_TRUE(backend.bind(input.data(), output.data(), batchSize));
+
+    ASSERT_TRUE(backend.run());
+    for (float value : output) {
+        EXPECT_TRUE(std::isfinite(value));
+    }
+
+    // Same input, same output; new input is picked up without rebinding
+    const std::vector<float> first = output;
+    ASSERT_TRUE(backend.run());
+    EXPECT_EQ(output, first);
+
+    std::fill(input.begin(), input.end(), 0.0f);
+    ASSERT_TRUE(backend.run());
+    EXPECT_NE(output, first);
+
+    // Each frame of a batch matches running it alone
+    std::vector<float> single(input.begin(), input.begin() + backend.getInputSize());
+    std::vector<float> singleOutput(backend.getOutputSize());
+    ASSERT_TRUE(backend.bind(single.data(), singleOutput.data(), 1));
+    ASSERT_TRUE(backend.run());
+    for (int i = 0; i < backend.getOutputSize(); ++i) {
+        EXPECT_NEAR(singleOutput[i], output[i], 1e-5f);
+    }
+}
+
+TEST_F(OnnxBackendTest, PerformanceBenchmark_LatencyPerBatchSize)
+{
+    OnnxBackend backend;
+    if (!loadTestModel(backend)) {
+        GTEST_SKIP() << "Needs ONNX Runtime and KHDETECTOR_TEST_MODEL";
+    }
+
+    const int kRuns = 2000;
+    std::cout << "ONNX Runtime latency, 1 thread (microseconds):" << std::endl;
+    std::cout << "  batch   per batch (mean)   per batch (p99)   per frame" << std::endl;
+
+    for (int batchSize : { 1, 2, 4, 8, 16, 32, 64, 128, 256 }) {
+        std::vector<float> input = makeFeatures(batchSize * backend.getInputSize());
+        std::vector<float> output(batchSize * backend.getOutputSize());
+        ASSERT_TRUE(backend.bind(input.data(), output.data(), batchSize));
+
+        // Let the arena grow to its working size
+        for (int i = 0; i < 50; ++i) {
+            ASSERT_TRUE(backend.run());
+        }
+
+        std::vector<double> latencies(kRuns);
+        for (int i = 0; i < kRuns; ++i) {
+            const auto start = std::chrono::high_resolution_clock::now();
+            backend.run();
+            const auto end = std::chrono::high_resolution_clock::now();
+            latencies[i] = std::chrono::duration<double, std::micro>(end - start).count();
+        }
+
+        double total = 0.0;
+        for (double latency : latencies) {
+            total += latency;
+        }
+        const double mean = total / kRuns;
+        std::nth_element(latencies.begin(), latencies.begin() + kRuns * 99 / 100, latencies.end());
+        const double p99 = latencies[kRuns * 99 / 100];
+
+        std::cout << std::fixed << std::setprecision(2) << "  " << std::setw(5) << batchSize << std::setw(19) << mean
+                  << std::setw(18) << p99 << std::setw(12) << mean / batchSize << std::endl;
+
+        // One 20 ms frame must finish well inside its own duration
+        if (batchSize == 1) {
+            EXPECT_LT(mean, 1000.0);
+        }
+    }
+}
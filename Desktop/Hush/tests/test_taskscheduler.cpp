@@ -0,0 +1,258 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "RealtimeTask.h"
+#include "TaskScheduler.h"
+#include "WorkStealingDeque.h"
+
+using namespace KhDetector;
+
+class TaskSchedulerTest : public ::testing::Test
+{
+protected:
+    /**
+     * @brief Worker threads running the scheduler the way RealtimeThreadPool does
+     */
+    class Workers
+    {
+    public:
+        Workers(TaskScheduler& scheduler)
+            : mScheduler(scheduler)
+        {
+            for (int i = 0; i < scheduler.getWorkerCount(); ++i) {
+                mThreads.emplace_back([this, i] {
+                    mScheduler.bindWorker(i);
+                    RealtimeTask task;
+                    while (!mStop.load()) {
+                        if (mScheduler.take(i, task)) {
+                            task();
+                            task.reset();
+                        } else {
+                            mScheduler.waitForWork();
+                        }
+                    }
+                });
+            }
+        }
+
+        ~Workers()
+        {
+            mStop.store(true);
+            mScheduler.wakeAll();
+            for (auto& thread : mThreads) {
+                thread.join();
+            }
+        }
+
+    private:
+        TaskScheduler& mScheduler;
+        std::atomic<bool> mStop{false};
+        std::vector<std::thread> mThreads;
+    };
+
+    template<typename Predicate>
+    static bool waitUntil(Predicate predicate, std::chrono::milliseconds timeout = std::chrono::seconds(10))
+    {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!predicate()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+};
+
+TEST_F(TaskSchedulerTest, RealtimeTaskKeepsCapturesInline)
+{
+    static_assert(sizeof(RealtimeTask) <= 64, "One cache line");
+
+    // Move-only captures are fine, and destroyed exactly once
+    auto alive = std::make_shared<int>(0);
+    std::unique_ptr<int> value = std::make_unique<int>(41);
+    int result = 0;
+    RealtimeTask task([&result, value = std::move(value), alive] { result = *value + 1; });
+    EXPECT_TRUE(task);
+    EXPECT_EQ(alive.use_count(), 2);
+
+    RealtimeTask moved(std::move(task));
+    EXPECT_FALSE(task);
+    ASSERT_TRUE(moved);
+    moved();
+    EXPECT_EQ(result, 42);
+
+    task = std::move(moved);
+    EXPECT_EQ(alive.use_count(), 2);
+    task.reset();
+    EXPECT_FALSE(task);
+    EXPECT_EQ(alive.use_count(), 1);
+
+    RealtimeTask empty = nullptr;
+    EXPECT_FALSE(empty);
+}
+
+TEST_F(TaskSchedulerTest, DequeOwnerTakesNewestThiefOldest)
+{
+    WorkStealingDeque<uint32_t, 8> deque;
+    uint32_t item = 0;
+    EXPECT_FALSE(deque.pop(item));
+    EXPECT_FALSE(deque.steal(item));
+
+    for (uint32_t i = 1; i <= 8; ++i) {
+        EXPECT_TRUE(deque.push(i));
+    }
+    EXPECT_FALSE(deque.push(9));
+    EXPECT_EQ(deque.size(), 8u);
+
+    ASSERT_TRUE(deque.steal(item));
+    EXPECT_EQ(item, 1u);
+    ASSERT_TRUE(deque.pop(item));
+    EXPECT_EQ(item, 8u);
+    EXPECT_TRUE(deque.push(9));     // Room again, wrapping around
+
+    std::vector<uint32_t> popped;
+    while (deque.pop(item)) {
+        popped.push_back(item);
+    }
+    EXPECT_EQ(popped, (std::vector<uint32_t>{ 9, 7, 6, 5, 4, 3, 2 }));
+    EXPECT_TRUE(deque.empty());
+}
+
+TEST_F(TaskSchedulerTest, DequeHandsEachItemToExactlyOneThread)
+{
+    WorkStealingDeque<uint32_t, 64> deque;
+    const uint32_t numItems = 200000;
+    std::vector<std::atomic<int>> taken(numItems);
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < 3; ++t) {
+        thieves.emplace_back([&] {
+            uint32_t item = 0;
+            while (!done.load()) {
+                if (deque.steal(item)) {
+                    taken[item].fetch_add(1);
+                }
+            }
+        });
+    }
+
+    // The owner pushes everything, popping now and then and whenever the deque is full
+    uint32_t item = 0;
+    for (uint32_t next = 0; next < numItems;) {
+        if (deque.push(next)) {
+            ++next;
+        }
+        if ((next % 3 == 0 || deque.size() == 64) && deque.pop(item)) {
+            taken[item].fetch_add(1);
+        }
+    }
+    while (deque.pop(item)) {
+        taken[item].fetch_add(1);
+    }
+    done.store(true);
+    for (auto& thief : thieves) {
+        thief.join();
+    }
+
+    for (uint32_t i = 0; i < numItems; ++i) {
+        ASSERT_EQ(taken[i].load(), 1) << "item " << i;
+    }
+}
+
+TEST_F(TaskSchedulerTest, EveryTaskRunsOnce)
+{
+    TaskScheduler scheduler(3);
+    const int numProducers = 2;
+    const int tasksPerProducer = 20000;
+    std::vector<std::atomic<int>> runs(numProducers * tasksPerProducer);
+    std::atomic<int> rejected{0};
+
+    {
+        Workers workers(scheduler);
+        std::vector<std::thread> producers;
+        for (int p = 0; p < numProducers; ++p) {
+            producers.emplace_back([&, p] {
+                for (int i = 0; i < tasksPerProducer; ++i) {
+                    std::atomic<int>* counter = &runs[p * tasksPerProducer + i];
+                    // A full queue turns the task down; retry like a producer that must not drop it
+                    while (!scheduler.submit([counter] { counter->fetch_add(1); })) {
+                        rejected.fetch_add(1);
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+        ASSERT_TRUE(waitUntil([&] { return scheduler.size() == 0; }));
+    }
+
+    for (size_t i = 0; i < runs.size(); ++i) {
+        ASSERT_EQ(runs[i].load(), 1) << "task " << i;
+    }
+    std::cout << "Submissions turned down while the queue was full: " << rejected.load() << std::endl;
+}
+
+TEST_F(TaskSchedulerTest, BoundedAndClearable)
+{
+    // No workers: nothing runs, so the queue fills up
+    TaskScheduler scheduler(0);
+    auto alive = std::make_shared<int>(0);
+    int ran = 0;
+    for (size_t i = 0; i < TaskScheduler::kCapacity; ++i) {
+        EXPECT_TRUE(scheduler.submit([alive, &ran] { ++ran; }));
+    }
+    EXPECT_FALSE(scheduler.submit([alive, &ran] { ++ran; }));
+    EXPECT_FALSE(scheduler.submit(RealtimeTask()));
+    EXPECT_EQ(scheduler.size(), TaskScheduler::kCapacity);
+    EXPECT_EQ(alive.use_count(), static_cast<long>(TaskScheduler::kCapacity) + 1);
+
+    // Threads that are not workers may take from the injection queue too
+    RealtimeTask task;
+    ASSERT_TRUE(scheduler.take(-1, task));
+    task();
+    EXPECT_EQ(ran, 1);
+    EXPECT_TRUE(scheduler.submit([alive, &ran] { ++ran; }));
+
+    task.reset();
+    scheduler.clear();
+    EXPECT_EQ(scheduler.size(), 0u);
+    EXPECT_EQ(alive.use_count(), 1);
+    EXPECT_FALSE(scheduler.take(-1, task));
+    EXPECT_TRUE(scheduler.submit([alive, &ran] { ++ran; }));
+    EXPECT_EQ(ran, 1);
+}
+
+TEST_F(TaskSchedulerTest, IdleWorkersStealSpawnedTasks)
+{
+    TaskScheduler scheduler(3);
+    const int numChildren = 32;
+    std::atomic<int> childrenDone{0};
+    std::atomic<bool> rootDone{false};
+
+    {
+        Workers workers(scheduler);
+        // The root task queues its children on its own worker's deque and waits for them
+        // without returning, so every child has to be stolen by another worker
+        ASSERT_TRUE(scheduler.submit([&] {
+            for (int i = 0; i < numChildren; ++i) {
+                EXPECT_TRUE(scheduler.submit([&childrenDone] { childrenDone.fetch_add(1); }));
+            }
+            waitUntil([&] { return childrenDone.load() == numChildren; });
+            rootDone.store(true);
+        }));
+        ASSERT_TRUE(waitUntil([&] { return rootDone.load(); }));
+    }
+
+    EXPECT_EQ(childrenDone.load(), numChildren);
+    EXPECT_EQ(scheduler.getStealCount(), static_cast<uint64_t>(numChildren));
+    EXPECT_EQ(scheduler.size(), 0u);
+}
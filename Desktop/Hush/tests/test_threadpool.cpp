@@ -274,7 +274,7 @@ TEST_F(RealtimeThreadPoolTest, Statistics)
     // Check updated statistics
     stats = threadPool->getStatistics();
     EXPECT_GT(stats.framesProcessed.load(), 0);
-    EXPECT_GE(stats.averageProcessingTimeMs.load(), 0.0);
+    EXPECT_GE(stats.getAverageProcessingTimeMs(), 0.0);
     
     // Reset statistics
     threadPool->resetStatistics();
@@ -363,7 +363,7 @@ TEST_F(RealtimeThreadPoolTest, LongRunningStressTest)
     
     auto stats = threadPool->getStatistics();
     EXPECT_GT(stats.framesProcessed.load(), 0);
-    EXPECT_LT(stats.cpuUsagePercent.load(), 100.0);  // Should not max out CPU
+    EXPECT_LT(threadPool->getCpuUsagePercent(), 100.0);  // Should not max out CPU
     
     threadPool->stop();
 }
@@ -389,8 +389,8 @@ TEST_F(RealtimeThreadPoolTest, PerformanceBenchmark)
     
     // Performance validation
     if (stats.framesProcessed.load() > 0) {
-        double avgProcessingTime = stats.averageProcessingTimeMs.load();
-        double cpuUsage = stats.cpuUsagePercent.load();
+        double avgProcessingTime = stats.getAverageProcessingTimeMs();
+        double cpuUsage = threadPool->getCpuUsagePercent();
         
         // These are reasonable bounds for a stub implementation
         EXPECT_LT(avgProcessingTime, 10.0);  // Should be less than 10ms average
@@ -0,0 +1,261 @@
+#!/usr/bin/env python3
+"""
+Export a trained ח detector for the plugin's native MLP engine
+
+Writes the file read by KhDetector::MlpModel (Desktop/Hush/src/MlpModel.h):
+dropout is dropped, inference-time batch norms are folded into the
+neighbouring linear layers, and each layer's weights are packed in blocks
+of 8 outputs in the order the plugin's SIMD kernel reads them. GRU layers
+(describe_gru()) make a streaming model whose hidden state the plugin
+carries from hop to hop.
+"""
+
+import argparse
+import math
+import os
+import random
+import struct
+from pathlib import Path
+
+import torch
+import torch.nn as nn
+
+MAGIC = b'KHML'
+VERSION = 1
+BLOCK = 8
+ACTIVATION_RELU = 1
+ACTIVATION_GRU = 2
+
+
+def fold_batch_norm(layer, scale, shift):
+    """Fold y = scale * x + shift into a layer's output
+
+    A batch norm straight after the linear layer folds into its weights; one
+    after the ReLU is kept and folded into the next layer's inputs.
+    """
+    if layer['relu']:
+        if layer['post_scale'] is not None:
+            raise ValueError('Two batch norms after one layer')
+        layer['post_scale'] = scale
+        layer['post_shift'] = shift
+    else:
+        layer['weight'] = [[w * s for w in row] for row, s in zip(layer['weight'], scale)]
+        layer['bias'] = [b * s + t for b, s, t in zip(layer['bias'], scale, shift)]
+
+
+def describe_layers(model):
+    """Linear layers of the model's Sequential network as plain lists"""
+    layers = []
+    for module in model.network:
+        if isinstance(module, nn.Linear):
+            layers.append({
+                'weight': module.weight.detach().cpu().double().tolist(),
+                'bias': module.bias.detach().cpu().double().tolist(),
+                'relu': False,
+                'post_scale': None,
+                'post_shift': None,
+            })
+        elif not layers:
+            raise ValueError(f'Native export needs a linear first layer, got {module}')
+        elif isinstance(module, nn.ReLU):
+            layers[-1]['relu'] = True
+        elif isinstance(module, nn.BatchNorm1d):
+            # Inference-time batch norm: running statistics, not batch statistics
+            inv_std = 1.0 / torch.sqrt(module.running_var.double() + module.eps)
+            scale = module.weight.detach().double() * inv_std
+            shift = module.bias.detach().double() - module.running_mean.double() * scale
+            fold_batch_norm(layers[-1], scale.cpu().tolist(), shift.cpu().tolist())
+        elif isinstance(module, nn.Dropout):
+            continue  # Identity at inference
+        else:
+            raise ValueError(f'Unsupported layer for native export: {module}')
+    return layers
+
+
+def describe_gru(module):
+    """A single-layer, unidirectional nn.GRU as a layer for pack_model()
+
+    Weights keep PyTorch's gate order (reset, update, new), which is the
+    order MlpModel reads.
+    """
+    if module.num_layers != 1 or module.bidirectional or not module.bias:
+        raise ValueError(f'Native export needs a single-layer, one-way GRU with biases, got {module}')
+    return {
+        'weight': module.weight_ih_l0.detach().cpu().double().tolist(),
+        'bias': module.bias_ih_l0.detach().cpu().double().tolist(),
+        'hidden_weight': module.weight_hh_l0.detach().cpu().double().tolist(),
+        'hidden_bias': module.bias_hh_l0.detach().cpu().double().tolist(),
+        'gru': True,
+        'relu': False,
+        'post_scale': None,
+        'post_shift': None,
+    }
+
+
+def fold_post_activation_scales(layers):
+    """W2 (s * a + t) + b2 = (W2 diag(s)) a + (W2 t + b2)"""
+    for previous, layer in zip(layers, layers[1:]):
+        scale, shift = previous['post_scale'], previous['post_shift']
+        if scale is None:
+            continue
+        if layer.get('gru'):
+            raise ValueError('A batch norm before a GRU layer is not supported')
+        layer['bias'] = [b + sum(w * t for w, t in zip(row, shift))
+                         for row, b in zip(layer['weight'], layer['bias'])]
+        layer['weight'] = [[w * s for w, s in zip(row, scale)] for row in layer['weight']]
+        previous['post_scale'] = None
+        previous['post_shift'] = None
+
+    if layers[-1]['post_scale'] is not None:
+        raise ValueError('A batch norm after the output activation cannot be folded')
+    return layers
+
+
+def pack_dense(weight, bias):
+    """Bias and weights of one projection, padded and blocked for the kernel"""
+    num_outputs, num_inputs = len(weight), len(weight[0])
+    padded = (num_outputs + BLOCK - 1) // BLOCK * BLOCK
+
+    packed_bias = list(bias) + [0.0] * (padded - num_outputs)
+    packed_weights = []
+    for block in range(0, padded, BLOCK):
+        for i in range(num_inputs):
+            for o in range(block, block + BLOCK):
+                packed_weights.append(weight[o][i] if o < num_outputs else 0.0)
+
+    return struct.pack(f'<{padded}f', *packed_bias) + struct.pack(f'<{len(packed_weights)}f', *packed_weights)
+
+
+def pack_model(layers):
+    """Serialize folded layers in the MlpModel file layout"""
+    header = struct.pack('<4sIII', MAGIC, VERSION, len(layers), 0)
+    table = b''
+    payload = b''
+
+    for layer in layers:
+        weight, bias = layer['weight'], layer['bias']
+        num_inputs = len(weight[0])
+        if layer.get('gru'):
+            table += struct.pack('<IIII', num_inputs, len(weight) // 3, ACTIVATION_GRU, 0)
+            payload += pack_dense(weight, bias) + pack_dense(layer['hidden_weight'], layer['hidden_bias'])
+        else:
+            table += struct.pack('<IIII', num_inputs, len(weight), ACTIVATION_RELU if layer['relu'] else 0, 0)
+            payload += pack_dense(weight, bias)
+
+    return header + table + payload
+
+
+def unpack_dense(data, offset, num_inputs, num_outputs):
+    """Read one packed projection as a function of its inputs; returns it and the next offset"""
+    padded = (num_outputs + BLOCK - 1) // BLOCK * BLOCK
+    bias = struct.unpack_from(f'<{padded}f', data, offset)
+    offset += 4 * padded
+    weights = struct.unpack_from(f'<{padded * num_inputs}f', data, offset)
+    offset += 4 * padded * num_inputs
+
+    def project(values):
+        outputs = []
+        for o in range(num_outputs):
+            block, lane = divmod(o, BLOCK)
+            total = bias[o]
+            for i in range(num_inputs):
+                total += weights[(block * num_inputs + i) * BLOCK + lane] * values[i]
+            outputs.append(total)
+        return outputs
+
+    return project, offset
+
+
+def evaluate_packed(data, features, state=None):
+    """Evaluate a packed model on one frame the way MlpModel::run() does
+
+    state holds one hidden vector per GRU layer, starts empty and is
+    advanced in place, so consecutive calls follow one stream.
+    """
+    magic, version, num_layers, _ = struct.unpack_from('<4sIII', data, 0)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError('Not a native model file')
+    if state is None:
+        state = {}
+
+    offset = 16 + 16 * num_layers
+    values = list(features)
+    for l in range(num_layers):
+        num_inputs, num_outputs, activation, _ = struct.unpack_from('<IIII', data, 16 + 16 * l)
+        if activation == ACTIVATION_GRU:
+            input_gates, offset = unpack_dense(data, offset, num_inputs, 3 * num_outputs)
+            hidden_gates, offset = unpack_dense(data, offset, num_outputs, 3 * num_outputs)
+            hidden = state.setdefault(l, [0.0] * num_outputs)
+            x, h = input_gates(values), hidden_gates(hidden)
+            for j in range(num_outputs):
+                reset = 1.0 / (1.0 + math.exp(-(x[j] + h[j])))
+                update = 1.0 / (1.0 + math.exp(-(x[num_outputs + j] + h[num_outputs + j])))
+                candidate = math.tanh(x[2 * num_outputs + j] + reset * h[2 * num_outputs + j])
+                hidden[j] = (1.0 - update) * candidate + update * hidden[j]
+            values = list(hidden)
+        else:
+            project, offset = unpack_dense(data, offset, num_inputs, num_outputs)
+            values = [max(v, 0.0) if activation == ACTIVATION_RELU else v for v in project(values)]
+
+    return values
+
+
+def verify_export(model, data, input_size, num_frames=64, tolerance=1e-4):
+    """Largest difference between the packed model and the PyTorch model's logits"""
+    model.eval()
+    rng = random.Random(0)
+    frames = [[rng.gauss(0.0, 1.0) for _ in range(input_size)] for _ in range(num_frames)]
+    with torch.no_grad():
+        expected = model(torch.tensor(frames, dtype=torch.float32)).tolist()
+
+    max_error = 0.0
+    for frame, logits in zip(frames, expected):
+        actual = evaluate_packed(data, frame)
+        max_error = max(max_error, max(abs(a - e) for a, e in zip(actual, logits)))
+
+    if max_error > tolerance:
+        raise RuntimeError(f'Native export differs from the model by {max_error:.2e}')
+    return max_error
+
+
+def export_native_model(model, input_size=40, output_path='het_detector.khmlp'):
+    """Fold, pack and verify the model, then write it for the plugin"""
+    print(f"📦 Exporting native model: {output_path}")
+
+    model.eval()
+    layers = fold_post_activation_scales(describe_layers(model))
+    data = pack_model(layers)
+    max_error = verify_export(model, data, input_size)
+
+    # Write a new file and rename it over the old one: running plugins map the
+    # model file, and rewriting it in place would change their weights under them
+    output = Path(output_path)
+    temporary = output.with_name(output.name + '.tmp')
+    temporary.write_bytes(data)
+    os.replace(temporary, output)
+    shape = ' → '.join([str(len(layers[0]['weight'][0]))] + [str(len(layer['weight'])) for layer in layers])
+    print(f"✅ Native model saved: {output_path} ({shape}, max error {max_error:.1e})")
+    print(f"📏 Model size: {len(data) / 1024:.1f} KB")
+
+
+def main():
+    from train_het_detector import LightweightHetDetector
+
+    parser = argparse.ArgumentParser(description='Export a trained ח detector for the native MLP engine')
+    parser.add_argument('--checkpoint', type=str, default='best_het_detector.pth',
+                        help='State dict saved by train_het_detector.py')
+    parser.add_argument('--input-size', type=int, default=40,
+                        help='Features per frame')
+    parser.add_argument('--hidden-size', type=int, default=64,
+                        help='Hidden layer size used for training')
+    parser.add_argument('--output', type=str, default='het_detector.khmlp',
+                        help='Output model file')
+    args = parser.parse_args()
+
+    model = LightweightHetDetector(input_size=args.input_size, hidden_size=args.hidden_size)
+    model.load_state_dict(torch.load(args.checkpoint, map_location='cpu'))
+    export_native_model(model, args.input_size, args.output)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+"""
+Dependency-free port of the librosa calls in extract_audio_features()
+
+Reproduces, with the standard library only and in double precision, what
+HebrewAudioPreprocessor.extract_audio_features() computes with librosa 0.10
+defaults at n_fft=2048 and hop_length=512:
+
+- mfcc: centered zero-padded STFT with a periodic Hann window, power
+  spectrum through a 128-band Slaney mel filterbank, power_to_db (amin
+  1e-10, top_db 80 below the loudest value of the clip), orthonormal DCT-II
+- delta: Savitzky-Golay derivatives over 9 frames, polynomial fits of the
+  first and last 9 frames at the edges (scipy's "interp" mode)
+- spectral_centroid: magnitude-weighted mean of the bin frequencies
+- zero_crossing_rate: sign changes over edge-padded frames, samples within
+  1e-10 of zero counting as positive, divided by the frame length
+- energy: real part of the sum of the squared complex bins, np.sum(stft ** 2)
+
+make_feature_golden.py uses it with --reference where librosa is not
+installed. Rows come out in the plugin's order, one per hop:
+mfcc[13], delta[13], delta2[13], centroid, zcr, energy.
+"""
+
+import cmath
+import math
+
+N_FFT = 2048
+HOP_LENGTH = 512
+N_MELS = 128
+N_MFCC = 13
+DELTA_WIDTH = 9
+AMIN = 1e-10
+TOP_DB = 80.0
+ZERO_THRESHOLD = 1e-10
+
+
+def _fft(values):
+    """Radix-2 complex FFT"""
+    n = len(values)
+    out = list(values)
+    j = 0
+    for i in range(1, n):
+        bit = n >> 1
+        while j & bit:
+            j ^= bit
+            bit >>= 1
+        j |= bit
+        if i < j:
+            out[i], out[j] = out[j], out[i]
+    size = 2
+    while size <= n:
+        step = cmath.exp(-2j * math.pi / size)
+        half = size // 2
+        twiddles = [step ** k for k in range(half)]
+        for start in range(0, n, size):
+            for k in range(half):
+                a = out[start + k]
+                b = out[start + k + half] * twiddles[k]
+                out[start + k] = a + b
+                out[start + k + half] = a - b
+        size *= 2
+    return out
+
+
+def _hz_to_mel(frequency):
+    """Slaney mel scale: linear below 1 kHz, logarithmic above"""
+    f_sp = 200.0 / 3
+    min_log_hz = 1000.0
+    min_log_mel = min_log_hz / f_sp
+    logstep = math.log(6.4) / 27.0
+    if frequency >= min_log_hz:
+        return min_log_mel + math.log(frequency / min_log_hz) / logstep
+    return frequency / f_sp
+
+
+def _mel_to_hz(mel):
+    f_sp = 200.0 / 3
+    min_log_hz = 1000.0
+    min_log_mel = min_log_hz / f_sp
+    logstep = math.log(6.4) / 27.0
+    if mel >= min_log_mel:
+        return min_log_hz * math.exp(logstep * (mel - min_log_mel))
+    return f_sp * mel
+
+
+def _mel_filterbank(sample_rate):
+    """librosa.filters.mel() with norm='slaney', as (first bin, weights) per band"""
+    max_mel = _hz_to_mel(sample_rate / 2.0)
+    edges = [_mel_to_hz(max_mel * i / (N_MELS + 1)) for i in range(N_MELS + 2)]
+    frequencies = [k * sample_rate / N_FFT for k in range(N_FFT // 2 + 1)]
+    bands = []
+    for m in range(N_MELS):
+        enorm = 2.0 / (edges[m + 2] - edges[m])
+        weights = []
+        first = None
+        for k, f in enumerate(frequencies):
+            lower = (f - edges[m]) / (edges[m + 1] - edges[m])
+            upper = (edges[m + 2] - f) / (edges[m + 2] - edges[m + 1])
+            weight = max(0.0, min(lower, upper))
+            if weight > 0.0:
+                if first is None:
+                    first = k
+                weights.append(weight * enorm)
+            elif first is not None:
+                break
+        bands.append((first or 0, weights))
+    return bands
+
+
+def _stft(audio):
+    """One-sided spectra of the centered, zero-padded frames"""
+    window = [0.5 - 0.5 * math.cos(2.0 * math.pi * i / N_FFT) for i in range(N_FFT)]
+    padded = [0.0] * (N_FFT // 2) + list(audio) + [0.0] * (N_FFT // 2)
+    num_frames = 1 + (len(padded) - N_FFT) // HOP_LENGTH
+    spectra = []
+    for t in range(num_frames):
+        offset = t * HOP_LENGTH
+        frame = [padded[offset + i] * window[i] for i in range(N_FFT)]
+        spectra.append(_fft(frame)[:N_FFT // 2 + 1])
+    return spectra
+
+
+def _zero_crossing_rates(audio, num_frames):
+    padded = [audio[0]] * (N_FFT // 2) + list(audio) + [audio[-1]] * (N_FFT // 2)
+    negative = [x < 0.0 and abs(x) > ZERO_THRESHOLD for x in padded]
+    rates = []
+    for t in range(num_frames):
+        offset = t * HOP_LENGTH
+        crossings = sum(negative[offset + i] != negative[offset + i - 1] for i in range(1, N_FFT))
+        rates.append(crossings / N_FFT)
+    return rates
+
+
+def _savgol_derivative(series, order):
+    """scipy.signal.savgol_filter(width 9, polyorder=deriv=order, mode='interp') for order 1 or 2"""
+    half = DELTA_WIDTH // 2
+    offsets = range(-half, half + 1)
+    mean_square = sum(k * k for k in offsets) / DELTA_WIDTH
+
+    def at(centre):
+        window = series[centre - half:centre + half + 1]
+        if order == 1:
+            return sum(k * x for k, x in zip(offsets, window)) / sum(k * k for k in offsets)
+        curvature = sum((k * k - mean_square) * x for k, x in zip(offsets, window))
+        return 2.0 * curvature / sum((k * k - mean_square) ** 2 for k in offsets)
+
+    # A polynomial of degree `order` has a constant `order`th derivative, so the
+    # edge fits give every edge frame the value of the nearest full window
+    n = len(series)
+    return [at(min(max(t, half), n - 1 - half)) for t in range(n)]
+
+
+def extract_features(audio, sample_rate):
+    """Per-frame features in the plugin's order, one list per hop"""
+    if len(audio) < DELTA_WIDTH * HOP_LENGTH:
+        raise ValueError('clip too short for 9-frame deltas')
+
+    spectra = _stft(audio)
+    bands = _mel_filterbank(sample_rate)
+    bin_frequencies = [k * sample_rate / N_FFT for k in range(N_FFT // 2 + 1)]
+
+    log_mels, centroids, energies = [], [], []
+    for spectrum in spectra:
+        power = [abs(x) ** 2 for x in spectrum]
+        magnitude = [abs(x) for x in spectrum]
+        log_mels.append([10.0 * math.log10(max(AMIN, sum(w * power[first + i] for i, w in enumerate(weights))))
+                         for first, weights in bands])
+        total = sum(magnitude)
+        weighted = sum(f * s for f, s in zip(bin_frequencies, magnitude))
+        centroids.append(weighted / total if total > 0.0 else weighted)
+        energies.append(sum((x * x).real for x in spectrum))
+
+    floor = max(max(row) for row in log_mels) - TOP_DB
+    mfccs = []
+    for row in log_mels:
+        clipped = [max(value, floor) for value in row]
+        mfccs.append([math.sqrt((1.0 if k == 0 else 2.0) / N_MELS) *
+                      sum(v * math.cos(math.pi * k * (2 * m + 1) / (2.0 * N_MELS)) for m, v in enumerate(clipped))
+                      for k in range(N_MFCC)])
+
+    deltas = [_savgol_derivative([row[c] for row in mfccs], 1) for c in range(N_MFCC)]
+    deltas2 = [_savgol_derivative([row[c] for row in mfccs], 2) for c in range(N_MFCC)]
+    rates = _zero_crossing_rates(audio, len(spectra))
+
+    return [mfccs[t] + [d[t] for d in deltas] + [d[t] for d in deltas2] + [centroids[t], rates[t], energies[t]]
+            for t in range(len(spectra))]
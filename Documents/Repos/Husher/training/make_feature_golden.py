@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""
+Write a golden file for the plugin's streaming feature extractor
+
+Runs HebrewAudioPreprocessor.extract_audio_features() on a clip and stores
+the samples with librosa's per-frame features, for the MatchesLibrosaGoldenFile
+test of KhDetector::FeatureExtractor (Desktop/Hush/tests/test_featureextractor.cpp).
+
+File layout (little-endian):
+
+    char     magic[4]      "KHFG"
+    uint32   version       1
+    uint32   sampleRate
+    uint32   numSamples
+    uint32   numFrames
+    uint32   numFeatures   42
+    float32  samples[numSamples]
+    float32  features[numFrames][numFeatures]
+
+with each feature frame laid out as save_processed_data() concatenates it:
+mfcc[13], delta[13], delta2[13], centroid, zcr, energy. The energy is the
+real part of extract_audio_features()' complex np.sum(stft ** 2).
+
+With --reference the features come from librosa_reference.py, a port of
+the same librosa calls that needs neither librosa nor numpy.
+"""
+
+import argparse
+import math
+import random
+import struct
+from pathlib import Path
+
+MAGIC = b'KHFG'
+VERSION = 1
+
+
+def synthetic_clip(sample_rate, duration, seed=0):
+    """Gliding harmonic tone with a noise burst over a noise floor, as float32 values
+
+    The floor keeps every mel band within power_to_db's 80 dB of the loudest,
+    where the plugin's per-frame clipping and librosa's per-clip clipping agree.
+    """
+    rng = random.Random(seed)
+    clip = []
+    phase = 0.0
+    for n in range(int(sample_rate * duration)):
+        t = n / sample_rate
+        phase += 2 * math.pi * (150.0 + 100.0 * t) / sample_rate
+        value = sum(0.2 / h * math.sin(h * phase) for h in range(1, 6))
+        burst = duration / 2 < t < duration / 2 + duration / 8
+        value += (0.1 if burst else 0.003) * rng.gauss(0.0, 1.0)
+        clip.append(value)
+    return list(struct.unpack(f'<{len(clip)}f', struct.pack(f'<{len(clip)}f', *clip)))
+
+
+def per_frame_features(sample_rate, audio):
+    """Feature frames in the plugin's order, one row per hop"""
+    import numpy as np
+    from preprocess_audio import HebrewAudioPreprocessor
+
+    preprocessor = HebrewAudioPreprocessor(sample_rate=sample_rate)
+    features = preprocessor.extract_audio_features(np.asarray(audio, dtype=np.float32))
+    return np.concatenate([
+        features['mfcc'],
+        features['mfcc_delta'],
+        features['mfcc_delta2'],
+        features['spectral_centroid'],
+        features['zcr'],
+        np.real(features['energy']),
+    ], axis=1).astype(np.float32)
+
+
+def write_golden(path, sample_rate, audio, frames):
+    with open(path, 'wb') as f:
+        f.write(struct.pack('<4sIIIII', MAGIC, VERSION, sample_rate, len(audio), len(frames), len(frames[0])))
+        f.write(struct.pack(f'<{len(audio)}f', *audio))
+        for frame in frames:
+            f.write(struct.pack(f'<{len(frame)}f', *frame))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Write a golden file for the plugin feature extractor')
+    parser.add_argument('--audio', type=str, default=None,
+                        help='Audio file to use instead of the synthetic clip')
+    parser.add_argument('--sample-rate', type=int, default=44100,
+                        help='Sample rate (the training rate)')
+    parser.add_argument('--duration', type=float, default=1.0,
+                        help='Length of the synthetic clip in seconds')
+    parser.add_argument('--reference', action='store_true',
+                        help='Compute the features with librosa_reference.py instead of librosa')
+    parser.add_argument('--output', type=str, default='features.khfg',
+                        help='Output golden file')
+    args = parser.parse_args()
+
+    if args.audio:
+        import librosa
+        audio, _ = librosa.load(args.audio, sr=args.sample_rate)
+        audio = audio.tolist()
+    else:
+        audio = synthetic_clip(args.sample_rate, args.duration)
+
+    if args.reference:
+        from librosa_reference import extract_features
+        frames = extract_features(audio, args.sample_rate)
+    else:
+        frames = per_frame_features(args.sample_rate, audio).tolist()
+    write_golden(Path(args.output), args.sample_rate, audio, frames)
+    print(f"✅ Golden features saved: {args.output} ({len(audio)} samples, {len(frames)} frames)")
+
+
+if __name__ == '__main__':
+    main()
@@ -19,6 +19,8 @@ from tqdm import tqdm
 import onnx
 import torch.onnx
 
+from export_native_model import export_native_model
+
 class HebrewHetDataset(Dataset):
     """Dataset for Hebrew ח detection"""
     
@@ -356,6 +358,9 @@ def main():
     # Export to ONNX
     export_to_onnx(model, input_size, output_dir / "het_detector.onnx")
     
+    # Export the same weights for the plugin's native engine
+    export_native_model(model, input_size, output_dir / "het_detector.khmlp")
+    
     # Save training configuration and results
     config = {
         'model_config': {